@@ -4,6 +4,12 @@
 #include <sstream>
 #include <chrono>
 #include <map>
+#include <set>
+#include <unordered_set>
+#include <unordered_map>
+#include <deque>
+#include <list>
+#include <queue>
 #include <vector>
 #include <cassert>
 #include <ctime>
@@ -11,8 +17,173 @@
 #include <thread>
 #include <future>
 #include <mutex>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <functional>
+#include <condition_variable>
+#include <cstdint>
+#include <string_view>
+#include <array>
+#include <charconv>
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <stdexcept>
+#include <filesystem>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <csignal>
 #define DELAY std::chrono::seconds(5)
 #define LOG_PATH "logs.txt"
+#define LOG_QUEUE_SIZE 65536
+#define LOG_FLUSH_INTERVAL std::chrono::milliseconds(100)
+#define LOG_MAX_SIZE (16 * 1024 * 1024)
+#define LOG_MAX_FILES 5
+#define LOG_BLOCK_TIMEOUT std::chrono::milliseconds(50)
+#define PIPELINE_QUEUE_SIZE 1024
+#define BULK_BATCH_SIZE 4096
+#define LINE_READER_CHUNK (64 * 1024)
+#define LINE_READER_MAX_LINE (1024 * 1024)
+#define REQUEST_ARENA_CHUNK (256 * 1024)
+#define TIMER_TICK std::chrono::milliseconds(10)
+#define TIMER_SLOTS 512
+#define WAL_COMMIT_INTERVAL std::chrono::milliseconds(5)
+#define WAL_SNAPSHOT_EVERY 65536
+#define ESTIMATOR_QUANTILE 0.5
+#define ESTIMATOR_MIN_SAMPLES 5
+#define ESTIMATOR_MAX_KEYS 65536
+#define METRICS_SHARDS 16
+#define METRICS_SHARED_SHARD (METRICS_SHARDS - 1)
+#define METRICS_MAX_STANDS 1024
+#define METRICS_INTERVAL std::chrono::milliseconds(1000)
+#define SERVER_THREADS 4
+#define SERVER_BACKLOG 1024
+#define SERVER_MAX_EVENTS 256
+#define SERVER_READ_CHUNK (16 * 1024)
+#define SERVER_MAX_FRAME (64 * 1024)
+#define SERVER_MAX_OUTPUT (1024 * 1024)
+#define SERVER_TICKETS_PRUNE 256
+#define CLIENT_WINDOW 256
+#define SPOOL_BATCH 256
+#define SPOOL_BATCH_DELAY std::chrono::milliseconds(20)
+#define SPOOL_READ_SIZE (16 * 1024)
+#define SPOOL_READ_THREADS 4
+#define EXEC_MAX_JOBS 256
+#define EXEC_TIMEOUT std::chrono::minutes(10)
+#define EXEC_MAX_OUTPUT (64 * 1024 * 1024)
+#define EXEC_SPLICE_CHUNK (64 * 1024)
+#define EXEC_MAX_EVENTS 256
+#define EXEC_MAX_WAIT 1000
+#define EXEC_POLL_INTERVAL 50
+#define EXEC_OVERRUN_STEP std::chrono::seconds(1)
+#define CACHE_SETTLE_TIME std::chrono::milliseconds(20)
+#define REQUEST_FILE_MAX (8 * 1024)
+#define REQUEST_CACHE_ENTRIES 4096
+#define REQUEST_CACHE_BYTES (16 * 1024 * 1024)
+#define EXEC_CACHE_ENTRIES 4096
+#define EXEC_CACHE_BYTES (1024ull * 1024 * 1024)
+#define BOARD_DIRECTORY_CAPACITY 16
+#define CLUSTER_READER_STRIPES 16
+#define TOPOLOGY_BATCH 32
+#define TOPOLOGY_HEADROOM 4
+#define STAND_SEGMENT 16
+#define SUBSCRIBER_QUEUE 4096
+#define SUBSCRIBER_BATCH 256
+
+// Функция для вывода времени в формате std::ctime, безопасная для нескольких потоков
+std::string formatTime(std::chrono::system_clock::time_point time) {
+    std::time_t time_t = std::chrono::system_clock::to_time_t(time);
+    std::tm local;
+    char buffer[64];
+
+    localtime_r(&time_t, &local);
+    std::strftime(buffer, sizeof(buffer), "%a %b %e %H:%M:%S %Y\n", &local);
+
+    return buffer;
+}
+
+// Абстрактные часы: всё время в программе берётся через них
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    // Текущее время
+    virtual std::chrono::system_clock::time_point now() const = 0;
+
+    // Идёт ли время само (для виртуальных часов таймеры продвигаются вручную)
+    virtual bool isRealTime() const = 0;
+};
+
+// Системные часы
+class SystemClock final : public Clock {
+public:
+    std::chrono::system_clock::time_point now() const override {
+        return std::chrono::system_clock::now();
+    }
+
+    bool isRealTime() const override {
+        return true;
+    }
+};
+
+// Виртуальные часы для тестов и моделирования: время меняется только явно
+class ManualClock final : public Clock {
+private:
+    std::atomic<std::chrono::system_clock::rep> ticks;
+
+public:
+    // Конструктор, по умолчанию часы стоят на текущем системном времени
+    explicit ManualClock(std::chrono::system_clock::time_point start = std::chrono::system_clock::now())
+        : ticks(start.time_since_epoch().count()) {}
+
+    std::chrono::system_clock::time_point now() const override {
+        return std::chrono::system_clock::time_point(std::chrono::system_clock::duration(ticks.load()));
+    }
+
+    bool isRealTime() const override {
+        return false;
+    }
+
+    // Установка времени
+    void set(std::chrono::system_clock::time_point time) {
+        ticks.store(time.time_since_epoch().count());
+    }
+
+    // Продвижение времени вперёд
+    void advance(std::chrono::system_clock::duration delta) {
+        ticks.fetch_add(delta.count());
+    }
+};
+
+// Системные часы программы
+const Clock& systemClock() {
+    static SystemClock instance;
+    return instance;
+}
 
 // Абстрактный класс Stand
 class Stand {
@@ -33,7 +204,7 @@ public:
 };
 
 // Класс удалённого стенда
-class RemoteStand : public Stand {
+class RemoteStand final : public Stand {
 private:
     // Имя платы
     std::string boardName;
@@ -43,7 +214,11 @@ private:
 public:
     // Конструктор по умолчанию
     RemoteStand()
-        : boardName("Unnamed Board"), freeTime(std::chrono::system_clock::now()) {}
+        : boardName("Unnamed Board"), freeTime(systemClock().now()) {}
+
+    // Конструктор стенда, свободного в текущий момент по заданным часам
+    RemoteStand(const std::string& board, const Clock& clock)
+        : boardName(board), freeTime(clock.now()) {}
 
     // Конструктор с параметрами
     RemoteStand(const std::string& board, std::chrono::system_clock::time_point time)
@@ -78,10 +253,8 @@ public:
 
     // Переопределение метода для вывода информации о стенде
     void printInfo() const override {
-        std::time_t freeTime_t = std::chrono::system_clock::to_time_t(freeTime);
-
         std::cout << "Board Name: " << boardName << "\n";
-        std::cout << "Free Time: " << std::ctime(&freeTime_t); // выводим время в читаемом формате
+        std::cout << "Free Time: " << formatTime(freeTime); // выводим время в читаемом формате
     }
 
     // Метод для увеличения времени освобождения (секунды)
@@ -183,582 +356,14818 @@ void testRemoteStand() {
     assert(stand1.getFreeTime() == updatedTime);
 }
 
-// Класс кластера стендов
-class StandCluster {
+// Столбец значений стендов платы: элементы лежат в сегментах, k-й сегмент содержит STAND_SEGMENT << k элементов
+// Рост только подключает следующий сегмент, элементы никогда не переносятся. Поэтому память под рост можно выделить
+// и заполнить вне блокировки шарда (prepare), а под блокировкой лишь подключить готовые сегменты (adopt)
+// Элементы за концом столбца хранят значение по умолчанию
+template <typename T>
+class StandColumn {
 private:
-    // Словарь название платы - вектор стендов
-    std::map<std::string, std::vector<RemoteStand>> stands;
+    std::vector<std::unique_ptr<T[]>> segments;
+    size_t count = 0;
 
-public:
-    // Конструктор по умолчанию
-    StandCluster() = default;
-
-    // Конструктор копирования
-    StandCluster(const StandCluster& other) : stands(other.stands) {}
+    // Номер сегмента элемента index
+    static size_t segmentOf(size_t index) {
+        return 63 - __builtin_clzll(index / STAND_SEGMENT + 1);
+    }
 
-    // Деструктор
-    ~StandCluster() = default;
+    // Индекс первого элемента сегмента segment (он же ёмкость первых segment сегментов)
+    static size_t segmentStart(size_t segment) {
+        return ((size_t(1) << segment) - 1) * STAND_SEGMENT;
+    }
 
-    // Метод для добавления стенда в кластер
-    void addStand(const RemoteStand& stand) {
-        stands[stand.getBoardName()].push_back(stand);
+    // Новый сегмент segment, заполненный значениями по умолчанию (страницы памяти уже затронуты)
+    static std::unique_ptr<T[]> makeSegment(size_t segment) {
+        return std::unique_ptr<T[]>(new T[STAND_SEGMENT << segment]());
     }
 
-    // Метод для удаления стенда из кластера по названию платы
-    void removeStand(const std::string& boardName, const RemoteStand& stand) {
-        auto it = stands.find(boardName);
+public:
+    StandColumn() = default;
+    StandColumn(StandColumn&&) = default;
+    StandColumn& operator=(StandColumn&&) = default;
 
-        if (it != stands.end()) {
-            auto& standVector = it->second;
-            auto vecIt = std::remove(standVector.begin(), standVector.end(), stand);
+    StandColumn(const StandColumn& other) {
+        reserve(other.count);
 
-            if (vecIt != standVector.end()) {
-                standVector.erase(vecIt, standVector.end());
-            }
+        for (size_t i = 0; i < other.count; ++i) {
+            (*this)[i] = other[i];
         }
+
+        count = other.count;
     }
 
-    // Метод для получения всех стендов по названию платы (ссылку на вектор)
-    std::vector<RemoteStand>& getStandsByBoard(const std::string& boardName) {
-        return stands[boardName];
+    StandColumn& operator=(const StandColumn& other) {
+        StandColumn copy(other);
+        std::swap(*this, copy);
+        return *this;
     }
 
-    // Метод для увеличения времени освобождения всех стендов на заданный кулдаун
-    void increaseCooldownForAllStands(const std::string& boardName, std::chrono::minutes delay) {
-        auto it = stands.find(boardName);
+    T& operator[](size_t index) {
+        size_t segment = segmentOf(index);
+        return segments[segment][index - segmentStart(segment)];
+    }
 
-        if (it != stands.end()) {
-            for (auto& stand : it->second) {
-                stand.increaseDelay(delay);
-            }
-        }
+    const T& operator[](size_t index) const {
+        size_t segment = segmentOf(index);
+        return segments[segment][index - segmentStart(segment)];
     }
 
-    // Метод для очистки всех стендов в кластере
-    void clearAllStands() {
-        stands.clear();
+    size_t size() const {
+        return count;
     }
 
-    // Метод для вывода всех стендов в кластере
-    void printAllStands() const {
-        for (const auto& pair : stands) {
-            std::cout << "Board: " << pair.first << "\n";
+    bool empty() const {
+        return count == 0;
+    }
 
-            for (const auto& stand : pair.second) {
-                stand.printInfo();
-            }
-        }
+    // Количество элементов в подключённых сегментах
+    size_t capacity() const {
+        return segmentStart(segments.size());
     }
 
-    // Метод для вывода количества стендов с каждой платой
-    void printStandsCount() const {
-        for (const auto& pair : stands) {
-            std::cout << pair.first << " : " << pair.second.size() << "\n";
-        }
+    T& back() {
+        return (*this)[count - 1];
     }
 
-    // Оператор присваивания
-    StandCluster& operator=(const StandCluster& other) {
-        if (this != &other) {
-            stands = other.stands;
+    void push_back(T value) {
+        if (count == capacity()) {
+            segments.push_back(makeSegment(segments.size()));
         }
 
-        return *this;
+        (*this)[count++] = std::move(value);
     }
 
-    // Оператор сравнения (==): два кластера равны, если у них одинаковое количество стендов по каждой плате
-    bool operator==(const StandCluster& other) const {
-        return stands == other.stands;
+    // Удаление последнего элемента: его место получает значение по умолчанию (календарь освобождает память)
+    void pop_back() {
+        (*this)[--count] = T();
     }
 
-    // Оператор сравнения (!=): два кластера не равны, если они отличаются по количеству стендов по хотя бы одной плате
-    bool operator!=(const StandCluster& other) const {
-        return !(*this == other);
+    // Изменение размера; сегменты при уменьшении остаются подключёнными
+    void resize(size_t size) {
+        reserve(size);
+
+        while (count > size) {
+            pop_back();
+        }
+
+        count = size;
     }
 
-    // Оператор сравнения (<): два кластера сравниваются по количеству стендов, можно отсортировать по количеству
-    bool operator<(const StandCluster& other) const {
-        if (stands.size() != other.stands.size()) {
-            return stands.size() < other.stands.size();
+    void clear() {
+        resize(0);
+    }
+
+    // Подключение сегментов до ёмкости не меньше size
+    void reserve(size_t size) {
+        while (capacity() < size) {
+            segments.push_back(makeSegment(segments.size()));
         }
+    }
 
-        for (const auto& pair : stands) {
-            if (other.stands.find(pair.first) == other.stands.end()) {
-                return false; // Если в другом кластере нет такой платы, то этот кластер "меньше"
+    // Выделение сегментов, которых столбцу ёмкости from не хватает до size элементов (у пустого столбца-хранилища)
+    void prepare(size_t from, size_t size) {
+        for (size_t segment = segmentOf(from); segmentStart(segment) < size; ++segment) {
+            if (segments.size() <= segment) {
+                segments.resize(segment + 1);
             }
 
-            if (pair.second.size() != other.stands.at(pair.first).size()) {
-                return pair.second.size() < other.stands.at(pair.first).size();
+            if (!segments[segment]) {
+                segments[segment] = makeSegment(segment);
             }
         }
+    }
 
-        return false;
+    // Подключение следующих по порядку сегментов, подготовленных в storage методом prepare (без выделений)
+    void adopt(StandColumn& storage) {
+        while (segments.size() < storage.segments.size() && storage.segments[segments.size()]) {
+            segments.push_back(std::move(storage.segments[segments.size()]));
+        }
     }
 
-    // Оператор сравнения (>): это обратный оператор по отношению к operator<
-    bool operator>(const StandCluster& other) const {
-        return other < *this;
+    // Память сегментов в байтах
+    size_t memoryUsage() const {
+        return capacity() * sizeof(T) + segments.capacity() * sizeof(segments[0]);
     }
 };
 
-// Тесты класса кластера стендов
-void testStandCluster() {
-    using namespace std::chrono;
+// Индексированная двоичная куча стендов одной платы по времени освобождения
+// Хранит 32-битные индексы в столбец времён освобождения платы
+class StandHeap {
+private:
+    // Индексы стендов в порядке кучи
+    StandColumn<uint32_t> heap;
+    // Позиция каждого стенда в куче (по индексу стенда)
+    StandColumn<uint32_t> position;
+
+    // Сравнение двух элементов кучи по времени освобождения стендов
+    static bool less(const StandColumn<std::chrono::system_clock::time_point>& times, size_t a, size_t b) {
+        return times[a] < times[b];
+    }
 
-    // Создаем несколько стендов
-    RemoteStand stand1("Board A", system_clock::now() + hours(1));
-    RemoteStand stand2("Board A", system_clock::now() + hours(2));
-    RemoteStand stand3("Board B", system_clock::now() + hours(3));
-    RemoteStand stand4("Board A", system_clock::now() + hours(4));
+    // Обмен двух элементов кучи с обновлением позиций
+    void swapNodes(size_t i, size_t j) {
+        std::swap(heap[i], heap[j]);
+        position[heap[i]] = static_cast<uint32_t>(i);
+        position[heap[j]] = static_cast<uint32_t>(j);
+    }
 
-    // Создаем кластер стендов
-    StandCluster cluster;
+    // Подъём элемента к вершине кучи
+    void siftUp(const StandColumn<std::chrono::system_clock::time_point>& times, size_t i) {
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
 
-    // Добавление стендов
-    cluster.addStand(stand1);
-    cluster.addStand(stand2);
-    cluster.addStand(stand3);
-    cluster.addStand(stand4);
+            if (!less(times, heap[i], heap[parent])) {
+                break;
+            }
 
-    // Проверяем, что стенды добавлены
-    auto standsA = cluster.getStandsByBoard("Board A");
-    auto standsB = cluster.getStandsByBoard("Board B");
+            swapNodes(i, parent);
+            i = parent;
+        }
+    }
 
-    // Проверяем, что для Board A 3 стенда, для Board B - 1 стенд
-    assert(standsA.size() == 3);  // Должно быть 3 стенда для Board A
-    assert(standsB.size() == 1);  // Должно быть 1 стенд для Board B
+    // Спуск элемента к листьям кучи
+    void siftDown(const StandColumn<std::chrono::system_clock::time_point>& times, size_t i) {
+        while (true) {
+            size_t smallest = i;
+            size_t left = 2 * i + 1;
+            size_t right = left + 1;
 
-    // Удаление стенда
-    cluster.removeStand("Board A", stand1);  // Удаляем stand1 для Board A
-    standsA = cluster.getStandsByBoard("Board A");
+            if (left < heap.size() && less(times, heap[left], heap[smallest])) {
+                smallest = left;
+            }
 
-    // Проверяем, что один стенд был удален
-    assert(standsA.size() == 2);  // Должно быть 2 стенда для Board A
+            if (right < heap.size() && less(times, heap[right], heap[smallest])) {
+                smallest = right;
+            }
 
-    // Получение стендов по названию платы
-    std::vector<RemoteStand> standsAAfterRemoval = cluster.getStandsByBoard("Board A");
-    assert(standsAAfterRemoval.size() == 2);  // После удаления stand1 осталось 2 стенда для Board A
+            if (smallest == i) {
+                break;
+            }
 
-    // Увеличение времени освобождения для всех стендов
-    minutes cooldown(30);
-    cluster.increaseCooldownForAllStands("Board A", cooldown);
+            swapNodes(i, smallest);
+            i = smallest;
+        }
+    }
 
-    // Проверяем, что время освобождения стендов увеличилось
-    auto updatedStandsA = cluster.getStandsByBoard("Board A");
-    auto originalFreeTime = stand2.getFreeTime();
-    auto updatedFreeTime = updatedStandsA[0].getFreeTime();
+public:
+    // Построение кучи по всему массиву времён за O(n)
+    void build(const StandColumn<std::chrono::system_clock::time_point>& times) {
+        heap.resize(times.size());
+        position.resize(times.size());
+
+        for (uint32_t i = 0; i < times.size(); ++i) {
+            heap[i] = i;
+            position[i] = i;
+        }
 
-    assert(updatedFreeTime == originalFreeTime + cooldown);
+        for (size_t i = heap.size() / 2; i-- > 0;) {
+            siftDown(times, i);
+        }
+    }
 
-    // Очистка всех стендов
-    cluster.clearAllStands();
+    // Добавление в кучу стенда, только что добавленного в конец массива
+    void push(const StandColumn<std::chrono::system_clock::time_point>& times) {
+        uint32_t index = static_cast<uint32_t>(times.size() - 1);
 
-    assert(cluster.getStandsByBoard("Board A").empty());  // Все стенды для Board A должны быть удалены
-    assert(cluster.getStandsByBoard("Board B").empty());  // Все стенды для Board B должны быть удалены
+        heap.push_back(index);
+        position.push_back(static_cast<uint32_t>(heap.size() - 1));
+        siftUp(times, heap.size() - 1);
+    }
 
-    // Конструктор копирования
-    StandCluster copiedCluster(cluster);
+    // Восстановление порядка после изменения времени освобождения стенда
+    void update(const StandColumn<std::chrono::system_clock::time_point>& times, size_t index) {
+        size_t i = position[index];
 
-    assert(copiedCluster.getStandsByBoard("Board A").empty());  // Проверка, что копия пустая после очистки
-    assert(copiedCluster.getStandsByBoard("Board B").empty());  // Проверка, что копия пустая после очистки
+        siftUp(times, i);
+        siftDown(times, position[index]);
+    }
 
-    // Оператор присваивания
-    StandCluster assignedCluster;
-    assignedCluster = cluster;
+    // Удаление стенда index из кучи за O(log n)
+    // Последний стенд массива получает индекс index: вызывающий переносит на его место время последнего стенда
+    void erase(const StandColumn<std::chrono::system_clock::time_point>& times, size_t index) {
+        size_t i = position[index];
+        size_t last = heap.size() - 1;
 
-    // Проверка оператора присваивания
-    assert(assignedCluster.getStandsByBoard("Board A").empty());
-    assert(assignedCluster.getStandsByBoard("Board B").empty());
+        if (i != last) {
+            swapNodes(i, last);
+        }
 
-    // Оператор сравнения (==)
-    StandCluster cluster2;
+        heap.pop_back();
 
-    // Добавление стендов в кластер
-    cluster2.addStand(stand1);
-    cluster2.addStand(stand2);
-    cluster2.addStand(stand3);
+        if (i < heap.size()) {
+            uint32_t moved = heap[i];
+            siftUp(times, i);
+            siftDown(times, position[moved]);
+        }
 
-    // Кластеры с одинаковым содержимым должны быть равны
-    assert(cluster != cluster2);  // Кластеры с разным содержимым не равны
-    assert(cluster == cluster);   // Кластер должен быть равен сам себе
+        size_t lastIndex = position.size() - 1;
 
-    // Оператор сравнения (!=)
-    assert(cluster != cluster2);  // Кластеры с разным содержимым не равны
+        if (index != lastIndex) {
+            heap[position[lastIndex]] = static_cast<uint32_t>(index);
+            position[index] = position[lastIndex];
+        }
 
-    // Оператор сравнения (<)
-    StandCluster cluster3;
+        position.pop_back();
+    }
 
-    // Добавление стендов в кластер
-    cluster3.addStand(stand1);
-    cluster3.addStand(stand2);
-    cluster3.addStand(stand4);
-    cluster3.addStand(stand3);
+    // Индекс стенда с самым ранним временем освобождения
+    size_t top() const {
+        return heap[0];
+    }
 
-    // Проверяем, что первый кластер "меньше" второго, т.к. у второго больше стендов
-    assert(cluster < cluster3);
+    // Проверка на пустоту
+    bool empty() const {
+        return heap.empty();
+    }
 
-    // Оператор сравнения (>)
-    assert(cluster3 > cluster);  // Проверяем, что второй кластер "больше" первого
-}
+    // Память кучи в байтах
+    size_t memoryUsage() const {
+        return heap.memoryUsage() + position.memoryUsage();
+    }
 
-// Структура для хранения о заявке
-struct Request {
-    std::string lastName;
-    std::string firstName;
-    std::string patronymic;
-    std::string group;
-    std::string boardName;
-    std::string executablePath;
-    std::string resultPath;
-};
+    // Резервирование места под count стендов
+    void reserve(size_t count) {
+        heap.reserve(count);
+        position.reserve(count);
+    }
 
-// Функция для чтения заявки из файла
-Request readRequestFromFile(const std::string& fileName) {
-    std::ifstream file(fileName);
-    Request request;
+    // Выделение сегментов, которых куче ёмкости from не хватает до count стендов (у пустой кучи-хранилища)
+    void prepare(size_t from, size_t count) {
+        heap.prepare(from, count);
+        position.prepare(from, count);
+    }
 
-    // Проверка открытия файла
-    if (!file.is_open()) {
-        std::cerr << "Ошибка при открытии файла!" << std::endl;
-        return request;
+    // Подключение сегментов, подготовленных в storage
+    void adopt(StandHeap& storage) {
+        heap.adopt(storage.heap);
+        position.adopt(storage.position);
     }
 
-    // Читаем данные по очереди
-    std::getline(file, request.lastName);
-    std::getline(file, request.firstName);
-    std::getline(file, request.patronymic);
-    std::getline(file, request.group);
-    std::getline(file, request.boardName);
-    std::getline(file, request.executablePath);
-    std::getline(file, request.resultPath);
+    // Ёмкость кучи без выделения памяти
+    size_t capacity() const {
+        return std::min(heap.capacity(), position.capacity());
+    }
 
-    // Закрытие файла   
-    file.close();
+    // Свободное место без перераспределения памяти
+    size_t spare() const {
+        return std::min(heap.capacity() - heap.size(), position.capacity() - position.size());
+    }
 
-    return request;
-}
+    // Очистка кучи
+    void clear() {
+        heap.clear();
+        position.clear();
+    }
+};
 
-// Функция проверки пути файла
-bool isValidFilePath(const std::string& path) {
-    // Простой пример проверки пути (можно улучшить под платформу)
-    return !path.empty() && path.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_/\\:.") == std::string::npos;
-}
+// Получатель изменений времени освобождения стендов (например, журнал упреждающей записи)
+// Вызывается под блокировкой шарда платы, поэтому изменения одного стенда приходят в порядке их выполнения
+class StandChangeListener {
+public:
+    virtual ~StandChangeListener() = default;
 
-// Тесты для функции проверки пути файла
-void testIsValidFilePath() {
-    // Тестирование валидных путей
-    assert(isValidFilePath("/path/to/executable"));
-    assert(isValidFilePath("C:/Users/Username/Documents/test.exe"));
-    assert(isValidFilePath("valid_path/with/underscore"));
-    
-    // Тестирование невалидных путей
-    assert(!isValidFilePath("invalid|path"));
-    assert(!isValidFilePath("path with spaces"));
-    assert(!isValidFilePath("<invalid>path"));
-}
+    // Стенд платы boardName со слотом slot и меткой label теперь освобождается в freeTime
+    // Слот и метка не меняются при удалении других стендов, в отличие от индекса стенда
+    virtual void standChanged(const std::string& boardName, uint32_t slot, const std::string& label,
+                              std::chrono::system_clock::time_point freeTime) = 0;
+};
 
-// Функция проверки группы
-bool isValidGroup(const std::string& group) {
-    // Проверка на строку, состоящую из букв (русских и латинских) и цифр
-    std::regex groupPattern("^[a-zA-Zа-яА-Я0-9]+$");
+// Календарь бронирований стенда: отсортированный плоский массив непересекающихся интервалов [начало, конец)
+// До floor стенд занят заданиями, о которых календарь не знает (начальная занятость, ручной сдвиг времени)
+class StandCalendar {
+public:
+    using Time = std::chrono::system_clock::time_point;
 
-    return std::regex_match(group, groupPattern);
-}
+    struct Slot {
+        Time start;
+        Time end;
+    };
 
-// Тесты для функции проверки группы
-void testIsValidGroup() {
-    // Тестирование валидных групп
-    assert(isValidGroup("Group123"));
-    assert(isValidGroup("Group01"));
-    assert(isValidGroup("12345"));
-    
-    // Тестирование невалидных групп
-    assert(!isValidGroup("Group@123"));
-    assert(!isValidGroup("Invalid Group"));
-    assert(!isValidGroup("Group#123"));
-}
+private:
+    Time floor;
+    std::vector<Slot> slots;
+    // Количество промежутков между соседними бронированиями
+    size_t holes = 0;
+
+    // Есть ли промежуток между двумя соседними бронированиями
+    static bool hole(const Slot& first, const Slot& second) {
+        return first.end < second.start;
+    }
 
-// Функция проверки имени
-bool isValidName(const std::string& name) {
-    // Регулярное выражение для проверки только букв (латинских и кириллических) без пробелов
-    std::regex namePattern("^[a-zA-Zа-яА-ЯёЁрРчЧьЬъЪ]+$");
+    // Учёт промежутков вокруг бронирования it: sign = 1 при вставке, -1 при удалении
+    void countHoles(std::vector<Slot>::const_iterator it, int sign) {
+        bool hasPrev = it != slots.begin();
+        bool hasNext = it + 1 != slots.end();
+        int delta = (hasPrev && hole(*(it - 1), *it)) + (hasNext && hole(*it, *(it + 1))) -
+                    (hasPrev && hasNext && hole(*(it - 1), *(it + 1)));
+        holes += sign * delta;
+    }
 
-    // Используем std::regex_match для проверки строки
-    return std::regex_match(name, namePattern);
-}
+public:
+    explicit StandCalendar(Time floor = Time()) : floor(floor) {}
 
-// Тесты для функции проверки имени
-void testIsValidName() {
-    // Тестирование валидных имен
-    assert(isValidName("John"));
-    assert(isValidName("Смирнов"));
-    assert(isValidName("JaneDoe"));
-    
-    // Тестирование невалидных имен
+    // Окончание последнего бронирования
+    Time tail() const {
+        return slots.empty() ? floor : std::max(floor, slots.back().end);
+    }
+
+    // Количество бронирований
+    size_t size() const {
+        return slots.size();
+    }
+
+    // Сброс календаря: стенд занят до time
+    void reset(Time time) {
+        slots.clear();
+        floor = time;
+        holes = 0;
+    }
+
+    // Удаление завершившихся бронирований; окончание календаря при этом не уменьшается
+    void trim(Time now) {
+        size_t expired = 0;
+
+        while (expired < slots.size() && slots[expired].end <= now) {
+            floor = std::max(floor, slots[expired].end);
+
+            if (expired + 1 < slots.size() && hole(slots[expired], slots[expired + 1])) {
+                --holes;
+            }
+
+            ++expired;
+        }
+
+        slots.erase(slots.begin(), slots.begin() + expired);
+    }
+
+    // Самое раннее начало не раньше from, при котором задание длины length не пересекается с бронированиями
+    Time earliestFit(Time from, std::chrono::system_clock::duration length) const {
+        Time start = std::max(from, floor);
+        auto it = std::upper_bound(slots.begin(), slots.end(), start,
+                                   [](Time time, const Slot& slot) { return time < slot.end; });
+
+        for (; it != slots.end(); ++it) {
+            if (it->start >= start + length) {
+                break;
+            }
+
+            start = std::max(start, it->end);
+        }
+
+        return start;
+    }
+
+    // Есть ли свободное время между now и окончанием календаря
+    // Без промежутков между бронированиями проверяется только начало первого, иначе календарь просматривается
+    bool hasGapAfter(Time now) const {
+        Time time = std::max(now, floor);
+
+        if (holes == 0) {
+            return !slots.empty() && slots.front().start > time;
+        }
+
+        for (const auto& slot : slots) {
+            if (slot.end <= time) {
+                continue;
+            }
+
+            if (slot.start > time) {
+                return true;
+            }
+
+            time = slot.end;
+        }
+
+        return false;
+    }
+
+    // Бронирование интервала (свободность проверяется вызывающим через earliestFit)
+    void book(Time start, Time end) {
+        auto it = std::lower_bound(slots.begin(), slots.end(), start,
+                                   [](const Slot& slot, Time time) { return slot.start < time; });
+        countHoles(slots.insert(it, Slot{start, end}), 1);
+    }
+
+    // Изменение окончания бронирования, начавшегося в start; продление не заходит на следующее бронирование
+    // Бронирование нулевой длины удаляется. Возвращает false, если бронирования нет
+    bool resize(Time start, Time end) {
+        auto it = std::lower_bound(slots.begin(), slots.end(), start,
+                                   [](const Slot& slot, Time time) { return slot.start < time; });
+
+        if (it == slots.end() || it->start != start) {
+            return false;
+        }
+
+        if (it + 1 != slots.end()) {
+            end = std::min(end, (it + 1)->start);
+        }
+
+        countHoles(it, -1);
+
+        if (end <= start) {
+            slots.erase(it);
+        } else {
+            it->end = end;
+            countHoles(it, 1);
+        }
+
+        return true;
+    }
+
+    // Продление бронирования [start, end) до until, когда задание работает дольше предсказанного
+    // Бронирования, начинающиеся раньше until, снимаются и дописываются в displaced (их переносит вызывающий);
+    // бронирование, уже удалённое trim, восстанавливается от end
+    void extend(Time start, Time end, Time until, std::vector<Slot>& displaced) {
+        auto it = std::lower_bound(slots.begin(), slots.end(), start,
+                                   [](const Slot& slot, Time time) { return slot.start < time; });
+
+        if (it == slots.end() || it->start != start) {
+            it = std::lower_bound(slots.begin(), slots.end(), end, [](const Slot& slot, Time time) { return slot.start < time; });
+            it = slots.insert(it, Slot{end, end});
+        }
+
+        auto next = it + 1;
+
+        while (next != slots.end() && next->start < until) {
+            displaced.push_back(*next);
+            ++next;
+        }
+
+        it->end = std::max(it->end, until);
+        slots.erase(it + 1, next);
+        holes = 0;
+
+        for (size_t i = 1; i < slots.size(); ++i) {
+            holes += hole(slots[i - 1], slots[i]);
+        }
+    }
+
+    // Освобождение брони, начавшейся в start: будущая бронь удаляется, выполняющаяся обрезается до now
+    // Возвращает false, если брони нет или она уже закончилась
+    bool release(Time start, Time now) {
+        auto it = std::lower_bound(slots.begin(), slots.end(), start,
+                                   [](const Slot& slot, Time time) { return slot.start < time; });
+
+        if (it == slots.end() || it->start != start || it->end <= now) {
+            return false;
+        }
+
+        return resize(start, std::max(start, now));
+    }
+};
+
+// Номер платы в кластере (названия плат интернируются при добавлении первого стенда)
+using BoardId = uint32_t;
+
+// Постоянный номер стенда: плата, слот и поколение слота
+// Индекс стенда в массивах платы меняется при удалении других стендов, номер - нет
+// Поколение слота увеличивается при удалении стенда, поэтому номер удалённого стенда не указывает на новый стенд
+struct StandHandle {
+    BoardId board = 0;
+    uint32_t slot = 0;
+    // Поколение 0 не выдаётся: номер по умолчанию не указывает ни на какой стенд
+    uint32_t generation = 0;
+
+    bool operator==(const StandHandle& other) const {
+        return board == other.board && slot == other.slot && generation == other.generation;
+    }
+};
+
+// Стенды одной платы вместе с кучей по времени освобождения
+// Каждая плата - отдельный шард со своей блокировкой, заявки на разные платы не конкурируют
+// Стенды хранятся по столбцам (StandColumn): времена освобождения лежат сегментами подряд, название платы хранится один раз
+// Время освобождения стенда - окончание его календаря, куча по нему даёт стенд для добавления в конец
+// Стенды со свободными промежутками отмечены в listed, перечислены в gapped и проверяются при бронировании отдельно
+struct BoardStands {
+    std::string name;
+    StandColumn<std::chrono::system_clock::time_point> freeTimes;
+    StandColumn<StandCalendar> calendars;
+    StandColumn<uint8_t> listed;
+    std::vector<uint32_t> gapped;
+    StandHeap heap;
+    // Слоты постоянных номеров: slotOf[индекс] - слот стенда, slots[слот] - индекс стенда, generations[слот] - поколение
+    StandColumn<uint32_t> slotOf;
+    StandColumn<uint32_t> slots;
+    StandColumn<uint32_t> generations;
+    std::vector<uint32_t> freeSlots;
+    // Метки стендов топологии по слотам: номер n нумерованного стенда "#n" (0 - нет) и явные метки
+    // Метка (у стенда вне топологии - слот) - ключ стенда в журнале состояния, не зависящий от индекса
+    // Нумерованный стенд стоит 4 байта, строки хранятся только для явных меток
+    StandColumn<uint32_t> numbers;
+    std::unordered_map<uint32_t, std::string> names;
+    BoardId id = 0;
+    mutable std::mutex mutex;
+
+    BoardStands() = default;
+
+    // Конструктор копирования (копируются стенды, блокировка у копии своя)
+    BoardStands(const BoardStands& other) {
+        std::lock_guard<std::mutex> lock(other.mutex);
+        name = other.name;
+        freeTimes = other.freeTimes;
+        calendars = other.calendars;
+        listed = other.listed;
+        gapped = other.gapped;
+        heap = other.heap;
+        slotOf = other.slotOf;
+        slots = other.slots;
+        generations = other.generations;
+        freeSlots = other.freeSlots;
+        numbers = other.numbers;
+        names = other.names;
+        id = other.id;
+    }
+
+    // Выделение слота для стенда, только что добавленного в конец массивов
+    void addSlot() {
+        uint32_t index = static_cast<uint32_t>(freeTimes.size() - 1);
+
+        if (!freeSlots.empty()) {
+            slotOf.push_back(freeSlots.back());
+            freeSlots.pop_back();
+            slots[slotOf.back()] = index;
+        } else {
+            slotOf.push_back(static_cast<uint32_t>(slots.size()));
+            slots.push_back(index);
+            generations.push_back(1);
+            numbers.push_back(0);
+        }
+    }
+
+    // Добавление стенда со временем освобождения freeTime в конец массивов
+    void append(std::chrono::system_clock::time_point freeTime) {
+        freeTimes.push_back(freeTime);
+        calendars.push_back(StandCalendar(freeTime));
+        listed.push_back(0);
+        heap.push(freeTimes);
+        addSlot();
+    }
+
+    // Резервирование места под extra новых стендов во всех массивах
+    void reserve(size_t extra) {
+        size_t count = freeTimes.size() + extra;
+
+        freeTimes.reserve(count);
+        calendars.reserve(count);
+        listed.reserve(count);
+        heap.reserve(count);
+        slotOf.reserve(count);
+        slots.reserve(slots.size() + extra);
+        generations.reserve(generations.size() + extra);
+        numbers.reserve(numbers.size() + extra);
+    }
+
+    // Ёмкость столбцов стендов (без выделения памяти)
+    size_t capacity() const {
+        return std::min({freeTimes.capacity(), calendars.capacity(), listed.capacity(), slotOf.capacity(), heap.capacity()});
+    }
+
+    // Ёмкость столбцов слотов (без выделения памяти)
+    size_t slotCapacity() const {
+        return std::min({slots.capacity(), generations.capacity(), numbers.capacity()});
+    }
+
+    // Сколько стендов можно добавить без выделения памяти
+    size_t spare() const {
+        return std::min(capacity() - freeTimes.size(), slotCapacity() - slots.size() + freeSlots.size());
+    }
+
+    // Выделение в пустом хранилище сегментов, которых столбцам ёмкости from (стенды) и slotsFrom (слоты)
+    // не хватает до count стендов и slotCount слотов. Выполняется вне блокировки шарда
+    void prepare(size_t from, size_t count, size_t slotsFrom, size_t slotCount) {
+        freeTimes.prepare(from, count);
+        calendars.prepare(from, count);
+        listed.prepare(from, count);
+        heap.prepare(from, count);
+        slotOf.prepare(from, count);
+        slots.prepare(slotsFrom, slotCount);
+        generations.prepare(slotsFrom, slotCount);
+        numbers.prepare(slotsFrom, slotCount);
+    }
+
+    // Подключение сегментов, подготовленных в storage (под блокировкой шарда, без выделений и переноса стендов)
+    void adopt(BoardStands& storage) {
+        freeTimes.adopt(storage.freeTimes);
+        calendars.adopt(storage.calendars);
+        listed.adopt(storage.listed);
+        heap.adopt(storage.heap);
+        slotOf.adopt(storage.slotOf);
+        slots.adopt(storage.slots);
+        generations.adopt(storage.generations);
+        numbers.adopt(storage.numbers);
+    }
+
+    // Освобождение слота удалённого стенда: его номер и метка становятся недействительными
+    void releaseSlot(uint32_t slot) {
+        ++generations[slot];
+
+        if (numbers[slot] == 0) {
+            names.erase(slot);
+        }
+
+        numbers[slot] = 0;
+        freeSlots.push_back(slot);
+    }
+
+    // Метка стенда со слотом slot (пустая - стенд добавлен не через топологию)
+    std::string slotLabel(uint32_t slot) const {
+        if (numbers[slot] != 0) {
+            return "#" + std::to_string(numbers[slot]);
+        }
+
+        auto it = names.find(slot);
+        return it == names.end() ? std::string() : it->second;
+    }
+
+    // Установка метки стенда со слотом slot: "#n" - нумерованный стенд, иначе явная метка
+    void setLabel(uint32_t slot, std::string label) {
+        uint32_t number = 0;
+
+        if (!label.empty() && label.front() == '#') {
+            std::from_chars(label.data() + 1, label.data() + label.size(), number);
+        }
+
+        numbers[slot] = number;
+
+        if (number == 0) {
+            names[slot] = std::move(label);
+        }
+    }
+
+    // Постоянный номер стенда с индексом index
+    StandHandle handle(size_t index) const {
+        uint32_t slot = slotOf[index];
+        return StandHandle{id, slot, generations[slot]};
+    }
+
+    // Индекс стенда по постоянному номеру за O(1); false, если стенд удалён
+    bool find(const StandHandle& handle, size_t& index) const {
+        if (handle.board != id || handle.slot >= generations.size() || generations[handle.slot] != handle.generation) {
+            return false;
+        }
+
+        index = slots[handle.slot];
+        return true;
+    }
+
+    // Стенды платы в виде объектов RemoteStand (собираются по запросу)
+    std::vector<RemoteStand> standsCopy() const {
+        std::vector<RemoteStand> result;
+        result.reserve(freeTimes.size());
+
+        for (size_t i = 0; i < freeTimes.size(); ++i) {
+            result.emplace_back(name, freeTimes[i]);
+        }
+
+        return result;
+    }
+
+    // Удаление всех стендов платы
+    void clear() {
+        for (size_t i = 0; i < slotOf.size(); ++i) {
+            releaseSlot(slotOf[i]);
+        }
+
+        freeTimes.clear();
+        calendars.clear();
+        listed.clear();
+        gapped.clear();
+        heap.clear();
+        slotOf.clear();
+    }
+
+    // Память стендов платы в байтах (без учёта бронирований в календарях)
+    size_t memoryUsage() const {
+        return freeTimes.memoryUsage() + calendars.memoryUsage() + listed.memoryUsage() + heap.memoryUsage() +
+               slotOf.memoryUsage() + slots.memoryUsage() + generations.memoryUsage() + numbers.memoryUsage() +
+               (gapped.capacity() + freeSlots.capacity()) * sizeof(uint32_t) +
+               names.size() * (sizeof(std::pair<uint32_t, std::string>) + 2 * sizeof(void*));
+    }
+};
+
+// Результат бронирования стенда
+struct Reservation {
+    // Индекс стенда в векторе платы в момент бронирования и постоянный номер стенда
+    size_t standIndex = 0;
+    StandHandle stand;
+    // Начало и окончание выполнения задания
+    std::chrono::system_clock::time_point startTime;
+    std::chrono::system_clock::time_point freeTime;
+};
+
+// Время освобождения стенда с ключом стенда в журнале состояния: меткой топологии или, без метки, слотом
+struct StandState {
+    uint32_t slot = 0;
+    std::string label;
+    std::chrono::system_clock::time_point freeTime;
+};
+
+// Итог пакетного изменения стендов: сколько стендов изменено, сколько из удалённых было занято или забронировано,
+// и наибольшее время удержания блокировки шарда (столько могла ждать заявка на ту же плату)
+struct StandBatchResult {
+    size_t changed = 0;
+    size_t busy = 0;
+    std::chrono::nanoseconds longestHold{0};
+};
+
+// Справочник плат кластера: шарды по номерам и таблица с открытой адресацией по названиям
+// Читатели берут справочник одной атомарной загрузкой и ищут в нём без блокировок (RCU)
+// Писатель дописывает плату на свободное место: шард заполнен до публикации, а ячейки записываются
+// с release-упорядочиванием, поэтому читатель видит либо пустую ячейку, либо готовый шард
+struct BoardDirectory {
+    // Ячейки по номерам плат и по хешу названия (таблица названий заполнена не больше чем наполовину)
+    std::vector<std::atomic<BoardStands*>> byId;
+    std::vector<std::atomic<BoardStands*>> byName;
+    std::atomic<size_t> count{0};
+
+    // Справочник на capacity плат (capacity - степень двойки)
+    explicit BoardDirectory(size_t capacity) : byId(capacity), byName(capacity * 2) {}
+
+    // Количество опубликованных плат
+    size_t size() const {
+        return count.load(std::memory_order_acquire);
+    }
+
+    // Есть ли место для ещё одной платы
+    bool full() const {
+        return size() == byId.size();
+    }
+
+    // Шард платы по номеру (nullptr, если такой платы нет)
+    BoardStands* find(BoardId id) const {
+        return id < byId.size() ? byId[id].load(std::memory_order_acquire) : nullptr;
+    }
+
+    // Шард платы по названию (nullptr, если такой платы нет)
+    BoardStands* find(std::string_view name) const {
+        size_t mask = byName.size() - 1;
+
+        for (size_t i = std::hash<std::string_view>()(name) & mask;; i = (i + 1) & mask) {
+            BoardStands* board = byName[i].load(std::memory_order_acquire);
+
+            if (!board || board->name == name) {
+                return board;
+            }
+        }
+    }
+
+    // Публикация шарда с номером board->id (только писателем, номера идут подряд)
+    void insert(BoardStands* board) {
+        size_t mask = byName.size() - 1;
+        size_t i = std::hash<std::string_view>()(board->name) & mask;
+
+        while (byName[i].load(std::memory_order_relaxed)) {
+            i = (i + 1) & mask;
+        }
+
+        byId[board->id].store(board, std::memory_order_release);
+        byName[i].store(board, std::memory_order_release);
+        count.store(board->id + 1, std::memory_order_release);
+    }
+};
+
+// Счётчики читателей справочника плат для периода ожидания RCU
+// Читатель отмечается в полосе своего потока по чётности текущей эпохи; писатель меняет эпоху и ждёт,
+// пока обнулятся счётчики прежней чётности: после этого ни один читатель не держит снятые с публикации шарды
+class ReaderEpochs {
+private:
+    struct alignas(64) Stripe {
+        std::array<std::atomic<uint64_t>, 2> counts{};
+    };
+
+    std::array<Stripe, CLUSTER_READER_STRIPES> stripes{};
+    std::atomic<uint64_t> epoch{0};
+    // Ожидания периода выполняются по одному: за одну смену эпохи ждут только читателей прежней чётности
+    std::mutex waitMutex;
+
+    // Полоса потока (раздаются по кругу при первом обращении)
+    static size_t stripe() {
+        static std::atomic<size_t> next{0};
+        thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % CLUSTER_READER_STRIPES;
+        return index;
+    }
+
+public:
+    // Участок чтения: пока он открыт, снятые с публикации справочники и шарды не освобождаются
+    class Section {
+    private:
+        std::atomic<uint64_t>* counter;
+
+    public:
+        explicit Section(ReaderEpochs& epochs) {
+            Stripe& own = epochs.stripes[stripe()];
+
+            // Если эпоха сменилась между чтением и отметкой, писатель мог уже проверить эту чётность
+            for (;;) {
+                uint64_t current = epochs.epoch.load();
+                counter = &own.counts[current & 1];
+                counter->fetch_add(1);
+
+                if (epochs.epoch.load() == current) {
+                    break;
+                }
+
+                counter->fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        ~Section() {
+            counter->fetch_sub(1, std::memory_order_release);
+        }
+
+        Section(const Section&) = delete;
+        Section& operator=(const Section&) = delete;
+    };
+
+    // Ожидание завершения участков чтения, открытых до вызова (нельзя вызывать внутри участка)
+    void synchronize() {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        uint64_t previous = epoch.fetch_add(1) & 1;
+
+        for (;;) {
+            uint64_t active = 0;
+
+            for (const auto& own : stripes) {
+                active += own.counts[previous].load(std::memory_order_acquire);
+            }
+
+            if (active == 0) {
+                return;
+            }
+
+            std::this_thread::yield();
+        }
+    }
+};
+
+// Класс кластера стендов
+// Стенды каждой платы защищены блокировкой своего шарда, набор плат - справочник, публикуемый по схеме RCU:
+// заявки находят шард без блокировок, а добавление плат и смена топологии не останавливают планирование
+// Платы доступны по названию и по номеру; номера не меняются, пока существует кластер
+class StandCluster {
+private:
+    // Текущий справочник плат; при нехватке места публикуется копия вдвое большего размера
+    std::atomic<BoardDirectory*> directory{nullptr};
+    // Опубликованные справочники и шарды кластера (под topologyMutex). Вдвое растущие копии справочника
+    // живут до копирования кластера (в сумме они не больше текущей), прежние шарды копирование освобождает
+    // после периода ожидания readers
+    std::vector<std::unique_ptr<BoardDirectory>> directories;
+    std::vector<std::unique_ptr<BoardStands>> shards;
+    // Участки чтения справочника: каждый открытый метод открывает участок до поиска шарда
+    mutable ReaderEpochs readers;
+    // Блокировка писателей справочника
+    mutable std::mutex topologyMutex;
+
+    // Получатель изменений (не копируется вместе с кластером)
+    std::atomic<StandChangeListener*> listener{nullptr};
+
+    // Сообщение получателю об изменении стенда (вызывается под блокировкой шарда)
+    void notifyChanged(const BoardStands& board, size_t index, std::chrono::system_clock::time_point freeTime) {
+        StandChangeListener* current = listener.load(std::memory_order_acquire);
+
+        if (current) {
+            uint32_t slot = board.slotOf[index];
+            current->standChanged(board.name, slot, board.slotLabel(slot), freeTime);
+        }
+    }
+
+    // Синхронизация времени освобождения стенда с окончанием его календаря (под блокировкой шарда)
+    void syncFreeTime(BoardStands& board, size_t index) {
+        auto tail = board.calendars[index].tail();
+
+        if (board.freeTimes[index] != tail) {
+            board.freeTimes[index] = tail;
+            board.heap.update(board.freeTimes, index);
+            notifyChanged(board, index, tail);
+        }
+    }
+
+    // Прямая установка времени освобождения: календарь сворачивается в занятость до этого времени
+    void setFreeTime(BoardStands& board, size_t index, std::chrono::system_clock::time_point time) {
+        board.calendars[index].reset(time);
+        board.freeTimes[index] = time;
+        board.heap.update(board.freeTimes, index);
+        notifyChanged(board, index, time);
+    }
+
+    // Добавление стенда в список стендов со свободными промежутками после now
+    static void trackGaps(BoardStands& board, size_t index, std::chrono::system_clock::time_point now) {
+        if (!board.listed[index] && board.calendars[index].hasGapAfter(now)) {
+            board.listed[index] = 1;
+            board.gapped.push_back(static_cast<uint32_t>(index));
+        }
+    }
+
+    // Поиск стенда, в промежутке которого задание длины length начинается раньше всего (не раньше from)
+    // Стенды, промежутки которых уже прошли, удаляются из списка. Возвращает false, если промежутков нет
+    static bool findGap(BoardStands& board, std::chrono::system_clock::time_point now, std::chrono::system_clock::time_point from,
+                        std::chrono::system_clock::duration length, size_t& index, std::chrono::system_clock::time_point& start) {
+        bool found = false;
+
+        for (size_t i = 0; i < board.gapped.size();) {
+            size_t candidate = board.gapped[i];
+            StandCalendar& calendar = board.calendars[candidate];
+            calendar.trim(now);
+
+            if (!calendar.hasGapAfter(now)) {
+                board.listed[candidate] = 0;
+                board.gapped[i] = board.gapped.back();
+                board.gapped.pop_back();
+                continue;
+            }
+
+            auto fit = calendar.earliestFit(from, length);
+
+            // Промежуток, в который задание не помещается, не лучше добавления в конец календаря
+            if (fit < calendar.tail() && (!found || fit < start || (fit == start && candidate < index))) {
+                found = true;
+                index = candidate;
+                start = fit;
+            }
+
+            ++i;
+        }
+
+        return found;
+    }
+
+    // Бронирование интервала в календаре стенда (под блокировкой шарда)
+    void bookSlot(BoardStands& board, size_t index, std::chrono::system_clock::time_point now,
+                  std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point end) {
+        StandCalendar& calendar = board.calendars[index];
+
+        calendar.trim(now);
+        calendar.book(start, end);
+        syncFreeTime(board, index);
+        trackGaps(board, index, now);
+    }
+
+    // Бронирование самого раннего подходящего интервала на стендах шарда (под блокировкой шарда)
+    // Задание начинается не раньше from (по умолчанию - сейчас)
+    bool reserveIn(BoardStands& board, std::chrono::system_clock::time_point now, std::chrono::system_clock::duration duration,
+                   Reservation& reservation, std::chrono::system_clock::time_point latestStart,
+                   std::chrono::system_clock::time_point from = std::chrono::system_clock::time_point()) {
+        if (board.heap.empty()) {
+            return false;
+        }
+
+        // Свободный стенд начинает задание сейчас, занятый - после окончания текущих заданий
+        from = std::max(from, now);
+        size_t index = board.heap.top();
+        auto start = std::max(board.freeTimes[index], from);
+        size_t gapIndex = 0;
+        std::chrono::system_clock::time_point gapStart;
+
+        if (!board.gapped.empty() && findGap(board, now, from, duration, gapIndex, gapStart) && gapStart <= start) {
+            index = gapIndex;
+            start = gapStart;
+        }
+
+        if (start > latestStart) {
+            reservation.startTime = start;
+            return false;
+        }
+
+        reservation.standIndex = index;
+        reservation.stand = board.handle(index);
+        reservation.startTime = start;
+        reservation.freeTime = start + duration;
+        bookSlot(board, index, now, reservation.startTime, reservation.freeTime);
+        return true;
+    }
+
+    // Бронирование стенда шарда на заданное время start (под блокировкой шарда)
+    // Сначала ищется промежуток в календарях, затем стенд, освобождающийся не позже start
+    bool placeAt(BoardStands& board, std::chrono::system_clock::time_point now, std::chrono::system_clock::time_point start,
+                 std::chrono::system_clock::duration duration, Reservation& reservation) {
+        if (board.heap.empty()) {
+            return false;
+        }
+
+        size_t index;
+        std::chrono::system_clock::time_point gapStart;
+
+        if (!findGap(board, now, start, duration, index, gapStart) || gapStart != start) {
+            index = board.heap.top();
+
+            if (board.freeTimes[index] > start) {
+                return false;
+            }
+        }
+
+        reservation.standIndex = index;
+        reservation.stand = board.handle(index);
+        reservation.startTime = start;
+        reservation.freeTime = start + duration;
+        bookSlot(board, index, now, reservation.startTime, reservation.freeTime);
+        return true;
+    }
+
+    // Текущий индекс стенда брони: по постоянному номеру, а у брони без номера - по индексу (под блокировкой шарда)
+    static bool locate(const BoardStands& board, const Reservation& reservation, size_t& index) {
+        if (reservation.stand.generation != 0) {
+            return board.find(reservation.stand, index);
+        }
+
+        index = reservation.standIndex;
+        return index < board.freeTimes.size();
+    }
+
+    // Удаление стенда index за O(log n): на его место переносится последний стенд платы (под блокировкой шарда)
+    void eraseStand(BoardStands& board, size_t index) {
+        size_t last = board.freeTimes.size() - 1;
+        uint32_t slot = board.slotOf[index];
+
+        // Список стендов с промежутками короткий, номера в нём исправляются перебором
+        for (size_t i = 0; i < board.gapped.size();) {
+            if (board.gapped[i] == index) {
+                board.gapped[i] = board.gapped.back();
+                board.gapped.pop_back();
+                continue;
+            }
+
+            if (board.gapped[i] == last) {
+                board.gapped[i] = static_cast<uint32_t>(index);
+            }
+
+            ++i;
+        }
+
+        board.heap.erase(board.freeTimes, index);
+
+        if (index != last) {
+            board.freeTimes[index] = board.freeTimes[last];
+            board.calendars[index] = std::move(board.calendars[last]);
+            board.listed[index] = board.listed[last];
+            board.slotOf[index] = board.slotOf[last];
+            board.slots[board.slotOf[index]] = static_cast<uint32_t>(index);
+        }
+
+        board.freeTimes.pop_back();
+        board.calendars.pop_back();
+        board.listed.pop_back();
+        board.slotOf.pop_back();
+        board.releaseSlot(slot);
+    }
+
+    // Текущий справочник плат (без блокировок)
+    const BoardDirectory& view() const {
+        return *directory.load(std::memory_order_acquire);
+    }
+
+    // Поиск шарда платы по названию (без блокировок)
+    BoardStands* findBoard(std::string_view boardName) const {
+        return view().find(boardName);
+    }
+
+    // Поиск шарда платы по номеру (без блокировок)
+    BoardStands* findBoard(BoardId id) const {
+        return view().find(id);
+    }
+
+    // Шард существующей платы; для неизвестной платы - исключение std::out_of_range
+    BoardStands& boardAt(std::string_view boardName) const {
+        BoardStands* board = findBoard(boardName);
+
+        if (!board) {
+            throw std::out_of_range("Неизвестная плата: " + std::string(boardName));
+        }
+
+        return *board;
+    }
+
+    // Проверка номера стенда платы (под блокировкой шарда)
+    static size_t checkedIndex(const BoardStands& board, size_t index) {
+        if (index >= board.freeTimes.size()) {
+            throw std::out_of_range("Нет стенда " + std::to_string(index) + " на плате " + board.name);
+        }
+
+        return index;
+    }
+
+    // Публикация справочника (под topologyMutex)
+    void publish(std::unique_ptr<BoardDirectory> published) {
+        directories.push_back(std::move(published));
+        directory.store(directories.back().get(), std::memory_order_release);
+    }
+
+    // Публикация заполненного шарда новой платы (под topologyMutex), возвращает опубликованный шард
+    BoardStands* publishBoard(std::unique_ptr<BoardStands> board) {
+        const BoardDirectory& current = view();
+        board->id = static_cast<BoardId>(current.size());
+
+        if (current.full()) {
+            auto grown = std::make_unique<BoardDirectory>(current.byId.size() * 2);
+
+            for (size_t i = 0; i < current.size(); ++i) {
+                grown->insert(current.find(static_cast<BoardId>(i)));
+            }
+
+            publish(std::move(grown));
+        }
+
+        shards.push_back(std::move(board));
+        directories.back()->insert(shards.back().get());
+        return shards.back().get();
+    }
+
+    // Копия всех стендов по платам для сравнения кластеров (платы без стендов не учитываются)
+    std::map<std::string, std::vector<RemoteStand>> snapshot() const {
+        ReaderEpochs::Section section(readers);
+        const BoardDirectory& boards = view();
+        std::map<std::string, std::vector<RemoteStand>> result;
+
+        for (size_t i = 0; i < boards.size(); ++i) {
+            const BoardStands* board = boards.find(static_cast<BoardId>(i));
+            std::lock_guard<std::mutex> lock(board->mutex);
+
+            if (!board->freeTimes.empty()) {
+                result[board->name] = board->standsCopy();
+            }
+        }
+
+        return result;
+    }
+
+    // Копирование шардов другого кластера: копии публикуются новым справочником,
+    // прежние справочники и шарды освобождаются, когда завершатся начатые до публикации участки чтения
+    void copyFrom(const StandCluster& other) {
+        std::vector<std::unique_ptr<BoardStands>> copy;
+
+        {
+            ReaderEpochs::Section section(other.readers);
+            const BoardDirectory& source = other.view();
+
+            for (size_t i = 0; i < source.size(); ++i) {
+                copy.push_back(std::make_unique<BoardStands>(*source.find(static_cast<BoardId>(i))));
+            }
+        }
+
+        size_t capacity = BOARD_DIRECTORY_CAPACITY;
+
+        while (capacity < copy.size()) {
+            capacity *= 2;
+        }
+
+        std::vector<std::unique_ptr<BoardDirectory>> retiredDirectories;
+        std::vector<std::unique_ptr<BoardStands>> retiredShards;
+
+        {
+            std::lock_guard<std::mutex> lock(topologyMutex);
+            auto copied = std::make_unique<BoardDirectory>(capacity);
+
+            for (auto& board : copy) {
+                copied->insert(board.get());
+            }
+
+            retiredDirectories.swap(directories);
+            retiredShards.swap(shards);
+            shards = std::move(copy);
+            publish(std::move(copied));
+        }
+
+        // Ожидание вне topologyMutex: участок чтения может ждать его при добавлении платы
+        readers.synchronize();
+    }
+
+
+public:
+    // Конструктор по умолчанию
+    StandCluster() {
+        publish(std::make_unique<BoardDirectory>(BOARD_DIRECTORY_CAPACITY));
+    }
+
+    // Конструктор копирования
+    StandCluster(const StandCluster& other) {
+        copyFrom(other);
+    }
+
+    // Деструктор
+    ~StandCluster() = default;
+
+    // Номер платы по названию; false, если стендов этой платы в кластере не было
+    bool boardId(std::string_view boardName, BoardId& id) const {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(boardName);
+
+        if (!board) {
+            return false;
+        }
+
+        id = board->id;
+        return true;
+    }
+
+    // Метод для добавления стенда в кластер, возвращает постоянный номер стенда
+    StandHandle addStand(const RemoteStand& stand) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(stand.getBoardName());
+
+        if (!board) {
+            std::lock_guard<std::mutex> topologyLock(topologyMutex);
+            board = findBoard(stand.getBoardName());
+
+            if (!board) {
+                auto created = std::make_unique<BoardStands>();
+                created->name = stand.getBoardName();
+                board = publishBoard(std::move(created));
+            }
+        }
+
+        // Шард не освобождается, пока открыт участок чтения, поэтому указатель остаётся действительным
+        std::lock_guard<std::mutex> lock(board->mutex);
+        board->append(stand.getFreeTime());
+        return board->handle(board->freeTimes.size() - 1);
+    }
+
+    // Удаление стенда по постоянному номеру за O(log n); false, если стенд уже удалён
+    // Последний стенд платы занимает индекс удалённого, номера остальных стендов не меняются
+    bool removeStand(const StandHandle& handle) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(handle.board);
+        size_t index;
+
+        if (!board) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+
+        if (!board->find(handle, index)) {
+            return false;
+        }
+
+        eraseStand(*board, index);
+        return true;
+    }
+
+    // Добавление count стендов платы, свободных с freeTime; постоянные номера стендов дописываются в handles,
+    // label(i), если задана, даёт метку i-го добавленного стенда (см. BoardStands::labels)
+    // Шард новой платы заполняется целиком до публикации, и заявки его не ждут. В существующую плату стенды
+    // добавляются порциями по TOPOLOGY_BATCH с отпусканием блокировки шарда между порциями. Если места не хватает,
+    // сегменты столбцов под все добавляемые стенды с запасом в 1/TOPOLOGY_HEADROOM выделяются и заполняются
+    // вне блокировки, а под ней только подключаются: стенды не переносятся, и пауза не зависит от размера платы
+    StandBatchResult addStands(const std::string& boardName, size_t count, std::chrono::system_clock::time_point freeTime,
+                               std::vector<StandHandle>& handles, const std::function<std::string(size_t)>& label = nullptr) {
+        ReaderEpochs::Section section(readers);
+        using namespace std::chrono;
+
+        StandBatchResult result;
+        BoardStands* board = findBoard(boardName);
+
+        if (!board) {
+            std::lock_guard<std::mutex> topologyLock(topologyMutex);
+            board = findBoard(boardName);
+
+            if (!board) {
+                auto created = std::make_unique<BoardStands>();
+                created->name = boardName;
+                created->id = static_cast<BoardId>(view().size());
+                created->reserve(count + count / TOPOLOGY_HEADROOM);
+
+                for (size_t i = 0; i < count; ++i) {
+                    created->append(freeTime);
+                    handles.push_back(created->handle(i));
+
+                    if (label) {
+                        created->setLabel(created->slotOf[i], label(i));
+                    }
+                }
+
+                publishBoard(std::move(created));
+                result.changed = count;
+                return result;
+            }
+        }
+
+        BoardStands storage;
+
+        while (result.changed < count) {
+            std::unique_lock<std::mutex> lock(board->mutex);
+            auto start = steady_clock::now();
+            size_t batch = std::min<size_t>(count - result.changed, TOPOLOGY_BATCH);
+
+            if (board->spare() < batch) {
+                board->adopt(storage);
+            }
+
+            if (board->spare() < batch) {
+                // Плата могла вырасти, пока сегменты выделялись: ёмкость проверяется снова под блокировкой
+                size_t extra = count - result.changed;
+                size_t from = board->capacity();
+                size_t needed = board->freeTimes.size() + extra + (board->freeTimes.size() + extra) / TOPOLOGY_HEADROOM;
+                size_t slotsFrom = board->slotCapacity();
+                size_t slotsNeeded = board->slots.size() + needed - board->freeTimes.size();
+                lock.unlock();
+                storage.prepare(from, needed, slotsFrom, slotsNeeded);
+                continue;
+            }
+
+            for (size_t i = 0; i < batch; ++i) {
+                board->append(freeTime);
+                handles.push_back(board->handle(board->freeTimes.size() - 1));
+
+                if (label) {
+                    board->setLabel(board->slotOf.back(), label(result.changed + i));
+                }
+            }
+
+            result.changed += batch;
+            result.longestHold = std::max<nanoseconds>(result.longestHold, steady_clock::now() - start);
+        }
+
+        return result;
+    }
+
+    // Удаление стендов по постоянным номерам порциями по TOPOLOGY_BATCH, блокировка шарда отпускается между порциями
+    // Уже удалённые стенды пропускаются; стенды, занятые после now, учитываются в busy
+    StandBatchResult removeStands(const std::vector<StandHandle>& handles, std::chrono::system_clock::time_point now) {
+        ReaderEpochs::Section section(readers);
+        using namespace std::chrono;
+
+        StandBatchResult result;
+
+        for (size_t first = 0; first < handles.size();) {
+            BoardStands* board = findBoard(handles[first].board);
+
+            if (!board) {
+                ++first;
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(board->mutex);
+            auto start = steady_clock::now();
+            size_t last = first;
+
+            for (; last < handles.size() && last - first < TOPOLOGY_BATCH && handles[last].board == board->id; ++last) {
+                size_t index;
+
+                if (board->find(handles[last], index)) {
+                    result.busy += board->freeTimes[index] > now;
+                    eraseStand(*board, index);
+                    ++result.changed;
+                }
+            }
+
+            result.longestHold = std::max<nanoseconds>(result.longestHold, steady_clock::now() - start);
+            first = last;
+        }
+
+        return result;
+    }
+
+    // Текущий индекс стенда в векторе платы по постоянному номеру; false, если стенд удалён
+    bool standIndex(const StandHandle& handle, size_t& index) const {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(handle.board);
+
+        if (!board) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+        return board->find(handle, index);
+    }
+
+    // Постоянный номер стенда платы с индексом index; false, если такого стенда нет
+    bool standHandle(std::string_view boardName, size_t index, StandHandle& handle) const {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(boardName);
+
+        if (!board) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+
+        if (index >= board->freeTimes.size()) {
+            return false;
+        }
+
+        handle = board->handle(index);
+        return true;
+    }
+
+    // Метод для удаления стенда из кластера по названию платы
+    // Удаляются все стенды платы с тем же временем освобождения (поиск по столбцу времён, O(n))
+    // Порядок оставшихся стендов сохраняется; стенд, время которого могло измениться, удаляется по номеру
+    void removeStand(const std::string& boardName, const RemoteStand& stand) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(boardName);
+
+        if (!board || stand.getBoardName() != boardName) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+        auto time = stand.getFreeTime();
+        size_t count = board->freeTimes.size();
+        size_t kept = 0;
+
+        // Календари и отметки сдвигаются вместе с временами; стенды до первого удалённого остаются на месте
+        // (перемещение календаря в самого себя опустошило бы его)
+        for (size_t i = 0; i < count; ++i) {
+            if (board->freeTimes[i] == time) {
+                continue;
+            }
+
+            if (kept != i) {
+                board->freeTimes[kept] = board->freeTimes[i];
+                board->calendars[kept] = std::move(board->calendars[i]);
+                board->listed[kept] = board->listed[i];
+                std::swap(board->slotOf[kept], board->slotOf[i]);
+            }
+
+            ++kept;
+        }
+
+        if (kept != count) {
+            // Слоты удалённых стендов собраны в хвосте slotOf
+            for (size_t i = kept; i < count; ++i) {
+                board->releaseSlot(board->slotOf[i]);
+            }
+
+            board->freeTimes.resize(kept);
+            board->calendars.resize(kept);
+            board->listed.resize(kept);
+            board->slotOf.resize(kept);
+            board->gapped.clear();
+
+            for (size_t i = 0; i < kept; ++i) {
+                board->slots[board->slotOf[i]] = static_cast<uint32_t>(i);
+
+                if (board->listed[i]) {
+                    board->gapped.push_back(static_cast<uint32_t>(i));
+                }
+            }
+
+            board->heap.build(board->freeTimes);
+        }
+    }
+
+    // Метод для получения копии всех стендов по названию платы
+    std::vector<RemoteStand> getStandsByBoard(const std::string& boardName) const {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(boardName);
+
+        if (!board) {
+            return {};
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+        return board->standsCopy();
+    }
+
+    // Метод для поиска стенда с самым ранним временем освобождения за O(1)
+    // Возвращает индекс стенда в векторе платы или false, если стендов для платы нет
+    bool findEarliestStand(std::string_view boardName, size_t& index) const {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(boardName);
+
+        if (!board) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+
+        if (board->heap.empty()) {
+            return false;
+        }
+
+        index = board->heap.top();
+        return true;
+    }
+
+    // Метод для бронирования самого раннего подходящего интервала на стендах платы
+    // Кандидаты: конец календаря стенда с самым ранним временем освобождения (O(log n)) и промежутки
+    // стендов из списка gapped; при равном начале промежуток предпочтительнее, чтобы не дробить свободные стенды
+    // Выбор и обновление стенда выполняются под одной блокировкой шарда платы
+    // Если задание не может начаться до latestStart, стенд не бронируется, а в reservation.startTime
+    // возвращается самое раннее возможное начало
+    bool reserveEarliestStand(std::string_view boardName, std::chrono::system_clock::time_point now,
+                              std::chrono::system_clock::duration duration, Reservation& reservation,
+                              std::chrono::system_clock::time_point latestStart = std::chrono::system_clock::time_point::max()) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(boardName);
+
+        if (!board) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+        return reserveIn(*board, now, duration, reservation, latestStart);
+    }
+
+    // То же по номеру платы, без поиска по названию
+    bool reserveEarliestStand(BoardId id, std::chrono::system_clock::time_point now,
+                              std::chrono::system_clock::duration duration, Reservation& reservation,
+                              std::chrono::system_clock::time_point latestStart = std::chrono::system_clock::time_point::max()) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(id);
+
+        if (!board) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+        return reserveIn(*board, now, duration, reservation, latestStart);
+    }
+
+    // Предварительное бронирование стенда платы на заданное время start
+    bool reserveAt(const std::string& boardName, std::chrono::system_clock::time_point now, std::chrono::system_clock::time_point start,
+                   std::chrono::system_clock::duration duration, Reservation& reservation) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(boardName);
+
+        if (!board || start < now) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+        return placeAt(*board, now, start, duration, reservation);
+    }
+
+    // Отмена брони: будущее задание освобождает свой интервал, выполняющееся - остаток после now
+    // Освободившееся время сразу доступно другим заданиям. Возвращает false, если задание уже завершилось
+    // или стенд удалён
+    bool cancelReservation(const Reservation& reservation, std::chrono::system_clock::time_point now) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(reservation.stand.board);
+        size_t index;
+
+        if (!board) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+
+        if (!board->find(reservation.stand, index) || !board->calendars[index].release(reservation.startTime, now)) {
+            return false;
+        }
+
+        syncFreeTime(*board, index);
+        trackGaps(*board, index, now);
+        return true;
+    }
+
+    // Перенос ещё не начавшегося задания на время start на любой стенд платы, свободный в это время
+    // Интервал задания освобождается и бронируется заново под одной блокировкой шарда; при неудаче бронь не меняется
+    bool moveReservation(const Reservation& from, std::chrono::system_clock::time_point now, std::chrono::system_clock::time_point start,
+                         Reservation& to) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(from.stand.board);
+        size_t index;
+
+        if (!board || start < now || from.startTime <= now) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+
+        if (!board->find(from.stand, index) || !board->calendars[index].release(from.startTime, now)) {
+            return false;
+        }
+
+        syncFreeTime(*board, index);
+        trackGaps(*board, index, now);
+
+        if (placeAt(*board, now, start, from.freeTime - from.startTime, to)) {
+            return true;
+        }
+
+        bookSlot(*board, index, now, from.startTime, from.freeTime);
+        return false;
+    }
+
+    // Продление выполняющейся брони до until, когда задание работает дольше предсказанного
+    // Брони того же стенда, на которые заходит продление, снимаются и бронируются заново не раньше своего начала
+    // на любом стенде платы; пары прежней и новой брони дописываются в moved. Всё выполняется под одной блокировкой шарда
+    // Окончание reservation становится until; false, если стенд удалён
+    bool extendReservation(Reservation& reservation, std::chrono::system_clock::time_point now, std::chrono::system_clock::time_point until,
+                           std::vector<std::pair<Reservation, Reservation>>& moved) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(reservation.stand.board);
+        size_t index;
+
+        if (!board) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+
+        if (!locate(*board, reservation, index)) {
+            return false;
+        }
+
+        std::vector<StandCalendar::Slot> displaced;
+        board->calendars[index].extend(reservation.startTime, reservation.freeTime, until, displaced);
+        reservation.freeTime = std::max(reservation.freeTime, until);
+        syncFreeTime(*board, index);
+        trackGaps(*board, index, now);
+
+        for (const auto& slot : displaced) {
+            Reservation from;
+            from.standIndex = index;
+            from.stand = board->handle(index);
+            from.startTime = slot.start;
+            from.freeTime = slot.end;
+
+            Reservation to;
+            reserveIn(*board, now, slot.end - slot.start, to, std::chrono::system_clock::time_point::max(), slot.start);
+            moved.emplace_back(from, to);
+        }
+
+        return true;
+    }
+
+    // Метод для обновления времени освобождения стенда за O(log n)
+    // Неизвестная плата или номер стенда за пределами платы - исключение std::out_of_range
+    void updateFreeTime(const std::string& boardName, size_t index, std::chrono::system_clock::time_point newTime) {
+        ReaderEpochs::Section section(readers);
+        BoardStands& board = boardAt(boardName);
+        std::lock_guard<std::mutex> lock(board.mutex);
+
+        setFreeTime(board, checkedIndex(board, index), newTime);
+    }
+
+    // Перенос окончания брони на фактическое время завершения задания
+    // Досрочное завершение освобождает промежуток для других заданий, продление не заходит на следующую бронь
+    bool completeReservation(std::string_view boardName, const Reservation& reservation, std::chrono::system_clock::time_point actualEnd) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(boardName);
+
+        if (!board) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+        size_t index;
+
+        if (!locate(*board, reservation, index) || !board->calendars[index].resize(reservation.startTime, actualEnd)) {
+            return false;
+        }
+
+        syncFreeTime(*board, index);
+        trackGaps(*board, index, actualEnd);
+        return true;
+    }
+
+    // Метод для увеличения времени освобождения стенда за O(log n)
+    // Неизвестная плата или номер стенда за пределами платы - исключение std::out_of_range
+    void increaseDelay(const std::string& boardName, size_t index, std::chrono::seconds delay) {
+        ReaderEpochs::Section section(readers);
+        BoardStands& board = boardAt(boardName);
+        std::lock_guard<std::mutex> lock(board.mutex);
+
+        size_t stand = checkedIndex(board, index);
+        setFreeTime(board, stand, board.freeTimes[stand] + delay);
+    }
+
+    // Метод для увеличения времени освобождения всех стендов на заданный кулдаун
+    void increaseCooldownForAllStands(const std::string& boardName, std::chrono::minutes delay) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(boardName);
+
+        // Сдвиг всех стендов на одинаковую величину не нарушает порядок кучи
+        if (board) {
+            std::lock_guard<std::mutex> lock(board->mutex);
+
+            for (size_t i = 0; i < board->freeTimes.size(); ++i) {
+                board->freeTimes[i] += delay;
+                board->calendars[i].reset(board->freeTimes[i]);
+                notifyChanged(*board, i, board->freeTimes[i]);
+            }
+        }
+    }
+
+    // Установка получателя изменений времени освобождения (nullptr - отключить)
+    void setListener(StandChangeListener* value) {
+        listener.store(value, std::memory_order_release);
+    }
+
+    // Копия времени освобождения и ключей всех стендов по платам в порядке индексов (для снимков и восстановления)
+    // Каждый шард блокируется только на время копирования его стендов
+    std::map<std::string, std::vector<StandState>> exportStands() const {
+        ReaderEpochs::Section section(readers);
+        std::map<std::string, std::vector<StandState>> result;
+
+        const BoardDirectory& boards = view();
+
+        for (size_t i = 0; i < boards.size(); ++i) {
+            BoardStands* board = boards.find(static_cast<BoardId>(i));
+            std::lock_guard<std::mutex> lock(board->mutex);
+
+            if (board->freeTimes.empty()) {
+                continue;
+            }
+
+            std::vector<StandState>& stands = result[board->name];
+            stands.resize(board->freeTimes.size());
+
+            for (size_t index = 0; index < stands.size(); ++index) {
+                stands[index].slot = board->slotOf[index];
+                stands[index].label = board->slotLabel(stands[index].slot);
+                stands[index].freeTime = board->freeTimes[index];
+            }
+        }
+
+        return result;
+    }
+
+    // Восстановление времени освобождения первых count стендов платы с перестройкой кучи за O(n)
+    // Календари сворачиваются в занятость до восстановленного времени
+    // Лишние значения (стендов стало меньше) игнорируются, возвращается количество восстановленных стендов
+    size_t restoreFreeTimes(const std::string& boardName, const std::chrono::system_clock::time_point* times, size_t count) {
+        ReaderEpochs::Section section(readers);
+        BoardStands* board = findBoard(boardName);
+
+        if (!board) {
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(board->mutex);
+        size_t restored = std::min(count, board->freeTimes.size());
+
+        for (size_t i = 0; i < restored; ++i) {
+            board->freeTimes[i] = times[i];
+            board->calendars[i].reset(times[i]);
+        }
+
+        board->heap.build(board->freeTimes);
+        return restored;
+    }
+
+    // Метод для очистки всех стендов в кластере (номера плат сохраняются)
+    void clearAllStands() {
+        ReaderEpochs::Section section(readers);
+        const BoardDirectory& boards = view();
+
+        for (size_t i = 0; i < boards.size(); ++i) {
+            BoardStands* board = boards.find(static_cast<BoardId>(i));
+            std::lock_guard<std::mutex> lock(board->mutex);
+            board->clear();
+        }
+    }
+
+    // Количество стендов во всех платах
+    size_t standsCount() const {
+        ReaderEpochs::Section section(readers);
+        size_t count = 0;
+
+        const BoardDirectory& boards = view();
+
+        for (size_t i = 0; i < boards.size(); ++i) {
+            BoardStands* board = boards.find(static_cast<BoardId>(i));
+            std::lock_guard<std::mutex> lock(board->mutex);
+            count += board->freeTimes.size();
+        }
+
+        return count;
+    }
+
+    // Память, занятая стендами всех плат, в байтах (без учёта бронирований в календарях)
+    size_t standsMemory() const {
+        ReaderEpochs::Section section(readers);
+        size_t bytes = 0;
+
+        const BoardDirectory& boards = view();
+
+        for (size_t i = 0; i < boards.size(); ++i) {
+            BoardStands* board = boards.find(static_cast<BoardId>(i));
+            std::lock_guard<std::mutex> lock(board->mutex);
+            bytes += board->memoryUsage();
+        }
+
+        return bytes;
+    }
+
+    // Метод для вывода всех стендов в кластере
+    void printAllStands() const {
+        for (const auto& pair : snapshot()) {
+            std::cout << "Board: " << pair.first << "\n";
+
+            for (const auto& stand : pair.second) {
+                stand.printInfo();
+            }
+        }
+    }
+
+    // Метод для вывода количества стендов с каждой платой
+    void printStandsCount() const {
+        for (const auto& pair : snapshot()) {
+            std::cout << pair.first << " : " << pair.second.size() << "\n";
+        }
+    }
+
+    // Оператор присваивания
+    StandCluster& operator=(const StandCluster& other) {
+        if (this != &other) {
+            copyFrom(other);
+        }
+
+        return *this;
+    }
+
+    // Оператор сравнения (==): два кластера равны, если у них одинаковое количество стендов по каждой плате
+    bool operator==(const StandCluster& other) const {
+        return this == &other || snapshot() == other.snapshot();
+    }
+
+    // Оператор сравнения (!=): два кластера не равны, если они отличаются по количеству стендов по хотя бы одной плате
+    bool operator!=(const StandCluster& other) const {
+        return !(*this == other);
+    }
+
+    // Оператор сравнения (<): два кластера сравниваются по количеству стендов, можно отсортировать по количеству
+    bool operator<(const StandCluster& other) const {
+        auto mine = snapshot();
+        auto theirs = other.snapshot();
+
+        if (mine.size() != theirs.size()) {
+            return mine.size() < theirs.size();
+        }
+
+        for (const auto& pair : mine) {
+            if (theirs.find(pair.first) == theirs.end()) {
+                return false; // Если в другом кластере нет такой платы, то этот кластер "меньше"
+            }
+
+            if (pair.second.size() != theirs.at(pair.first).size()) {
+                return pair.second.size() < theirs.at(pair.first).size();
+            }
+        }
+
+        return false;
+    }
+
+    // Оператор сравнения (>): это обратный оператор по отношению к operator<
+    bool operator>(const StandCluster& other) const {
+        return other < *this;
+    }
+};
+
+// Тесты класса кластера стендов
+void testStandCluster() {
+    using namespace std::chrono;
+
+    // Создаем несколько стендов
+    RemoteStand stand1("Board A", system_clock::now() + hours(1));
+    RemoteStand stand2("Board A", system_clock::now() + hours(2));
+    RemoteStand stand3("Board B", system_clock::now() + hours(3));
+    RemoteStand stand4("Board A", system_clock::now() + hours(4));
+
+    // Создаем кластер стендов
+    StandCluster cluster;
+
+    // Добавление стендов
+    cluster.addStand(stand1);
+    cluster.addStand(stand2);
+    cluster.addStand(stand3);
+    cluster.addStand(stand4);
+
+    // Проверяем, что стенды добавлены
+    auto standsA = cluster.getStandsByBoard("Board A");
+    auto standsB = cluster.getStandsByBoard("Board B");
+
+    // Проверяем, что для Board A 3 стенда, для Board B - 1 стенд
+    assert(standsA.size() == 3);  // Должно быть 3 стенда для Board A
+    assert(standsB.size() == 1);  // Должно быть 1 стенд для Board B
+
+    // Проверяем, что куча выдаёт стенд с самым ранним временем освобождения
+    size_t earliest = 0;
+    assert(cluster.findEarliestStand("Board A", earliest));
+    assert(cluster.getStandsByBoard("Board A")[earliest] == stand1);
+
+    // После увеличения задержки самым ранним становится следующий стенд
+    cluster.increaseDelay("Board A", earliest, hours(5));
+    assert(cluster.findEarliestStand("Board A", earliest));
+    assert(cluster.getStandsByBoard("Board A")[earliest] == stand2);
+
+    // Возвращаем первому стенду исходное время освобождения
+    cluster.updateFreeTime("Board A", 0, stand1.getFreeTime());
+    assert(cluster.findEarliestStand("Board A", earliest));
+    assert(earliest == 0);
+
+    // Для неизвестной платы стенда нет, и запись о плате не создаётся
+    assert(!cluster.findEarliestStand("Board C", earliest));
+    assert(cluster.getStandsByBoard("Board C").empty());
+    assert(!(cluster < StandCluster(cluster)) && cluster == StandCluster(cluster));
+
+    // Изменение времени стенда неизвестной платы или несуществующего стенда - исключение, стенды не меняются
+    auto outOfRange = [](const std::function<void()>& change) {
+        try {
+            change();
+        } catch (const std::out_of_range&) {
+            return true;
+        }
+
+        return false;
+    };
+    assert(outOfRange([&]() { cluster.updateFreeTime("Board C", 0, stand1.getFreeTime()); }));
+    assert(outOfRange([&]() { cluster.increaseDelay("Board C", 0, seconds(1)); }));
+    assert(outOfRange([&]() { cluster.increaseDelay("Board B", 1, seconds(1)); }));
+    assert(cluster.getStandsByBoard("Board C").empty() && cluster.getStandsByBoard("Board B")[0].getFreeTime() == standsB[0].getFreeTime());
+
+    // Удаление стенда
+    cluster.removeStand("Board A", stand1);  // Удаляем stand1 для Board A
+    standsA = cluster.getStandsByBoard("Board A");
+
+    // Проверяем, что один стенд был удален
+    assert(standsA.size() == 2);  // Должно быть 2 стенда для Board A
+
+    // Получение стендов по названию платы
+    std::vector<RemoteStand> standsAAfterRemoval = cluster.getStandsByBoard("Board A");
+    assert(standsAAfterRemoval.size() == 2);  // После удаления stand1 осталось 2 стенда для Board A
+
+    // Увеличение времени освобождения для всех стендов
+    minutes cooldown(30);
+    cluster.increaseCooldownForAllStands("Board A", cooldown);
+
+    // Проверяем, что время освобождения стендов увеличилось
+    auto updatedStandsA = cluster.getStandsByBoard("Board A");
+    auto originalFreeTime = stand2.getFreeTime();
+    auto updatedFreeTime = updatedStandsA[0].getFreeTime();
+
+    assert(updatedFreeTime == originalFreeTime + cooldown);
+
+    // Очистка всех стендов
+    cluster.clearAllStands();
+
+    assert(cluster.getStandsByBoard("Board A").empty());  // Все стенды для Board A должны быть удалены
+    assert(cluster.getStandsByBoard("Board B").empty());  // Все стенды для Board B должны быть удалены
+
+    // Конструктор копирования
+    StandCluster copiedCluster(cluster);
+
+    assert(copiedCluster.getStandsByBoard("Board A").empty());  // Проверка, что копия пустая после очистки
+    assert(copiedCluster.getStandsByBoard("Board B").empty());  // Проверка, что копия пустая после очистки
+
+    // Оператор присваивания
+    StandCluster assignedCluster;
+    assignedCluster = cluster;
+
+    // Проверка оператора присваивания
+    assert(assignedCluster.getStandsByBoard("Board A").empty());
+    assert(assignedCluster.getStandsByBoard("Board B").empty());
+
+    // Оператор сравнения (==)
+    StandCluster cluster2;
+
+    // Добавление стендов в кластер
+    cluster2.addStand(stand1);
+    cluster2.addStand(stand2);
+    cluster2.addStand(stand3);
+
+    // Кластеры с одинаковым содержимым должны быть равны
+    assert(cluster != cluster2);  // Кластеры с разным содержимым не равны
+    assert(cluster == cluster);   // Кластер должен быть равен сам себе
+
+    // Оператор сравнения (!=)
+    assert(cluster != cluster2);  // Кластеры с разным содержимым не равны
+
+    // Оператор сравнения (<)
+    StandCluster cluster3;
+
+    // Добавление стендов в кластер
+    cluster3.addStand(stand1);
+    cluster3.addStand(stand2);
+    cluster3.addStand(stand4);
+    cluster3.addStand(stand3);
+
+    // Проверяем, что первый кластер "меньше" второго, т.к. у второго больше стендов
+    assert(cluster < cluster3);
+
+    // Оператор сравнения (>)
+    assert(cluster3 > cluster);  // Проверяем, что второй кластер "больше" первого
+
+    // Номера плат выдаются по порядку появления и сохраняются после очистки
+    BoardId idA = 0;
+    BoardId idB = 0;
+    assert(cluster3.boardId("Board A", idA) && cluster3.boardId("Board B", idB));
+    assert(idA == 0 && idB == 1 && !cluster3.boardId("Board C", idA));
+    cluster3.clearAllStands();
+    assert(cluster3.boardId("Board B", idB) && idB == 1 && cluster3.standsCount() == 0);
+
+    // Бронирование по номеру платы равнозначно бронированию по названию
+    Reservation reservation;
+    assert(!cluster3.reserveEarliestStand(idB, system_clock::now(), DELAY, reservation));
+    cluster3.addStand(stand3);
+    assert(cluster3.reserveEarliestStand(idB, stand3.getFreeTime(), DELAY, reservation));
+    assert(reservation.standIndex == 0 && reservation.freeTime == stand3.getFreeTime() + DELAY);
+    assert(cluster3.getStandsByBoard("Board B")[0].getFreeTime() == reservation.freeTime);
+    assert(!cluster3.reserveEarliestStand(BoardId(7), system_clock::now(), DELAY, reservation));
+
+    // Постоянные номера стендов: стенд удаляется по номеру и после изменения времени освобождения,
+    // последний стенд переносится на место удалённого, а номер удалённого стенда больше не действует
+    StandCluster handles;
+    auto start = system_clock::now();
+    StandHandle first = handles.addStand(RemoteStand("Board H", start + hours(3)));
+    StandHandle second = handles.addStand(RemoteStand("Board H", start + hours(1)));
+    StandHandle third = handles.addStand(RemoteStand("Board H", start + hours(2)));
+    size_t index = 0;
+
+    assert(reservation.stand.generation != 0 && !(first == second));
+    handles.increaseDelay("Board H", 0, hours(1));
+    assert(handles.removeStand(first) && !handles.removeStand(first));
+    assert(!handles.standIndex(first, index));
+    assert(handles.standIndex(third, index) && index == 0);
+    assert(handles.getStandsByBoard("Board H")[0].getFreeTime() == start + hours(2));
+    assert(handles.findEarliestStand("Board H", index) && index == 1);
+
+    // Слот удалённого стенда достаётся новому стенду с другим поколением
+    StandHandle fourth = handles.addStand(RemoteStand("Board H", start));
+    assert(fourth.slot == first.slot && !(fourth == first));
+    assert(handles.standIndex(fourth, index) && index == 2);
+    assert(handles.findEarliestStand("Board H", index) && index == 2);
+    assert(handles.standHandle("Board H", 1, first) && first == second);
+
+    // Бронь ссылается на стенд по номеру, поэтому переживает перенос стенда при удалении другого
+    assert(handles.reserveEarliestStand("Board H", start, DELAY, reservation) && reservation.stand == fourth);
+    assert(handles.removeStand(third) && handles.standIndex(fourth, index) && index == 0);
+    assert(handles.completeReservation("Board H", reservation, start + seconds(1)));
+    assert(handles.getStandsByBoard("Board H")[0].getFreeTime() == start + seconds(1));
+
+    // После очистки кластера номера стендов не действуют
+    handles.clearAllStands();
+    assert(!handles.standIndex(second, index) && !handles.removeStand(fourth));
+
+    // Удаление другого стенда по значению не теряет брони стендов, стоящих до него
+    StandCluster booked;
+    booked.addStand(RemoteStand("Board R", start));
+    booked.addStand(RemoteStand("Board R", start + hours(5)));
+    Reservation running;
+    Reservation queued;
+    assert(booked.reserveEarliestStand("Board R", start, DELAY, running) && running.standIndex == 0);
+    assert(booked.reserveEarliestStand("Board R", start, DELAY, queued) && queued.standIndex == 0);
+    booked.removeStand("Board R", RemoteStand("Board R", start + hours(5)));
+    booked.removeStand("Board R", RemoteStand("Board R", start + hours(7)));
+    assert(booked.getStandsByBoard("Board R").size() == 1);
+    assert(booked.cancelReservation(queued, start + seconds(1)));
+    assert(booked.completeReservation("Board R", running, start + seconds(2)));
+    assert(booked.getStandsByBoard("Board R")[0].getFreeTime() == start + seconds(2));
+
+    // Сто тысяч стендов одной платы занимают несколько мегабайт
+    StandCluster large;
+    auto base = system_clock::now();
+
+    for (int i = 0; i < 100000; ++i) {
+        large.addStand(RemoteStand("Board L", base + milliseconds(i % 977)));
+    }
+
+    assert(large.standsCount() == 100000);
+    assert(large.standsMemory() < 100000 * 128);
+}
+
+// Тест одновременной работы с кластером из нескольких потоков (проверяется также под ThreadSanitizer)
+void testStandClusterConcurrency() {
+    using namespace std::chrono;
+
+    // Все стенды заняты на час вперёд, поэтому каждое бронирование добавляет ровно одну задержку
+    auto base = system_clock::now() + hours(1);
+    StandCluster cluster;
+
+    for (int i = 0; i < 4; ++i) {
+        cluster.addStand(RemoteStand("Board A", base));
+        cluster.addStand(RemoteStand("Board B", base));
+    }
+
+    const int threadsCount = 8;
+    const int reservationsPerThread = 500;
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadsCount; ++t) {
+        threads.emplace_back([&cluster, t, base]() {
+            std::string boardName = (t % 2 == 0) ? "Board A" : "Board B";
+
+            for (int i = 0; i < reservationsPerThread; ++i) {
+                Reservation reservation;
+                assert(cluster.reserveEarliestStand(boardName, system_clock::now(), DELAY, reservation));
+                assert(reservation.startTime >= base);
+
+                // Параллельно с бронированием читаем копии и добавляем стенды новой платы
+                if (i % 100 == 0) {
+                    assert(cluster.getStandsByBoard(boardName).size() == 4);
+                    cluster.addStand(RemoteStand("Board " + std::to_string(t), base));
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Суммарное занятое время по каждой плате равно числу бронирований, умноженному на задержку
+    for (const std::string boardName : {"Board A", "Board B"}) {
+        system_clock::duration total(0);
+
+        for (const auto& stand : cluster.getStandsByBoard(boardName)) {
+            total += stand.getFreeTime() - base;
+        }
+
+        assert(total == DELAY * (threadsCount / 2 * reservationsPerThread));
+    }
+
+    assert(cluster.getStandsByBoard("Board 3").size() == reservationsPerThread / 100);
+
+    // Присваивание во время чтения: прежние шарды освобождаются только после завершения начатых чтений
+    StandCluster source;
+    source.addStand(RemoteStand("Board A", base));
+    source.addStand(RemoteStand("Board A", base));
+    std::atomic<bool> assigning{true};
+    std::vector<std::thread> readers;
+
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&cluster, &assigning]() {
+            while (assigning.load()) {
+                size_t count = cluster.getStandsByBoard("Board A").size();
+                assert(count == 4 || count == 2);
+                size_t index;
+                assert(cluster.findEarliestStand("Board A", index));
+            }
+        });
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        cluster = source;
+    }
+
+    assigning.store(false);
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    assert(cluster == source && cluster.standsCount() == 2);
+}
+
+// Тесты календаря бронирований и заполнения промежутков (backfilling)
+void testStandCalendar() {
+    using namespace std::chrono;
+
+    auto base = system_clock::time_point(seconds(1700000000));
+
+    // Календарь: свободные промежутки [0, 10) и [20, 30)
+    StandCalendar calendar(base);
+    calendar.book(base + seconds(30), base + seconds(40));
+    calendar.book(base + seconds(10), base + seconds(20));
+
+    assert(calendar.tail() == base + seconds(40));
+    assert(calendar.earliestFit(base, seconds(5)) == base);
+    assert(calendar.earliestFit(base, seconds(15)) == base + seconds(40));
+    assert(calendar.earliestFit(base + seconds(12), seconds(10)) == base + seconds(20));
+    assert(calendar.hasGapAfter(base));
+
+    // Прошедшие бронирования удаляются, окончание календаря не меняется
+    calendar.trim(base + seconds(25));
+    assert(calendar.size() == 1 && calendar.tail() == base + seconds(40));
+    assert(!calendar.hasGapAfter(base + seconds(30)));
+    assert(calendar.resize(base + seconds(30), base + seconds(35)));
+    assert(!calendar.resize(base + seconds(31), base + seconds(35)));
+    assert(calendar.tail() == base + seconds(35));
+
+    // Промежуток между бронированиями закрывается вставкой и открывается досрочным завершением
+    calendar.book(base + seconds(40), base + seconds(50));
+    assert(calendar.hasGapAfter(base + seconds(30)));
+    calendar.book(base + seconds(35), base + seconds(40));
+    assert(!calendar.hasGapAfter(base + seconds(30)));
+    assert(calendar.resize(base + seconds(35), base + seconds(38)));
+    assert(calendar.hasGapAfter(base + seconds(30)));
+    assert(calendar.resize(base + seconds(35), base + seconds(35)));
+    assert(calendar.size() == 2 && calendar.hasGapAfter(base + seconds(30)));
+    calendar.trim(base + seconds(36));
+    assert(calendar.size() == 1 && calendar.hasGapAfter(base + seconds(36)) && !calendar.hasGapAfter(base + seconds(40)));
+
+    // Досрочное завершение оставляет промежуток, который занимает короткое задание
+    StandCluster cluster;
+    cluster.addStand(RemoteStand("Board A", base));
+    Reservation first;
+    Reservation reservation;
+
+    assert(cluster.reserveEarliestStand("Board A", base, seconds(10), first));
+    assert(cluster.reserveEarliestStand("Board A", base, seconds(10), reservation));
+    assert(reservation.startTime == base + seconds(10));
+    assert(cluster.completeReservation("Board A", first, base + seconds(2)));
+
+    assert(cluster.reserveEarliestStand("Board A", base + seconds(3), seconds(5), reservation));
+    assert(reservation.startTime == base + seconds(3) && reservation.freeTime == base + seconds(8));
+    assert(cluster.reserveEarliestStand("Board A", base + seconds(3), seconds(10), reservation));
+    assert(reservation.startTime == base + seconds(20));
+
+    // Предварительное бронирование на будущее время, промежуток до него доступен другим заданиям
+    assert(cluster.reserveAt("Board A", base + seconds(3), base + seconds(100), seconds(5), reservation));
+    assert(cluster.getStandsByBoard("Board A")[0].getFreeTime() == base + seconds(105));
+    assert(cluster.reserveEarliestStand("Board A", base + seconds(3), seconds(20), reservation));
+    assert(reservation.startTime == base + seconds(30));
+    assert(!cluster.reserveAt("Board A", base + seconds(3), base + seconds(40), seconds(5), reservation));
+    assert(!cluster.reserveAt("Board A", base + seconds(3), base, seconds(5), reservation));
+    assert(cluster.reserveAt("Board A", base + seconds(3), base + seconds(50), seconds(50), reservation));
+
+    // При равном начале промежуток на занятом стенде предпочтительнее свободного стенда
+    cluster.addStand(RemoteStand("Board A", base));
+    assert(cluster.reserveEarliestStand("Board A", base + seconds(8), seconds(2), reservation));
+    assert(reservation.standIndex == 0 && reservation.startTime == base + seconds(8));
+    assert(cluster.reserveEarliestStand("Board A", base + seconds(8), seconds(2), reservation));
+    assert(reservation.standIndex == 1);
+
+    // Отмена будущего задания возвращает его интервал стенду, выполняющееся задание обрезается до текущего момента
+    StandCluster jobs;
+    jobs.addStand(RemoteStand("Board J", base));
+    Reservation running;
+    Reservation queued;
+    Reservation moved;
+
+    assert(jobs.reserveEarliestStand("Board J", base, seconds(10), running));
+    assert(jobs.reserveEarliestStand("Board J", base, seconds(10), queued));
+    assert(jobs.cancelReservation(queued, base + seconds(1)) && !jobs.cancelReservation(queued, base + seconds(1)));
+    assert(jobs.getStandsByBoard("Board J")[0].getFreeTime() == base + seconds(10));
+    assert(jobs.cancelReservation(running, base + seconds(4)));
+    assert(jobs.getStandsByBoard("Board J")[0].getFreeTime() == base + seconds(4));
+    assert(!jobs.cancelReservation(running, base + seconds(5)));
+
+    // Перенос задания: интервал освобождается, задание занимает новое время; занятое время не бронируется
+    assert(jobs.reserveEarliestStand("Board J", base + seconds(4), seconds(10), running));
+    assert(jobs.reserveEarliestStand("Board J", base + seconds(4), seconds(10), queued));
+    assert(jobs.moveReservation(queued, base + seconds(5), base + seconds(60), moved));
+    assert(moved.startTime == base + seconds(60) && moved.freeTime == base + seconds(70));
+    assert(jobs.reserveEarliestStand("Board J", base + seconds(5), seconds(10), reservation));
+    assert(reservation.startTime == base + seconds(14));
+    assert(!jobs.moveReservation(moved, base + seconds(5), base + seconds(20), queued));
+    assert(jobs.getStandsByBoard("Board J")[0].getFreeTime() == base + seconds(70));
+    assert(!jobs.moveReservation(running, base + seconds(5), base + seconds(100), queued));
+}
+
+// Контрольная сумма FNV-1a (32 бита) для записей журнала
+uint32_t fnv1a32(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619u;
+    }
+
+    return hash;
+}
+
+// Контрольная сумма FNV-1a (64 бита) для снимков состояния
+uint64_t fnv1a64(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// Быстрая 64-битная хэш-функция содержимого (XXH64): четыре независимые цепочки по 8 байт за шаг
+// Не криптографическая, для ключей кэша по содержимому
+uint64_t hash64(const void* data, size_t size, uint64_t seed = 0) {
+    static constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+    static constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+    static constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+    static constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+    static constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+    auto rotl = [](uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); };
+    auto round = [&rotl](uint64_t acc, uint64_t input) { return rotl(acc + input * P2, 31) * P1; };
+    auto merge = [&round](uint64_t acc, uint64_t value) { return (acc ^ round(0, value)) * P1 + P4; };
+    auto read64 = [](const unsigned char* p) { uint64_t value; std::memcpy(&value, p, 8); return value; };
+    auto read32 = [](const unsigned char* p) { uint32_t value; std::memcpy(&value, p, 4); return static_cast<uint64_t>(value); };
+
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    uint64_t hash;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + P1 + P2;
+        uint64_t v2 = seed + P2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - P1;
+
+        for (; p + 32 <= end; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = merge(merge(merge(merge(hash, v1), v2), v3), v4);
+    } else {
+        hash = seed + P5;
+    }
+
+    hash += size;
+
+    for (; p + 8 <= end; p += 8) {
+        hash = rotl(hash ^ round(0, read64(p)), 27) * P1 + P4;
+    }
+
+    if (p + 4 <= end) {
+        hash = rotl(hash ^ (read32(p) * P1), 23) * P2 + P3;
+        p += 4;
+    }
+
+    for (; p < end; ++p) {
+        hash = rotl(hash ^ (*p * P5), 11) * P1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= P2;
+    hash ^= hash >> 29;
+    hash *= P3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// Запись буфера в файл целиком, с повтором при частичной записи
+bool writeAll(int fd, const char* data, size_t size) {
+    size_t written = 0;
+
+    while (written < size) {
+        ssize_t count = ::write(fd, data + written, size - written);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (count <= 0) {
+            return false;
+        }
+
+        written += static_cast<size_t>(count);
+    }
+
+    return true;
+}
+
+// Результат восстановления состояния кластера из каталога журнала
+struct RecoveryReport {
+    bool snapshotLoaded = false;
+    uint64_t snapshotSequence = 0;
+    uint64_t lastSequence = 0;
+    size_t segments = 0;
+    size_t replayed = 0;
+    size_t standsRestored = 0;
+    bool tornTail = false;
+};
+
+// Журнал упреждающей записи изменений кластера со снимками состояния
+// Каталог: wal-<номер первой записи>.log - сегменты журнала, snapshot.bin - последний снимок
+// Запись сегмента: длина тела (4), FNV-1a тела (4), тело: номер (8), тип (1), резерв (1),
+// длина названия платы (2), слот стенда (4), время освобождения в нс от эпохи (8), название платы, метка стенда
+// Снимок: "RSSNAP02", номер последней учтённой записи (8), число плат (8), FNV-1a данных (8),
+// затем по каждой плате: длина названия (4), число стендов (4), название с выравниванием до 8 байт, времена (8 * n),
+// слоты (4 * n), метки (длина (2) и байты) с выравниванием до 8 байт
+// Стенд определяется меткой топологии, а стенд без метки - слотом постоянного номера: индексы стендов меняются
+// при удалении стендов перезагрузкой топологии, а метки и слоты - нет
+// Записи накапливаются в буфере и сбрасываются фоновым потоком одним write и fdatasync (групповая фиксация).
+// Фиксация асинхронная: изменение кластера не ждёт диска, и при сбое теряются изменения последних commitInterval;
+// дождаться сброса можно waitDurable. Если запись сегмента не удалась, журнал заменяется снимком, а если
+// не удался и снимок, журнал отказывает: записи больше не принимаются и граница сброшенных записей не сдвигается
+class ClusterJournal final : public StandChangeListener {
+private:
+    enum RecordType : uint8_t { SetFreeTime = 2 };
+
+    // Стенды платы при восстановлении: времена по текущим индексам и индексы по ключам стендов
+    struct RecoveredBoard {
+        std::vector<std::chrono::system_clock::time_point> times;
+        std::unordered_map<std::string, size_t> labelled;
+        std::unordered_map<uint32_t, size_t> unlabelled;
+
+        // Время стенда по ключу; стенды, которых больше нет в кластере, пропускаются
+        void set(uint32_t slot, const std::string& label, std::chrono::system_clock::time_point time) {
+            if (label.empty()) {
+                auto it = unlabelled.find(slot);
+
+                if (it != unlabelled.end()) {
+                    times[it->second] = time;
+                }
+            } else {
+                auto it = labelled.find(label);
+
+                if (it != labelled.end()) {
+                    times[it->second] = time;
+                }
+            }
+        }
+    };
+
+    using RecoveryState = std::map<std::string, RecoveredBoard>;
+
+    static constexpr size_t RecordHeaderSize = 8;
+    static constexpr size_t RecordBodySize = 24;
+    static constexpr size_t SnapshotHeaderSize = 32;
+
+    StandCluster& cluster;
+    std::string directory;
+    size_t snapshotEvery;
+    std::chrono::milliseconds commitInterval;
+
+    // Дескриптор текущего сегмента (используется только фоновым потоком после запуска)
+    int fd = -1;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable durableChanged;
+    std::thread committer;
+    // Закодированные, но ещё не записанные записи
+    std::string pending;
+    // Номер последней выданной записи и последней записи, сброшенной на диск
+    uint64_t sequence = 0;
+    uint64_t durableSequence = 0;
+    size_t sinceSnapshot = 0;
+    size_t snapshots = 0;
+    bool snapshotRequested = false;
+    bool running = false;
+    bool stopping = false;
+    bool finalSnapshot = true;
+    // Запись на диск не удалась: новые записи не принимаются
+    bool failed = false;
+    // Отказ записи для проверки обработки ошибок: запись сегмента и снимка завершается EIO
+    std::atomic<bool> writeFault{false};
+
+    // Запись в файл журнала или снимка с учётом внедрённого отказа
+    bool writeFile(int file, const char* data, size_t size) const {
+        if (writeFault.load(std::memory_order_relaxed)) {
+            errno = EIO;
+            return false;
+        }
+
+        return writeAll(file, data, size);
+    }
+
+    std::string segmentPath(uint64_t firstSequence) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "wal-%016llx.log", static_cast<unsigned long long>(firstSequence));
+        return (std::filesystem::path(directory) / name).string();
+    }
+
+    std::string snapshotPath() const {
+        return (std::filesystem::path(directory) / "snapshot.bin").string();
+    }
+
+    static int64_t toNanoseconds(std::chrono::system_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    static std::chrono::system_clock::time_point fromNanoseconds(int64_t value) {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(value)));
+    }
+
+    // Синхронизация каталога, чтобы созданные и переименованные файлы пережили сбой
+    void syncDirectory() const {
+        int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+        if (dirFd >= 0) {
+            ::fsync(dirFd);
+            ::close(dirFd);
+        }
+    }
+
+    // Открытие нового сегмента, первая запись которого будет иметь номер firstSequence
+    void openSegment(uint64_t firstSequence) {
+        fd = ::open(segmentPath(firstSequence).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+        if (fd < 0) {
+            std::cerr << "Не удалось открыть журнал состояния!" << std::endl;
+            return;
+        }
+
+        syncDirectory();
+    }
+
+    // Список сегментов журнала, упорядоченный по номеру первой записи
+    std::vector<std::pair<uint64_t, std::string>> listSegments() const {
+        std::vector<std::pair<uint64_t, std::string>> result;
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            std::string name = entry.path().filename().string();
+            unsigned long long first = 0;
+
+            if (name.size() == 24 && name.compare(0, 4, "wal-") == 0 && name.compare(20, 4, ".log") == 0 &&
+                std::sscanf(name.c_str() + 4, "%16llx", &first) == 1) {
+                result.emplace_back(first, entry.path().string());
+            }
+        }
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    // Кодирование записи в конец буфера
+    static void encodeRecord(std::string& out, uint64_t number, const std::string& boardName, uint32_t slot,
+                             const std::string& label, std::chrono::system_clock::time_point freeTime) {
+        char body[RecordBodySize];
+        uint8_t type = SetFreeTime;
+        uint8_t reserved = 0;
+        uint16_t boardLength = static_cast<uint16_t>(std::min<size_t>(boardName.size(), UINT16_MAX));
+        uint16_t labelLength = static_cast<uint16_t>(std::min<size_t>(label.size(), UINT16_MAX));
+        int64_t time = toNanoseconds(freeTime);
+
+        std::memcpy(body, &number, 8);
+        std::memcpy(body + 8, &type, 1);
+        std::memcpy(body + 9, &reserved, 1);
+        std::memcpy(body + 10, &boardLength, 2);
+        std::memcpy(body + 12, &slot, 4);
+        std::memcpy(body + 16, &time, 8);
+
+        uint32_t length = static_cast<uint32_t>(RecordBodySize + boardLength + labelLength);
+        size_t offset = out.size();
+        out.resize(offset + RecordHeaderSize + length);
+        char* record = &out[offset];
+        std::memcpy(record + RecordHeaderSize, body, RecordBodySize);
+        std::memcpy(record + RecordHeaderSize + RecordBodySize, boardName.data(), boardLength);
+        std::memcpy(record + RecordHeaderSize + RecordBodySize + boardLength, label.data(), labelLength);
+
+        uint32_t checksum = fnv1a32(record + RecordHeaderSize, length);
+        std::memcpy(record, &length, 4);
+        std::memcpy(record + 4, &checksum, 4);
+    }
+
+    // Запись снимка во временный файл с fsync и атомарной заменой предыдущего снимка
+    bool writeSnapshot(uint64_t covered) {
+        auto state = cluster.exportStands();
+        std::string data(SnapshotHeaderSize, '\0');
+
+        for (const auto& pair : state) {
+            uint32_t nameLength = static_cast<uint32_t>(pair.first.size());
+            uint32_t count = static_cast<uint32_t>(pair.second.size());
+            size_t padded = (nameLength + 7) / 8 * 8;
+
+            data.append(reinterpret_cast<const char*>(&nameLength), 4);
+            data.append(reinterpret_cast<const char*>(&count), 4);
+            data.append(pair.first);
+            data.append(padded - nameLength, '\0');
+
+            for (const auto& stand : pair.second) {
+                int64_t value = toNanoseconds(stand.freeTime);
+                data.append(reinterpret_cast<const char*>(&value), 8);
+            }
+
+            for (const auto& stand : pair.second) {
+                data.append(reinterpret_cast<const char*>(&stand.slot), 4);
+            }
+
+            for (const auto& stand : pair.second) {
+                uint16_t labelLength = static_cast<uint16_t>(std::min<size_t>(stand.label.size(), UINT16_MAX));
+                data.append(reinterpret_cast<const char*>(&labelLength), 2);
+                data.append(stand.label, 0, labelLength);
+            }
+
+            data.append((8 - data.size() % 8) % 8, '\0');
+        }
+
+        uint64_t boardCount = state.size();
+        uint64_t checksum = fnv1a64(data.data() + SnapshotHeaderSize, data.size() - SnapshotHeaderSize);
+        std::memcpy(&data[0], "RSSNAP02", 8);
+        std::memcpy(&data[8], &covered, 8);
+        std::memcpy(&data[16], &boardCount, 8);
+        std::memcpy(&data[24], &checksum, 8);
+
+        std::string temporary = snapshotPath() + ".tmp";
+        int snapshotFd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+        if (snapshotFd < 0) {
+            std::cerr << "Не удалось записать снимок состояния!" << std::endl;
+            return false;
+        }
+
+        bool written = writeFile(snapshotFd, data.data(), data.size()) && ::fsync(snapshotFd) == 0;
+        ::close(snapshotFd);
+
+        if (!written || ::rename(temporary.c_str(), snapshotPath().c_str()) != 0) {
+            std::cerr << "Не удалось записать снимок состояния!" << std::endl;
+            return false;
+        }
+
+        syncDirectory();
+        return true;
+    }
+
+    // Снимок состояния: сегмент закрывается, снимок покрывает все записи до covered, старые сегменты удаляются
+    // Возвращает false, если снимок не записан
+    bool checkpoint(uint64_t covered, bool reopen) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+
+        if (reopen) {
+            openSegment(covered + 1);
+        }
+
+        if (!writeSnapshot(covered)) {
+            return false;
+        }
+
+        for (const auto& segment : listSegments()) {
+            if (segment.first <= covered) {
+                ::unlink(segment.second.c_str());
+            }
+        }
+
+        return true;
+    }
+
+    // Фоновый поток: групповая фиксация записей и снимки состояния
+    // Без изменений поток спит; первая запись открывает окно commitInterval, записи окна сбрасываются вместе
+    void commitLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            wakeUp.wait(lock, [this]() { return stopping || snapshotRequested || !pending.empty(); });
+            wakeUp.wait_for(lock, commitInterval, [this]() { return stopping || snapshotRequested; });
+
+            bool stop = stopping;
+            bool takeSnapshot = snapshotRequested || (stop && finalSnapshot);
+            uint64_t covered = sequence;
+            std::string batch;
+            batch.swap(pending);
+            snapshotRequested = false;
+            lock.unlock();
+
+            bool written = batch.empty() || (fd >= 0 && writeFile(fd, batch.data(), batch.size()) && ::fdatasync(fd) == 0);
+
+            // Оборванная запись при восстановлении отбросила бы все следующие записи, поэтому сегмент после ошибки
+            // не дописывается: состояние сохраняется снимком, который заменяет все сегменты
+            if (!written) {
+                std::cerr << "Не удалось записать журнал состояния!" << std::endl;
+                takeSnapshot = true;
+            }
+
+            bool saved = takeSnapshot && checkpoint(covered, !stop);
+
+            if (!written && !saved && fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+
+            lock.lock();
+
+            if (written || saved) {
+                durableSequence = covered;
+            } else {
+                failed = true;
+                std::cerr << "Журнал состояния отключён: изменения больше не сохраняются!" << std::endl;
+            }
+
+            snapshots += saved ? 1 : 0;
+            durableChanged.notify_all();
+
+            if (stop) {
+                break;
+            }
+        }
+
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    // Применение снимка, отображённого в память, к копии состояния
+    bool applySnapshot(RecoveryState& state, RecoveryReport& report) const {
+        int snapshotFd = ::open(snapshotPath().c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (snapshotFd < 0) {
+            return false;
+        }
+
+        struct stat info;
+        size_t size = ::fstat(snapshotFd, &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+        void* mapping = size >= SnapshotHeaderSize ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, snapshotFd, 0) : MAP_FAILED;
+        ::close(snapshotFd);
+
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+
+        const char* data = static_cast<const char*>(mapping);
+        uint64_t covered = 0;
+        uint64_t boardCount = 0;
+        uint64_t checksum = 0;
+        std::memcpy(&covered, data + 8, 8);
+        std::memcpy(&boardCount, data + 16, 8);
+        std::memcpy(&checksum, data + 24, 8);
+        bool valid = std::memcmp(data, "RSSNAP02", 8) == 0 && fnv1a64(data + SnapshotHeaderSize, size - SnapshotHeaderSize) == checksum;
+
+        // Разбор проверяется по границам, затем значения накладываются на стенды, существующие в кластере
+        size_t offset = SnapshotHeaderSize;
+
+        for (uint64_t board = 0; valid && board < boardCount; ++board) {
+            uint32_t nameLength = 0;
+            uint32_t count = 0;
+
+            if (size - offset < 8) {
+                valid = false;
+                break;
+            }
+
+            std::memcpy(&nameLength, data + offset, 4);
+            std::memcpy(&count, data + offset + 4, 4);
+            size_t padded = (static_cast<size_t>(nameLength) + 7) / 8 * 8;
+
+            if (size - offset - 8 < padded || (size - offset - 8 - padded) / 8 < count) {
+                valid = false;
+                break;
+            }
+
+            std::string boardName(data + offset + 8, nameLength);
+            const char* times = data + offset + 8 + padded;
+            const char* slots = times + static_cast<size_t>(count) * 8;
+            offset += 8 + padded + static_cast<size_t>(count) * 8;
+            std::vector<std::string> labels(count);
+
+            if ((size - offset) / 4 < count) {
+                valid = false;
+                break;
+            }
+
+            offset += static_cast<size_t>(count) * 4;
+
+            for (uint32_t i = 0; valid && i < count; ++i) {
+                uint16_t labelLength = 0;
+
+                if (size - offset < 2) {
+                    valid = false;
+                    break;
+                }
+
+                std::memcpy(&labelLength, data + offset, 2);
+
+                if (size - offset - 2 < labelLength) {
+                    valid = false;
+                    break;
+                }
+
+                labels[i].assign(data + offset + 2, labelLength);
+                offset += 2 + labelLength;
+            }
+
+            offset = std::min(size, (offset + 7) / 8 * 8);
+
+            auto it = valid ? state.find(boardName) : state.end();
+
+            if (it == state.end()) {
+                continue;
+            }
+
+            for (uint32_t i = 0; i < count; ++i) {
+                int64_t value;
+                uint32_t slot;
+                std::memcpy(&value, times + static_cast<size_t>(i) * 8, 8);
+                std::memcpy(&slot, slots + static_cast<size_t>(i) * 4, 4);
+                it->second.set(slot, labels[i], fromNanoseconds(value));
+            }
+        }
+
+        ::munmap(mapping, size);
+
+        if (!valid) {
+            std::cerr << "Снимок состояния повреждён и пропущен: " << snapshotPath() << std::endl;
+            return false;
+        }
+
+        report.snapshotLoaded = true;
+        report.snapshotSequence = covered;
+        return true;
+    }
+
+    // Повтор записей сегмента с номером больше last; повреждённый хвост обрезается
+    // Возвращает false, если сегмент оборвался (более поздние сегменты не применяются)
+    bool replaySegment(const std::string& path, RecoveryState& state, uint64_t& last, RecoveryReport& report) const {
+        std::ifstream file(path, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t offset = 0;
+
+        while (data.size() - offset >= RecordHeaderSize) {
+            uint32_t length = 0;
+            uint32_t checksum = 0;
+            std::memcpy(&length, data.data() + offset, 4);
+            std::memcpy(&checksum, data.data() + offset + 4, 4);
+
+            if (length < RecordBodySize || data.size() - offset - RecordHeaderSize < length) {
+                break;
+            }
+
+            const char* body = data.data() + offset + RecordHeaderSize;
+            uint64_t number = 0;
+            uint8_t type = 0;
+            uint16_t boardLength = 0;
+            uint32_t stand = 0;
+            int64_t time = 0;
+            std::memcpy(&number, body, 8);
+            std::memcpy(&type, body + 8, 1);
+            std::memcpy(&boardLength, body + 10, 2);
+            std::memcpy(&stand, body + 12, 4);
+            std::memcpy(&time, body + 16, 8);
+
+            // Метка стенда - остаток тела после названия платы
+            if (fnv1a32(body, length) != checksum || RecordBodySize + boardLength > length || type != SetFreeTime ||
+                (number <= last && number > report.snapshotSequence)) {
+                break;
+            }
+
+            offset += RecordHeaderSize + length;
+
+            // Записи, уже учтённые снимком, пропускаются
+            if (number <= report.snapshotSequence) {
+                continue;
+            }
+
+            last = number;
+            ++report.replayed;
+            auto it = state.find(std::string(body + RecordBodySize, boardLength));
+
+            if (it == state.end()) {
+                continue;
+            }
+
+            std::string label(body + RecordBodySize + boardLength, length - RecordBodySize - boardLength);
+            it->second.set(stand, label, fromNanoseconds(time));
+        }
+
+        if (offset == data.size()) {
+            return true;
+        }
+
+        report.tornTail = true;
+
+        if (::truncate(path.c_str(), static_cast<off_t>(offset)) != 0) {
+            std::cerr << "Не удалось обрезать журнал состояния: " << path << std::endl;
+        }
+
+        return false;
+    }
+
+public:
+    // Конструктор; журнал начинает записывать изменения после recover и start
+    ClusterJournal(StandCluster& cluster, const std::string& directory, size_t snapshotEvery = WAL_SNAPSHOT_EVERY,
+                   std::chrono::milliseconds commitInterval = WAL_COMMIT_INTERVAL)
+        : cluster(cluster), directory(directory), snapshotEvery(snapshotEvery), commitInterval(commitInterval) {}
+
+    ClusterJournal(const ClusterJournal&) = delete;
+    ClusterJournal& operator=(const ClusterJournal&) = delete;
+
+    // Деструктор: остановка со снимком состояния
+    ~ClusterJournal() {
+        stop();
+    }
+
+    // Восстановление времени освобождения стендов кластера: снимок, затем записи журнала после него
+    // Стенды сопоставляются по названию платы и метке топологии (без метки - по слоту), поэтому стенды
+    // должны быть добавлены заранее; записи о стендах, которых в кластере больше нет, пропускаются
+    RecoveryReport recover() {
+        RecoveryReport report;
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        RecoveryState state;
+
+        for (auto& pair : cluster.exportStands()) {
+            RecoveredBoard& board = state[pair.first];
+            board.times.reserve(pair.second.size());
+
+            for (auto& stand : pair.second) {
+                if (stand.label.empty()) {
+                    board.unlabelled.emplace(stand.slot, board.times.size());
+                } else {
+                    board.labelled.emplace(std::move(stand.label), board.times.size());
+                }
+
+                board.times.push_back(stand.freeTime);
+            }
+        }
+
+        applySnapshot(state, report);
+
+        uint64_t last = report.snapshotSequence;
+        auto segments = listSegments();
+
+        for (size_t i = 0; i < segments.size(); ++i) {
+            ++report.segments;
+
+            if (!replaySegment(segments[i].second, state, last, report)) {
+                // Сегменты после оборванного не могут содержать согласованных записей
+                for (size_t j = i + 1; j < segments.size(); ++j) {
+                    ::unlink(segments[j].second.c_str());
+                }
+
+                break;
+            }
+        }
+
+        for (const auto& pair : state) {
+            report.standsRestored += cluster.restoreFreeTimes(pair.first, pair.second.times.data(), pair.second.times.size());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        sequence = durableSequence = report.lastSequence = last;
+        return report;
+    }
+
+    // Запуск журналирования изменений кластера
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (running) {
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        openSegment(sequence + 1);
+        stopping = false;
+        running = true;
+        committer = std::thread(&ClusterJournal::commitLoop, this);
+        cluster.setListener(this);
+    }
+
+    // Остановка журналирования; изменения кластера к этому моменту должны быть завершены
+    // withSnapshot = false оставляет только журнал (используется для проверки восстановления после сбоя)
+    void stop(bool withSnapshot = true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (!running) {
+                return;
+            }
+
+            cluster.setListener(nullptr);
+            stopping = true;
+            finalSnapshot = withSnapshot;
+        }
+
+        wakeUp.notify_all();
+        committer.join();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+
+    // Запись изменения в буфер; на диск попадает фоновым потоком не позже чем через commitInterval
+    void standChanged(const std::string& boardName, uint32_t slot, const std::string& label,
+                      std::chrono::system_clock::time_point freeTime) override {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!running || stopping || failed) {
+            return;
+        }
+
+        bool first = pending.empty();
+        encodeRecord(pending, ++sequence, boardName, slot, label, freeTime);
+
+        if (++sinceSnapshot >= snapshotEvery) {
+            sinceSnapshot = 0;
+            snapshotRequested = true;
+            wakeUp.notify_one();
+        } else if (first) {
+            wakeUp.notify_one();
+        }
+    }
+
+    // Внеочередной снимок состояния (например, после перезагрузки топологии): записи до него больше не повторяются
+    void requestSnapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (running && !stopping && !failed) {
+            sinceSnapshot = 0;
+            snapshotRequested = true;
+            wakeUp.notify_one();
+        }
+    }
+
+    // Ожидание, пока все уже сделанные изменения не будут сброшены на диск; false, если журнал отказал
+    bool waitDurable() {
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t target = sequence;
+        durableChanged.wait(lock, [this, target]() { return durableSequence >= target || !running || failed; });
+        return durableSequence >= target;
+    }
+
+    // Журнал отказал после ошибки записи
+    bool writeFailed() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return failed;
+    }
+
+    // Внедрение отказа записи сегмента и снимка (для проверки обработки ошибок)
+    void injectWriteFault(bool value) {
+        writeFault.store(value, std::memory_order_relaxed);
+    }
+
+    // Номер последней записи журнала
+    uint64_t lastSequence() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sequence;
+    }
+
+    // Количество снимков, сделанных с момента запуска
+    size_t snapshotsTaken() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return snapshots;
+    }
+};
+
+// Тест журнала состояния: восстановление после остановки, после сбоя и с повреждённым хвостом
+void testClusterJournal() {
+    using namespace std::chrono;
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "remote_stand_test_state";
+    std::filesystem::remove_all(directory);
+
+    auto base = system_clock::time_point(seconds(1700000000));
+    auto makeCluster = [base]() {
+        auto cluster = std::make_unique<StandCluster>();
+
+        for (int i = 0; i < 3; ++i) {
+            cluster->addStand(RemoteStand("Board A", base));
+            cluster->addStand(RemoteStand("Board B", base));
+        }
+
+        return cluster;
+    };
+    auto reserveMany = [base](StandCluster& cluster, int count) {
+        for (int i = 0; i < count; ++i) {
+            Reservation reservation;
+            assert(cluster.reserveEarliestStand(i % 3 == 0 ? "Board B" : "Board A", base, DELAY, reservation));
+        }
+    };
+
+    // Остановка со снимком: журнал после снимка пуст, состояние восстанавливается из снимка
+    auto original = makeCluster();
+    {
+        ClusterJournal journal(*original, directory.string(), 1000, milliseconds(1));
+        RecoveryReport report = journal.recover();
+        assert(!report.snapshotLoaded && report.replayed == 0);
+        journal.start();
+        reserveMany(*original, 50);
+        original->increaseDelay("Board B", 1, seconds(30));
+        assert(journal.lastSequence() == 51);
+    }
+
+    auto restored = makeCluster();
+    {
+        ClusterJournal journal(*restored, directory.string());
+        RecoveryReport report = journal.recover();
+        assert(report.snapshotLoaded && report.snapshotSequence == 51 && report.replayed == 0);
+        assert(report.standsRestored == 6);
+        assert(*restored == *original);
+    }
+
+    // Сбой без итогового снимка: частые снимки плюс хвост журнала
+    {
+        ClusterJournal journal(*original, directory.string(), 16, milliseconds(1));
+        journal.recover();
+        journal.start();
+        reserveMany(*original, 100);
+        journal.waitDurable();
+        journal.stop(false);
+        assert(journal.snapshotsTaken() >= 1);
+    }
+
+    restored = makeCluster();
+    {
+        ClusterJournal journal(*restored, directory.string());
+        RecoveryReport report = journal.recover();
+        assert(report.snapshotLoaded && report.lastSequence == 151 && !report.tornTail);
+        assert(report.snapshotSequence + report.replayed == 151);
+        assert(*restored == *original);
+    }
+
+    // Оборванная запись в конце сегмента отбрасывается, предыдущие записи сохраняются
+    std::string lastSegment;
+
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == ".log") {
+            lastSegment = std::max(lastSegment, entry.path().string());
+        }
+    }
+
+    assert(!lastSegment.empty());
+    auto validSize = std::filesystem::file_size(lastSegment);
+    {
+        std::ofstream tail(lastSegment, std::ios::binary | std::ios::app);
+        tail.write("\x30\x00\x00\x00garbage", 11);
+    }
+
+    restored = makeCluster();
+    {
+        ClusterJournal journal(*restored, directory.string());
+        RecoveryReport report = journal.recover();
+        assert(report.tornTail && report.lastSequence == 151);
+        assert(*restored == *original);
+        assert(std::filesystem::file_size(lastSegment) == validSize);
+    }
+
+    // Ошибка записи: журнал отказывает, граница сброшенных записей не сдвигается, восстановление видит только их
+    uint64_t durable = 0;
+    {
+        ClusterJournal journal(*restored, directory.string(), 1000, milliseconds(1));
+        journal.recover();
+        journal.start();
+        reserveMany(*restored, 10);
+        assert(journal.waitDurable() && !journal.writeFailed());
+        durable = journal.lastSequence();
+
+        // Запись сегмента и снимка завершается ошибкой
+        journal.injectWriteFault(true);
+        reserveMany(*restored, 5);
+        assert(!journal.waitDurable() && journal.writeFailed());
+        journal.injectWriteFault(false);
+        reserveMany(*restored, 5);
+        assert(journal.lastSequence() == durable + 5);
+        journal.stop(false);
+    }
+
+    {
+        auto recovered = makeCluster();
+        ClusterJournal journal(*recovered, directory.string());
+        RecoveryReport report = journal.recover();
+        assert(report.lastSequence == durable && !report.tornTail);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+// Стенды одной платы в топологии: numbered стендов с метками "#1".."#n" и стенды с явными метками
+struct TopologyBoard {
+    std::string name;
+    size_t numbered = 0;
+    std::vector<std::string> labels;
+
+    bool operator==(const TopologyBoard& other) const {
+        return name == other.name && numbered == other.numbered && labels == other.labels;
+    }
+};
+
+// Топология кластера: какие стенды каких плат должны существовать
+struct Topology {
+    std::vector<TopologyBoard> boards;
+
+    // Количество стендов во всех платах
+    size_t standsCount() const {
+        size_t count = 0;
+
+        for (const auto& board : boards) {
+            count += board.numbered + board.labels.size();
+        }
+
+        return count;
+    }
+};
+
+// Строка без пробельных символов по краям
+std::string_view trimmed(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+
+    return text;
+}
+
+// Разбор текстовой топологии. Строки вида "плата = количество" задают нумерованные стенды,
+// "плата: метка, метка" - стенды с явными метками; пустые строки и строки с # в начале пропускаются
+// Плата может встречаться в нескольких строках, но количество задаётся один раз, а метки не повторяются
+bool parseTopologyText(std::string_view text, Topology& topology, std::string& error) {
+    std::map<std::string, size_t, std::less<>> positions;
+    std::vector<std::set<std::string, std::less<>>> seen;
+    std::vector<bool> counted;
+    size_t lineNumber = 0;
+
+    topology.boards.clear();
+
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = trimmed(text.substr(0, end));
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        ++lineNumber;
+
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+
+        auto fail = [&error, lineNumber](const std::string& message) {
+            error = "строка " + std::to_string(lineNumber) + ": " + message;
+            return false;
+        };
+
+        size_t separator = line.find_first_of(":=");
+
+        if (separator == std::string_view::npos) {
+            return fail("ожидается \"плата = количество\" или \"плата: метки\"");
+        }
+
+        std::string_view name = trimmed(line.substr(0, separator));
+        std::string_view value = trimmed(line.substr(separator + 1));
+
+        if (name.empty() || name.size() > UINT16_MAX) {
+            return fail("неверное название платы");
+        }
+
+        auto position = positions.find(name);
+
+        if (position == positions.end()) {
+            position = positions.emplace(std::string(name), topology.boards.size()).first;
+            topology.boards.push_back(TopologyBoard{std::string(name), 0, {}});
+            seen.emplace_back();
+            counted.push_back(false);
+        }
+
+        TopologyBoard& board = topology.boards[position->second];
+
+        if (line[separator] == '=') {
+            size_t count = 0;
+            auto parsed = std::from_chars(value.data(), value.data() + value.size(), count);
+
+            if (value.empty() || parsed.ec != std::errc() || parsed.ptr != value.data() + value.size() || count > UINT32_MAX) {
+                return fail("неверное количество стендов: " + std::string(value));
+            }
+
+            if (counted[position->second]) {
+                return fail("количество стендов платы " + board.name + " уже задано");
+            }
+
+            counted[position->second] = true;
+            board.numbered = count;
+            continue;
+        }
+
+        while (!value.empty()) {
+            size_t comma = value.find(',');
+            std::string_view label = trimmed(value.substr(0, comma));
+            value.remove_prefix(comma == std::string_view::npos ? value.size() : comma + 1);
+
+            if (label.empty() || label.front() == '#' || label.size() > UINT16_MAX) {
+                return fail("неверная метка стенда: \"" + std::string(label) + "\"");
+            }
+
+            if (!seen[position->second].emplace(label).second) {
+                return fail("метка " + std::string(label) + " платы " + board.name + " повторяется");
+            }
+
+            board.labels.emplace_back(label);
+        }
+    }
+
+    return true;
+}
+
+// Компактная двоичная топология: "RSTOPO01", число плат (4), резерв (4), FNV-1a данных (8), затем по каждой плате:
+// длина названия (2), количество нумерованных стендов (4), число меток (4), название, метки (длина (2) и байты)
+// Плата с нумерованными стендами занимает десяток байт при любом количестве стендов
+std::string topologyBinary(const Topology& topology) {
+    std::string data(24, '\0');
+    uint32_t boardCount = static_cast<uint32_t>(topology.boards.size());
+
+    auto put = [&data](const void* value, size_t size) {
+        data.append(static_cast<const char*>(value), size);
+    };
+
+    for (const auto& board : topology.boards) {
+        uint16_t nameLength = static_cast<uint16_t>(board.name.size());
+        uint32_t numbered = static_cast<uint32_t>(board.numbered);
+        uint32_t labelCount = static_cast<uint32_t>(board.labels.size());
+        put(&nameLength, 2);
+        put(&numbered, 4);
+        put(&labelCount, 4);
+        put(board.name.data(), board.name.size());
+
+        for (const auto& label : board.labels) {
+            uint16_t labelLength = static_cast<uint16_t>(label.size());
+            put(&labelLength, 2);
+            put(label.data(), label.size());
+        }
+    }
+
+    uint64_t checksum = fnv1a64(data.data() + 24, data.size() - 24);
+    std::memcpy(&data[0], "RSTOPO01", 8);
+    std::memcpy(&data[8], &boardCount, 4);
+    std::memcpy(&data[16], &checksum, 8);
+    return data;
+}
+
+// Разбор двоичной топологии с проверкой контрольной суммы, границ и повторов
+bool parseTopologyBinary(std::string_view data, Topology& topology, std::string& error) {
+    uint32_t boardCount = 0;
+    uint64_t checksum = 0;
+
+    topology.boards.clear();
+
+    if (data.size() < 24 || data.substr(0, 8) != "RSTOPO01") {
+        error = "неверный заголовок двоичной топологии";
+        return false;
+    }
+
+    std::memcpy(&boardCount, data.data() + 8, 4);
+    std::memcpy(&checksum, data.data() + 16, 8);
+
+    if (fnv1a64(data.data() + 24, data.size() - 24) != checksum) {
+        error = "контрольная сумма двоичной топологии не совпадает";
+        return false;
+    }
+
+    std::set<std::string_view> names;
+    size_t offset = 24;
+
+    for (uint32_t i = 0; i < boardCount; ++i) {
+        uint16_t nameLength = 0;
+        uint32_t numbered = 0;
+        uint32_t labelCount = 0;
+
+        if (data.size() - offset < 10) {
+            error = "двоичная топология обрезана";
+            return false;
+        }
+
+        std::memcpy(&nameLength, data.data() + offset, 2);
+        std::memcpy(&numbered, data.data() + offset + 2, 4);
+        std::memcpy(&labelCount, data.data() + offset + 6, 4);
+        offset += 10;
+
+        if (data.size() - offset < nameLength || nameLength == 0 || !names.insert(data.substr(offset, nameLength)).second) {
+            error = "неверное название платы в двоичной топологии";
+            return false;
+        }
+
+        TopologyBoard board{std::string(data.substr(offset, nameLength)), numbered, {}};
+        std::set<std::string_view> labels;
+        offset += nameLength;
+
+        for (uint32_t j = 0; j < labelCount; ++j) {
+            uint16_t labelLength = 0;
+
+            if (data.size() - offset < 2) {
+                error = "двоичная топология обрезана";
+                return false;
+            }
+
+            std::memcpy(&labelLength, data.data() + offset, 2);
+            offset += 2;
+            std::string_view label = data.substr(offset, labelLength);
+
+            if (data.size() - offset < labelLength || label.empty() || label.front() == '#' || !labels.insert(label).second) {
+                error = "неверная метка стенда платы " + board.name + " в двоичной топологии";
+                return false;
+            }
+
+            board.labels.emplace_back(label);
+            offset += labelLength;
+        }
+
+        topology.boards.push_back(std::move(board));
+    }
+
+    if (offset != data.size()) {
+        error = "лишние данные в конце двоичной топологии";
+        return false;
+    }
+
+    return true;
+}
+
+// Загрузка топологии из файла: двоичная форма распознаётся по заголовку, иначе файл разбирается как текст
+bool loadTopology(const std::string& path, Topology& topology, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open()) {
+        error = "не удалось открыть файл " + path;
+        return false;
+    }
+
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.compare(0, 8, "RSTOPO01") == 0) {
+        return parseTopologyBinary(data, topology, error);
+    }
+
+    return parseTopologyText(data, topology, error);
+}
+
+// Итог применения топологии: добавленные и удалённые стенды (из них занятые или забронированные),
+// стенды топологии после применения, общее время и наибольшая пауза заявок на одну плату
+struct TopologyReport {
+    size_t added = 0;
+    size_t removed = 0;
+    size_t busyRemoved = 0;
+    size_t stands = 0;
+    std::chrono::nanoseconds elapsed{0};
+    std::chrono::nanoseconds longestHold{0};
+};
+
+// Стенды кластера, заданные топологией, по меткам
+// Применяется только разница с текущей топологией: стенды сохранившихся меток остаются вместе с календарями, бронями
+// и постоянными номерами, для новых меток добавляются стенды, стенды исчезнувших меток удаляются
+// Новые стенды добавляются до удаления старых, поэтому число стендов платы не проседает во время перезагрузки
+// Стенды, добавленные в кластер не через топологию, не затрагиваются
+class ClusterTopology {
+private:
+    // Стенды платы: нумерованные по порядку и по явным меткам
+    struct BoardState {
+        std::vector<StandHandle> numbered;
+        std::unordered_map<std::string, StandHandle> labelled;
+    };
+
+    StandCluster& cluster;
+    std::string path;
+    std::map<std::string, BoardState, std::less<>> boards;
+    mutable std::mutex mutex;
+
+    // Учёт пакетного изменения стендов в итоге
+    static void account(TopologyReport& report, const StandBatchResult& result, bool added) {
+        (added ? report.added : report.removed) += result.changed;
+        report.busyRemoved += result.busy;
+        report.longestHold = std::max(report.longestHold, result.longestHold);
+    }
+
+public:
+    // Топология кластера cluster из файла path (пустой путь - топология задаётся только через apply)
+    explicit ClusterTopology(StandCluster& cluster, std::string path = "") : cluster(cluster), path(std::move(path)) {}
+
+    // Файл топологии
+    const std::string& source() const {
+        return path;
+    }
+
+    // Применение топологии: новые стенды свободны с now, стенды, занятые после now, учитываются в busyRemoved
+    TopologyReport apply(const Topology& topology, std::chrono::system_clock::time_point now) {
+        using namespace std::chrono;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto started = steady_clock::now();
+        TopologyReport report;
+        std::vector<StandHandle> removing;
+        std::set<std::string_view> present;
+
+        for (const auto& desired : topology.boards) {
+            BoardState& state = boards[desired.name];
+            present.insert(desired.name);
+
+            if (state.numbered.size() > desired.numbered) {
+                removing.insert(removing.end(), state.numbered.begin() + desired.numbered, state.numbered.end());
+                state.numbered.resize(desired.numbered);
+            } else if (state.numbered.size() < desired.numbered) {
+                size_t first = state.numbered.size();
+                account(report, cluster.addStands(desired.name, desired.numbered - first, now, state.numbered, [first](size_t i) {
+                    return "#" + std::to_string(first + i + 1);
+                }), true);
+            }
+
+            std::unordered_set<std::string_view> wanted(desired.labels.begin(), desired.labels.end());
+            std::vector<const std::string*> fresh;
+
+            for (auto it = state.labelled.begin(); it != state.labelled.end();) {
+                if (wanted.count(it->first)) {
+                    ++it;
+                    continue;
+                }
+
+                removing.push_back(it->second);
+                it = state.labelled.erase(it);
+            }
+
+            for (const auto& label : desired.labels) {
+                if (!state.labelled.count(label)) {
+                    fresh.push_back(&label);
+                }
+            }
+
+            std::vector<StandHandle> handles;
+            account(report, cluster.addStands(desired.name, fresh.size(), now, handles, [&fresh](size_t i) {
+                return *fresh[i];
+            }), true);
+
+            for (size_t i = 0; i < fresh.size(); ++i) {
+                state.labelled.emplace(*fresh[i], handles[i]);
+            }
+        }
+
+        // Платы, исчезнувшие из топологии, лишаются всех своих стендов
+        for (auto it = boards.begin(); it != boards.end();) {
+            if (present.count(it->first)) {
+                report.stands += it->second.numbered.size() + it->second.labelled.size();
+                ++it;
+                continue;
+            }
+
+            removing.insert(removing.end(), it->second.numbered.begin(), it->second.numbered.end());
+
+            for (const auto& pair : it->second.labelled) {
+                removing.push_back(pair.second);
+            }
+
+            it = boards.erase(it);
+        }
+
+        account(report, cluster.removeStands(removing, now), false);
+        report.elapsed = duration_cast<nanoseconds>(steady_clock::now() - started);
+        return report;
+    }
+
+    // Перечитывание файла топологии и применение разницы; при ошибке разбора кластер не меняется
+    bool reload(TopologyReport& report, std::string& error) {
+        Topology topology;
+
+        if (!loadTopology(path, topology, error)) {
+            return false;
+        }
+
+        report = apply(topology, std::chrono::system_clock::now());
+        return true;
+    }
+
+    // Постоянный номер стенда платы по метке ("#n" - n-й нумерованный стенд); false, если такого стенда нет
+    bool find(std::string_view boardName, std::string_view label, StandHandle& handle) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto board = boards.find(boardName);
+
+        if (board == boards.end()) {
+            return false;
+        }
+
+        if (!label.empty() && label.front() == '#') {
+            size_t number = 0;
+            auto parsed = std::from_chars(label.data() + 1, label.data() + label.size(), number);
+
+            if (parsed.ec != std::errc() || number == 0 || number > board->second.numbered.size()) {
+                return false;
+            }
+
+            handle = board->second.numbered[number - 1];
+            return true;
+        }
+
+        auto it = board->second.labelled.find(std::string(label));
+
+        if (it == board->second.labelled.end()) {
+            return false;
+        }
+
+        handle = it->second;
+        return true;
+    }
+};
+
+// Вывод итога применения топологии
+void printTopologyReport(std::ostream& out, const TopologyReport& report) {
+    using namespace std::chrono;
+
+    out << "Топология применена: стендов " << report.stands << ", добавлено " << report.added << ", удалено " << report.removed;
+
+    if (report.busyRemoved > 0) {
+        out << " (из них занятых " << report.busyRemoved << ")";
+    }
+
+    out << ", за " << duration<double, std::milli>(report.elapsed).count() << " мс, наибольшая пауза платы "
+        << duration<double, std::micro>(report.longestHold).count() << " мкс" << std::endl;
+}
+
+// Тесты топологии кластера
+void testTopology() {
+    using namespace std::chrono;
+
+    // Разбор текста: нумерованные стенды, метки в нескольких строках, комментарии и ошибки с номером строки
+    Topology topology;
+    std::string error;
+    assert(parseTopologyText("# стенды\nArduino Uno = 2\n\nSTM-32: stm-a, stm-b\n  STM-32 : stm-c\r\n", topology, error));
+    assert(topology.boards.size() == 2 && topology.standsCount() == 5);
+    assert(topology.boards[0].name == "Arduino Uno" && topology.boards[0].numbered == 2);
+    assert((topology.boards[1].labels == std::vector<std::string>{"stm-a", "stm-b", "stm-c"}));
+
+    Topology broken;
+    assert(!parseTopologyText("Arduino Uno = 2\nSTM-32: a, a\n", broken, error) && error.find("строка 2") == 0);
+    assert(!parseTopologyText("Arduino Uno = два\n", broken, error));
+    assert(!parseTopologyText("Arduino Uno = 1\nArduino Uno = 2\n", broken, error));
+    assert(!parseTopologyText("Arduino Uno\n", broken, error));
+    assert(!parseTopologyText("STM-32: a,,b\n", broken, error));
+
+    // Двоичная форма: совпадает с текстовой, повреждение и обрезка обнаруживаются
+    std::string binary = topologyBinary(topology);
+    Topology decoded;
+    assert(parseTopologyBinary(binary, decoded, error) && decoded.boards == topology.boards);
+    binary[30] ^= 1;
+    assert(!parseTopologyBinary(binary, decoded, error));
+    assert(!parseTopologyBinary(topologyBinary(topology).substr(0, 40), decoded, error));
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "remote_stand_test_topology.bin";
+    std::ofstream(path, std::ios::binary) << topologyBinary(topology);
+    assert(loadTopology(path.string(), decoded, error) && decoded.boards == topology.boards);
+
+    // Перезагрузка сохраняет стенды оставшихся меток вместе с бронями, стенды вне топологии не трогает
+    auto base = system_clock::now();
+    StandCluster cluster;
+    StandHandle manual = cluster.addStand(RemoteStand("Arduino Uno", base + hours(1)));
+    ClusterTopology stands(cluster, path.string());
+    TopologyReport report;
+    assert(stands.reload(report, error) && report.added == 5 && report.removed == 0 && report.stands == 5);
+    assert(cluster.standsCount() == 6);
+
+    StandHandle stmB;
+    Reservation reservation;
+    assert(stands.find("STM-32", "stm-b", stmB) && !stands.find("STM-32", "stm-d", stmB));
+    assert(cluster.reserveAt("STM-32", base, base + seconds(10), seconds(10), reservation));
+    assert(stands.find("STM-32", "stm-a", stmB) && reservation.stand == stmB);
+
+    Topology next;
+    assert(parseTopologyText("Arduino Uno = 1\nSTM-32: stm-c, stm-a, stm-d\nDE10-Lite = 3\n", next, error));
+    report = stands.apply(next, system_clock::now());
+    assert(report.added == 4 && report.removed == 2 && report.busyRemoved == 0 && report.stands == 7);
+    assert(cluster.standsCount() == 8 && cluster.standIndex(manual, reservation.standIndex));
+    assert(stands.find("STM-32", "stm-a", stmB) && reservation.stand == stmB);
+    assert(cluster.standIndex(stmB, reservation.standIndex));
+    assert(cluster.getStandsByBoard("STM-32")[reservation.standIndex].getFreeTime() == reservation.freeTime);
+
+    // Удаление занятого стенда учитывается, исчезнувшая плата теряет все стенды топологии
+    assert(parseTopologyText("STM-32: stm-c, stm-d\n", next, error));
+    report = stands.apply(next, system_clock::now());
+    assert(report.removed == 5 && report.busyRemoved == 1 && report.stands == 2);
+    assert(!cluster.standIndex(reservation.stand, reservation.standIndex));
+    assert(cluster.getStandsByBoard("Arduino Uno").size() == 1 && cluster.getStandsByBoard("DE10-Lite").empty());
+    std::filesystem::remove(path);
+
+    // Большая плата: новая плата заполняется до публикации, изменения существующей - короткими порциями,
+    // а заявки на плату обслуживаются во время перезагрузки
+    StandCluster big;
+    ClusterTopology bigStands(big);
+    Topology large{{TopologyBoard{"Board Big", 100000, {}}}};
+    report = bigStands.apply(large, base);
+    assert(report.added == 100000 && report.longestHold == nanoseconds(0) && big.standsCount() == 100000);
+
+    large.boards[0].numbered = 110000;
+    TopologyReport grown = bigStands.apply(large, base);
+    large.boards[0].numbered = 90000;
+    TopologyReport shrunk = bigStands.apply(large, base);
+    assert(grown.added == 10000 && shrunk.removed == 20000 && big.standsCount() == 90000);
+
+    // Рост в пределах запаса и сверх него: сегменты столбцов выделяются вне блокировки, стенды не переносятся
+    // (время удержания блокировки зависит от загрузки машины и замеряется в benchTopologyReload)
+    StandCluster sized;
+    ClusterTopology sizedStands(sized);
+    Topology resized{{TopologyBoard{"Board Sized", 100000, {}}}};
+    sizedStands.apply(resized, base);
+
+    for (size_t count : {110000, 200000, 90000}) {
+        resized.boards[0].numbered = count;
+        TopologyReport step = sizedStands.apply(resized, base);
+        assert(step.stands == count && sized.standsCount() == count);
+    }
+
+    std::atomic<bool> reloading{true};
+    std::atomic<size_t> reserved{0};
+    std::thread client([&]() {
+        Reservation booked;
+
+        while (reloading.load()) {
+            reserved += big.reserveEarliestStand("Board Big", base, seconds(1), booked);
+        }
+    });
+
+    while (reserved.load() == 0) {
+        std::this_thread::yield();
+    }
+
+    // Рост вдвое превышает запас в столбцах, заявки продолжают обслуживаться
+    for (size_t count : {200000, 80000}) {
+        large.boards[0].numbered = count;
+        bigStands.apply(large, base);
+    }
+
+    reloading = false;
+    client.join();
+    assert(big.standsCount() == 80000 && big.getStandsByBoard("Board Big").size() == 80000);
+
+    // Журнал состояния сопоставляет стенды по меткам: перезагрузка с удалением переставляет индексы стендов,
+    // а после перезапуска стенды строятся в порядке файла, но времена восстанавливаются на свои стенды
+    std::filesystem::path state = std::filesystem::temp_directory_path() / "remote_stand_test_topology_state";
+    std::filesystem::remove_all(state);
+    Topology before{{TopologyBoard{"Board J", 4, {"a", "b", "c"}}}};
+    Topology after{{TopologyBoard{"Board J", 2, {"a", "c"}}}};
+    std::map<std::string, system_clock::time_point> expected;
+
+    auto timeOf = [](StandCluster& target, ClusterTopology& labels, const std::string& label) {
+        StandHandle handle;
+        size_t index = 0;
+        assert(labels.find("Board J", label, handle) && target.standIndex(handle, index));
+        return target.getStandsByBoard("Board J")[index].getFreeTime();
+    };
+    auto setTime = [&expected](StandCluster& target, ClusterTopology& labels, const std::string& label, system_clock::time_point time) {
+        StandHandle handle;
+        size_t index = 0;
+        assert(labels.find("Board J", label, handle) && target.standIndex(handle, index));
+        target.updateFreeTime("Board J", index, time);
+        expected[label] = time;
+    };
+    auto restoredMatches = [&](bool finalSnapshot) {
+        StandCluster restarted;
+        ClusterTopology restartedLabels(restarted);
+        restartedLabels.apply(after, base);
+        ClusterJournal journal(restarted, state.string());
+        RecoveryReport recovered = journal.recover();
+        assert(recovered.snapshotLoaded == finalSnapshot && recovered.standsRestored == 4);
+
+        for (const auto& pair : expected) {
+            assert(timeOf(restarted, restartedLabels, pair.first) == pair.second);
+        }
+    };
+
+    StandCluster journaled;
+    ClusterTopology journaledLabels(journaled);
+    journaledLabels.apply(before, base);
+    {
+        ClusterJournal journal(journaled, state.string(), 1000, milliseconds(1));
+        journal.recover();
+        journal.start();
+        int hour = 1;
+
+        for (const char* label : {"#1", "#2", "#3", "#4", "a", "b", "c"}) {
+            setTime(journaled, journaledLabels, label, base + hours(hour++));
+        }
+
+        report = journaledLabels.apply(after, base);
+        assert(report.removed == 3);
+        expected.erase("#3");
+        expected.erase("#4");
+        expected.erase("b");
+        setTime(journaled, journaledLabels, "c", base + hours(10));
+
+        // Сбой без итогового снимка: повторяются записи журнала, сделанные до и после перестановки
+        journal.waitDurable();
+        journal.stop(false);
+    }
+
+    restoredMatches(false);
+    {
+        ClusterJournal journal(journaled, state.string());
+        journal.recover();
+        journal.start();
+        setTime(journaled, journaledLabels, "#2", base + hours(20));
+    }
+
+    restoredMatches(true);
+    std::filesystem::remove_all(state);
+}
+
+// Структура для хранения о заявке
+struct Request {
+    std::string lastName;
+    std::string firstName;
+    std::string patronymic;
+    std::string group;
+    std::string boardName;
+    std::string executablePath;
+    std::string resultPath;
+};
+
+// Заявка без владения строками: поля указывают в арену пачки заявок, в таблицу интернированных строк
+// или в поля обычной заявки. Представление действительно, пока жив владелец строк
+// (см. RequestArena и StringInterner); заявки, которые хранятся дольше, копируются в Request через toRequest
+struct RequestView {
+    std::string_view lastName;
+    std::string_view firstName;
+    std::string_view patronymic;
+    std::string_view group;
+    std::string_view boardName;
+    std::string_view executablePath;
+    std::string_view resultPath;
+
+    RequestView() = default;
+
+    // Представление обычной заявки (действительно, пока заявка не изменена и не удалена)
+    RequestView(const Request& request)
+        : lastName(request.lastName), firstName(request.firstName), patronymic(request.patronymic), group(request.group),
+          boardName(request.boardName), executablePath(request.executablePath), resultPath(request.resultPath) {}
+
+    // Копия заявки со своими строками
+    Request toRequest() const {
+        return Request{std::string(lastName), std::string(firstName), std::string(patronymic), std::string(group),
+                       std::string(boardName), std::string(executablePath), std::string(resultPath)};
+    }
+};
+
+// Таблица интернированных строк: каждая различная строка хранится один раз до завершения программы
+// Подходит для полей с малым числом значений (плата, группа); строки никогда не удаляются,
+// поэтому представления можно хранить где угодно, в том числе в таймерах и очередях
+class StringInterner {
+private:
+    std::unordered_set<std::string_view> strings;
+    std::deque<std::string> storage;
+    mutable std::shared_mutex mutex;
+
+public:
+    // Интернированная копия строки; повторные строки находятся под блокировкой на чтение без выделения памяти
+    std::string_view intern(std::string_view text) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = strings.find(text);
+
+            if (it != strings.end()) {
+                return *it;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = strings.find(text);
+
+        if (it != strings.end()) {
+            return *it;
+        }
+
+        // Элементы std::deque не перемещаются при добавлении в конец
+        storage.emplace_back(text);
+        return *strings.insert(storage.back()).first;
+    }
+
+    // Количество различных строк
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return strings.size();
+    }
+};
+
+// Общая таблица интернированных строк программы
+StringInterner& internedStrings() {
+    static StringInterner interner;
+    return interner;
+}
+
+// Арена строк пачки заявок: строки копируются подряд в крупные блоки
+// Память выделяется блоками по REQUEST_ARENA_CHUNK (строка длиннее блока получает свой блок),
+// reset освобождает все строки разом, но оставляет блоки для следующей пачки
+// Строки арены действительны до reset или удаления арены; арена используется одним потоком
+class RequestArena {
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<size_t> capacities;
+    // Текущий блок и занятая в нём часть
+    size_t current = 0;
+    size_t used = 0;
+
+public:
+    RequestArena() = default;
+
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    // Копия строки в арене
+    std::string_view store(std::string_view text) {
+        if (text.empty()) {
+            return std::string_view();
+        }
+
+        while (current < blocks.size() && used + text.size() > capacities[current]) {
+            ++current;
+            used = 0;
+        }
+
+        if (current == blocks.size()) {
+            size_t capacity = std::max<size_t>(REQUEST_ARENA_CHUNK, text.size());
+            blocks.emplace_back(new char[capacity]);
+            capacities.push_back(capacity);
+            used = 0;
+        }
+
+        char* target = blocks[current].get() + used;
+        std::memcpy(target, text.data(), text.size());
+        used += text.size();
+        return std::string_view(target, text.size());
+    }
+
+    // Копия заявки: все поля копируются в арену
+    // Плата и группа не интернируются здесь: таблица интернирования не очищается, и заявка на несуществующую
+    // плату росла бы её без предела. Обработчик интернирует их сам, когда заявка получает стенд или встаёт в очередь
+    RequestView store(const RequestView& request) {
+        RequestView result;
+        result.lastName = store(request.lastName);
+        result.firstName = store(request.firstName);
+        result.patronymic = store(request.patronymic);
+        result.group = store(request.group);
+        result.boardName = store(request.boardName);
+        result.executablePath = store(request.executablePath);
+        result.resultPath = store(request.resultPath);
+        return result;
+    }
+
+    // Освобождение всех строк с сохранением блоков
+    void reset() {
+        current = 0;
+        used = 0;
+    }
+
+    // Количество выделенных блоков
+    size_t blocksCount() const {
+        return blocks.size();
+    }
+};
+
+// Тесты представления заявки, интернирования строк и арены
+void testRequestArena() {
+    // Одинаковые строки интернируются в одну копию
+    StringInterner interner;
+    std::string board = "Arduino Uno";
+    std::string_view first = interner.intern(board);
+    board[0] = 'a';
+    assert(first == "Arduino Uno");
+    assert(interner.intern("Arduino Uno").data() == first.data());
+    assert(interner.intern(board).data() != first.data() && interner.size() == 2);
+
+    // Все поля копируются в арену, общая таблица интернирования не растёт
+    Request request{"Иванов", "Иван", "Иванович", "БИВ222", "Arduino Uno", "main.exe", "C:"};
+    RequestArena arena;
+    size_t interned = internedStrings().size();
+    RequestView view = arena.store(RequestView(request));
+    request.lastName = "Петров";
+    request.boardName = "Arduino Nano";
+    assert(view.lastName == "Иванов" && view.resultPath == "C:" && view.boardName == "Arduino Uno");
+    assert(internedStrings().size() == interned);
+    assert(view.toRequest().executablePath == "main.exe");
+
+    // После reset блоки переиспользуются, длинная строка получает свой блок
+    for (int i = 0; i < 3; ++i) {
+        arena.reset();
+
+        for (int j = 0; j < 10000; ++j) {
+            arena.store(RequestView(request));
+        }
+    }
+
+    size_t blocks = arena.blocksCount();
+    assert(blocks >= 1);
+    std::string huge(REQUEST_ARENA_CHUNK + 1, 'x');
+    assert(arena.store(huge) == huge && arena.blocksCount() == blocks + 1);
+    assert(arena.store(std::string_view()).empty());
+}
+
+// Классы символов ASCII для валидаторов
+enum CharClass : uint8_t {
+    CHAR_LETTER = 1,
+    CHAR_DIGIT = 2,
+    CHAR_PATH_PUNCT = 4
+};
+
+// Таблица классов для всех 256 значений байта, строится на этапе компиляции
+constexpr std::array<uint8_t, 256> makeCharClasses() {
+    std::array<uint8_t, 256> table{};
+
+    for (int c = 'a'; c <= 'z'; ++c) {
+        table[c] |= CHAR_LETTER;
+        table[c - 'a' + 'A'] |= CHAR_LETTER;
+    }
+
+    for (int c = '0'; c <= '9'; ++c) {
+        table[c] |= CHAR_DIGIT;
+    }
+
+    for (char c : {'_', '/', '\\', ':', '.'}) {
+        table[static_cast<uint8_t>(c)] |= CHAR_PATH_PUNCT;
+    }
+
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> charClasses = makeCharClasses();
+
+// Проверка двухбайтовой последовательности UTF-8 на кириллическую букву (А-Я, а-я, Ё, ё)
+inline bool isCyrillicLetter(uint8_t lead, uint8_t next) {
+    if (lead == 0xD0) {
+        return (next >= 0x90 && next <= 0xBF) || next == 0x81;
+    }
+
+    if (lead == 0xD1) {
+        return (next >= 0x80 && next <= 0x8F) || next == 0x91;
+    }
+
+    return false;
+}
+
+#ifdef __SSE2__
+// Проверка 16 байт ASCII за раз, возвращает маску байтов, попавших в разрешённые классы
+inline int matchAsciiBlock(__m128i block, uint8_t allowed) {
+    __m128i ok = _mm_setzero_si128();
+
+    if (allowed & CHAR_LETTER) {
+        __m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20));
+        ok = _mm_or_si128(ok, _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                            _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1))));
+    }
+
+    if (allowed & CHAR_DIGIT) {
+        ok = _mm_or_si128(ok, _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)),
+                                            _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1))));
+    }
+
+    if (allowed & CHAR_PATH_PUNCT) {
+        for (char c : {'_', '/', '\\', ':', '.'}) {
+            ok = _mm_or_si128(ok, _mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+        }
+    }
+
+    return _mm_movemask_epi8(ok);
+}
+#endif
+
+// Проверка строки на символы заданных классов за один проход без выделения памяти
+// Кириллические буквы разбираются как двухбайтовые последовательности UTF-8
+bool matchesCharClasses(std::string_view text, uint8_t allowed, bool allowCyrillic) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+    size_t size = text.size();
+    size_t i = 0;
+
+    if (size == 0) {
+        return false;
+    }
+
+#ifdef __SSE2__
+    // Быстрый путь для ASCII: блоки по 16 байт, до первого не-ASCII байта
+    while (i + 16 <= size) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+
+        if (_mm_movemask_epi8(block) != 0) {
+            break;
+        }
+
+        if (matchAsciiBlock(block, allowed) != 0xFFFF) {
+            return false;
+        }
+
+        i += 16;
+    }
+#endif
+
+    while (i < size) {
+        uint8_t c = data[i];
+
+        if (c < 0x80) {
+            if (!(charClasses[c] & allowed)) {
+                return false;
+            }
+
+            ++i;
+        } else if (allowCyrillic && i + 1 < size && isCyrillicLetter(c, data[i + 1])) {
+            i += 2;
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Функция проверки пути файла
+bool isValidFilePath(std::string_view path) {
+    // Латинские буквы, цифры и разделители путей (можно улучшить под платформу)
+    return matchesCharClasses(path, CHAR_LETTER | CHAR_DIGIT | CHAR_PATH_PUNCT, false);
+}
+
+// Тесты для функции проверки пути файла
+void testIsValidFilePath() {
+    // Тестирование валидных путей
+    assert(isValidFilePath("/path/to/executable"));
+    assert(isValidFilePath("C:/Users/Username/Documents/test.exe"));
+    assert(isValidFilePath("valid_path/with/underscore"));
+    
+    // Тестирование невалидных путей
+    assert(!isValidFilePath("invalid|path"));
+    assert(!isValidFilePath("path with spaces"));
+    assert(!isValidFilePath("<invalid>path"));
+}
+
+// Функция проверки группы
+bool isValidGroup(std::string_view group) {
+    // Проверка на строку, состоящую из букв (русских и латинских) и цифр
+    return matchesCharClasses(group, CHAR_LETTER | CHAR_DIGIT, true);
+}
+
+// Тесты для функции проверки группы
+void testIsValidGroup() {
+    // Тестирование валидных групп
+    assert(isValidGroup("Group123"));
+    assert(isValidGroup("Group01"));
+    assert(isValidGroup("12345"));
+    
+    // Тестирование невалидных групп
+    assert(!isValidGroup("Group@123"));
+    assert(!isValidGroup("Invalid Group"));
+    assert(!isValidGroup("Group#123"));
+}
+
+// Функция проверки имени
+bool isValidName(std::string_view name) {
+    // Проверка только букв (латинских и кириллических) без пробелов
+    return matchesCharClasses(name, CHAR_LETTER, true);
+}
+
+// Тесты для функции проверки имени
+void testIsValidName() {
+    // Тестирование валидных имен
+    assert(isValidName("John"));
+    assert(isValidName("Смирнов"));
+    assert(isValidName("JaneDoe"));
+    
+    // Тестирование невалидных имен
     assert(!isValidName("John123"));
     assert(!isValidName("Invalid Name@"));
     assert(!isValidName("Иванов_Петр"));
+
+    // Кириллица проверяется по символам, а не по отдельным байтам
+    assert(isValidName("Ёлкин"));
+    assert(isValidName("ёжикЖЩЪЯ"));
+    assert(!isValidName("\xD0"));
+    assert(!isValidName("Ђорђе"));
+    assert(!isValidName(""));
+}
+
+// Эталонная проверка: строка декодируется в символы Unicode и каждый символ сверяется с набором
+bool referenceValidate(std::string_view text, const std::u32string& extra, bool allowCyrillic) {
+    if (text.empty()) {
+        return false;
+    }
+
+    size_t i = 0;
+
+    while (i < text.size()) {
+        uint8_t c = static_cast<uint8_t>(text[i]);
+        char32_t symbol;
+
+        if (c < 0x80) {
+            symbol = c;
+            i += 1;
+        } else if ((c & 0xE0) == 0xC0 && i + 1 < text.size() && (static_cast<uint8_t>(text[i + 1]) & 0xC0) == 0x80) {
+            symbol = ((c & 0x1F) << 6) | (static_cast<uint8_t>(text[i + 1]) & 0x3F);
+            i += 2;
+        } else {
+            return false;
+        }
+
+        bool latin = (symbol >= U'a' && symbol <= U'z') || (symbol >= U'A' && symbol <= U'Z');
+        bool cyrillic = allowCyrillic && ((symbol >= U'А' && symbol <= U'я') || symbol == U'Ё' || symbol == U'ё');
+
+        if (!latin && !cyrillic && extra.find(symbol) == std::u32string::npos) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Сравнение валидаторов с эталонной реализацией на случайных строках
+void testValidatorsEquivalence() {
+    // Фрагменты для сборки строк: ASCII, кириллица, граничные и битые последовательности UTF-8
+    const std::vector<std::string> pieces = {
+        "a", "Z", "q", "0", "9", "_", "/", "\\", ":", ".", " ", "@", "`", "{", "[", "-", "\x7f",
+        "А", "я", "Ё", "ё", "р", "П", "Ђ", "ѐ", "\xD0", "\xD1", "\xD0\x8F", "\xD1\x90", "é", "\xFF"
+    };
+
+    std::mt19937 rng(2024);
+
+    for (int iteration = 0; iteration < 20000; ++iteration) {
+        std::string text;
+        size_t count = rng() % 40;
+
+        for (size_t i = 0; i < count; ++i) {
+            // Длинные ASCII-строки нужны, чтобы проверить блочную обработку
+            text += (iteration % 2 == 0) ? pieces[rng() % 10] : pieces[rng() % pieces.size()];
+        }
+
+        assert(isValidName(text) == referenceValidate(text, U"", true));
+        assert(isValidGroup(text) == referenceValidate(text, U"0123456789", true));
+        assert(isValidFilePath(text) == referenceValidate(text, U"0123456789_/\\:.", false));
+    }
+}
+
+// Ошибки разбора файла-заявки
+enum class RequestError {
+    None,
+    OpenFailed,
+    LastName,
+    FirstName,
+    Patronymic,
+    Group,
+    BoardName,
+    ExecutablePath,
+    ResultPath,
+    TooLarge
+};
+
+// Результат разбора файла-заявки: заявка или ошибка с ошибочной строкой
+struct ParseResult {
+    Request request;
+    RequestError error = RequestError::None;
+    std::string detail;
+
+    // Проверка успешности разбора
+    bool ok() const {
+        return error == RequestError::None;
+    }
+};
+
+// Функция для получения текста ошибки проверки по виду ошибки и ошибочной строке
+std::string describeError(RequestError error, const std::string& detail) {
+    switch (error) {
+    case RequestError::None:
+        return "";
+    case RequestError::OpenFailed:
+        return "Не удалось открыть файл: " + detail;
+    case RequestError::LastName:
+        return "Ошибка в фамилии: " + detail;
+    case RequestError::FirstName:
+        return "Ошибка в имени: " + detail;
+    case RequestError::Patronymic:
+        return "Ошибка в отчество: " + detail;
+    case RequestError::Group:
+        return "Ошибка в группе: " + detail;
+    case RequestError::BoardName:
+        return "Название платы не может быть пустым.";
+    case RequestError::ExecutablePath:
+        return "Неверный путь к исполняемому файлу: " + detail;
+    case RequestError::ResultPath:
+        return "Неверный путь для сохранения результата: " + detail;
+    case RequestError::TooLarge:
+        return "Файл заявки больше " + std::to_string(REQUEST_FILE_MAX) + " байт: " + detail;
+    }
+
+    return "";
+}
+
+// Функция для получения текста ошибки разбора
+std::string describeError(const ParseResult& result) {
+    return describeError(result.error, result.detail);
+}
+
+// Аренда шарда метрик потоком: поток получает свободный шард при первой записи и возвращает его при завершении
+// Пока шард арендован, в него пишет только этот поток, следующий арендатор продолжает его счётчики
+class MetricsShardLease {
+private:
+    static std::mutex& mutex() {
+        static std::mutex instance;
+        return instance;
+    }
+
+    static std::vector<size_t>& freeShards() {
+        static std::vector<size_t> shards = []() {
+            std::vector<size_t> result;
+
+            for (size_t i = METRICS_SHARED_SHARD; i-- > 0;) {
+                result.push_back(i);
+            }
+
+            return result;
+        }();
+        return shards;
+    }
+
+public:
+    size_t index = METRICS_SHARED_SHARD;
+
+    MetricsShardLease() {
+        std::lock_guard<std::mutex> lock(mutex());
+
+        if (!freeShards().empty()) {
+            index = freeShards().back();
+            freeShards().pop_back();
+        }
+    }
+
+    ~MetricsShardLease() {
+        if (index != METRICS_SHARED_SHARD) {
+            std::lock_guard<std::mutex> lock(mutex());
+            freeShards().push_back(index);
+        }
+    }
+};
+
+// Номер шарда метрик текущего потока
+inline size_t metricsShard() {
+    thread_local MetricsShardLease lease;
+    return lease.index;
+}
+
+// Добавление к ячейке шарда: единственный писатель своего шарда обходится без атомарного сложения,
+// общий шард использует атомарное сложение
+inline void metricsAdd(size_t shard, std::atomic<uint64_t>& cell, uint64_t value) {
+    if (shard != METRICS_SHARED_SHARD) {
+        cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    } else {
+        cell.fetch_add(value, std::memory_order_relaxed);
+    }
+}
+
+// Счётчик событий, разделённый по шардам потоков; запись в свой шард - обычное сложение без блокировок
+class MetricsCounter {
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::array<Cell, METRICS_SHARDS> cells;
+
+public:
+    // Увеличение счётчика
+    void add(uint64_t value = 1) {
+        size_t shard = metricsShard();
+        metricsAdd(shard, cells[shard].value, value);
+    }
+
+    // Сумма по всем шардам
+    uint64_t value() const {
+        uint64_t total = 0;
+
+        for (const auto& cell : cells) {
+            total += cell.value.load(std::memory_order_relaxed);
+        }
+
+        return total;
+    }
+
+    // Обнуление всех шардов
+    void reset() {
+        for (auto& cell : cells) {
+            cell.value.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Гистограмма длительностей в наносекундах в духе HDR: каждый интервал [2^k, 2^(k+1)) делится на 8 корзин,
+// поэтому относительная погрешность не больше 12.5% во всём диапазоне от 1 нс до ~20 часов
+// У каждого шарда потоков свои корзины, запись - вычисление номера корзины и два сложения в своём шарде
+class LatencyHistogram {
+public:
+    static constexpr size_t SUB_BITS = 3;
+    static constexpr size_t MAX_BITS = 46;
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) << SUB_BITS;
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+        std::atomic<uint64_t> sum{0};
+    };
+
+    std::array<Shard, METRICS_SHARDS> shards{};
+
+public:
+    // Номер корзины для значения (значения вне диапазона попадают в последнюю корзину)
+    static size_t bucketOf(uint64_t value) {
+        if (value < (1u << SUB_BITS)) {
+            return static_cast<size_t>(value);
+        }
+
+        size_t bits = 63 - __builtin_clzll(value);
+
+        if (bits >= MAX_BITS) {
+            return BUCKETS - 1;
+        }
+
+        size_t sub = static_cast<size_t>(value >> (bits - SUB_BITS)) & ((1u << SUB_BITS) - 1);
+        return ((bits - SUB_BITS + 1) << SUB_BITS) + sub;
+    }
+
+    // Нижняя граница корзины
+    static uint64_t bucketStart(size_t bucket) {
+        if (bucket < (1u << SUB_BITS)) {
+            return bucket;
+        }
+
+        size_t bits = (bucket >> SUB_BITS) + SUB_BITS - 1;
+        uint64_t sub = bucket & ((1u << SUB_BITS) - 1);
+        return ((uint64_t(1) << SUB_BITS) + sub) << (bits - SUB_BITS);
+    }
+
+    // Учёт значения в наносекундах
+    void record(uint64_t nanoseconds) {
+        size_t index = metricsShard();
+        Shard& shard = shards[index];
+        metricsAdd(index, shard.counts[bucketOf(nanoseconds)], 1);
+        metricsAdd(index, shard.sum, nanoseconds);
+    }
+
+    // Учёт длительности (отрицательная считается нулевой)
+    void record(std::chrono::nanoseconds duration) {
+        record(static_cast<uint64_t>(std::max<int64_t>(0, duration.count())));
+    }
+
+    // Сумма счётчиков корзин по всем шардам
+    std::vector<uint64_t> counts() const {
+        std::vector<uint64_t> result(BUCKETS, 0);
+
+        for (const auto& shard : shards) {
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                result[i] += shard.counts[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        return result;
+    }
+
+    // Обнуление корзин и сумм всех шардов
+    void reset() {
+        for (auto& shard : shards) {
+            for (auto& count : shard.counts) {
+                count.store(0, std::memory_order_relaxed);
+            }
+
+            shard.sum.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Сумма всех значений в наносекундах
+    uint64_t sum() const {
+        uint64_t total = 0;
+
+        for (const auto& shard : shards) {
+            total += shard.sum.load(std::memory_order_relaxed);
+        }
+
+        return total;
+    }
+
+    // Оценка квантиля q в наносекундах: нижняя граница корзины, в которую он попадает
+    uint64_t quantile(double q) const {
+        return quantile(counts(), q);
+    }
+
+    // Квантиль q по счётчикам корзин (например, по разности двух снимков counts)
+    static uint64_t quantile(const std::vector<uint64_t>& buckets, double q) {
+        uint64_t total = 0;
+
+        for (uint64_t count : buckets) {
+            total += count;
+        }
+
+        if (total == 0) {
+            return 0;
+        }
+
+        uint64_t rank = static_cast<uint64_t>(q * (total - 1));
+        uint64_t seen = 0;
+
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i];
+
+            if (seen > rank) {
+                return bucketStart(i);
+            }
+        }
+
+        return bucketStart(BUCKETS - 1);
+    }
+};
+
+// Замер длительности блока кода по монотонным часам с записью в гистограмму при выходе из блока
+class MetricsTimer {
+private:
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit MetricsTimer(LatencyHistogram& histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+    ~MetricsTimer() {
+        histogram.record(std::chrono::steady_clock::now() - start);
+    }
+
+    MetricsTimer(const MetricsTimer&) = delete;
+    MetricsTimer& operator=(const MetricsTimer&) = delete;
+};
+
+// Причины отказа в заявке: ошибки проверки полей (по RequestError), ошибка JSON и отсутствие стендов платы
+enum class RejectReason {
+    OpenFailed = 1,
+    LastName,
+    FirstName,
+    Patronymic,
+    Group,
+    BoardName,
+    ExecutablePath,
+    ResultPath,
+    TooLarge,
+    Json,
+    NoStands,
+    Count
+};
+
+// Причина отказа для ошибки проверки файла-заявки
+inline RejectReason rejectReason(RequestError error) {
+    return static_cast<RejectReason>(static_cast<int>(error));
+}
+
+// Кэши программы в метриках
+enum class CacheKind {
+    RequestPaths,
+    RequestContents,
+    ExecutablePaths,
+    Executables,
+    RuntimeModels,
+    Count
+};
+
+// Метрики платы: ожидание стенда и суммарное время бронирования каждого стенда
+// Стенд определяется слотом постоянного номера (StandHandle::slot), а не индексом: индекс меняется при удалении
+// других стендов, слот - нет (слот удалённого стенда может достаться новому стенду платы)
+// Стенды со слотом от METRICS_MAX_STANDS учитываются только в сумме по плате
+struct BoardMetrics {
+    LatencyHistogram wait;
+    MetricsCounter busyTotal;
+    std::array<std::atomic<uint64_t>, METRICS_MAX_STANDS> busy{};
+    // Количество стендов, по которым были бронирования
+    std::atomic<size_t> stands{0};
+};
+
+// Метрики программы: чтение и проверка заявок, время принятия решения, отказы и метрики плат
+// Выводятся в текстовом формате Prometheus
+class Metrics {
+private:
+    std::map<std::string, std::unique_ptr<BoardMetrics>, std::less<>> boards;
+    mutable std::shared_mutex boardsMutex;
+
+    // Экранирование значения метки Prometheus
+    static std::string escapeLabel(std::string_view value) {
+        std::string result;
+
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                result += '\\';
+                result += c;
+            } else if (c == '\n') {
+                result += "\\n";
+            } else {
+                result += c;
+            }
+        }
+
+        return result;
+    }
+
+    // Вывод гистограммы: накопленные корзины на границах степеней двойки (в секундах), сумма и количество
+    static void writeHistogram(std::ostream& out, const std::string& name, const std::string& labels, const LatencyHistogram& histogram) {
+        std::vector<uint64_t> counts = histogram.counts();
+        std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+
+        // Границы от 1 мкс до ~19 часов через каждые две степени двойки
+        for (size_t bits = 10; bits <= LatencyHistogram::MAX_BITS; bits += 2) {
+            uint64_t bound = uint64_t(1) << bits;
+
+            for (; bucket < LatencyHistogram::BUCKETS && LatencyHistogram::bucketStart(bucket) < bound; ++bucket) {
+                cumulative += counts[bucket];
+            }
+
+            out << name << "_bucket" << prefix << "le=\"" << bound / 1e9 << "\"} " << cumulative << "\n";
+        }
+
+        for (; bucket < LatencyHistogram::BUCKETS; ++bucket) {
+            cumulative += counts[bucket];
+        }
+
+        out << name << "_bucket" << prefix << "le=\"+Inf\"} " << cumulative << "\n";
+        out << name << "_sum" << (labels.empty() ? "" : "{" + labels + "}") << " " << histogram.sum() / 1e9 << "\n";
+        out << name << "_count" << (labels.empty() ? "" : "{" + labels + "}") << " " << cumulative << "\n";
+    }
+
+public:
+    // Время чтения и проверки файла-заявки
+    LatencyHistogram parseTime;
+    // Время принятия решения по заявке в обработчике
+    LatencyHistogram decisionTime;
+    // Заявки, получившие стенд
+    MetricsCounter reserved;
+    // Отказы по причинам
+    std::array<MetricsCounter, static_cast<size_t>(RejectReason::Count)> rejections;
+    // Попадания, промахи и вытеснения кэшей
+    std::array<MetricsCounter, static_cast<size_t>(CacheKind::Count)> cacheHits;
+    std::array<MetricsCounter, static_cast<size_t>(CacheKind::Count)> cacheMisses;
+    std::array<MetricsCounter, static_cast<size_t>(CacheKind::Count)> cacheEvictions;
+    // Повторные заявки, объединённые с выполняющимся заданием
+    MetricsCounter coalesced;
+    // Отправленные уведомления о завершении заданий
+    MetricsCounter completions;
+    // События завершения, доставленные в очереди подписчиков, и вытесненные из переполненных очередей
+    MetricsCounter eventsDelivered;
+    MetricsCounter eventsDropped;
+
+    // Учёт отказа
+    void reject(RejectReason reason) {
+        rejections[static_cast<size_t>(reason)].add();
+    }
+
+    // Учёт обращения к кэшу
+    void cacheLookup(CacheKind kind, bool hit) {
+        (hit ? cacheHits : cacheMisses)[static_cast<size_t>(kind)].add();
+    }
+
+    // Учёт вытеснения из кэша
+    void cacheEviction(CacheKind kind) {
+        cacheEvictions[static_cast<size_t>(kind)].add();
+    }
+
+    // Метрики платы; создаются при первом обращении и не удаляются
+    BoardMetrics& board(std::string_view boardName) {
+        {
+            std::shared_lock<std::shared_mutex> lock(boardsMutex);
+            auto it = boards.find(boardName);
+
+            if (it != boards.end()) {
+                return *it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(boardsMutex);
+        auto& slot = boards[std::string(boardName)];
+
+        if (!slot) {
+            slot = std::make_unique<BoardMetrics>();
+        }
+
+        return *slot;
+    }
+
+    // Учёт бронирования стенда: ожидание от поступления заявки до начала задания
+    void reservation(std::string_view boardName, std::chrono::nanoseconds wait) {
+        board(boardName).wait.record(wait);
+        reserved.add();
+    }
+
+    // Учёт занятого времени стенда по фактическому интервалу завершившегося или отменённого задания
+    // stand - слот постоянного номера стенда
+    void standBusy(std::string_view boardName, size_t stand, std::chrono::nanoseconds busy) {
+        BoardMetrics& metrics = board(boardName);
+        uint64_t busyNanoseconds = static_cast<uint64_t>(std::max<int64_t>(0, busy.count()));
+
+        metrics.busyTotal.add(busyNanoseconds);
+
+        if (stand < METRICS_MAX_STANDS) {
+            metrics.busy[stand].fetch_add(busyNanoseconds, std::memory_order_relaxed);
+
+            // Количество стендов только растёт
+            size_t stands = metrics.stands.load(std::memory_order_relaxed);
+
+            while (stands <= stand && !metrics.stands.compare_exchange_weak(stands, stand + 1, std::memory_order_relaxed)) {
+                // При неудаче stands содержит текущее значение
+            }
+        }
+    }
+
+    // Сброс всех метрик и удаление метрик плат, например после самопроверки перед запуском экспорта
+    // Вызывается, когда никто не держит ссылку на метрики плат (board)
+    void reset() {
+        parseTime.reset();
+        decisionTime.reset();
+        reserved.reset();
+
+        for (auto& counter : rejections) {
+            counter.reset();
+        }
+
+        for (size_t i = 0; i < cacheHits.size(); ++i) {
+            cacheHits[i].reset();
+            cacheMisses[i].reset();
+            cacheEvictions[i].reset();
+        }
+
+        coalesced.reset();
+        completions.reset();
+        eventsDelivered.reset();
+        eventsDropped.reset();
+
+        std::unique_lock<std::shared_mutex> lock(boardsMutex);
+        boards.clear();
+    }
+
+    // Вывод всех метрик в текстовом формате Prometheus
+    void writePrometheus(std::ostream& out) const {
+        static const char* reasons[] = {
+            "", "open_failed", "last_name", "first_name", "patronymic", "group", "board_name",
+            "executable_path", "result_path", "too_large", "json", "no_stands"
+        };
+        // Секунды с наносекундной точностью для сумм за длительную работу
+        std::streamsize precision = out.precision(15);
+
+        out << "# HELP remote_stand_parse_seconds Время чтения и проверки файла-заявки\n";
+        out << "# TYPE remote_stand_parse_seconds histogram\n";
+        writeHistogram(out, "remote_stand_parse_seconds", "", parseTime);
+
+        out << "# HELP remote_stand_decision_seconds Время принятия решения по заявке\n";
+        out << "# TYPE remote_stand_decision_seconds histogram\n";
+        writeHistogram(out, "remote_stand_decision_seconds", "", decisionTime);
+
+        out << "# HELP remote_stand_reserved_total Заявки, получившие стенд\n";
+        out << "# TYPE remote_stand_reserved_total counter\n";
+        out << "remote_stand_reserved_total " << reserved.value() << "\n";
+
+        out << "# HELP remote_stand_rejections_total Отклонённые заявки по причинам\n";
+        out << "# TYPE remote_stand_rejections_total counter\n";
+
+        for (size_t i = 1; i < rejections.size(); ++i) {
+            out << "remote_stand_rejections_total{reason=\"" << reasons[i] << "\"} " << rejections[i].value() << "\n";
+        }
+
+        static const char* caches[] = {"request_paths", "request_contents", "executable_paths", "executables", "runtime_models"};
+
+        out << "# HELP remote_stand_cache_hits_total Попадания в кэши\n";
+        out << "# TYPE remote_stand_cache_hits_total counter\n";
+
+        for (size_t i = 0; i < cacheHits.size(); ++i) {
+            out << "remote_stand_cache_hits_total{cache=\"" << caches[i] << "\"} " << cacheHits[i].value() << "\n";
+        }
+
+        out << "# HELP remote_stand_cache_misses_total Промахи кэшей\n";
+        out << "# TYPE remote_stand_cache_misses_total counter\n";
+
+        for (size_t i = 0; i < cacheMisses.size(); ++i) {
+            out << "remote_stand_cache_misses_total{cache=\"" << caches[i] << "\"} " << cacheMisses[i].value() << "\n";
+        }
+
+        out << "# HELP remote_stand_cache_evictions_total Записи, вытесненные из кэшей\n";
+        out << "# TYPE remote_stand_cache_evictions_total counter\n";
+
+        for (size_t i = 0; i < cacheEvictions.size(); ++i) {
+            out << "remote_stand_cache_evictions_total{cache=\"" << caches[i] << "\"} " << cacheEvictions[i].value() << "\n";
+        }
+
+        out << "# HELP remote_stand_coalesced_total Повторные заявки, объединённые с выполняющимся заданием\n";
+        out << "# TYPE remote_stand_coalesced_total counter\n";
+        out << "remote_stand_coalesced_total " << coalesced.value() << "\n";
+        out << "# HELP remote_stand_completions_total Отправленные уведомления о завершении заданий\n";
+        out << "# TYPE remote_stand_completions_total counter\n";
+        out << "remote_stand_completions_total " << completions.value() << "\n";
+        out << "# HELP remote_stand_events_delivered_total События завершения, доставленные подписчикам\n";
+        out << "# TYPE remote_stand_events_delivered_total counter\n";
+        out << "remote_stand_events_delivered_total " << eventsDelivered.value() << "\n";
+        out << "# HELP remote_stand_events_dropped_total События завершения, потерянные медленными подписчиками\n";
+        out << "# TYPE remote_stand_events_dropped_total counter\n";
+        out << "remote_stand_events_dropped_total " << eventsDropped.value() << "\n";
+
+        std::shared_lock<std::shared_mutex> lock(boardsMutex);
+
+        out << "# HELP remote_stand_queue_wait_seconds Ожидание стенда от поступления заявки до начала задания\n";
+        out << "# TYPE remote_stand_queue_wait_seconds histogram\n";
+
+        for (const auto& pair : boards) {
+            writeHistogram(out, "remote_stand_queue_wait_seconds", "board=\"" + escapeLabel(pair.first) + "\"", pair.second->wait);
+        }
+
+        // Загрузка стенда за период - rate этого счётчика
+        out << "# HELP remote_stand_stand_busy_seconds_total Время стенда, занятое завершёнными заданиями\n";
+        out << "# TYPE remote_stand_stand_busy_seconds_total counter\n";
+
+        for (const auto& pair : boards) {
+            std::string board = escapeLabel(pair.first);
+            size_t stands = pair.second->stands.load(std::memory_order_relaxed);
+
+            for (size_t i = 0; i < stands; ++i) {
+                out << "remote_stand_stand_busy_seconds_total{board=\"" << board << "\",stand=\"" << i << "\"} "
+                    << pair.second->busy[i].load(std::memory_order_relaxed) / 1e9 << "\n";
+            }
+        }
+
+        out << "# HELP remote_stand_board_busy_seconds_total Время всех стендов платы, занятое завершёнными заданиями\n";
+        out << "# TYPE remote_stand_board_busy_seconds_total counter\n";
+
+        for (const auto& pair : boards) {
+            out << "remote_stand_board_busy_seconds_total{board=\"" << escapeLabel(pair.first) << "\"} "
+                << pair.second->busyTotal.value() / 1e9 << "\n";
+        }
+
+        out.precision(precision);
+    }
+};
+
+// Общие метрики программы
+Metrics& metrics() {
+    static Metrics instance;
+    return instance;
+}
+
+// Периодическая запись метрик в файл для сборщика (например, textfile collector node_exporter)
+// Файл заменяется целиком через переименование, поэтому читатель не видит недописанных метрик
+class MetricsWriter {
+private:
+    const Metrics& source;
+    std::string path;
+    std::chrono::milliseconds interval;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+
+    // Запись файла метрик
+    void write() {
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            source.writePrometheus(out);
+        }
+
+        std::rename(temporary.c_str(), path.c_str());
+    }
+
+    // Поток записи: файл пишется каждые interval и ещё раз при остановке
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            wakeup.wait_for(lock, interval, [this]() { return stopping; });
+            bool last = stopping;
+            lock.unlock();
+            write();
+
+            if (last) {
+                break;
+            }
+
+            lock.lock();
+        }
+    }
+
+public:
+    // Конструктор, запускает поток записи
+    MetricsWriter(const Metrics& source, std::string path, std::chrono::milliseconds interval = METRICS_INTERVAL)
+        : source(source), path(std::move(path)), interval(interval) {
+        thread = std::thread(&MetricsWriter::run, this);
+    }
+
+    // Деструктор: последняя запись и остановка потока
+    ~MetricsWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wakeup.notify_one();
+        thread.join();
+    }
+
+    MetricsWriter(const MetricsWriter&) = delete;
+    MetricsWriter& operator=(const MetricsWriter&) = delete;
+};
+
+// Тесты метрик
+void testMetrics() {
+    using namespace std::chrono;
+
+    // Номер корзины и её нижняя граница согласованы, погрешность не больше 1/8
+    for (uint64_t value : {uint64_t(0), uint64_t(7), uint64_t(8), uint64_t(15), uint64_t(1000), uint64_t(123456789), uint64_t(1) << 45}) {
+        size_t bucket = LatencyHistogram::bucketOf(value);
+        uint64_t start = LatencyHistogram::bucketStart(bucket);
+        assert(start <= value && value - start <= value / 8);
+        assert(bucket + 1 == LatencyHistogram::BUCKETS || LatencyHistogram::bucketStart(bucket + 1) > value);
+    }
+
+    assert(LatencyHistogram::bucketOf(UINT64_MAX) == LatencyHistogram::BUCKETS - 1);
+
+    // Запись из нескольких потоков без потерь
+    Metrics local;
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&local]() {
+            for (uint64_t i = 1; i <= 10000; ++i) {
+                local.parseTime.record(i * 100);
+                local.reject(RejectReason::Group);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<uint64_t> counts = local.parseTime.counts();
+    assert(std::accumulate(counts.begin(), counts.end(), uint64_t(0)) == 40000);
+    assert(local.parseTime.sum() == uint64_t(4) * 100 * (10000 * 10001 / 2));
+    assert(local.rejections[static_cast<size_t>(RejectReason::Group)].value() == 40000);
+
+    // Квантили равномерного распределения 100 нс .. 1 мс с погрешностью корзины
+    uint64_t median = local.parseTime.quantile(0.5);
+    uint64_t p99 = local.parseTime.quantile(0.99);
+    assert(median >= 500000 * 7 / 8 && median <= 500000);
+    assert(p99 >= 990000 * 7 / 8 && p99 <= 990000);
+
+    // Метрики плат и формат Prometheus
+    local.reservation("Arduino \"Uno\"", seconds(2));
+    local.reservation("Arduino \"Uno\"", seconds(0));
+    local.standBusy("Arduino \"Uno\"", 1, seconds(5));
+    local.standBusy("Arduino \"Uno\"", 1, seconds(5));
+    std::ostringstream text;
+    local.writePrometheus(text);
+    std::string exposition = text.str();
+
+    assert(exposition.find("# TYPE remote_stand_parse_seconds histogram\n") != std::string::npos);
+    assert(exposition.find("remote_stand_parse_seconds_count 40000\n") != std::string::npos);
+    assert(exposition.find("remote_stand_parse_seconds_bucket{le=\"+Inf\"} 40000\n") != std::string::npos);
+    assert(exposition.find("remote_stand_rejections_total{reason=\"group\"} 40000\n") != std::string::npos);
+    assert(exposition.find("remote_stand_rejections_total{reason=\"no_stands\"} 0\n") != std::string::npos);
+    assert(exposition.find("remote_stand_queue_wait_seconds_count{board=\"Arduino \\\"Uno\\\"\"} 2\n") != std::string::npos);
+    assert(exposition.find("remote_stand_stand_busy_seconds_total{board=\"Arduino \\\"Uno\\\"\",stand=\"0\"} 0\n") != std::string::npos);
+    assert(exposition.find("remote_stand_stand_busy_seconds_total{board=\"Arduino \\\"Uno\\\"\",stand=\"1\"} 10\n") != std::string::npos);
+    assert(exposition.find("remote_stand_reserved_total 2\n") != std::string::npos);
+
+    // Запись файла метрик: последний снимок пишется при остановке
+    std::string path = (std::filesystem::temp_directory_path() / "remote_stand_test_metrics.prom").string();
+    {
+        MetricsWriter writer(local, path, milliseconds(10));
+    }
+
+    std::ifstream file(path);
+    std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    assert(written == exposition);
+    std::filesystem::remove(path);
+
+    // Сброс обнуляет счётчики и гистограммы и удаляет метрики плат
+    local.coalesced.add();
+    local.reset();
+    std::ostringstream cleared;
+    local.writePrometheus(cleared);
+    assert(local.parseTime.sum() == 0 && local.coalesced.value() == 0 && local.reserved.value() == 0);
+    assert(cleared.str().find("remote_stand_rejections_total{reason=\"group\"} 0\n") != std::string::npos);
+    assert(cleared.str().find("Arduino") == std::string::npos);
+}
+
+// Подпись файла: устройство, inode, размер и время изменения метаданных и содержимого с наносекундами
+// Пока подпись не изменилась, содержимое файла считается прежним и повторно не читается
+struct FileSignature {
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    int64_t modified = 0;
+    int64_t changed = 0;
+
+    bool operator==(const FileSignature& other) const {
+        return device == other.device && inode == other.inode && size == other.size && modified == other.modified &&
+               changed == other.changed;
+    }
+};
+
+// Подпись по результату stat
+FileSignature fileSignature(const struct stat& info) {
+    FileSignature signature;
+    signature.device = info.st_dev;
+    signature.inode = info.st_ino;
+    signature.size = static_cast<uint64_t>(info.st_size);
+    signature.modified = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    signature.changed = static_cast<int64_t>(info.st_ctim.tv_sec) * 1000000000 + info.st_ctim.tv_nsec;
+    return signature;
+}
+
+// Подпись файла по пути; false, если файла нет
+bool fileSignature(const std::string& path, FileSignature& signature) {
+    struct stat info;
+
+    if (::stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+
+    signature = fileSignature(info);
+    return true;
+}
+
+// Подпись можно запоминать, только если файл не менялся дольше шага часов файловой системы:
+// иначе запись того же размера в тот же квант времени оставила бы подпись прежней
+bool settled(const FileSignature& signature) {
+    auto now = std::chrono::system_clock::now() - CACHE_SETTLE_TIME;
+    int64_t limit = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    return signature.modified < limit && signature.changed < limit;
+}
+
+// Кэш с вытеснением давно не использованных записей (LRU) и счётчиками попаданий
+// Ёмкость задаётся в единицах веса записи (по умолчанию вес 1 - ёмкость в записях); вытесненная запись
+// передаётся в onEvict (например, чтобы удалить файл). Попадания и промахи учитываются и в общих метриках
+template <typename Key, typename Value>
+class LruCache {
+public:
+    using EvictHandler = std::function<void(const Key&, Value&)>;
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        size_t weight;
+    };
+
+    CacheKind kind;
+    size_t capacity;
+    EvictHandler onEvict;
+    mutable std::mutex mutex;
+    std::list<Entry> order;
+    std::unordered_map<Key, typename std::list<Entry>::iterator> index;
+    size_t weight = 0;
+    size_t hitsCount = 0;
+    size_t missesCount = 0;
+    size_t evictionsCount = 0;
+
+    // Вытеснение записей с конца списка, пока вес превышает ёмкость (под mutex)
+    void shrink() {
+        while (weight > capacity && !order.empty()) {
+            Entry& last = order.back();
+
+            if (onEvict) {
+                onEvict(last.key, last.value);
+            }
+
+            weight -= last.weight;
+            index.erase(last.key);
+            order.pop_back();
+            ++evictionsCount;
+            metrics().cacheEviction(kind);
+        }
+    }
+
+public:
+    LruCache(CacheKind kind, size_t capacity, EvictHandler onEvict = nullptr)
+        : kind(kind), capacity(capacity), onEvict(std::move(onEvict)) {}
+
+    // Запись по ключу; если её нет, добавляется make() - поиск и добавление под одной блокировкой
+    template <typename Make>
+    Value findOrInsert(const Key& key, Make make, size_t entryWeight = 1) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        bool hit = it != index.end();
+        metrics().cacheLookup(kind, hit);
+
+        if (hit) {
+            ++hitsCount;
+            order.splice(order.begin(), order, it->second);
+            return it->second->value;
+        }
+
+        ++missesCount;
+        order.push_front(Entry{key, make(), entryWeight});
+        index[key] = order.begin();
+        weight += entryWeight;
+        Value value = order.front().value;
+        shrink();
+        return value;
+    }
+
+    // Поиск записи; найденная запись становится самой свежей
+    // Запись, не прошедшая проверку valid (например, файл изменился), удаляется и считается промахом
+    template <typename Check>
+    bool find(const Key& key, Value& value, Check valid) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+
+        if (it != index.end() && !valid(it->second->value)) {
+            weight -= it->second->weight;
+            order.erase(it->second);
+            index.erase(it);
+            it = index.end();
+        }
+
+        bool hit = it != index.end();
+        metrics().cacheLookup(kind, hit);
+
+        if (!hit) {
+            ++missesCount;
+            return false;
+        }
+
+        ++hitsCount;
+        order.splice(order.begin(), order, it->second);
+        value = it->second->value;
+        return true;
+    }
+
+    bool find(const Key& key, Value& value) {
+        return find(key, value, [](const Value&) { return true; });
+    }
+
+    // Добавление или замена записи
+    void insert(const Key& key, Value value, size_t entryWeight = 1) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+
+        if (it != index.end()) {
+            weight -= it->second->weight;
+            order.erase(it->second);
+        }
+
+        order.push_front(Entry{key, std::move(value), entryWeight});
+        index[key] = order.begin();
+        weight += entryWeight;
+        shrink();
+    }
+
+    // Удаление записи без вызова onEvict
+    void erase(const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+
+        if (it != index.end()) {
+            weight -= it->second->weight;
+            order.erase(it->second);
+            index.erase(it);
+        }
+    }
+
+    // Количество записей и их суммарный вес
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order.size();
+    }
+
+    size_t totalWeight() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return weight;
+    }
+
+    // Счётчики попаданий, промахов и вытеснений
+    size_t hits() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return hitsCount;
+    }
+
+    size_t misses() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return missesCount;
+    }
+
+    size_t evictions() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return evictionsCount;
+    }
+
+    // Доля попаданий среди всех обращений
+    double hitRate() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t total = hitsCount + missesCount;
+        return total == 0 ? 0.0 : static_cast<double>(hitsCount) / total;
+    }
+};
+
+// Функция проверки полей заявки в порядке файла-заявки
+// Первая ошибка прерывает проверку, её номер поля возвращается в failed
+RequestError validateRequestFields(const std::string_view (&fields)[7], size_t& failed) {
+    static const RequestError errors[7] = {
+        RequestError::LastName, RequestError::FirstName, RequestError::Patronymic, RequestError::Group,
+        RequestError::BoardName, RequestError::ExecutablePath, RequestError::ResultPath
+    };
+
+    for (failed = 0; failed < 7; ++failed) {
+        bool valid;
+
+        if (failed < 3) {
+            valid = isValidName(fields[failed]);
+        } else if (failed == 3) {
+            valid = isValidGroup(fields[failed]);
+        } else if (failed == 4) {
+            valid = !fields[failed].empty();
+        } else {
+            valid = isValidFilePath(fields[failed]);
+        }
+
+        if (!valid) {
+            return errors[failed];
+        }
+    }
+
+    return RequestError::None;
+}
+
+// Функция для разбора текста заявки за один проход
+// Строки выделяются как std::string_view без копирования, копируются только поля готовой заявки
+ParseResult parseRequestText(std::string_view text) {
+    ParseResult result;
+    std::string_view lines[7];
+
+    // Делим текст на семь строк, отсутствующие строки остаются пустыми
+    for (auto& line : lines) {
+        size_t end = text.find('\n');
+        line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+        // Поддержка файлов с переводами строк Windows
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+    }
+
+    result.request.lastName = std::string(lines[0]);
+    result.request.firstName = std::string(lines[1]);
+    result.request.patronymic = std::string(lines[2]);
+    result.request.group = std::string(lines[3]);
+    result.request.boardName = std::string(lines[4]);
+    result.request.executablePath = std::string(lines[5]);
+    result.request.resultPath = std::string(lines[6]);
+
+    size_t failed = 7;
+    result.error = validateRequestFields(lines, failed);
+
+    if (failed < 7) {
+        result.detail = std::string(lines[failed]);
+    }
+
+    return result;
+}
+
+// Чтение открытого файла целиком в buffer, прочитанная длина возвращается в length
+// Размер файла известен заранее, поэтому обычно хватает одного read и одной проверки конца файла
+// Читается не больше limit + 1 байт: length > limit означает, что файл длиннее limit, и буфер не растёт дальше
+// Прерванное сигналом чтение повторяется; false при ошибке чтения - прочитанное до неё не считается файлом
+bool readFileContents(int fd, std::string& buffer, size_t& length, size_t limit) {
+    struct stat info;
+    size_t capacity = (::fstat(fd, &info) == 0 && info.st_size > 0) ? static_cast<size_t>(info.st_size) : 4096;
+    buffer.resize(std::min(capacity, limit) + 1);
+    length = 0;
+
+    while (length <= limit) {
+        if (length == buffer.size()) {
+            buffer.resize(std::min(buffer.size() * 2, limit + 1));
+        }
+
+        ssize_t count = ::read(fd, &buffer[length], buffer.size() - length);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (count < 0) {
+            return false;
+        }
+
+        if (count == 0) {
+            return true;
+        }
+
+        length += static_cast<size_t>(count);
+    }
+
+    return true;
+}
+
+// Кэш проверенных файлов-заявок. Два уровня:
+// по пути - подпись файла и хэш содержимого: неизменённый файл повторно не открывается и не читается;
+// по содержимому - текст и результат проверки: тот же текст под другим именем (повторная подача) не проверяется заново
+class RequestFileCache {
+private:
+    struct PathEntry {
+        FileSignature signature;
+        uint64_t hash = 0;
+    };
+
+    struct ContentEntry {
+        std::string text;
+        ParseResult result;
+    };
+
+    LruCache<std::string, PathEntry> paths;
+    LruCache<uint64_t, std::shared_ptr<const ContentEntry>> contents;
+
+public:
+    // Ёмкость: записей по путям и байт по содержимому
+    explicit RequestFileCache(size_t entries = REQUEST_CACHE_ENTRIES, size_t bytes = REQUEST_CACHE_BYTES)
+        : paths(CacheKind::RequestPaths, entries), contents(CacheKind::RequestContents, bytes) {}
+
+    // Результат проверки файла path, если его подпись не изменилась с прошлого чтения
+    bool findPath(const std::string& path, const FileSignature& signature, ParseResult& result) {
+        PathEntry entry;
+        std::shared_ptr<const ContentEntry> content;
+
+        if (!paths.find(path, entry, [&signature](const PathEntry& cached) { return cached.signature == signature; }) ||
+            !contents.find(entry.hash, content)) {
+            return false;
+        }
+
+        result = content->result;
+        return true;
+    }
+
+    // Результат проверки текста с хэшем hash; текст сравнивается целиком, поэтому коллизия хэша не подменит заявку
+    bool findContent(uint64_t hash, std::string_view text, ParseResult& result) {
+        std::shared_ptr<const ContentEntry> content;
+
+        if (!contents.find(hash, content) || content->text != text) {
+            return false;
+        }
+
+        result = content->result;
+        return true;
+    }
+
+    // Запоминание подписи файла path; файл, изменённый только что, не запоминается (см. settled)
+    void insertPath(const std::string& path, const FileSignature& signature, uint64_t hash) {
+        if (settled(signature)) {
+            paths.insert(path, PathEntry{signature, hash});
+        }
+    }
+
+    // Запоминание результата проверки текста; вес - текст и копия полей заявки
+    void insertContent(uint64_t hash, std::string_view text, const ParseResult& result) {
+        auto content = std::make_shared<ContentEntry>(ContentEntry{std::string(text), result});
+        contents.insert(hash, std::move(content), sizeof(ContentEntry) + 2 * text.size());
+    }
+
+    // Обращения к кэшу по путям и по содержимому
+    const LruCache<std::string, PathEntry>& pathCache() const {
+        return paths;
+    }
+
+    const LruCache<uint64_t, std::shared_ptr<const ContentEntry>>& contentCache() const {
+        return contents;
+    }
+};
+
+// Общий кэш файлов-заявок программы
+RequestFileCache& requestFiles() {
+    static RequestFileCache instance;
+    return instance;
+}
+
+// Разбор текста заявки с кэшем по содержимому: уже проверенный текст повторно не проверяется
+ParseResult parseRequestContents(std::string_view text, RequestFileCache& cache, uint64_t& hash) {
+    ParseResult result;
+    hash = hash64(text.data(), text.size());
+
+    if (!cache.findContent(hash, text, result)) {
+        result = parseRequestText(text);
+        cache.insertContent(hash, text, result);
+    }
+
+    return result;
+}
+
+// Функция для разбора файла-заявки: файл читается один раз целиком
+// Неизменённый файл и уже проверенное содержимое берутся из кэша cache
+// Время чтения и проверки и отказы по причинам учитываются в метриках
+ParseResult parseRequestFile(const std::string& fileName, RequestFileCache& cache) {
+    MetricsTimer timer(metrics().parseTime);
+
+    // Буфер переиспользуется между вызовами в одном потоке
+    thread_local std::string buffer;
+
+    ParseResult result;
+    FileSignature signature;
+
+    if (!fileSignature(fileName, signature) || !cache.findPath(fileName, signature, result)) {
+        // Канал или устройство на месте файла не открывается на ожидание и не читается: принимаются только обычные файлы
+        int fd = ::open(fileName.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        struct stat info;
+
+        if (fd < 0 || ::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+
+            result.error = RequestError::OpenFailed;
+            result.detail = fileName;
+            metrics().reject(RejectReason::OpenFailed);
+            return result;
+        }
+
+        size_t length = 0;
+        bool read = info.st_size <= REQUEST_FILE_MAX && readFileContents(fd, buffer, length, REQUEST_FILE_MAX);
+        ::close(fd);
+
+        // Файл заявки - семь коротких строк, больший файл не читается дальше REQUEST_FILE_MAX байт
+        if (info.st_size > REQUEST_FILE_MAX || length > REQUEST_FILE_MAX) {
+            result.error = RequestError::TooLarge;
+            result.detail = fileName;
+            metrics().reject(RejectReason::TooLarge);
+            return result;
+        }
+
+        // Ошибка чтения - файл не удалось получить, как и при ошибке открытия
+        if (!read) {
+            result.error = RequestError::OpenFailed;
+            result.detail = fileName;
+            metrics().reject(RejectReason::OpenFailed);
+            return result;
+        }
+
+        uint64_t hash;
+        result = parseRequestContents(std::string_view(buffer.data(), length), cache, hash);
+        cache.insertPath(fileName, fileSignature(info), hash);
+    }
+
+    if (!result.ok()) {
+        metrics().reject(rejectReason(result.error));
+    }
+
+    return result;
+}
+
+// Разбор файла-заявки с общим кэшем программы
+ParseResult parseRequestFile(const std::string& fileName) {
+    return parseRequestFile(fileName, requestFiles());
+}
+
+// Функция для чтения заявки из файла
+Request readRequestFromFile(const std::string& fileName) {
+    ParseResult result = parseRequestFile(fileName);
+
+    // Проверка открытия файла
+    if (result.error == RequestError::OpenFailed) {
+        std::cerr << "Ошибка при открытии файла!" << std::endl;
+    }
+
+    return result.request;
+}
+
+// Функция для проверки файла
+bool checkFile(const std::string& filename) {
+    ParseResult result = parseRequestFile(filename);
+
+    if (!result.ok()) {
+        std::cerr << describeError(result) << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Кэш исполняемых файлов по содержимому: хэш файла запоминается по его подписи, поэтому неизменённый
+// файл повторно не читается; копия файла кладётся в хранилище под именем из хэша содержимого,
+// и повторная подача того же файла (под любым путём) запускает готовую копию без переноса
+// Хранилище ограничено по суммарному размеру: вытесненная копия удаляется с диска
+class ExecutableCache {
+private:
+    struct PathEntry {
+        FileSignature signature;
+        uint64_t hash = 0;
+    };
+
+    LruCache<std::string, PathEntry> paths;
+    LruCache<uint64_t, std::string> store;
+    std::mutex storeMutex;
+    std::string storeDirectory;
+    std::atomic<uint64_t> temporaries{0};
+
+    // Хэш открытого файла через отображение в память
+    static bool hashFile(int fd, size_t size, uint64_t& hash) {
+        if (size == 0) {
+            hash = hash64(nullptr, 0);
+            return true;
+        }
+
+        void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED) {
+            return false;
+        }
+
+        hash = hash64(data, size);
+        ::munmap(data, size);
+        return true;
+    }
+
+    // Копирование файла в ядре (copy_file_range); без его поддержки - через буфер
+    static bool copyFile(int from, int to, size_t size) {
+        size_t copied = 0;
+
+        while (copied < size) {
+            ssize_t count = ::copy_file_range(from, nullptr, to, nullptr, size - copied, 0);
+
+            if (count < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                char buffer[EXEC_SPLICE_CHUNK];
+                count = ::read(from, buffer, std::min(sizeof(buffer), size - copied));
+
+                if (count > 0 && ::write(to, buffer, static_cast<size_t>(count)) != count) {
+                    count = -1;
+                }
+            }
+
+            // Файл стал короче, чем при хэшировании
+            if (count <= 0) {
+                return false;
+            }
+
+            copied += static_cast<size_t>(count);
+        }
+
+        return true;
+    }
+
+    // Совпадение содержимого файла path (с подписью signature, полученной при хэшировании) с копией file
+    static bool sameContents(const std::string& path, const FileSignature& signature, const std::string& file) {
+        int from = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        int copy = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat source;
+        struct stat staged;
+        bool same = from >= 0 && copy >= 0 && ::fstat(from, &source) == 0 && ::fstat(copy, &staged) == 0 &&
+                    fileSignature(source) == signature && source.st_size == staged.st_size;
+        size_t size = same ? static_cast<size_t>(source.st_size) : 0;
+
+        if (size > 0) {
+            void* left = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, from, 0);
+            void* right = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, copy, 0);
+            same = left != MAP_FAILED && right != MAP_FAILED && std::memcmp(left, right, size) == 0;
+
+            if (left != MAP_FAILED) {
+                ::munmap(left, size);
+            }
+
+            if (right != MAP_FAILED) {
+                ::munmap(right, size);
+            }
+        }
+
+        if (from >= 0) {
+            ::close(from);
+        }
+
+        if (copy >= 0) {
+            ::close(copy);
+        }
+
+        return same;
+    }
+
+    // Хэш содержимого файла path и подпись, по которой он получен
+    // Открывается только обычный файл и без блокировки: канал или устройство на месте файла не задерживают вызов
+    bool hashPath(const std::string& path, uint64_t& hash, FileSignature& signature) {
+        PathEntry entry;
+        struct stat info;
+
+        if (::stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+            return false;
+        }
+
+        signature = fileSignature(info);
+
+        if (paths.find(path, entry, [&signature](const PathEntry& cached) { return cached.signature == signature; })) {
+            hash = entry.hash;
+            return true;
+        }
+
+        int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        bool ok = fd >= 0 && ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+                  hashFile(fd, static_cast<size_t>(info.st_size), hash);
+
+        if (fd >= 0) {
+            ::close(fd);
+        }
+
+        if (!ok) {
+            return false;
+        }
+
+        signature = fileSignature(info);
+
+        if (settled(signature)) {
+            paths.insert(path, PathEntry{signature, hash});
+        }
+
+        return true;
+    }
+
+public:
+    // Ёмкость: записей по путям и байт в хранилище
+    explicit ExecutableCache(size_t entries = EXEC_CACHE_ENTRIES, size_t bytes = EXEC_CACHE_BYTES)
+        : paths(CacheKind::ExecutablePaths, entries),
+          store(CacheKind::Executables, bytes, [](const uint64_t&, std::string& file) { ::unlink(file.c_str()); }) {}
+
+    // Каталог хранилища копий; копии прошлых запусков учитываются, недописанные удаляются
+    bool setStore(const std::string& directory, std::string& error) {
+        std::error_code code;
+        std::filesystem::create_directories(directory, code);
+
+        if (code) {
+            error = "Не удалось создать каталог кэша " + directory + ": " + code.message();
+            return false;
+        }
+
+        for (const auto& entry : std::filesystem::directory_iterator(directory, code)) {
+            std::string name = entry.path().filename().string();
+
+            if (name.size() == 16 && name.find_first_not_of("0123456789abcdef") == std::string::npos &&
+                entry.is_regular_file(code)) {
+                store.insert(std::stoull(name, nullptr, 16), entry.path().string(), entry.file_size(code));
+            } else if (name.find(".tmp.") != std::string::npos) {
+                std::filesystem::remove(entry.path(), code);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(storeMutex);
+        storeDirectory = directory;
+        return true;
+    }
+
+    // Хэш содержимого файла path; false, если файла нет или он не обычный файл
+    bool contentHash(const std::string& path, uint64_t& hash) {
+        FileSignature signature;
+        return hashPath(path, hash, signature);
+    }
+
+    // Копия файла path в хранилище (путь возвращается в staged); false, если хранилище не задано
+    // или файл не удалось скопировать - тогда запускается сам файл
+    bool stage(const std::string& path, std::string& staged) {
+        std::string directory;
+        {
+            std::lock_guard<std::mutex> lock(storeMutex);
+            directory = storeDirectory;
+        }
+
+        uint64_t hash;
+        FileSignature signature;
+
+        if (directory.empty() || !hashPath(path, hash, signature)) {
+            return false;
+        }
+
+        // Копию могли удалить с диска в обход кэша. Копия находится только по 64-битному хэшу, поэтому перед
+        // запуском она сверяется с файлом побайтно: при коллизии или изменённой на диске копии файл копируется заново
+        if (store.find(hash, staged, [](const std::string& file) { return ::access(file.c_str(), X_OK) == 0; })) {
+            if (sameContents(path, signature, staged)) {
+                return true;
+            }
+
+            store.erase(hash);
+        }
+
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+        std::string target = directory + "/" + name;
+        std::string temporary = target + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(temporaries++);
+
+        int from = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+        if (from < 0) {
+            return false;
+        }
+
+        int to = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0755);
+        struct stat before;
+        struct stat after;
+
+        // Копия годится, только если файл не менялся с хэширования до конца копирования
+        bool ok = to >= 0 && ::fstat(from, &before) == 0 && fileSignature(before) == signature &&
+                  copyFile(from, to, static_cast<size_t>(before.st_size)) && ::fstat(from, &after) == 0 &&
+                  fileSignature(after) == signature && ::fchmod(to, 0755) == 0;
+
+        ::close(from);
+
+        if (to >= 0 && ::close(to) != 0) {
+            ok = false;
+        }
+
+        if (!ok || ::rename(temporary.c_str(), target.c_str()) != 0) {
+            ::unlink(temporary.c_str());
+            return false;
+        }
+
+        store.insert(hash, target, static_cast<size_t>(before.st_size));
+        staged = target;
+        return true;
+    }
+
+    // Обращения к кэшу хэшей и к хранилищу копий
+    const LruCache<std::string, PathEntry>& pathCache() const {
+        return paths;
+    }
+
+    const LruCache<uint64_t, std::string>& storeCache() const {
+        return store;
+    }
+};
+
+// Общий кэш исполняемых файлов программы
+ExecutableCache& executables() {
+    static ExecutableCache instance;
+    return instance;
+}
+
+// Тесты разбора заявки
+void testParseRequest() {
+    // Корректная заявка, в том числе с переводами строк Windows
+    ParseResult valid = parseRequestText("Иванов\nИван\nИванович\nБИВ211\nArduino Uno\n/users/Ivan/main.cpp\nC:\\Results\n");
+    assert(valid.ok());
+    assert(valid.request.lastName == "Иванов");
+    assert(valid.request.boardName == "Arduino Uno");
+    assert(valid.request.resultPath == "C:\\Results");
+
+    ParseResult windows = parseRequestText("Ivanov\r\nIvan\r\nIvanovich\r\nBIV211\r\nSTM-32\r\nmain.exe\r\nC:\r\n");
+    assert(windows.ok());
+    assert(windows.request.boardName == "STM-32");
+    assert(windows.request.resultPath == "C:");
+
+    // Первая ошибочная строка возвращается вместе с видом ошибки
+    ParseResult badGroup = parseRequestText("Ivanov\nIvan\nIvanovich\nBIV 211\nSTM-32\nmain.exe\nC:\n");
+    assert(badGroup.error == RequestError::Group);
+    assert(badGroup.detail == "BIV 211");
+    assert(describeError(badGroup) == "Ошибка в группе: BIV 211");
+
+    ParseResult noBoard = parseRequestText("Ivanov\nIvan\nIvanovich\nBIV211\n\nmain.exe\nC:\n");
+    assert(noBoard.error == RequestError::BoardName);
+
+    // Обрезанный файл: недостающие строки пустые
+    ParseResult truncated = parseRequestText("Ivanov\nIvan\nIvanovich\nBIV211\nSTM-32\nmain.exe");
+    assert(truncated.error == RequestError::ResultPath);
+
+    ParseResult missing = parseRequestFile("invalid_path.txt");
+    assert(missing.error == RequestError::OpenFailed);
+    assert(missing.detail == "invalid_path.txt");
+
+    // Каталог не обычный файл: он не принимается за пустую заявку
+    std::string unreadable = std::filesystem::temp_directory_path().string();
+    ParseResult directory = parseRequestFile(unreadable);
+    assert(directory.error == RequestError::OpenFailed && directory.detail == unreadable);
+}
+
+// Тесты хэша содержимого и кэшей файлов-заявок и исполняемых файлов
+void testContentCache() {
+    // Контрольные значения XXH64 с нулевым начальным значением, в том числе блоки по 32 байта и хвосты
+    assert(hash64("", 0) == 0xEF46DB3751D8E999ull);
+    assert(hash64("abc", 3) == 0x44BC2CF5AD770999ull);
+    std::string sentence = "Nobody inspects the spammish repetition";
+    assert(hash64(sentence.data(), sentence.size()) == 0xFBCEA83C8A378BF1ull);
+
+    // Вытесняется давно не использованная запись, попадания и промахи считаются
+    LruCache<int, int> lru(CacheKind::RequestPaths, 2);
+    int value = 0;
+    lru.insert(1, 10);
+    lru.insert(2, 20);
+    assert(lru.find(1, value) && value == 10);
+    lru.insert(3, 30);
+    assert(!lru.find(2, value) && lru.find(3, value) && value == 30);
+    assert(lru.hits() == 2 && lru.misses() == 1 && lru.evictions() == 1 && lru.hitRate() > 0.6);
+    assert(!lru.find(1, value, [](int cached) { return cached != 10; }) && lru.size() == 1);
+
+    // Ёмкость по весу; вытесненная запись передаётся обработчику
+    std::vector<int> evicted;
+    LruCache<int, int> weighted(CacheKind::Executables, 10, [&evicted](const int& key, int&) { evicted.push_back(key); });
+    weighted.insert(1, 0, 6);
+    weighted.insert(2, 0, 6);
+    assert((evicted == std::vector<int>{1}) && weighted.totalWeight() == 6);
+
+    auto directory = std::filesystem::temp_directory_path() / "remote_stand_test_cache";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    auto write = [&directory](const std::string& name, const std::string& text) {
+        std::ofstream((directory / name).string()) << text;
+        return (directory / name).string();
+    };
+
+    // Неизменённый файл берётся из кэша по пути, тот же текст в другом файле - из кэша по содержимому
+    RequestFileCache requests;
+    std::string text = "Ivanov\nIvan\nIvanovich\nBIV211\nSTM-32\nmain.exe\nC:\n";
+    std::string first = write("first.txt", text);
+    std::this_thread::sleep_for(CACHE_SETTLE_TIME);
+
+    assert(parseRequestFile(first, requests).ok());
+    assert(requests.pathCache().hits() == 0 && requests.contentCache().hits() == 0);
+    ParseResult cached = parseRequestFile(first, requests);
+    assert(cached.ok() && cached.request.lastName == "Ivanov" && requests.pathCache().hits() == 1);
+
+    std::string second = write("second.txt", text);
+    assert(parseRequestFile(second, requests).ok());
+    assert(requests.pathCache().hits() == 1 && requests.contentCache().hits() == 2);
+
+    // Изменённый файл проверяется заново; только что изменённый файл не запоминается по пути
+    write("first.txt", "Ivanov\nIvan\nIvanovich\nBIV 211\nSTM-32\nmain.exe\nC:\n");
+    assert(parseRequestFile(first, requests).error == RequestError::Group);
+    assert(parseRequestFile(first, requests).error == RequestError::Group);
+    assert(requests.pathCache().hits() == 1 && requests.contentCache().hits() == 3);
+    assert(parseRequestFile((directory / "missing.txt").string(), requests).error == RequestError::OpenFailed);
+
+    // Канал и устройство вместо файла-заявки отклоняются сразу, большой файл не читается целиком
+    std::string requestFifo = (directory / "request.fifo").string();
+    assert(::mkfifo(requestFifo.c_str(), 0600) == 0);
+    assert(parseRequestFile(requestFifo, requests).error == RequestError::OpenFailed);
+    assert(parseRequestFile("/dev/zero", requests).error == RequestError::OpenFailed);
+    std::string huge = write("huge.txt", text + std::string(REQUEST_FILE_MAX, '#'));
+    ParseResult oversized = parseRequestFile(huge, requests);
+    assert(oversized.error == RequestError::TooLarge && oversized.detail == huge);
+    assert(describeError(oversized) == "Файл заявки больше " + std::to_string(REQUEST_FILE_MAX) + " байт: " + huge);
+    std::string padded = write("padded.txt", text + std::string(REQUEST_FILE_MAX - text.size(), '#'));
+    assert(parseRequestFile(padded, requests).error != RequestError::TooLarge);
+
+    // Копия исполняемого файла в хранилище по содержимому: повторная подача и другой путь с тем же
+    // содержимым не копируются заново, хранилище ограничено по объёму
+    std::string store = (directory / "store").string();
+    ExecutableCache programs(16, 100);
+    std::string error;
+    std::string staged;
+    std::string again;
+    assert(!programs.stage(first, staged));
+    assert(programs.setStore(store, error));
+
+    std::string program = write("program.sh", "#!/bin/sh\necho program\n");
+    std::string copy = write("copy.sh", "#!/bin/sh\necho program\n");
+    std::this_thread::sleep_for(CACHE_SETTLE_TIME);
+    uint64_t hash;
+    uint64_t copyHash;
+    assert(programs.contentHash(program, hash) && programs.contentHash(copy, copyHash) && hash == copyHash);
+    assert(programs.stage(program, staged) && ::access(staged.c_str(), X_OK) == 0);
+    assert(std::filesystem::path(staged).parent_path() == store && std::filesystem::file_size(staged) == 23);
+    assert(programs.stage(program, again) && again == staged);
+    assert(programs.stage(copy, again) && again == staged);
+    assert(programs.storeCache().hits() == 2 && programs.storeCache().misses() == 1);
+    assert(programs.pathCache().hits() >= 3);
+    assert(!programs.stage((directory / "missing.sh").string(), again));
+
+    // Канал на месте исполняемого файла не открывается и не задерживает вызов
+    std::string fifo = (directory / "program.fifo").string();
+    assert(::mkfifo(fifo.c_str(), 0600) == 0);
+    assert(!programs.contentHash(fifo, hash) && !programs.stage(fifo, again));
+
+    std::string large = write("large.sh", "#!/bin/sh\n" + std::string(80, '#') + "\n");
+    assert(programs.stage(large, again) && again != staged);
+    assert(programs.storeCache().evictions() == 1 && !std::filesystem::exists(staged));
+
+    // Копии прошлого запуска учитываются, недописанные удаляются
+    write("store/0123456789abcdef.tmp.1.0", "partial");
+    ExecutableCache restarted;
+    assert(restarted.setStore(store, error) && restarted.storeCache().size() == 1);
+    assert(!std::filesystem::exists(directory / "store" / "0123456789abcdef.tmp.1.0"));
+    assert(restarted.stage(large, staged) && staged == again && restarted.storeCache().hits() == 1);
+
+    // Копия с тем же хэшем в имени, но другим содержимым не запускается, а заменяется копией файла
+    std::string largeText = "#!/bin/sh\n" + std::string(80, '#') + "\n";
+    {
+        std::ofstream tampered(again, std::ios::binary | std::ios::trunc);
+        tampered << "#!/bin/sh\n" << std::string(80, '!') << "\n";
+    }
+
+    assert(restarted.stage(large, staged) && staged == again && ::access(staged.c_str(), X_OK) == 0);
+    std::ifstream restaged(staged, std::ios::binary);
+    assert(std::string((std::istreambuf_iterator<char>(restaged)), std::istreambuf_iterator<char>()) == largeText);
+
+    std::filesystem::remove_all(directory);
+}
+
+// Ограниченная кольцевая очередь без блокировок для нескольких производителей и потребителей
+// Каждая ячейка хранит номер последовательности, по которому видно, свободна она или занята
+template <typename T>
+class MpmcRing {
+private:
+    // Ячейка очереди
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+
+public:
+    // Конструктор, ёмкость округляется вверх до степени двойки
+    explicit MpmcRing(size_t capacity) {
+        size_t size = 2;
+
+        while (size < capacity) {
+            size *= 2;
+        }
+
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    // Попытка добавить элемент, возвращает false при заполненной очереди
+    bool tryPush(T&& value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+        while (true) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (difference == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Попытка извлечь элемент, возвращает false при пустой очереди
+    bool tryPop(T& value) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+
+        while (true) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+            if (difference == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Ёмкость очереди
+    size_t capacity() const {
+        return mask + 1;
+    }
+};
+
+// Асинхронный журнал: вызывающие потоки только кладут готовую запись в очередь,
+// фоновый поток собирает записи в пакеты и пишет их в файл крупными вызовами write
+class AsyncLogger {
+private:
+    // Очередь готовых записей
+    MpmcRing<std::string> queue;
+    // Путь к файлу журнала и параметры сброса и ротации
+    std::string path;
+    std::chrono::milliseconds flushInterval;
+    size_t maxFileSize;
+    size_t maxFiles;
+
+    // Дескриптор и текущий размер файла журнала (используются только фоновым потоком)
+    int fd = -1;
+    size_t fileSize = 0;
+
+    // Количество записей, не поместившихся в очередь: ещё не отмеченных в файле и всего
+    std::atomic<size_t> dropped{0};
+    std::atomic<size_t> droppedCount{0};
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    // Сигнал писателям, ждущим места в заполненной очереди
+    std::condition_variable spaceFreed;
+    std::thread writer;
+    // Меняется под mutex, читается писателями и без него
+    std::atomic<bool> stopping{false};
+    // Писатели, проверившие stopping и ещё не закончившие постановку: итоговый сброс ждёт их
+    std::atomic<size_t> pushing{0};
+
+    // Открытие файла журнала на дозапись
+    void openFile() {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+        if (fd < 0) {
+            std::cerr << "Не удалось открыть лог-файл!" << std::endl;
+            return;
+        }
+
+        struct stat info;
+        fileSize = ::fstat(fd, &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+    }
+
+    // Ротация по размеру: logs.txt -> logs.txt.1 -> ... -> logs.txt.N
+    void rotate() {
+        ::close(fd);
+        fd = -1;
+
+        for (size_t i = maxFiles; i > 1; --i) {
+            std::string from = path + "." + std::to_string(i - 1);
+            std::string to = path + "." + std::to_string(i);
+            ::rename(from.c_str(), to.c_str());
+        }
+
+        if (maxFiles > 0) {
+            ::rename(path.c_str(), (path + ".1").c_str());
+        } else {
+            ::unlink(path.c_str());
+        }
+
+        openFile();
+    }
+
+    // Запись пакета целиком, с повтором при частичной записи
+    void writeBatch(const std::string& batch) {
+        if (fd < 0) {
+            openFile();
+        }
+
+        if (fd < 0) {
+            return;
+        }
+
+        size_t written = 0;
+
+        while (written < batch.size()) {
+            ssize_t count = ::write(fd, batch.data() + written, batch.size() - written);
+
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (count <= 0) {
+                std::cerr << "Не удалось записать в лог-файл!" << std::endl;
+                return;
+            }
+
+            written += static_cast<size_t>(count);
+        }
+
+        fileSize += batch.size();
+
+        if (maxFileSize > 0 && fileSize >= maxFileSize) {
+            rotate();
+        }
+    }
+
+    // Сбор всех записей из очереди в один пакет и его запись
+    bool drain(std::string& batch) {
+        std::string record;
+        batch.clear();
+
+        while (queue.tryPop(record)) {
+            batch += record;
+        }
+
+        size_t lost = dropped.exchange(0);
+
+        if (lost > 0) {
+            batch += "Пропущено записей журнала: " + std::to_string(lost) + "\n";
+        }
+
+        if (batch.empty()) {
+            return false;
+        }
+
+        writeBatch(batch);
+        return true;
+    }
+
+    // Цикл фонового потока
+    void run() {
+        std::string batch;
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!stopping) {
+            wakeUp.wait_for(lock, flushInterval);
+            lock.unlock();
+            drain(batch);
+            lock.lock();
+            spaceFreed.notify_all();
+        }
+
+        lock.unlock();
+
+        // Записи, начатые до остановки, успевают попасть в очередь до итогового сброса
+        while (pushing.load() != 0) {
+            std::this_thread::yield();
+        }
+
+        // Гарантированный сброс всего, что успели положить в очередь
+        while (drain(batch)) {
+        }
+    }
+
+    // Постановка записи в очередь с ожиданием места; false, если место не появилось или журнал остановлен
+    bool push(std::string& record) {
+        for (int attempt = 0; attempt < 64; ++attempt) {
+            if (queue.tryPush(std::move(record))) {
+                return true;
+            }
+
+            wakeUp.notify_one();
+            std::this_thread::yield();
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + LOG_BLOCK_TIMEOUT;
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!stopping) {
+            if (queue.tryPush(std::move(record))) {
+                return true;
+            }
+
+            wakeUp.notify_one();
+
+            if (spaceFreed.wait_until(lock, deadline) == std::cv_status::timeout) {
+                return queue.tryPush(std::move(record));
+            }
+        }
+
+        return false;
+    }
+
+public:
+    // Конструктор
+    AsyncLogger(const std::string& path, std::chrono::milliseconds flushInterval = LOG_FLUSH_INTERVAL,
+                size_t maxFileSize = LOG_MAX_SIZE, size_t maxFiles = LOG_MAX_FILES, size_t queueSize = LOG_QUEUE_SIZE)
+        : queue(queueSize), path(path), flushInterval(flushInterval), maxFileSize(maxFileSize), maxFiles(maxFiles) {
+        writer = std::thread(&AsyncLogger::run, this);
+    }
+
+    // Деструктор: сбрасывает оставшиеся записи
+    ~AsyncLogger() {
+        shutdown();
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Постановка готовой записи в очередь, в обычном случае без блокировки
+    // При заполненной очереди фоновый поток будится, а вызывающий ждёт освобождения места не дольше
+    // LOG_BLOCK_TIMEOUT; только если за это время место не появилось, запись отбрасывается,
+    // учитывается в droppedTotal() и отмечается в файле строкой "Пропущено записей журнала"
+    // После shutdown() записывать некому: запись отбрасывается и учитывается в droppedTotal()
+    bool log(std::string record) {
+        pushing.fetch_add(1);
+        bool queued = !stopping.load() && push(record);
+        pushing.fetch_sub(1);
+
+        if (!queued) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return queued;
+    }
+
+    // Количество отброшенных записей за всё время работы
+    size_t droppedTotal() const {
+        return droppedCount.load(std::memory_order_relaxed);
+    }
+
+    // Остановка фонового потока с записью всех оставшихся записей
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wakeUp.notify_all();
+        spaceFreed.notify_all();
+
+        if (writer.joinable()) {
+            writer.join();
+        }
+
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+};
+
+// Путь к журналу программы, можно изменить до первой записи
+std::string& logPath() {
+    static std::string path = LOG_PATH;
+    return path;
+}
+
+// Журнал программы
+AsyncLogger& logger() {
+    static AsyncLogger instance(logPath());
+    return instance;
+}
+
+// Функция для записи в логи
+void writeToLog(const std::string& message) {
+    logger().log(message);
+}
+
+// Функция для записи в лог готового сообщения без копирования
+void writeToLog(std::string&& message) {
+    logger().log(std::move(message));
+}
+
+// Тесты асинхронного журнала
+void testAsyncLogger() {
+    std::string path = (std::filesystem::temp_directory_path() / "remote_stand_test_log.txt").string();
+
+    for (size_t i = 0; i <= 3; ++i) {
+        std::filesystem::remove(i == 0 ? path : path + "." + std::to_string(i));
+    }
+
+    // Несколько потоков пишут одновременно, строки не должны перемешиваться
+    // Каждая запись либо попадает в файл, либо учитывается как отброшенная;
+    // если очередь вмещает все записи, не отбрасывается ни одна
+    for (size_t queueSize : {size_t(LOG_QUEUE_SIZE), size_t(64)}) {
+        size_t dropped = 0;
+
+        {
+            AsyncLogger testLogger(path, std::chrono::milliseconds(5), 0, 0, queueSize);
+            std::vector<std::thread> threads;
+
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&testLogger, t]() {
+                    for (int i = 0; i < 1000; ++i) {
+                        testLogger.log("поток " + std::to_string(t) + " запись " + std::to_string(i) + "\n");
+                    }
+                });
+            }
+
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            // Все записи дописываются при остановке, запись после остановки учитывается как отброшенная
+            testLogger.shutdown();
+            dropped = testLogger.droppedTotal();
+            assert(!testLogger.log("после остановки\n") && testLogger.droppedTotal() == dropped + 1);
+        }
+
+        std::ifstream file(path);
+        std::string line;
+        size_t lines = 0;
+        size_t reported = 0;
+
+        while (std::getline(file, line)) {
+            if (line.rfind("поток ", 0) == 0) {
+                ++lines;
+            } else {
+                assert(line.rfind("Пропущено записей журнала: ", 0) == 0);
+                reported += std::stoul(line.substr(line.rfind(' ') + 1));
+            }
+        }
+
+        assert(lines + dropped == 4000 && reported == dropped);
+
+        if (queueSize >= 4000) {
+            assert(dropped == 0);
+        }
+
+        file.close();
+        std::filesystem::remove(path);
+    }
+
+    // Ротация по размеру создаёт нумерованные файлы
+    {
+        AsyncLogger testLogger(path, std::chrono::milliseconds(1), 256, 2);
+
+        for (int i = 0; i < 50; ++i) {
+            testLogger.log(std::string(100, 'x') + "\n");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    assert(std::filesystem::exists(path + ".1"));
+    assert(std::filesystem::exists(path + ".2"));
+    assert(!std::filesystem::exists(path + ".3"));
+
+    for (size_t i = 0; i <= 3; ++i) {
+        std::filesystem::remove(i == 0 ? path : path + "." + std::to_string(i));
+    }
+}
+
+// Колесо таймеров: один поток-диспетчер вместо отдельного потока на каждое уведомление
+// Вставка и отмена таймера выполняются за O(1), каждый ожидающий таймер занимает одну запись
+class TimerWheel {
+public:
+    // Идентификатор таймера: поколение записи в старших битах, индекс записи в младших
+    using TimerId = uint64_t;
+
+private:
+    // Признак отсутствия записи в списке
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    // Запись таймера
+    struct Timer {
+        std::chrono::system_clock::time_point deadline;
+        std::function<void()> callback;
+        // Номер тика, на котором таймер должен сработать
+        uint64_t expiryTick = 0;
+        // Соседи в двусвязном списке слота
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        // Поколение записи, защищает от отмены чужого таймера по старому идентификатору
+        // Поколения начинаются с 1, поэтому идентификатор таймера никогда не равен 0 ("таймера нет")
+        uint32_t generation = 1;
+        bool active = false;
+    };
+
+    // Записи таймеров и список свободных записей
+    std::vector<Timer> timers;
+    std::vector<uint32_t> freeList;
+    // Голова списка таймеров каждого слота колеса
+    std::vector<uint32_t> slots;
+    // Наименьший тик таймеров каждого слота (UINT64_MAX для пустого) и занятые слоты по битам:
+    // ближайший срок ищется по занятым слотам, а не обходом всех таймеров
+    std::vector<uint64_t> slotMin;
+    std::array<uint64_t, TIMER_SLOTS / 64> occupied{};
+    // Момент, от которого отсчитываются тики
+    std::chrono::system_clock::time_point origin;
+    // Текущий необработанный тик
+    uint64_t currentTick = 0;
+    // Количество ожидающих таймеров
+    size_t pendingCount = 0;
+
+    // Часы, по которым отсчитываются сроки
+    const Clock& clock;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::thread dispatcher;
+    bool stopping = false;
+    // Тик, до которого спит диспетчер (UINT64_MAX, пока таймеров нет)
+    uint64_t wakeTick = UINT64_MAX;
+    // Количество пробуждений диспетчера
+    size_t wakeCount = 0;
+
+    // Номер тика, на котором наступит заданный момент (с округлением вверх)
+    uint64_t tickOf(std::chrono::system_clock::time_point time) const {
+        if (time <= origin) {
+            return 0;
+        }
+
+        auto ticks = (time - origin + TIMER_TICK - std::chrono::system_clock::duration(1)) / TIMER_TICK;
+        return static_cast<uint64_t>(ticks);
+    }
+
+    // Пересчёт наименьшего тика и признака занятости слота по его списку
+    void refreshSlot(size_t slot) {
+        uint64_t earliest = UINT64_MAX;
+
+        for (uint32_t index = slots[slot]; index != NIL; index = timers[index].next) {
+            earliest = std::min(earliest, timers[index].expiryTick);
+        }
+
+        slotMin[slot] = earliest;
+
+        if (earliest == UINT64_MAX) {
+            occupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+        } else {
+            occupied[slot / 64] |= uint64_t(1) << (slot % 64);
+        }
+    }
+
+    // Исключение таймера из списка его слота без пересчёта слота
+    void detach(uint32_t index) {
+        Timer& timer = timers[index];
+        size_t slot = timer.expiryTick % TIMER_SLOTS;
+
+        if (timer.prev != NIL) {
+            timers[timer.prev].next = timer.next;
+        } else {
+            slots[slot] = timer.next;
+        }
+
+        if (timer.next != NIL) {
+            timers[timer.next].prev = timer.prev;
+        }
+
+        timer.prev = NIL;
+        timer.next = NIL;
+    }
+
+    // Удаление таймера из списка его слота; слот пересматривается, только если таймер был в нём ближайшим
+    void unlink(uint32_t index) {
+        size_t slot = timers[index].expiryTick % TIMER_SLOTS;
+        detach(index);
+
+        if (slots[slot] == NIL || timers[index].expiryTick == slotMin[slot]) {
+            refreshSlot(slot);
+        }
+    }
+
+    // Вставка таймера в голову списка его слота
+    void link(uint32_t index) {
+        Timer& timer = timers[index];
+        size_t slot = timer.expiryTick % TIMER_SLOTS;
+        timer.prev = NIL;
+        timer.next = slots[slot];
+
+        if (slots[slot] != NIL) {
+            timers[slots[slot]].prev = index;
+        }
+
+        slots[slot] = index;
+        slotMin[slot] = std::min(slotMin[slot], timer.expiryTick);
+        occupied[slot / 64] |= uint64_t(1) << (slot % 64);
+    }
+
+    // Освобождение записи таймера
+    void release(uint32_t index) {
+        Timer& timer = timers[index];
+
+        timer.active = false;
+        timer.callback = nullptr;
+        ++timer.generation;
+        freeList.push_back(index);
+        --pendingCount;
+    }
+
+    // Сбор сработавших таймеров одного слота
+    void collectSlot(size_t slot, uint64_t tick, std::vector<std::pair<std::chrono::system_clock::time_point, std::function<void()>>>& due) {
+        uint32_t index = slots[slot];
+
+        while (index != NIL) {
+            uint32_t next = timers[index].next;
+
+            if (timers[index].expiryTick <= tick) {
+                detach(index);
+                due.emplace_back(timers[index].deadline, std::move(timers[index].callback));
+                release(index);
+            }
+
+            index = next;
+        }
+
+        refreshSlot(slot);
+    }
+
+    // Ближайший тик, на котором сработает хотя бы один таймер
+    // Занятые слоты обходятся по битовой карте в порядке тиков от текущего, не дальше одного оборота колеса:
+    // слот срабатывает на своём тике этого оборота, если его наименьший тик не позже; иначе берётся
+    // наименьший тик среди всех занятых слотов
+    uint64_t nextExpiryTick() const {
+        static_assert(TIMER_SLOTS % 64 == 0, "TIMER_SLOTS must be a multiple of 64");
+        constexpr size_t words = TIMER_SLOTS / 64;
+        uint64_t earliest = UINT64_MAX;
+        size_t start = currentTick % TIMER_SLOTS;
+
+        // Слово со стартовым слотом обходится дважды: сначала с него, в конце оборота - до него
+        for (size_t step = 0; step <= words; ++step) {
+            size_t word = (start / 64 + step) % words;
+            uint64_t bits = occupied[word];
+
+            if (step == 0) {
+                bits &= ~uint64_t(0) << (start % 64);
+            } else if (step == words) {
+                bits &= (uint64_t(1) << (start % 64)) - 1;
+            }
+
+            while (bits != 0) {
+                size_t slot = word * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+                bits &= bits - 1;
+                uint64_t tick = currentTick + (slot + TIMER_SLOTS - start) % TIMER_SLOTS;
+
+                if (slotMin[slot] <= tick) {
+                    return tick;
+                }
+
+                earliest = std::min(earliest, slotMin[slot]);
+            }
+        }
+
+        return earliest;
+    }
+
+    // Цикл потока-диспетчера
+    // С системными часами поток спит до ближайшего срока, а не просыпается каждый тик;
+    // с виртуальными часами время идёт не само, поэтому они опрашиваются раз в тик
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!stopping) {
+            if (pendingCount == 0) {
+                wakeTick = UINT64_MAX;
+                wakeUp.wait(lock);
+            } else if (!clock.isRealTime()) {
+                wakeUp.wait_for(lock, TIMER_TICK);
+            } else {
+                wakeTick = nextExpiryTick();
+                auto delay = origin + TIMER_TICK * wakeTick - clock.now();
+
+                if (delay > std::chrono::system_clock::duration::zero()) {
+                    wakeUp.wait_for(lock, delay);
+                }
+            }
+
+            wakeTick = UINT64_MAX;
+            ++wakeCount;
+
+            if (stopping) {
+                break;
+            }
+
+            lock.unlock();
+            poll(clock.now());
+            lock.lock();
+        }
+    }
+
+public:
+    // Конструктор
+    explicit TimerWheel(const Clock& clock = systemClock())
+        : slots(TIMER_SLOTS, NIL), slotMin(TIMER_SLOTS, UINT64_MAX), origin(clock.now()), clock(clock) {}
+
+    // Деструктор: останавливает поток-диспетчер
+    ~TimerWheel() {
+        stop();
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Запуск потока-диспетчера
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!dispatcher.joinable()) {
+            stopping = false;
+            dispatcher = std::thread(&TimerWheel::run, this);
+        }
+    }
+
+    // Остановка потока-диспетчера, ожидающие таймеры отменяются
+    // Возвращает количество отменённых таймеров
+    size_t stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wakeUp.notify_all();
+
+        if (dispatcher.joinable()) {
+            dispatcher.join();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t cancelled = pendingCount;
+
+        for (uint32_t i = 0; i < timers.size(); ++i) {
+            if (timers[i].active) {
+                unlink(i);
+                release(i);
+            }
+        }
+
+        return cancelled;
+    }
+
+    // Добавление таймера за O(1)
+    TimerId schedule(std::chrono::system_clock::time_point deadline, std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t index;
+
+        if (!freeList.empty()) {
+            index = freeList.back();
+            freeList.pop_back();
+        } else {
+            index = static_cast<uint32_t>(timers.size());
+            timers.emplace_back();
+        }
+
+        Timer& timer = timers[index];
+        timer.deadline = deadline;
+        timer.callback = std::move(callback);
+        timer.expiryTick = std::max(tickOf(deadline), currentTick);
+        timer.active = true;
+        link(index);
+        ++pendingCount;
+
+        // Диспетчер будится, только если новый таймер сработает раньше, чем он собирался проснуться
+        if (timer.expiryTick < wakeTick) {
+            wakeUp.notify_all();
+        }
+
+        return (static_cast<uint64_t>(timer.generation) << 32) | index;
+    }
+
+    // Отмена таймера за O(1), возвращает false, если таймер уже сработал или отменён
+    bool cancel(TimerId id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t index = static_cast<uint32_t>(id & UINT32_MAX);
+        uint32_t generation = static_cast<uint32_t>(id >> 32);
+
+        if (index >= timers.size() || !timers[index].active || timers[index].generation != generation) {
+            return false;
+        }
+
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    // Перенос ожидающего таймера на новый срок за O(1) с сохранением обработчика и идентификатора
+    // Возвращает false, если таймер уже сработал или отменён
+    bool reschedule(TimerId id, std::chrono::system_clock::time_point deadline) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t index = static_cast<uint32_t>(id & UINT32_MAX);
+        uint32_t generation = static_cast<uint32_t>(id >> 32);
+
+        if (index >= timers.size() || !timers[index].active || timers[index].generation != generation) {
+            return false;
+        }
+
+        unlink(index);
+        timers[index].deadline = deadline;
+        timers[index].expiryTick = std::max(tickOf(deadline), currentTick);
+        link(index);
+
+        if (timers[index].expiryTick < wakeTick) {
+            wakeUp.notify_all();
+        }
+
+        return true;
+    }
+
+    // Срабатывание всех таймеров, срок которых наступил по часам колеса
+    size_t poll() {
+        return poll(clock.now());
+    }
+
+    // Срабатывание всех таймеров, срок которых наступил к заданному моменту
+    // Обработчики вызываются вне блокировки в порядке сроков
+    size_t poll(std::chrono::system_clock::time_point now) {
+        std::vector<std::pair<std::chrono::system_clock::time_point, std::function<void()>>> due;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            uint64_t target = now < origin ? 0 : static_cast<uint64_t>((now - origin) / TIMER_TICK);
+
+            if (target >= currentTick) {
+                if (pendingCount == 0) {
+                    // Без таймеров пустые тики пропускаются целиком
+                    currentTick = target + 1;
+                } else if (target - currentTick >= TIMER_SLOTS) {
+                    // За большой промежуток каждый слот обходится только один раз
+                    for (size_t slot = 0; slot < TIMER_SLOTS; ++slot) {
+                        collectSlot(slot, target, due);
+                    }
+
+                    currentTick = target + 1;
+                } else {
+                    for (; currentTick <= target; ++currentTick) {
+                        collectSlot(currentTick % TIMER_SLOTS, currentTick, due);
+                    }
+                }
+            }
+        }
+
+        std::stable_sort(due.begin(), due.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+
+        for (auto& timer : due) {
+            timer.second();
+        }
+
+        return due.size();
+    }
+
+    // Количество ожидающих таймеров
+    size_t pending() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pendingCount;
+    }
+
+    // Количество пробуждений потока-диспетчера
+    size_t wakeups() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return wakeCount;
+    }
+};
+
+// Тесты колеса таймеров
+void testTimerWheel() {
+    using namespace std::chrono;
+
+    TimerWheel wheel;
+    auto now = system_clock::now();
+    std::vector<int> fired;
+
+    // Таймеры срабатывают в порядке сроков, отменённый таймер не срабатывает
+    wheel.schedule(now + milliseconds(40), [&]() { fired.push_back(2); });
+    auto cancelled = wheel.schedule(now + milliseconds(30), [&]() { fired.push_back(0); });
+    wheel.schedule(now + milliseconds(20), [&]() { fired.push_back(1); });
+    wheel.schedule(now + hours(1), [&]() { fired.push_back(3); });
+    assert(wheel.pending() == 4);
+
+    assert(wheel.cancel(cancelled));
+    assert(!wheel.cancel(cancelled));  // Повторная отмена невозможна
+    assert(wheel.pending() == 3);
+
+    // До наступления срока ничего не срабатывает
+    assert(wheel.poll(now) == 0);
+
+    // Перенесённый таймер срабатывает в новый срок
+    auto moved = wheel.schedule(now + milliseconds(10), [&]() { fired.push_back(4); });
+    assert(wheel.reschedule(moved, now + minutes(5)) && wheel.pending() == 4);
+    assert(!wheel.reschedule(cancelled, now));
+
+    assert(wheel.poll(now + seconds(1)) == 2);
+    assert((fired == std::vector<int>{1, 2}));
+    assert(wheel.poll(now + minutes(6)) == 1 && fired.back() == 4);
+
+    // Таймер через час срабатывает после перескока через всё колесо
+    assert(wheel.poll(now + hours(2)) == 1);
+    assert(fired.back() == 3);
+    assert(wheel.pending() == 0);
+
+    // Проверка срабатывания в потоке-диспетчере
+    TimerWheel threadWheel;
+    std::promise<void> done;
+    threadWheel.start();
+    threadWheel.schedule(system_clock::now() + milliseconds(20), [&]() { done.set_value(); });
+    assert(done.get_future().wait_for(seconds(5)) == std::future_status::ready);
+
+    // Далёкий таймер не будит диспетчер каждый тик
+    threadWheel.schedule(system_clock::now() + hours(1), []() {});
+    size_t wakeups = threadWheel.wakeups();
+    std::this_thread::sleep_for(TIMER_TICK * 10);
+    assert(threadWheel.wakeups() - wakeups <= 2);
+
+    // Отменённый ближайший таймер слота не оставляет его срок: диспетчер не просыпается к нему
+    // и не крутится на прошедшем сроке, хотя в том же слоте ждёт таймер следующего оборота
+    auto nearest = threadWheel.schedule(system_clock::now() + TIMER_TICK * 3, []() {});
+    threadWheel.schedule(system_clock::now() + TIMER_TICK * (3 + TIMER_SLOTS), []() {});
+    assert(threadWheel.cancel(nearest));
+    wakeups = threadWheel.wakeups();
+    std::this_thread::sleep_for(TIMER_TICK * 10);
+    assert(threadWheel.wakeups() - wakeups <= 2);
+
+    // Более ранний таймер будит спящий диспетчер
+    std::promise<void> early;
+    threadWheel.schedule(system_clock::now() + milliseconds(20), [&]() { early.set_value(); });
+    assert(early.get_future().wait_for(seconds(5)) == std::future_status::ready);
+
+    // Остановка отменяет ожидающие таймеры
+    assert(threadWheel.stop() == 2);
+    assert(threadWheel.pending() == 0);
+}
+
+// Потоковая оценка квантиля алгоритмом P² (Jain, Chlamtac): пять маркеров, O(1) памяти и времени на значение
+class P2Quantile {
+private:
+    double quantile;
+    size_t count = 0;
+    // Высоты маркеров, их текущие и желаемые позиции и приращения желаемых позиций
+    double heights[5] = {};
+    double positions[5] = {0, 1, 2, 3, 4};
+    double desired[5];
+    double increments[5];
+
+    // Параболическая интерполяция высоты маркера i при сдвиге на d
+    double parabolic(int i, double d) const {
+        return heights[i] + d / (positions[i + 1] - positions[i - 1]) *
+            ((positions[i] - positions[i - 1] + d) * (heights[i + 1] - heights[i]) / (positions[i + 1] - positions[i]) +
+             (positions[i + 1] - positions[i] - d) * (heights[i] - heights[i - 1]) / (positions[i] - positions[i - 1]));
+    }
+
+    // Линейная интерполяция, если параболическая нарушает порядок маркеров
+    double linear(int i, int d) const {
+        return heights[i] + d * (heights[i + d] - heights[i]) / (positions[i + d] - positions[i]);
+    }
+
+public:
+    explicit P2Quantile(double quantile)
+        : quantile(quantile),
+          desired{0, 2 * quantile, 4 * quantile, 2 + 2 * quantile, 4},
+          increments{0, quantile / 2, quantile, (1 + quantile) / 2, 1} {}
+
+    // Добавление наблюдения
+    void add(double value) {
+        if (count < 5) {
+            heights[count++] = value;
+
+            if (count == 5) {
+                std::sort(heights, heights + 5);
+            }
+
+            return;
+        }
+
+        // Ячейка между маркерами, в которую попало значение; крайние маркеры хранят минимум и максимум
+        int cell;
+
+        if (value < heights[0]) {
+            heights[0] = value;
+            cell = 0;
+        } else if (value >= heights[4]) {
+            heights[4] = value;
+            cell = 3;
+        } else {
+            cell = 0;
+
+            while (value >= heights[cell + 1]) {
+                ++cell;
+            }
+        }
+
+        for (int i = cell + 1; i < 5; ++i) {
+            positions[i] += 1;
+        }
+
+        for (int i = 0; i < 5; ++i) {
+            desired[i] += increments[i];
+        }
+
+        // Сдвиг средних маркеров к желаемым позициям
+        for (int i = 1; i < 4; ++i) {
+            double offset = desired[i] - positions[i];
+
+            if ((offset >= 1 && positions[i + 1] - positions[i] > 1) || (offset <= -1 && positions[i - 1] - positions[i] < -1)) {
+                int step = offset > 0 ? 1 : -1;
+                double height = parabolic(i, step);
+
+                heights[i] = (heights[i - 1] < height && height < heights[i + 1]) ? height : linear(i, step);
+                positions[i] += step;
+            }
+        }
+
+        ++count;
+    }
+
+    // Текущая оценка квантиля (до пяти наблюдений - точное значение по выборке)
+    double value() const {
+        if (count >= 5) {
+            return heights[2];
+        }
+
+        if (count == 0) {
+            return 0;
+        }
+
+        double sorted[5];
+        std::copy(heights, heights + count, sorted);
+        std::sort(sorted, sorted + count);
+        return sorted[static_cast<size_t>(quantile * (count - 1) + 0.5)];
+    }
+
+    // Количество наблюдений
+    size_t size() const {
+        return count;
+    }
+};
+
+// Модель длительности заданий, обучаемая по завершённым заданиям
+// Оценка берётся по самому точному ключу, для которого накоплено не меньше ESTIMATOR_MIN_SAMPLES наблюдений:
+// плата и исполняемый файл, затем плата и группа, затем плата; без наблюдений используется DELAY
+// Ключи задают клиенты, поэтому оценки хранятся в кэше LRU на ESTIMATOR_MAX_KEYS ключей: давно не обновлявшиеся
+// и не запрашивавшиеся ключи вытесняются, и оценка по ним начинается заново
+class RuntimeEstimator {
+private:
+    // Оценка квантиля по одному ключу со своей блокировкой
+    struct Entry {
+        std::mutex mutex;
+        P2Quantile quantile;
+
+        explicit Entry(double value) : quantile(value) {}
+    };
+
+    double quantile;
+    // Вытесненную запись держат, пока с ней работают, через shared_ptr
+    mutable LruCache<std::string, std::shared_ptr<Entry>> entries;
+
+    // Ключ плата-поле в буфере потока; действителен до следующего вызова в этом потоке
+    static const std::string& makeKey(std::string_view boardName, char kind, std::string_view value) {
+        thread_local std::string key;
+
+        key.assign(boardName);
+
+        if (kind != '\0') {
+            key += '\x1f';
+            key += kind;
+            key.append(value);
+        }
+
+        return key;
+    }
+
+    static const std::string& boardKey(std::string_view boardName) {
+        return makeKey(boardName, '\0', {});
+    }
+
+    static const std::string& executableKey(std::string_view boardName, std::string_view executable) {
+        return makeKey(boardName, 'e', executable);
+    }
+
+    static const std::string& groupKey(std::string_view boardName, std::string_view group) {
+        return makeKey(boardName, 'g', group);
+    }
+
+    void add(const std::string& key, double seconds) {
+        std::shared_ptr<Entry> entry = entries.findOrInsert(key, [this]() { return std::make_shared<Entry>(quantile); });
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        entry->quantile.add(seconds);
+    }
+
+    // Оценка по ключу, если наблюдений достаточно
+    bool lookup(const std::string& key, double& seconds) const {
+        std::shared_ptr<Entry> entry;
+
+        if (!entries.find(key, entry)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> entryLock(entry->mutex);
+
+        if (entry->quantile.size() < ESTIMATOR_MIN_SAMPLES) {
+            return false;
+        }
+
+        seconds = entry->quantile.value();
+        return true;
+    }
+
+public:
+    // quantile - доля заданий, которые должны укладываться в бронирование
+    // keys - наибольшее число хранимых ключей
+    explicit RuntimeEstimator(double quantile = ESTIMATOR_QUANTILE, size_t keys = ESTIMATOR_MAX_KEYS)
+        : quantile(quantile), entries(CacheKind::RuntimeModels, keys) {}
+
+    // Учёт фактической длительности завершённого задания
+    void record(const RequestView& request, std::chrono::system_clock::duration runtime) {
+        double seconds = std::chrono::duration<double>(runtime).count();
+
+        add(boardKey(request.boardName), seconds);
+        add(groupKey(request.boardName, request.group), seconds);
+        add(executableKey(request.boardName, request.executablePath), seconds);
+    }
+
+    // Ожидаемая длительность задания
+    std::chrono::system_clock::duration estimate(const RequestView& request) const {
+        double seconds;
+
+        if (lookup(executableKey(request.boardName, request.executablePath), seconds) ||
+            lookup(groupKey(request.boardName, request.group), seconds) ||
+            lookup(boardKey(request.boardName), seconds)) {
+            auto predicted = std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<double>(seconds));
+            return std::max(predicted, std::chrono::system_clock::duration(std::chrono::milliseconds(1)));
+        }
+
+        return DELAY;
+    }
+
+    // Количество хранимых ключей
+    size_t keys() const {
+        return entries.size();
+    }
+};
+
+// Тесты потоковых квантилей и модели длительности
+void testRuntimeEstimator() {
+    using namespace std::chrono;
+
+    // Оценка квантилей равномерного распределения на [0, 100)
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> uniform(0, 100);
+    P2Quantile median(0.5);
+    P2Quantile p90(0.9);
+    P2Quantile p99(0.99);
+
+    for (int i = 0; i < 100000; ++i) {
+        double value = uniform(rng);
+        median.add(value);
+        p90.add(value);
+        p99.add(value);
+    }
+
+    assert(std::abs(median.value() - 50) < 1.5);
+    assert(std::abs(p90.value() - 90) < 1.5);
+    assert(std::abs(p99.value() - 99) < 0.5);
+
+    // До пяти наблюдений квантиль считается по выборке
+    P2Quantile small(0.5);
+    assert(small.value() == 0);
+    small.add(3);
+    small.add(1);
+    small.add(2);
+    assert(small.value() == 2);
+
+    // Без наблюдений используется DELAY, затем уточняется по плате, группе и исполняемому файлу
+    RuntimeEstimator estimator(0.5);
+    Request fpga{"Иванов", "Иван", "Иванович", "БИВ1", "DE10-Lite", "blink.sof", "C:"};
+    Request other{"Петров", "Пётр", "Петрович", "БИВ2", "DE10-Lite", "counter.sof", "C:"};
+    assert(estimator.estimate(fpga) == DELAY);
+
+    for (int i = 0; i < ESTIMATOR_MIN_SAMPLES; ++i) {
+        estimator.record(fpga, seconds(60));
+    }
+
+    assert(estimator.estimate(fpga) == seconds(60));
+    assert(estimator.estimate(other) == seconds(60));
+
+    for (int i = 0; i < 3 * ESTIMATOR_MIN_SAMPLES; ++i) {
+        estimator.record(other, seconds(20));
+    }
+
+    // У каждого исполняемого файла своя оценка, по плате - общая (приближённая медиана смеси)
+    assert(estimator.estimate(fpga) == seconds(60));
+    assert(estimator.estimate(other) == seconds(20));
+
+    Request unknown = fpga;
+    unknown.executablePath = "new.sof";
+    unknown.group = "БИВ3";
+    auto boardEstimate = estimator.estimate(unknown);
+    assert(boardEstimate >= seconds(20) && boardEstimate < seconds(60));
+
+    // Число ключей ограничено: поток новых исполняемых файлов вытесняет старые, оценка по плате сохраняется
+    RuntimeEstimator bounded(0.5, 8);
+    Request varied = fpga;
+
+    for (int i = 0; i < 100; ++i) {
+        varied.executablePath = "job" + std::to_string(i) + ".sof";
+        bounded.record(varied, seconds(30));
+    }
+
+    assert(bounded.keys() <= 8);
+    assert(bounded.estimate(unknown) == seconds(30));
+}
+
+// Заявка, ожидающая стенда в очереди политики планирования
+struct PendingRequest {
+    Request request;
+    // Номер заявки в обработчике
+    uint64_t ticket = 0;
+    // Время поступления и ожидаемая длительность задания
+    std::chrono::system_clock::time_point arrival;
+    std::chrono::system_clock::duration runtime{0};
+};
+
+// Политика планирования: порядок, в котором заявки одной платы получают стенды
+class SchedulingPolicy {
+public:
+    virtual ~SchedulingPolicy() = default;
+
+    // Удерживать заявки в очереди, пока стенд не освободится (иначе стенд бронируется сразу при поступлении)
+    virtual bool holdsRequests() const = 0;
+
+    // Добавление заявки в очередь
+    virtual void push(PendingRequest request) = 0;
+
+    // Следующая заявка (очередь не пуста)
+    virtual const PendingRequest& front() const = 0;
+
+    // Удаление следующей заявки
+    virtual void pop() = 0;
+
+    // Количество заявок в очереди
+    virtual size_t size() const = 0;
+};
+
+// Фабрика политик: у каждой платы своя очередь
+using PolicyFactory = std::function<std::unique_ptr<SchedulingPolicy>()>;
+
+// Обслуживание в порядке поступления: стенд бронируется сразу, очередью служат календари стендов
+class FcfsPolicy final : public SchedulingPolicy {
+private:
+    std::deque<PendingRequest> queue;
+
+public:
+    bool holdsRequests() const override {
+        return false;
+    }
+
+    void push(PendingRequest request) override {
+        queue.push_back(std::move(request));
+    }
+
+    const PendingRequest& front() const override {
+        return queue.front();
+    }
+
+    void pop() override {
+        queue.pop_front();
+    }
+
+    size_t size() const override {
+        return queue.size();
+    }
+};
+
+// Взвешенное справедливое разделение стендов между группами (start-time fair queueing)
+// Заявке группы g назначается виртуальное начало S = max(V, F_g) и окончание F_g = S + длительность / вес_g,
+// стенд получает заявка с наименьшим S, а виртуальное время V становится равным её S
+// Группа, отправившая много заявок сразу, уходит вперёд по виртуальному времени и не задерживает другие группы
+// Выбор заявки - O(log групп): в active хранятся начала первых заявок непустых групп
+class FairSharePolicy final : public SchedulingPolicy {
+private:
+    struct GroupQueue {
+        // Заявки группы с виртуальными началами (не убывают внутри группы)
+        std::deque<std::pair<double, PendingRequest>> requests;
+        double finish = 0;
+    };
+
+    std::map<std::string, double> weights;
+    std::map<std::string, GroupQueue> groups;
+    std::set<std::pair<double, std::string>> active;
+    double virtualTime = 0;
+    size_t count = 0;
+
+public:
+    // Веса групп; группы без веса имеют вес 1
+    explicit FairSharePolicy(std::map<std::string, double> weights = {}) : weights(std::move(weights)) {}
+
+    bool holdsRequests() const override {
+        return true;
+    }
+
+    void push(PendingRequest request) override {
+        auto weight = weights.find(request.request.group);
+        double share = weight == weights.end() || weight->second <= 0 ? 1.0 : weight->second;
+        std::string group = request.request.group;
+        GroupQueue& queue = groups[group];
+
+        double start = std::max(virtualTime, queue.finish);
+        queue.finish = start + std::chrono::duration<double>(request.runtime).count() / share;
+
+        if (queue.requests.empty()) {
+            active.emplace(start, group);
+        }
+
+        queue.requests.emplace_back(start, std::move(request));
+        ++count;
+    }
+
+    const PendingRequest& front() const override {
+        return groups.find(active.begin()->second)->second.requests.front().second;
+    }
+
+    void pop() override {
+        auto first = active.begin();
+        std::string group = first->second;
+        GroupQueue& queue = groups.find(group)->second;
+
+        virtualTime = first->first;
+        active.erase(first);
+        queue.requests.pop_front();
+        --count;
+
+        if (!queue.requests.empty()) {
+            active.emplace(queue.requests.front().first, group);
+        }
+    }
+
+    size_t size() const override {
+        return count;
+    }
+};
+
+// Разбор неотрицательного целого text целиком; false для пустой строки, знака, лишних символов и переполнения
+bool parseCount(const std::string& text, size_t& value) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) {
+        return false;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+
+    if (end != text.c_str() + text.size() || errno == ERANGE || parsed > SIZE_MAX) {
+        return false;
+    }
+
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+// Разбор числа text целиком; false для пустой строки, лишних символов, переполнения, бесконечности и NaN
+bool parseNumber(const std::string& text, double& value) {
+    if (text.empty() || std::isspace(static_cast<unsigned char>(text[0]))) {
+        return false;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    double parsed = std::strtod(text.c_str(), &end);
+
+    if (end != text.c_str() + text.size() || errno == ERANGE || !std::isfinite(parsed)) {
+        return false;
+    }
+
+    value = parsed;
+    return true;
+}
+
+// Фабрика политики по названию (fcfs или fair) и весам групп вида "группа=вес,группа=вес"
+// Вес - положительное конечное число. Для неизвестного названия или неверного веса возвращается пустая фабрика,
+// а причина записывается в error
+PolicyFactory makePolicyFactory(const std::string& name, const std::string& weightsText, std::string& error) {
+    if (name == "fcfs") {
+        return []() { return std::make_unique<FcfsPolicy>(); };
+    }
+
+    if (name != "fair") {
+        error = "Неизвестная политика планирования: " + name;
+        return PolicyFactory();
+    }
+
+    std::map<std::string, double> weights;
+    std::istringstream input(weightsText);
+    std::string item;
+
+    while (std::getline(input, item, ',')) {
+        size_t separator = item.find('=');
+        double weight = 0;
+
+        if (separator == std::string::npos || !parseNumber(item.substr(separator + 1), weight) || weight <= 0) {
+            error = "Неверный вес группы (ожидается группа=положительное число): " + item;
+            return PolicyFactory();
+        }
+
+        weights[item.substr(0, separator)] = weight;
+    }
+
+    return [weights]() { return std::make_unique<FairSharePolicy>(weights); };
+}
+
+// То же без текста ошибки
+PolicyFactory makePolicyFactory(const std::string& name, const std::string& weightsText = "") {
+    std::string error;
+    return makePolicyFactory(name, weightsText, error);
+}
+
+// Тесты политик планирования
+void testSchedulingPolicy() {
+    using namespace std::chrono;
+
+    auto pending = [](const std::string& group, uint64_t ticket) {
+        PendingRequest request;
+        request.request.group = group;
+        request.ticket = ticket;
+        request.runtime = seconds(1);
+        return request;
+    };
+    auto order = [](SchedulingPolicy& policy) {
+        std::vector<uint64_t> tickets;
+
+        while (policy.size() > 0) {
+            tickets.push_back(policy.front().ticket);
+            policy.pop();
+        }
+
+        return tickets;
+    };
+
+    // Порядок поступления
+    FcfsPolicy fcfs;
+    fcfs.push(pending("A", 1));
+    fcfs.push(pending("A", 2));
+    fcfs.push(pending("B", 3));
+    assert(!fcfs.holdsRequests());
+    assert((order(fcfs) == std::vector<uint64_t>{1, 2, 3}));
+
+    // Заявка группы B не ждёт всю пачку группы A
+    FairSharePolicy fair;
+    for (uint64_t ticket = 1; ticket <= 4; ++ticket) {
+        fair.push(pending("A", ticket));
+    }
+    fair.push(pending("B", 5));
+    assert(fair.holdsRequests() && fair.size() == 5);
+    assert((order(fair) == std::vector<uint64_t>{1, 5, 2, 3, 4}));
+
+    // Группа с весом 2 получает вдвое больше стендов; новая группа начинает с текущего виртуального времени
+    PolicyFactory factory = makePolicyFactory("fair", "A=2,B=1");
+    auto weighted = factory();
+    for (uint64_t ticket = 1; ticket <= 4; ++ticket) {
+        weighted->push(pending("A", ticket));
+        weighted->push(pending("B", 10 + ticket));
+    }
+    assert((order(*weighted) == std::vector<uint64_t>{1, 11, 2, 3, 12, 4, 13, 14}));
+
+    assert(makePolicyFactory("fcfs")()->size() == 0);
+    assert(!makePolicyFactory("lifo"));
+
+    // Вес группы - положительное конечное число, мусор в весах не заменяется нулём
+    std::string error;
+    assert(makePolicyFactory("fair", "A=0.5,B=3", error));
+    assert(!makePolicyFactory("lifo", "", error) && error == "Неизвестная политика планирования: lifo");
+
+    for (const char* weights : {"A=abc", "A=-1", "A=0", "A=nan", "A=inf", "A=1e999", "A=2x", "A=", "A", "A=1,,B=2"}) {
+        error.clear();
+        assert(!makePolicyFactory("fair", weights, error) && !error.empty());
+    }
+}
+
+// Событие завершения задания для подписчиков
+struct CompletionEvent {
+    uint64_t ticket = 0;
+    std::string student;
+    std::string group;
+    std::string board;
+    std::chrono::system_clock::time_point completedAt;
+};
+
+// Отбор событий подписчиком: все события или события одного студента, группы или платы
+struct CompletionFilter {
+    enum class Kind { All, Student, Group, Board };
+
+    Kind kind = Kind::All;
+    std::string value;
+
+    // Разбор фильтра вида "all", "student Фамилия", "group Группа" или "board Плата"; false при неверном фильтре
+    bool parse(std::string_view text) {
+        static const std::pair<const char*, Kind> kinds[] = {{"student", Kind::Student}, {"group", Kind::Group}, {"board", Kind::Board}};
+        text = trimmed(text);
+
+        if (text == "all") {
+            kind = Kind::All;
+            value.clear();
+            return true;
+        }
+
+        for (const auto& pair : kinds) {
+            std::string_view prefix = pair.first;
+
+            if (text.size() > prefix.size() && text.compare(0, prefix.size(), prefix) == 0 && text[prefix.size()] == ' ') {
+                std::string_view rest = trimmed(text.substr(prefix.size()));
+
+                if (!rest.empty()) {
+                    kind = pair.second;
+                    value = std::string(rest);
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+};
+
+// Подписчик на события завершения: ограниченная очередь событий и eventfd, который становится читаемым,
+// когда в пустую очередь приходит событие. При переполнении вытесняется самое старое событие и растёт счётчик потерь,
+// поэтому медленный подписчик теряет события, но не задерживает рассылку
+class CompletionSubscriber {
+private:
+    CompletionFilter subscriberFilter;
+    mutable std::mutex mutex;
+    // Кольцевой буфер событий; одно событие разделяется всеми подписчиками, которым оно доставлено
+    std::vector<std::shared_ptr<const CompletionEvent>> ring;
+    size_t head = 0;
+    size_t count = 0;
+    // Потерянные события: с последнего забора и всего
+    uint64_t lost = 0;
+    uint64_t lostTotal = 0;
+    int fd = -1;
+
+public:
+    // Подписчик с фильтром filter и очередью на capacity событий
+    CompletionSubscriber(CompletionFilter filter, size_t capacity)
+        : subscriberFilter(std::move(filter)), ring(std::max<size_t>(1, capacity)) {
+        fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+
+    ~CompletionSubscriber() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    CompletionSubscriber(const CompletionSubscriber&) = delete;
+    CompletionSubscriber& operator=(const CompletionSubscriber&) = delete;
+
+    // Фильтр подписчика
+    const CompletionFilter& filter() const {
+        return subscriberFilter;
+    }
+
+    // Дескриптор для epoll/poll: читаем, пока в очереди есть события, о которых подписчику не сообщено
+    int eventFd() const {
+        return fd;
+    }
+
+    // Постановка события в очередь, не блокирует дольше короткой блокировки очереди; false, если вытеснено старое событие
+    bool push(std::shared_ptr<const CompletionEvent> event) {
+        bool wake;
+        bool full;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            full = count == ring.size();
+            wake = count == 0;
+
+            if (full) {
+                head = (head + 1) % ring.size();
+                --count;
+                ++lost;
+                ++lostTotal;
+            }
+
+            ring[(head + count) % ring.size()] = std::move(event);
+            ++count;
+        }
+
+        if (wake) {
+            uint64_t one = 1;
+            ssize_t written = ::write(fd, &one, sizeof(one));
+            (void)written;
+        }
+
+        return !full;
+    }
+
+    // Забор до limit событий в out; в dropped возвращаются события, потерянные с прошлого забора
+    // Сигнал eventfd сбрасывается, поэтому после забора оставшиеся события нужно забирать без ожидания
+    size_t take(std::vector<std::shared_ptr<const CompletionEvent>>& out, size_t limit, uint64_t& dropped) {
+        uint64_t value;
+        ssize_t received = ::read(fd, &value, sizeof(value));
+        (void)received;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t taken = std::min(limit, count);
+
+        for (size_t i = 0; i < taken; ++i) {
+            out.push_back(std::move(ring[head]));
+            head = (head + 1) % ring.size();
+        }
+
+        count -= taken;
+        dropped = lost;
+        lost = 0;
+        return taken;
+    }
+
+    // Ожидание событий не дольше timeout; true, если очередь не пуста
+    bool wait(std::chrono::milliseconds timeout) {
+        if (pending() > 0) {
+            return true;
+        }
+
+        pollfd descriptor{fd, POLLIN, 0};
+        return ::poll(&descriptor, 1, static_cast<int>(timeout.count())) > 0 && pending() > 0;
+    }
+
+    // События в очереди
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count;
+    }
+
+    // Все потерянные события
+    uint64_t droppedTotal() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lostTotal;
+    }
+};
+
+// Рассылка событий завершения подписчикам по студенту, группе или плате
+// Список подписчиков копируется при записи: рассылка берёт текущий список одной атомарной загрузкой и находит
+// подписчиков события по трём хэш-таблицам, не перебирая остальных. Без подписчиков рассылка не создаёт событий
+class CompletionHub {
+private:
+    using Subscribers = std::vector<std::shared_ptr<CompletionSubscriber>>;
+
+    // Неизменяемый список подписчиков
+    struct Registry {
+        Subscribers all;
+        std::unordered_map<std::string, Subscribers> students;
+        std::unordered_map<std::string, Subscribers> groups;
+        std::unordered_map<std::string, Subscribers> boards;
+        size_t size = 0;
+    };
+
+    std::shared_ptr<const Registry> registry = std::make_shared<Registry>();
+    std::mutex writersMutex;
+
+    // Таблица подписчиков для вида фильтра (nullptr для подписки на все события)
+    static std::unordered_map<std::string, Subscribers>* table(Registry& registry, CompletionFilter::Kind kind) {
+        switch (kind) {
+        case CompletionFilter::Kind::Student:
+            return &registry.students;
+        case CompletionFilter::Kind::Group:
+            return &registry.groups;
+        case CompletionFilter::Kind::Board:
+            return &registry.boards;
+        default:
+            return nullptr;
+        }
+    }
+
+    // Доставка события подписчикам из списка
+    static void deliver(const Subscribers* subscribers, const std::shared_ptr<const CompletionEvent>& event) {
+        if (!subscribers) {
+            return;
+        }
+
+        for (const auto& subscriber : *subscribers) {
+            if (subscriber->push(event)) {
+                metrics().eventsDelivered.add();
+            } else {
+                metrics().eventsDropped.add();
+            }
+        }
+    }
+
+    // Подписчики ключа key в таблице (nullptr, если их нет)
+    static const Subscribers* find(const std::unordered_map<std::string, Subscribers>& subscribers, const std::string& key) {
+        auto it = subscribers.find(key);
+        return it == subscribers.end() ? nullptr : &it->second;
+    }
+
+public:
+    // Новый подписчик с фильтром filter и очередью на capacity событий
+    std::shared_ptr<CompletionSubscriber> subscribe(const CompletionFilter& filter, size_t capacity = SUBSCRIBER_QUEUE) {
+        auto subscriber = std::make_shared<CompletionSubscriber>(filter, capacity);
+        std::lock_guard<std::mutex> lock(writersMutex);
+        auto updated = std::make_shared<Registry>(*std::atomic_load(&registry));
+        auto* subscribers = table(*updated, filter.kind);
+
+        (subscribers ? (*subscribers)[filter.value] : updated->all).push_back(subscriber);
+        ++updated->size;
+        std::atomic_store(&registry, std::shared_ptr<const Registry>(std::move(updated)));
+        return subscriber;
+    }
+
+    // Отписка; события, уже стоящие в очереди подписчика, остаются ему доступны
+    void unsubscribe(const std::shared_ptr<CompletionSubscriber>& subscriber) {
+        std::lock_guard<std::mutex> lock(writersMutex);
+        auto updated = std::make_shared<Registry>(*std::atomic_load(&registry));
+        auto* subscribers = table(*updated, subscriber->filter().kind);
+        Subscribers& list = subscribers ? (*subscribers)[subscriber->filter().value] : updated->all;
+        auto it = std::find(list.begin(), list.end(), subscriber);
+
+        if (it == list.end()) {
+            return;
+        }
+
+        list.erase(it);
+        --updated->size;
+
+        if (subscribers && list.empty()) {
+            subscribers->erase(subscriber->filter().value);
+        }
+
+        std::atomic_store(&registry, std::shared_ptr<const Registry>(std::move(updated)));
+    }
+
+    // Количество подписчиков
+    size_t subscribers() const {
+        return std::atomic_load(&registry)->size;
+    }
+
+    // Рассылка события завершения; событие создаётся, только если у него есть получатели
+    void publish(uint64_t ticket, std::string_view student, std::string_view group, std::string_view board,
+                 std::chrono::system_clock::time_point completedAt) {
+        auto current = std::atomic_load(&registry);
+
+        if (current->size == 0) {
+            return;
+        }
+
+        std::string studentKey(student);
+        std::string groupKey(group);
+        std::string boardKey(board);
+        const Subscribers* targets[] = {current->all.empty() ? nullptr : &current->all, find(current->students, studentKey),
+                                        find(current->groups, groupKey), find(current->boards, boardKey)};
+
+        if (std::all_of(std::begin(targets), std::end(targets), [](const Subscribers* list) { return list == nullptr; })) {
+            return;
+        }
+
+        auto event = std::make_shared<const CompletionEvent>(
+            CompletionEvent{ticket, std::move(studentKey), std::move(groupKey), std::move(boardKey), completedAt});
+
+        for (const Subscribers* list : targets) {
+            deliver(list, event);
+        }
+    }
+};
+
+// Общая рассылка событий завершения программы
+CompletionHub& completionHub() {
+    static CompletionHub instance;
+    return instance;
+}
+
+// Текст события для отправки подписчику: номер, студент, группа, плата и время завершения в мс от эпохи через табуляцию
+std::string completionEventText(const CompletionEvent& event) {
+    auto completed = std::chrono::duration_cast<std::chrono::milliseconds>(event.completedAt.time_since_epoch());
+    std::string text = std::to_string(event.ticket);
+
+    for (const std::string* field : {&event.student, &event.group, &event.board}) {
+        text += '\t';
+        text += *field;
+    }
+
+    text += '\t';
+    text += std::to_string(completed.count());
+    return text;
+}
+
+// Тесты рассылки событий завершения
+void testCompletionHub() {
+    using namespace std::chrono;
+
+    CompletionFilter filter;
+    assert(filter.parse("board Arduino Uno") && filter.kind == CompletionFilter::Kind::Board && filter.value == "Arduino Uno");
+    assert(filter.parse(" all ") && filter.kind == CompletionFilter::Kind::All);
+    assert(!filter.parse("board ") && !filter.parse("teacher Иванов") && !filter.parse("students Иванов"));
+
+    // Отбор по студенту, группе и плате, общий подписчик получает всё
+    CompletionHub hub;
+    hub.publish(1, "Иванов", "БИВ222", "STM-32", system_clock::time_point(seconds(1)));
+
+    CompletionFilter student;
+    CompletionFilter board;
+    assert(student.parse("student Иванов") && board.parse("board Arduino Uno"));
+    auto everyone = hub.subscribe(CompletionFilter());
+    auto ivanov = hub.subscribe(student);
+    auto arduino = hub.subscribe(board, 2);
+    assert(hub.subscribers() == 3 && !everyone->wait(milliseconds(0)));
+
+    hub.publish(2, "Иванов", "БИВ222", "STM-32", system_clock::time_point(seconds(2)));
+    hub.publish(3, "Петров", "БИВ223", "Arduino Uno", system_clock::time_point(seconds(3)));
+    assert(everyone->wait(milliseconds(0)) && everyone->pending() == 2);
+    assert(ivanov->pending() == 1 && arduino->pending() == 1);
+
+    std::vector<std::shared_ptr<const CompletionEvent>> events;
+    uint64_t dropped = 0;
+    assert(ivanov->take(events, 16, dropped) == 1 && dropped == 0 && events[0]->ticket == 2);
+    assert(completionEventText(*events[0]) == "2\tИванов\tБИВ222\tSTM-32\t2000");
+
+    // Переполненная очередь вытесняет старые события и сообщает о потерях
+    for (uint64_t ticket = 4; ticket < 8; ++ticket) {
+        hub.publish(ticket, "Сидоров", "БИВ224", "Arduino Uno", system_clock::time_point(seconds(ticket)));
+    }
+
+    events.clear();
+    assert(arduino->take(events, 16, dropped) == 2 && dropped == 3 && arduino->droppedTotal() == 3);
+    assert(events[0]->ticket == 6 && events[1]->ticket == 7);
+    assert(arduino->take(events, 16, dropped) == 0 && dropped == 0);
+
+    // Отписка останавливает доставку, очередь подписчика сохраняется
+    hub.unsubscribe(everyone);
+    hub.unsubscribe(everyone);
+    hub.publish(8, "Иванов", "БИВ222", "STM-32", system_clock::now());
+    assert(hub.subscribers() == 2 && everyone->pending() == 6 && ivanov->pending() == 1);
+}
+
+// Класс для обработки заявки
+// Заявки каждой платы проходят через очередь политики планирования (по умолчанию - в порядке поступления)
+class RequestProcessor {
+public:
+    // Обработчик бронирования: заявка, её номер, время поступления и бронь
+    // Представление заявки действительно только на время вызова
+    using DispatchHandler = std::function<void(const RequestView&, uint64_t, std::chrono::system_clock::time_point, const Reservation&)>;
+
+    // Обработчик отмены задания с бронью (например, прерывание его процесса исполнителем)
+    using CancelHandler = std::function<void(uint64_t)>;
+
+    // Время ожидания стенда по группе
+    struct GroupWaitSummary {
+        std::string group;
+        size_t count = 0;
+        double p50 = 0;
+        double p99 = 0;
+    };
+
+private:
+    // Очередь заявок платы
+    struct BoardQueue {
+        std::unique_ptr<SchedulingPolicy> policy;
+        // Заявки ждут стенда, который освободится в blockedUntil
+        bool blocked = false;
+        std::chrono::system_clock::time_point blockedUntil;
+    };
+
+    // Отслеживание брони одной заявки при выдаче стендов очереди
+    struct Watch {
+        uint64_t ticket = 0;
+        Reservation reservation;
+        bool reserved = false;
+    };
+
+    // Задание по номеру заявки: плата (название интернировано), бронь и таймер уведомления о завершении
+    // Заявка, ждущая в очереди политики, ещё не имеет брони; отменённая заявка удаляется из очереди при выдаче стендов
+    struct Job {
+        std::string_view boardName;
+        Reservation reservation;
+        TimerWheel::TimerId timer = 0;
+        bool reserved = false;
+        bool cancelled = false;
+        // Ключ повторной подачи (0 - задание не участвует в объединении)
+        uint64_t submission = 0;
+    };
+
+    // Окончание брони задания для удаления завершившихся заданий
+    using JobExpiry = std::pair<std::chrono::system_clock::time_point, uint64_t>;
+
+    // Потоковые квантили ожидания группы
+    struct WaitStats {
+        P2Quantile p50{0.5};
+        P2Quantile p99{0.99};
+    };
+
+    // Кластер стендов для выбора оптимального стенда
+    StandCluster& cluster;
+
+    // Часы обработчика и уведомлений
+    const Clock& clock;
+
+    // Таймеры уведомлений о завершении заданий и повторного планирования очередей
+    TimerWheel notifier;
+
+    // Модель длительности заданий
+    RuntimeEstimator estimator;
+
+    // Вывод сообщений в консоль (журнал ведётся всегда)
+    bool verbose = true;
+
+    // Планирование уведомлений о завершении
+    bool notifications = true;
+
+    // Объединение повторных подач с ещё не завершившимся заданием
+    bool coalescing = false;
+
+    // Задания выполняет исполнитель: о завершении сообщает окончание процесса (reportCompletion), а не таймер брони
+    std::atomic<bool> exitCompletion{false};
+
+    // Очереди по платам, фабрика политик и таймер ближайшего освобождения стенда для удерживаемых заявок
+    std::mutex queueMutex;
+    PolicyFactory policyFactory = []() { return std::make_unique<FcfsPolicy>(); };
+    std::map<std::string, BoardQueue, std::less<>> queues;
+    TimerWheel::TimerId dispatchTimer = 0;
+    std::chrono::system_clock::time_point dispatchAt;
+    std::atomic<uint64_t> nextTicket{1};
+    DispatchHandler dispatchHandler;
+    CancelHandler cancelHandler;
+    // Отменённые заявки, ещё лежащие в очередях политик (под queueMutex)
+    size_t cancelledQueued = 0;
+
+    // Задания по номерам заявок; завершившиеся задания удаляются по окончаниям броней
+    // Порядок блокировок: queueMutex, затем jobsMutex
+    std::mutex jobsMutex;
+    std::unordered_map<uint64_t, Job> jobs;
+    std::priority_queue<JobExpiry, std::vector<JobExpiry>, std::greater<JobExpiry>> expiries;
+    // Незавершённые задания по ключу подачи (под jobsMutex)
+    std::unordered_map<uint64_t, uint64_t> submissions;
+    // Задания по стенду и началу брони, пока задания выполняет исполнитель (под jobsMutex): продление брони
+    // переносит брони, на которые заходит, и по ним находятся их задания
+    std::map<std::pair<uint64_t, std::chrono::system_clock::time_point>, uint64_t> bookings;
+
+    // Ожидание по группам
+    mutable std::mutex statsMutex;
+    std::map<std::string, WaitStats, std::less<>> waits;
+
+    // Блокировка вывода в терминал, общая для всех потоков обработчика
+    static std::mutex& outputMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    // Сообщение об отсутствии стендов для платы
+    void noStandsMessage(std::string_view boardName) {
+        metrics().reject(RejectReason::NoStands);
+        std::string message = "Нет доступных стендов для платы: ";
+        message.append(boardName);
+
+        if (verbose) {
+            std::lock_guard<std::mutex> lock(outputMutex());
+            std::cout << message << std::endl;
+        }
+
+        // Записываем в лог
+        writeToLog(message + "\n");
+    }
+
+    // Ключ брони в bookings: плата и слот стенда, начало брони
+    static std::pair<uint64_t, std::chrono::system_clock::time_point> bookingKey(const Reservation& reservation) {
+        return {(static_cast<uint64_t>(reservation.stand.board) << 32) | reservation.stand.slot, reservation.startTime};
+    }
+
+    // Новая бронь задания ticket с учётом её окончания и, при выполнении исполнителем, места в bookings (под jobsMutex)
+    void assignReservation(uint64_t ticket, Job& job, const Reservation& reservation) {
+        if (job.reserved) {
+            auto booked = bookings.find(bookingKey(job.reservation));
+
+            if (booked != bookings.end() && booked->second == ticket) {
+                bookings.erase(booked);
+            }
+        }
+
+        job.reservation = reservation;
+        job.reserved = true;
+        expiries.emplace(reservation.freeTime, ticket);
+
+        if (exitCompletion) {
+            bookings[bookingKey(reservation)] = ticket;
+        }
+    }
+
+    // Удаление задания вместе с его ключом подачи (под jobsMutex)
+    // Занятое время стенда учитывается в метриках только здесь, по фактическому интервалу брони от начала до end:
+    // отменённое или досрочно завершённое задание не оставляет в загрузке предсказанную длительность
+    void eraseJob(std::unordered_map<uint64_t, Job>::iterator it, std::chrono::system_clock::time_point end) {
+        if (it->second.reserved) {
+            const Reservation& reservation = it->second.reservation;
+            auto booked = bookings.find(bookingKey(reservation));
+
+            if (booked != bookings.end() && booked->second == it->first) {
+                bookings.erase(booked);
+            }
+
+            metrics().standBusy(it->second.boardName, reservation.stand.slot,
+                                std::max(end, reservation.startTime) - reservation.startTime);
+        }
+
+        if (it->second.submission != 0) {
+            auto submission = submissions.find(it->second.submission);
+
+            if (submission != submissions.end() && submission->second == it->first) {
+                submissions.erase(submission);
+            }
+        }
+
+        jobs.erase(it);
+    }
+
+    // Ключ подачи: все поля заявки и, если файл доступен, хэш содержимого исполняемого файла -
+    // изменённый файл подаётся как новое задание. Файл из заявки сетевого клиента (local = false) не читается:
+    // иначе любой клиент мог бы заставить сервер открыть произвольный файл
+    static uint64_t submissionKey(const RequestView& request, bool local) {
+        const std::string_view fields[] = {request.lastName, request.firstName, request.patronymic, request.group,
+                                           request.boardName, request.executablePath, request.resultPath};
+        uint64_t key = 0;
+
+        for (const auto& field : fields) {
+            key = hash64(field.data(), field.size(), key + field.size());
+        }
+
+        uint64_t content;
+
+        if (local && executables().contentHash(std::string(request.executablePath), content)) {
+            key = hash64(&content, sizeof(content), key);
+        }
+
+        return key == 0 ? 1 : key;
+    }
+
+    // Удаление заданий, брони которых закончились к now (под jobsMutex)
+    // Задания исполнителя удаляются только по окончании процесса: процесс может работать дольше брони
+    void pruneJobs(std::chrono::system_clock::time_point now) {
+        while (!expiries.empty() && expiries.top().first <= now) {
+            auto it = jobs.find(expiries.top().second);
+            expiries.pop();
+
+            // Перенесённое задание имеет более позднюю запись об окончании
+            if (it != jobs.end() && it->second.reserved && it->second.reservation.freeTime <= now && !exitCompletion) {
+                eraseJob(it, it->second.reservation.freeTime);
+            }
+        }
+    }
+
+    // Учёт брони задания ticket
+    void trackJob(uint64_t ticket, std::string_view boardName, const Reservation& reservation, TimerWheel::TimerId timer,
+                  std::chrono::system_clock::time_point now) {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        pruneJobs(now);
+        Job& job = jobs[ticket];
+        job.boardName = boardName;
+        job.timer = timer;
+        assignReservation(ticket, job, reservation);
+    }
+
+    // Удаление заявки ticket из учёта заданий; true, если заявка была отменена, пока ждала в очереди
+    bool forgetQueued(uint64_t ticket) {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        auto it = jobs.find(ticket);
+
+        if (it == jobs.end() || !it->second.cancelled) {
+            return false;
+        }
+
+        eraseJob(it, clock.now());
+        return true;
+    }
+
+    // Повторная подача submission, пока её задание не завершилось: номер и бронь этого задания (под queueMutex)
+    bool coalesce(uint64_t submission, std::chrono::system_clock::time_point now, uint64_t& ticket, Reservation& reservation,
+                  bool& reserved) {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            pruneJobs(now);
+            auto found = submissions.find(submission);
+
+            if (found == submissions.end()) {
+                return false;
+            }
+
+            const Job& job = jobs.at(found->second);
+            ticket = found->second;
+            reserved = job.reserved;
+
+            if (reserved) {
+                reservation = job.reservation;
+            }
+        }
+
+        metrics().coalesced.add();
+        std::string message = "Заявка уже подана, задание " + std::to_string(ticket) + " ещё не завершено\n";
+
+        if (verbose) {
+            std::lock_guard<std::mutex> lock(outputMutex());
+            std::cout << message;
+        }
+
+        writeToLog(message);
+        return true;
+    }
+
+    // Запоминание ключа подачи задания ticket, если задание ещё не завершилось (под queueMutex)
+    void remember(uint64_t submission, uint64_t ticket) {
+        if (submission == 0) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        auto it = jobs.find(ticket);
+
+        if (it != jobs.end() && !it->second.cancelled) {
+            it->second.submission = submission;
+            submissions[submission] = ticket;
+        }
+    }
+
+    // Повторная выдача стендов очереди платы после освобождения времени (под queueMutex)
+    void redispatch(std::string_view boardName) {
+        auto it = queues.find(boardName);
+
+        if (it != queues.end() && it->second.blocked) {
+            dispatchLocked(it->second);
+            armDispatchTimer();
+        }
+    }
+
+    // Бронирование стенда для заявки (при onlyFree - только если стенд свободен сейчас); сообщение, уведомление и учёт ожидания
+    bool reserve(const RequestView& request, uint64_t ticket, std::chrono::system_clock::time_point arrival, Reservation& reservation,
+                 bool onlyFree = false) {
+        auto now = clock.now();
+        auto latestStart = onlyFree ? now : std::chrono::system_clock::time_point::max();
+
+        // Бронируем самый ранний подходящий интервал на стендах заданной платы
+        if (!cluster.reserveEarliestStand(request.boardName, now, estimator.estimate(request), reservation, latestStart)) {
+            return false;
+        }
+
+        // Выводим время, когда задание будет выполнено
+        auto freeTime = reservation.freeTime;
+
+        std::string message = "Задание будет выполнено на стенде с платой ";
+        message.append(request.boardName);
+        message += " в ";
+        message += formatTime(freeTime);
+
+        if (verbose) {
+            std::lock_guard<std::mutex> lock(outputMutex());
+            std::cout << message;
+        }
+
+        // Записываем в лог
+        writeToLog(std::move(message));
+
+        // Уведомление о завершении по таймеру: название платы интернировано, таймер хранит только представление
+        // Задание исполнителя сообщает о завершении по окончании процесса (reportCompletion), таймер ему не нужен
+        std::string_view boardName = internedStrings().intern(request.boardName);
+        TimerWheel::TimerId timer = 0;
+
+        if (notifications && !exitCompletion) {
+            std::string studentName(request.lastName);
+            std::string_view group = internedStrings().intern(request.group);
+
+            timer = notifier.schedule(freeTime, [this, boardName, studentName, group, ticket]() {
+                completionMessage(boardName, studentName, group, ticket);
+            });
+        }
+
+        trackJob(ticket, boardName, reservation, timer, now);
+
+        metrics().reservation(request.boardName, reservation.startTime - arrival);
+
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            auto it = waits.find(request.group);
+
+            if (it == waits.end()) {
+                it = waits.emplace(std::string(request.group), WaitStats()).first;
+            }
+
+            WaitStats& stats = it->second;
+            double wait = std::chrono::duration<double>(reservation.startTime - arrival).count();
+            stats.p50.add(wait);
+            stats.p99.add(wait);
+        }
+
+        if (dispatchHandler) {
+            dispatchHandler(request, ticket, arrival, reservation);
+        }
+
+        return true;
+    }
+
+    // Выдача стендов заявкам очереди платы в порядке политики (под queueMutex)
+    // Удерживаемые заявки получают стенд, только если он свободен сейчас; иначе очередь ждёт blockedUntil
+    // Если задан watch, бронь заявки watch->ticket возвращается в нём
+    size_t dispatchLocked(BoardQueue& queue, Watch* watch = nullptr) {
+        size_t dispatched = 0;
+        queue.blocked = false;
+
+        while (queue.policy->size() > 0) {
+            const PendingRequest& next = queue.policy->front();
+            Reservation reservation;
+
+            // Отменённая заявка покидает очередь, не получая стенда
+            if (cancelledQueued > 0 && forgetQueued(next.ticket)) {
+                --cancelledQueued;
+                queue.policy->pop();
+                continue;
+            }
+
+            if (reserve(next.request, next.ticket, next.arrival, reservation, queue.policy->holdsRequests())) {
+                if (watch && next.ticket == watch->ticket) {
+                    watch->reservation = reservation;
+                    watch->reserved = true;
+                }
+
+                queue.policy->pop();
+                ++dispatched;
+                continue;
+            }
+
+            // Стенды платы исчезли (кластер очищен) - заявка отклоняется
+            if (reservation.startTime == std::chrono::system_clock::time_point()) {
+                noStandsMessage(next.request.boardName);
+                {
+                    std::lock_guard<std::mutex> lock(jobsMutex);
+                    auto job = jobs.find(next.ticket);
+
+                    if (job != jobs.end()) {
+                        eraseJob(job, next.arrival);
+                    }
+                }
+                queue.policy->pop();
+                continue;
+            }
+
+            queue.blocked = true;
+            queue.blockedUntil = reservation.startTime;
+            break;
+        }
+
+        return dispatched;
+    }
+
+    // Перезапуск таймера на ближайшее освобождение стенда для удерживаемых заявок (под queueMutex)
+    void armDispatchTimer() {
+        auto earliest = std::chrono::system_clock::time_point::max();
+
+        for (const auto& pair : queues) {
+            if (pair.second.blocked) {
+                earliest = std::min(earliest, pair.second.blockedUntil);
+            }
+        }
+
+        if (dispatchTimer != 0 && dispatchAt == earliest) {
+            return;
+        }
+
+        if (dispatchTimer != 0) {
+            notifier.cancel(dispatchTimer);
+            dispatchTimer = 0;
+        }
+
+        if (earliest != std::chrono::system_clock::time_point::max()) {
+            dispatchAt = earliest;
+            dispatchTimer = notifier.schedule(earliest, [this]() { dispatchDue(); });
+        }
+    }
+
+public:
+    // Конструктор; с виртуальными часами уведомления продвигаются вызовом pollNotifications
+    RequestProcessor(StandCluster& cluster, const Clock& clock = systemClock())
+        : cluster(cluster), clock(clock), notifier(clock) {
+        if (clock.isRealTime()) {
+            notifier.start();
+        }
+    }
+
+    // Деструктор: останавливает поток уведомлений
+    ~RequestProcessor() {
+        shutdown();
+    }
+
+    // Отправка уведомлений, срок которых наступил по часам обработчика
+    size_t pollNotifications() {
+        return notifier.poll();
+    }
+
+    // Количество ожидающих уведомлений
+    size_t pendingNotifications() {
+        return notifier.pending();
+    }
+
+    // Остановка уведомлений, возвращает количество отменённых уведомлений
+    // Заявки, оставшиеся в очередях, больше не планируются (см. queuedRequests)
+    size_t shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+
+            if (dispatchTimer != 0) {
+                notifier.cancel(dispatchTimer);
+                dispatchTimer = 0;
+            }
+        }
+
+        return notifier.stop();
+    }
+
+    // Включение или отключение вывода в консоль
+    void setVerbose(bool value) {
+        verbose = value;
+    }
+
+    // Включение или отключение уведомлений о завершении (не нужны, если программа сразу завершается)
+    void setNotifications(bool value) {
+        notifications = value;
+    }
+
+    // Включение объединения повторных подач: та же заявка (и тот же исполняемый файл), поданная,
+    // пока её задание ждёт или выполняется, получает номер и бронь этого задания вместо нового
+    void setCoalescing(bool value) {
+        coalescing = value;
+    }
+
+    // Установка политики планирования (до поступления заявок)
+    void setPolicy(PolicyFactory factory) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        policyFactory = std::move(factory);
+        queues.clear();
+        cancelledQueued = 0;
+    }
+
+    // Установка обработчика бронирований (вызывается в потоке, выдавшем стенд, под блокировкой очередей,
+    // поэтому обработчик не должен обращаться к очередям обработчика заявок)
+    void setDispatchHandler(DispatchHandler handler) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        dispatchHandler = std::move(handler);
+    }
+
+    // Включение завершения заданий по окончанию процессов исполнителя: уведомление о завершении отправляет
+    // reportCompletion, а не таймер брони, и задание не удаляется, пока его процесс работает дольше брони
+    void setCompletionByExit(bool value) {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        exitCompletion = value;
+
+        if (!value) {
+            bookings.clear();
+        }
+    }
+
+    // Установка обработчика отмены заданий с бронью (вызывается под блокировкой очередей, как обработчик бронирований)
+    void setCancelHandler(CancelHandler handler) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        cancelHandler = std::move(handler);
+    }
+
+    // Сообщение о завершении работы: событие подписчикам, строка в журнал и, в подробном режиме, в консоль
+    // Консоль не сбрасывается на каждом сообщении: поток уведомлений не ждёт медленного терминала
+    void completionMessage(std::string_view boardName, std::string_view studentName, std::string_view group = {}, uint64_t ticket = 0) {
+        std::string message = "Запрос студента ";
+        message.append(studentName);
+        message += " на стенде с платой ";
+        message.append(boardName);
+        message += " выполнено.\n";
+        metrics().completions.add();
+        completionHub().publish(ticket, studentName, group, boardName, clock.now());
+
+        if (verbose) {
+            // Блокируем вывод в консоль
+            std::lock_guard<std::mutex> lock(outputMutex());
+            std::cout << message;
+        }
+
+        // Записываем в лог
+        writeToLog(std::move(message));
+    }
+
+    // Немедленная обработка заявки в обход очереди, при успехе в reservation возвращается выбранный стенд и время выполнения
+    bool processRequest(const RequestView& request, Reservation& reservation) {
+        MetricsTimer timer(metrics().decisionTime);
+
+        if (reserve(request, nextTicket++, clock.now(), reservation)) {
+            return true;
+        }
+
+        noStandsMessage(request.boardName);
+        return false;
+    }
+
+    // Обработка заявки через очередь политики планирования; в ticket возвращается номер заявки
+    // Если стенд выдан сразу, reserved = true и бронь возвращается в reservation, иначе заявка ждёт в очереди платы
+    // Заявка копируется, только если она остаётся ждать в очереди; local = false для заявок сетевых клиентов
+    bool processRequest(const RequestView& request, uint64_t& ticket, Reservation& reservation, bool& reserved,
+                        bool local = true) {
+        MetricsTimer timer(metrics().decisionTime);
+        reserved = false;
+        size_t index;
+
+        // Если стендов для этой платы нет, заявка отклоняется сразу
+        if (!cluster.findEarliestStand(request.boardName, index)) {
+            noStandsMessage(request.boardName);
+            return false;
+        }
+
+        uint64_t submission = coalescing ? submissionKey(request, local) : 0;
+        std::lock_guard<std::mutex> lock(queueMutex);
+        auto now = clock.now();
+
+        if (submission != 0 && coalesce(submission, now, ticket, reservation, reserved)) {
+            return true;
+        }
+
+        auto it = queues.find(request.boardName);
+
+        if (it == queues.end()) {
+            it = queues.emplace(std::string(request.boardName), BoardQueue()).first;
+        }
+
+        BoardQueue& queue = it->second;
+
+        if (!queue.policy) {
+            queue.policy = policyFactory();
+        }
+
+        ticket = nextTicket++;
+
+        // Политика без удержания с пустой очередью выдаёт стенд сразу, заявка в очередь не копируется
+        if (!queue.policy->holdsRequests() && queue.policy->size() == 0 && reserve(request, ticket, now, reservation)) {
+            reserved = true;
+            remember(submission, ticket);
+            armDispatchTimer();
+            return true;
+        }
+
+        Watch watch;
+        watch.ticket = ticket;
+        queue.policy->push(PendingRequest{request.toRequest(), ticket, now, estimator.estimate(request)});
+        {
+            std::lock_guard<std::mutex> jobsLock(jobsMutex);
+            jobs[ticket].boardName = internedStrings().intern(request.boardName);
+        }
+
+        dispatchLocked(queue, &watch);
+        remember(submission, ticket);
+
+        if (watch.reserved) {
+            reservation = watch.reservation;
+            reserved = true;
+        }
+
+        if (queue.blocked) {
+            std::string message = "Заявка поставлена в очередь платы ";
+            message.append(request.boardName);
+            message += ", заявок в очереди: " + std::to_string(queue.policy->size()) + "\n";
+
+            if (verbose) {
+                std::lock_guard<std::mutex> outputLock(outputMutex());
+                std::cout << message;
+            }
+
+            writeToLog(message);
+        }
+
+        armDispatchTimer();
+        return true;
+    }
+
+    // Обработка заявки через очередь политики планирования; в ticket возвращается номер заявки
+    bool processRequest(const RequestView& request, uint64_t& ticket) {
+        Reservation reservation;
+        bool reserved;
+        return processRequest(request, ticket, reservation, reserved);
+    }
+
+    // Обработка заявки
+    bool processRequest(const RequestView& request) {
+        uint64_t ticket;
+        return processRequest(request, ticket);
+    }
+
+    // Номер, который получит следующая заявка (для однопоточного моделирования)
+    uint64_t upcomingTicket() const {
+        return nextTicket.load();
+    }
+
+    // Выдача стендов удерживаемым заявкам, чьё время наступило; возвращает количество запланированных заявок
+    size_t dispatchDue() {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        size_t dispatched = 0;
+        auto now = clock.now();
+
+        for (auto& pair : queues) {
+            if (pair.second.blocked && pair.second.blockedUntil <= now) {
+                dispatched += dispatchLocked(pair.second);
+            }
+        }
+
+        armDispatchTimer();
+        return dispatched;
+    }
+
+    // Ближайшее время, когда удерживаемая заявка может получить стенд; false, если таких заявок нет
+    bool nextDispatchTime(std::chrono::system_clock::time_point& time) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        bool found = false;
+
+        for (const auto& pair : queues) {
+            if (pair.second.blocked && (!found || pair.second.blockedUntil < time)) {
+                found = true;
+                time = pair.second.blockedUntil;
+            }
+        }
+
+        return found;
+    }
+
+    // Количество заявок, ожидающих в очередях
+    size_t queuedRequests() {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        size_t count = 0;
+
+        for (const auto& pair : queues) {
+            count += pair.second.policy ? pair.second.policy->size() : 0;
+        }
+
+        return count - cancelledQueued;
+    }
+
+    // Отмена задания по номеру заявки за O(log n)
+    // Бронь освобождается (выполняющееся задание - с текущего момента) и достаётся ждущим заявкам платы,
+    // таймер уведомления о завершении отменяется, а обработчик отмены прерывает процесс задания;
+    // заявка из очереди больше не получит стенд
+    // Возвращает false, если задания нет, оно уже отменено или завершилось
+    bool cancelJob(uint64_t ticket) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        auto now = clock.now();
+        Job job;
+        {
+            std::lock_guard<std::mutex> jobsLock(jobsMutex);
+            auto it = jobs.find(ticket);
+
+            if (it == jobs.end() || it->second.cancelled) {
+                return false;
+            }
+
+            if (!it->second.reserved) {
+                it->second.cancelled = true;
+
+                // Повторная подача после отмены - новое задание
+                auto submission = submissions.find(it->second.submission);
+
+                if (submission != submissions.end() && submission->second == ticket) {
+                    submissions.erase(submission);
+                }
+
+                ++cancelledQueued;
+                writeToLog("Заявка " + std::to_string(ticket) + " отменена в очереди\n");
+                return true;
+            }
+
+            job = it->second;
+        }
+
+        // Задание снимается только после освобождения брони: если бронь освободить не удалось
+        // (например, задание уже завершилось), оно остаётся и завершается как обычно
+        if (!cluster.cancelReservation(job.reservation, now)) {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> jobsLock(jobsMutex);
+            auto it = jobs.find(ticket);
+
+            if (it != jobs.end()) {
+                eraseJob(it, now);
+            }
+        }
+
+        if (job.timer != 0) {
+            notifier.cancel(job.timer);
+        }
+
+        if (cancelHandler) {
+            cancelHandler(ticket);
+        }
+
+        writeToLog("Задание " + std::to_string(ticket) + " отменено\n");
+        redispatch(job.boardName);
+        return true;
+    }
+
+    // Перенос ещё не начавшегося задания на время start за O(log n) на любой стенд платы, свободный в это время
+    // Уведомление о завершении переносится вместе с заданием, освобождённое время достаётся ждущим заявкам
+    // При успехе новая бронь возвращается в reservation; при неудаче задание остаётся на прежнем месте
+    bool moveJob(uint64_t ticket, std::chrono::system_clock::time_point start, Reservation& reservation) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        auto now = clock.now();
+        std::string_view boardName;
+        {
+            std::lock_guard<std::mutex> jobsLock(jobsMutex);
+            auto it = jobs.find(ticket);
+
+            if (it == jobs.end() || !it->second.reserved ||
+                !cluster.moveReservation(it->second.reservation, now, start, reservation)) {
+                return false;
+            }
+
+            Job& job = it->second;
+            assignReservation(ticket, job, reservation);
+
+            if (job.timer != 0) {
+                notifier.reschedule(job.timer, reservation.freeTime);
+            }
+
+            boardName = job.boardName;
+        }
+
+        writeToLog("Задание " + std::to_string(ticket) + " перенесено на " + formatTime(start));
+        redispatch(boardName);
+        return true;
+    }
+
+    // Продление брони выполняющегося задания ticket до until: процесс работает дольше предсказанного
+    // Стенд остаётся занят, новые заявки получают время после until, а брони, на которые заходит продление,
+    // переносятся не раньше своего начала (см. StandCluster::extendReservation) вместе с уведомлениями
+    // В reservation возвращается продлённая бронь; false, если задания нет (например, оно отменено)
+    bool extendJob(uint64_t ticket, std::chrono::system_clock::time_point until, Reservation& reservation) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        auto now = clock.now();
+        std::vector<std::pair<Reservation, Reservation>> moved;
+        std::string message;
+        {
+            std::lock_guard<std::mutex> jobsLock(jobsMutex);
+            auto it = jobs.find(ticket);
+
+            if (it == jobs.end() || !it->second.reserved) {
+                return false;
+            }
+
+            Reservation extended = it->second.reservation;
+
+            if (!cluster.extendReservation(extended, now, until, moved)) {
+                return false;
+            }
+
+            assignReservation(ticket, it->second, extended);
+            reservation = extended;
+            message = "Задание " + std::to_string(ticket) + " выполняется дольше брони, стенд занят до " + formatTime(until);
+
+            for (const auto& pair : moved) {
+                auto booked = bookings.find(bookingKey(pair.first));
+
+                if (booked == bookings.end()) {
+                    continue;
+                }
+
+                uint64_t other = booked->second;
+                Job& job = jobs.at(other);
+                assignReservation(other, job, pair.second);
+
+                if (job.timer != 0) {
+                    notifier.reschedule(job.timer, pair.second.freeTime);
+                }
+
+                message += "Задание " + std::to_string(other) + " перенесено на " + formatTime(pair.second.startTime);
+            }
+        }
+
+        writeToLog(message);
+        return true;
+    }
+
+    // Удаление из tickets номеров заявок, задания которых завершились или отменены
+    void forgetFinished(std::unordered_set<uint64_t>& tickets) {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        pruneJobs(clock.now());
+
+        for (auto it = tickets.begin(); it != tickets.end();) {
+            it = jobs.count(*it) ? std::next(it) : tickets.erase(it);
+        }
+    }
+
+    // Бронь задания по номеру заявки; false, если задание ждёт в очереди, отменено или завершилось
+    bool jobReservation(uint64_t ticket, Reservation& reservation) {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        pruneJobs(clock.now());
+        auto it = jobs.find(ticket);
+
+        if (it == jobs.end() || !it->second.reserved) {
+            return false;
+        }
+
+        reservation = it->second.reservation;
+        return true;
+    }
+
+    // Учёт завершения задания в момент завершения по часам обработчика
+    // Модель длительности обучается, досрочно освободившийся стенд сразу становится доступен, в том числе очереди платы;
+    // задание ticket (если задан) завершено, и повторная подача той же заявки становится новым заданием.
+    // Уведомление о завершении такого задания отправляется сразу, а не в запланированное окончание брони
+    void reportCompletion(const RequestView& request, const Reservation& reservation, uint64_t ticket = 0) {
+        auto now = clock.now();
+        bool announce = false;
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            // Задание исполнителя, которого уже нет, было отменено: его длительность не обучает модель
+            bool finished = ticket == 0 || !exitCompletion;
+
+            if (ticket != 0) {
+                std::lock_guard<std::mutex> jobsLock(jobsMutex);
+                auto it = jobs.find(ticket);
+
+                if (it != jobs.end() && it->second.reserved) {
+                    finished = true;
+                    announce = it->second.timer != 0 ? notifier.cancel(it->second.timer) : exitCompletion && notifications;
+                    eraseJob(it, now);
+                }
+            }
+
+            if (finished) {
+                estimator.record(request, now - reservation.startTime);
+            }
+
+            cluster.completeReservation(request.boardName, reservation, now);
+            redispatch(request.boardName);
+        }
+
+        if (announce) {
+            completionMessage(internedStrings().intern(request.boardName), request.lastName, request.group, ticket);
+        }
+    }
+
+    // Модель длительности заданий
+    const RuntimeEstimator& runtimeEstimator() const {
+        return estimator;
+    }
+
+    // Медиана и 99-й перцентиль ожидания стенда по группам, с
+    std::vector<GroupWaitSummary> groupWaits() const {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        std::vector<GroupWaitSummary> result;
+
+        for (const auto& pair : waits) {
+            result.push_back({pair.first, pair.second.p50.size(), pair.second.p50.value(), pair.second.p99.value()});
+        }
+
+        return result;
+    }
+
+    // Вывод ожидания по группам
+    void printGroupWaits(std::ostream& out) const {
+        auto summary = groupWaits();
+
+        if (summary.empty()) {
+            return;
+        }
+
+        out << "Ожидание стенда по группам, с:\n";
+
+        for (const auto& group : summary) {
+            out << "  " << group.group << ": заявок " << group.count << ", p50 " << group.p50 << ", p99 " << group.p99 << "\n";
+        }
+
+        out.flush();
+    }
+};
+
+void testRequestProcessor() {
+    using namespace std::chrono;
+
+    std::cout << "Запуск тестов для RequestProcessor..." << std::endl;
+
+    // Время в тесте виртуальное, поэтому ожидание выполнения задания не занимает реального времени
+    ManualClock clock;
+
+    // Создание тестового кластера и стендов
+    StandCluster testCluster;
+    RemoteStand stand1("Arduino Uno", clock);
+    RemoteStand stand2("Arduino Uno", clock.now() + seconds(10)); // Стенд занят
+    testCluster.addStand(stand1);
+    testCluster.addStand(stand2);
+
+    // Проверка вывода сообщения о завершении
+    RequestProcessor processor(testCluster, clock);
+
+    std::string boardName = "Arduino Uno";
+    std::string studentName = "Иванов";
+    processor.completionMessage(boardName, studentName);
+
+    // Тест 2: Проверка обработки заявки на стенде
+    Request request1{"Иванов", "Иван", "Иванович", "БИВ222", "Arduino Uno", "otpt.txt", "C:"};
+    Reservation reservation;
+    assert(processor.processRequest(request1, reservation));
+
+    // Заявка попала на свободный стенд и будет выполнена через DELAY
+    assert(reservation.standIndex == 0);
+    assert(reservation.startTime == clock.now());
+    assert(reservation.freeTime == clock.now() + DELAY);
+    assert(processor.pendingNotifications() == 1);
+
+    // До окончания задания уведомление не отправляется
+    clock.advance(DELAY - seconds(1));
+    assert(processor.pollNotifications() == 0);
+
+    clock.advance(seconds(1));
+    assert(processor.pollNotifications() == 1);
+    assert(processor.pendingNotifications() == 0);
+
+    // Время, когда запрос должен быть выполнен
+    auto freeTimeAfterRequest = testCluster.getStandsByBoard("Arduino Uno")[0].getFreeTime();
+
+    // Проверим, что время свободного стенда обновилось
+    assert(freeTimeAfterRequest == clock.now());
+    assert(freeTimeAfterRequest <= clock.now() + seconds(10));
+
+    // Задания завершаются за 2 с: после обучения бронируется оценка, а стенд освобождается досрочно
+    for (int i = 0; i < ESTIMATOR_MIN_SAMPLES; ++i) {
+        assert(processor.processRequest(request1, reservation));
+        clock.advance(seconds(2));
+        processor.reportCompletion(request1, reservation);
+        assert(testCluster.getStandsByBoard("Arduino Uno")[reservation.standIndex].getFreeTime() == clock.now());
+    }
+
+    assert(processor.processRequest(request1, reservation));
+    assert(reservation.freeTime - reservation.startTime == seconds(2));
+
+    // Заявка из арены, оставшаяся в очереди, переживает освобождение арены
+    StandCluster singleCluster;
+    singleCluster.addStand(RemoteStand("Arduino Uno", clock));
+    RequestProcessor fairProcessor(singleCluster, clock);
+    fairProcessor.setVerbose(false);
+    fairProcessor.setPolicy(makePolicyFactory("fair", ""));
+    std::vector<std::string> booked;
+    fairProcessor.setDispatchHandler([&booked](const RequestView& view, uint64_t, system_clock::time_point, const Reservation&) {
+        booked.emplace_back(view.lastName);
+    });
+
+    RequestArena arena;
+    Request request3{"Петров", "Пётр", "Петрович", "БИВ223", "Arduino Uno", "otpt.txt", "C:"};
+    assert(fairProcessor.processRequest(arena.store(RequestView(request1))));
+    assert(fairProcessor.processRequest(arena.store(RequestView(request3))));
+    assert(fairProcessor.queuedRequests() == 1);
+    arena.reset();
+    arena.store(RequestView(Request{"Xxxxxxxxxxxx", "X", "X", "X", "X", "X", "X"}));
+    clock.advance(DELAY);
+    assert(fairProcessor.dispatchDue() == 1);
+    assert((booked == std::vector<std::string>{"Иванов", "Петров"}));
+
+    // Загрузка стенда учитывается по его постоянному номеру: после удаления первого стенда второй получает индекс 0,
+    // но его задания по-прежнему попадают в метрику второго стенда. Занятое время - фактический интервал задания:
+    // отменённое до начала задание не учитывается, досрочно завершённое - только до завершения
+    StandCluster meteredCluster;
+    StandHandle removed = meteredCluster.addStand(RemoteStand("Metered Board", clock));
+    StandHandle kept = meteredCluster.addStand(RemoteStand("Metered Board", clock));
+    assert(meteredCluster.removeStand(removed));
+    RequestProcessor meteredProcessor(meteredCluster, clock);
+    meteredProcessor.setVerbose(false);
+    Request metered = request1;
+    metered.boardName = "Metered Board";
+    uint64_t meteredFirst;
+    uint64_t meteredSecond;
+    uint64_t meteredThird;
+    Reservation meteredReservation;
+    assert(meteredProcessor.processRequest(metered, meteredFirst) && meteredProcessor.processRequest(metered, meteredSecond));
+    assert(meteredProcessor.jobReservation(meteredFirst, meteredReservation));
+    assert(meteredProcessor.cancelJob(meteredSecond));
+    clock.advance(seconds(2));
+    meteredProcessor.reportCompletion(metered, meteredReservation, meteredFirst);
+    std::string keptSeries = "remote_stand_stand_busy_seconds_total{board=\"Metered Board\",stand=\"" + std::to_string(kept.slot) + "\"} ";
+    {
+        std::ostringstream exposition;
+        metrics().writePrometheus(exposition);
+        assert(kept.slot == 1 && exposition.str().find(keptSeries + "2\n") != std::string::npos);
+    }
+
+    // Задание без исполнителя учитывается целиком, когда его бронь заканчивается
+    assert(meteredProcessor.processRequest(metered, meteredThird));
+    clock.advance(DELAY);
+    assert(!meteredProcessor.jobReservation(meteredThird, meteredReservation));
+    std::ostringstream exposition;
+    metrics().writePrometheus(exposition);
+    assert(exposition.str().find(keptSeries + std::to_string(2 + DELAY.count()) + "\n") != std::string::npos);
+    assert(exposition.str().find("{board=\"Metered Board\",stand=\"0\"} 0\n") != std::string::npos);
+
+    // Отмена и перенос заданий по номерам заявок: время возвращается стенду, уведомления отменяются и переносятся
+    StandCluster jobCluster;
+    jobCluster.addStand(RemoteStand("Arduino Uno", clock));
+    RequestProcessor jobProcessor(jobCluster, clock);
+    jobProcessor.setVerbose(false);
+    uint64_t first;
+    uint64_t second;
+    uint64_t third;
+    auto jobStart = clock.now();
+
+    assert(jobProcessor.processRequest(request1, first) && jobProcessor.processRequest(request1, second));
+    assert(jobProcessor.pendingNotifications() == 2);
+    assert(jobProcessor.cancelJob(second) && !jobProcessor.cancelJob(second));
+    assert(jobProcessor.pendingNotifications() == 1 && !jobProcessor.jobReservation(second, reservation));
+    assert(jobCluster.getStandsByBoard("Arduino Uno")[0].getFreeTime() == jobStart + DELAY);
+
+    assert(jobProcessor.processRequest(request1, third));
+    assert(jobProcessor.jobReservation(third, reservation) && reservation.startTime == jobStart + DELAY);
+    assert(jobProcessor.moveJob(third, jobStart + 10 * DELAY, reservation));
+    assert(reservation.startTime == jobStart + 10 * DELAY && jobProcessor.pendingNotifications() == 2);
+    assert(!jobProcessor.moveJob(first, jobStart + 20 * DELAY, reservation));
+    assert(jobCluster.getStandsByBoard("Arduino Uno")[0].getFreeTime() == jobStart + 11 * DELAY);
+
+    // Уведомление перенесённого задания приходит в новое время
+    clock.advance(2 * DELAY);
+    assert(jobProcessor.pollNotifications() == 1 && jobProcessor.pendingNotifications() == 1);
+    assert(!jobProcessor.cancelJob(first) && !jobProcessor.jobReservation(first, reservation));
+    clock.advance(10 * DELAY);
+    assert(jobProcessor.pollNotifications() == 1);
+
+    // Если бронь освободить не удалось (её время уже прошло), уведомление о завершении задания не теряется
+    assert(jobProcessor.processRequest(request1, first));
+    clock.advance(2 * DELAY);
+    assert(!jobProcessor.cancelJob(first));
+    assert(jobProcessor.pendingNotifications() == 1 && jobProcessor.pollNotifications() == 1);
+
+    // Отменённая заявка из очереди справедливой политики не получает стенд
+    size_t bookedBefore = booked.size();
+    assert(fairProcessor.processRequest(request1, first) && fairProcessor.processRequest(request3, second));
+    assert(fairProcessor.queuedRequests() == 1);
+    assert(fairProcessor.cancelJob(second) && fairProcessor.queuedRequests() == 0 && !fairProcessor.cancelJob(second));
+    clock.advance(DELAY);
+    assert(fairProcessor.dispatchDue() == 0 && booked.size() == bookedBefore + 1);
+
+    // Повторная подача до завершения задания объединяется с ним; после отмены или завершения - новое задание
+    StandCluster coalesceCluster;
+    coalesceCluster.addStand(RemoteStand("Arduino Uno", clock));
+    RequestProcessor coalesceProcessor(coalesceCluster, clock);
+    coalesceProcessor.setVerbose(false);
+    coalesceProcessor.setCoalescing(true);
+    Reservation repeated;
+    bool reserved;
+    uint64_t coalescedBefore = metrics().coalesced.value();
+
+    assert(coalesceProcessor.processRequest(request1, first, reservation, reserved) && reserved);
+    assert(coalesceProcessor.processRequest(request1, second, repeated, reserved) && reserved && second == first);
+    assert(repeated.stand == reservation.stand && repeated.startTime == reservation.startTime);
+    assert(metrics().coalesced.value() == coalescedBefore + 1);
+    assert(coalesceProcessor.processRequest(request3, third) && third != first);
+
+    assert(coalesceProcessor.cancelJob(first));
+    assert(coalesceProcessor.processRequest(request1, second, reservation, reserved) && second != first);
+    clock.advance(3 * DELAY);
+    coalesceProcessor.reportCompletion(request1, reservation, second);
+    assert(coalesceProcessor.processRequest(request1, third) && third != second);
+    assert(metrics().coalesced.value() == coalescedBefore + 1);
+
+    // Досрочное завершение сразу отправляет событие подписчикам и отменяет уведомление по окончании брони
+    StandCluster eventCluster;
+    eventCluster.addStand(RemoteStand("Arduino Uno", clock));
+    RequestProcessor eventProcessor(eventCluster, clock);
+    eventProcessor.setVerbose(false);
+    CompletionFilter byStudent;
+    assert(byStudent.parse("student Сидоров"));
+    auto events = completionHub().subscribe(byStudent);
+    Request request4{"Сидоров", "Сидор", "Сидорович", "БИВ224", "Arduino Uno", "otpt.txt", "C:"};
+    uint64_t ticket4;
+
+    assert(eventProcessor.processRequest(request4, ticket4, reservation, reserved) && reserved);
+    clock.advance(seconds(1));
+    eventProcessor.reportCompletion(request4, reservation, ticket4);
+    assert(eventProcessor.pendingNotifications() == 0 && events->pending() == 1);
+
+    std::vector<std::shared_ptr<const CompletionEvent>> received;
+    uint64_t dropped;
+    events->take(received, 16, dropped);
+    assert(received[0]->ticket == ticket4 && received[0]->group == "БИВ224" && received[0]->completedAt == clock.now());
+    completionHub().unsubscribe(events);
+
+    // Проверка на отсутствие доступных стендов для платы
+    StandCluster emptyCluster;  // Пустой кластер
+    RequestProcessor emptyProcessor(emptyCluster, clock);
+
+    Request request2{"Иванов", "Иван", "Иванович", "БИВ222", "STM-32", "otpt.txt", "C:"};
+    assert(!emptyProcessor.processRequest(request2));
+
+    // Проверка на некорректный путь файла
+    std::string invalidPath = "invalid_path.txt";
+    bool isValid = checkFile(invalidPath);
+
+    // Ожидаем, что путь будет неверным
+    assert(!isValid);
+}
+
+// Ограниченная блокирующая очередь для нескольких производителей и потребителей
+// Заполненная очередь останавливает производителя, так создаётся обратное давление между стадиями
+template <typename T>
+class BoundedQueue {
+private:
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+public:
+    // Конструктор
+    explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+    // Добавление элемента, ждёт освобождения места; false, если очередь закрыта
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+
+        if (closed) {
+            return false;
+        }
+
+        items.push_back(std::move(value));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Извлечение элемента, ждёт его появления; false, если очередь закрыта и пуста
+    bool pop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+
+        if (items.empty()) {
+            return false;
+        }
+
+        value = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Закрытие очереди: новые элементы не принимаются, оставшиеся можно забрать
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
+
+// Конвейер приёма заявок: чтение и проверка файлов -> планирование -> уведомление
+// Чтение и проверку выполняет пул потоков, планирование - один поток-секвенсор,
+// который восстанавливает порядок поступления, поэтому назначение стендов детерминировано
+class IntakePipeline {
+public:
+    // Функция планирования проверенной заявки (вызывается только из потока-секвенсора)
+    // Результат разбора принадлежит конвейеру и действителен только на время вызова
+    using Scheduler = std::function<void(const ParseResult&)>;
+    // Функция чтения и проверки файла-заявки (вызывается из потоков пула)
+    using Parser = std::function<ParseResult(const std::string&)>;
+
+private:
+    // Путь к файлу с порядковым номером поступления
+    struct PathItem {
+        uint64_t sequence = 0;
+        std::string path;
+    };
+
+    // Результат разбора с порядковым номером поступления
+    struct ParsedItem {
+        uint64_t sequence = 0;
+        ParseResult result;
+    };
+
+    Scheduler scheduler;
+    Parser parser;
+    BoundedQueue<PathItem> parseQueue;
+    BoundedQueue<ParsedItem> scheduleQueue;
+    std::vector<std::thread> workers;
+    std::thread sequencer;
+    uint64_t nextSequence = 0;
+    bool finished = false;
+    // Окно переупорядочивания: принимаются только заявки с номером меньше expected + window,
+    // поэтому медленный разбор одной заявки не даёт секвенсору копить неограниченно много следующих
+    size_t window;
+    std::mutex windowMutex;
+    std::condition_variable windowMoved;
+    uint64_t expected = 0;
+
+    // Стадия чтения и проверки
+    void parseLoop() {
+        PathItem item;
+
+        while (parseQueue.pop(item)) {
+            scheduleQueue.push(ParsedItem{item.sequence, parser(item.path)});
+        }
+    }
+
+    // Стадия планирования в порядке поступления
+    void sequenceLoop() {
+        std::map<uint64_t, ParseResult> reorder;
+        uint64_t next = 0;
+        ParsedItem item;
+
+        while (scheduleQueue.pop(item)) {
+            reorder.emplace(item.sequence, std::move(item.result));
+            uint64_t before = next;
+
+            for (auto it = reorder.find(next); it != reorder.end(); it = reorder.find(next)) {
+                scheduler(it->second);
+                reorder.erase(it);
+                ++next;
+            }
+
+            if (next != before) {
+                std::lock_guard<std::mutex> lock(windowMutex);
+                expected = next;
+                windowMoved.notify_one();
+            }
+        }
+    }
+
+public:
+    // Конструктор, запускает пул потоков разбора и поток-секвенсор
+    // Без parser файлы разбираются parseRequestFile с общим кэшем
+    IntakePipeline(Scheduler scheduler, size_t workersCount = std::max(1u, std::thread::hardware_concurrency()),
+                   size_t capacity = PIPELINE_QUEUE_SIZE, Parser parser = nullptr)
+        : scheduler(std::move(scheduler)),
+          parser(parser ? std::move(parser) : Parser([](const std::string& path) { return parseRequestFile(path); })),
+          parseQueue(capacity), scheduleQueue(capacity), window(std::max<size_t>(1, capacity)) {
+        for (size_t i = 0; i < std::max<size_t>(1, workersCount); ++i) {
+            workers.emplace_back(&IntakePipeline::parseLoop, this);
+        }
+
+        sequencer = std::thread(&IntakePipeline::sequenceLoop, this);
+    }
+
+    // Деструктор: дожидается обработки всех принятых заявок
+    ~IntakePipeline() {
+        finish();
+    }
+
+    IntakePipeline(const IntakePipeline&) = delete;
+    IntakePipeline& operator=(const IntakePipeline&) = delete;
+
+    // Приём пути к файлу-заявке; при заполненном конвейере вызывающий поток ждёт, заявки не теряются
+    // Ждёт и тогда, когда заявка не помещается в окно переупорядочивания за ещё не спланированной
+    // Вызывается из одного потока ввода
+    void submit(const std::string& path) {
+        {
+            std::unique_lock<std::mutex> lock(windowMutex);
+            windowMoved.wait(lock, [this]() { return nextSequence - expected < window; });
+        }
+
+        parseQueue.push(PathItem{nextSequence++, path});
+    }
+
+    // Завершение: все принятые заявки обрабатываются, потоки останавливаются
+    void finish() {
+        if (finished) {
+            return;
+        }
+
+        finished = true;
+        parseQueue.close();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        scheduleQueue.close();
+        sequencer.join();
+    }
+};
+
+// Тесты конвейера приёма заявок
+void testIntakePipeline() {
+    auto directory = std::filesystem::temp_directory_path() / "remote_stand_test_pipeline";
+    std::filesystem::create_directories(directory);
+
+    // Файлы-заявки: каждая пятая заявка с ошибкой в группе
+    std::vector<std::string> paths;
+
+    for (int i = 0; i < 40; ++i) {
+        std::string path = (directory / ("request" + std::to_string(i) + ".txt")).string();
+        std::ofstream file(path);
+        std::string lastName = std::string(1, static_cast<char>('A' + i % 26)) + std::string(1, static_cast<char>('a' + i / 26));
+
+        file << lastName << "\nIvan\nIvanovich\n" << (i % 5 == 0 ? "BIV 1" : "BIV1") << "\nArduino Uno\nmain.exe\nC:\n";
+        paths.push_back(path);
+    }
+
+    // Маленькая ёмкость очередей заставляет ввод ждать, порядок планирования должен совпасть с порядком ввода
+    std::vector<std::string> order;
+    {
+        IntakePipeline pipeline([&order](const ParseResult& result) {
+            order.push_back(result.ok() ? result.request.lastName : "error");
+        }, 4, 2);
+
+        for (const auto& path : paths) {
+            pipeline.submit(path);
+        }
+
+        pipeline.submit((directory / "missing.txt").string());
+    }
+
+    assert(order.size() == paths.size() + 1);
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        std::string expected = std::string(1, static_cast<char>('A' + i % 26)) + std::string(1, static_cast<char>('a' + i / 26));
+        assert(order[i] == (i % 5 == 0 ? "error" : expected));
+    }
+
+    assert(order.back() == "error");
+
+    // Разбор первой заявки стоит, пока тест его не отпустит: ввод ждёт, пока следующие заявки не выйдут за окно
+    std::string stalledPath = (directory / "stalled.txt").string();
+    std::mutex stallMutex;
+    std::condition_variable stallReleased;
+    bool released = false;
+    std::atomic<size_t> submitted{0};
+    order.clear();
+    {
+        IntakePipeline pipeline([&order](const ParseResult& result) {
+            order.push_back(result.ok() ? result.request.lastName : "error");
+        }, 4, 2, [&](const std::string& path) {
+            if (path == stalledPath) {
+                std::unique_lock<std::mutex> lock(stallMutex);
+                stallReleased.wait(lock, [&]() { return released; });
+                return parseRequestText("Pipe\nIvan\nIvanovich\nBIV1\nArduino Uno\nmain.exe\nC:\n");
+            }
+
+            return parseRequestFile(path);
+        });
+
+        std::thread input([&]() {
+            pipeline.submit(stalledPath);
+            ++submitted;
+
+            for (const auto& path : paths) {
+                pipeline.submit(path);
+                ++submitted;
+            }
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        assert(submitted <= 2);
+
+        {
+            std::lock_guard<std::mutex> lock(stallMutex);
+            released = true;
+        }
+
+        stallReleased.notify_all();
+        input.join();
+    }
+
+    assert(submitted == paths.size() + 1 && order.size() == paths.size() + 1 && order[0] == "Pipe");
+    std::filesystem::remove_all(directory);
+}
+
+// Кадр протокола приёма заявок: 4 байта длины (big-endian, без учёта самих 4 байт), байт типа и данные
+// Запросы: 'R' - текст заявки в формате файла-заявки, 'P' - путь к файлу-заявке на сервере (только через Unix-сокет),
+// 'C' - отмена задания по номеру заявки
+// Ответы: 'A' - стенд выдан ("номер время_окончания_мс_от_эпохи"), 'Q' - заявка ждёт в очереди ("номер"),
+// 'C' - задание отменено ("номер"), 'E' - заявка отклонена (текст ошибки). Ответы приходят в порядке запросов, поэтому клиент может
+// отправлять запросы пачкой, не дожидаясь ответов
+void appendFrame(std::string& out, char type, std::string_view payload) {
+    uint32_t length = static_cast<uint32_t>(payload.size() + 1);
+    char header[5] = {
+        static_cast<char>(length >> 24), static_cast<char>(length >> 16), static_cast<char>(length >> 8),
+        static_cast<char>(length), type
+    };
+
+    out.append(header, sizeof(header));
+    out.append(payload.data(), payload.size());
+}
+
+// Результат извлечения кадра из буфера
+enum class FrameStatus {
+    Ready,
+    Incomplete,
+    TooLarge
+};
+
+// Извлечение кадра из buffer начиная с offset; при успехе offset сдвигается за кадр
+// Данные кадра указывают в buffer
+FrameStatus takeFrame(std::string_view buffer, size_t& offset, char& type, std::string_view& payload) {
+    if (buffer.size() - offset < 4) {
+        return FrameStatus::Incomplete;
+    }
+
+    const auto* bytes = reinterpret_cast<const uint8_t*>(buffer.data() + offset);
+    uint32_t length = (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+
+    if (length == 0 || length > SERVER_MAX_FRAME) {
+        return FrameStatus::TooLarge;
+    }
+
+    if (buffer.size() - offset - 4 < length) {
+        return FrameStatus::Incomplete;
+    }
+
+    type = buffer[offset + 4];
+    payload = buffer.substr(offset + 5, length - 1);
+    offset += 4 + length;
+    return FrameStatus::Ready;
+}
+
+// Разбор адреса "узел:порт"
+bool splitHostPort(const std::string& address, std::string& host, uint16_t& port) {
+    size_t colon = address.rfind(':');
+    size_t value = 0;
+
+    if (colon == std::string::npos || !parseCount(address.substr(colon + 1), value) || value > 65535) {
+        return false;
+    }
+
+    host = address.substr(0, colon);
+    port = static_cast<uint16_t>(value);
+    return true;
+}
+
+// Адрес Unix-сокета; false, если путь не помещается в sockaddr_un
+bool unixAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+
+    std::memcpy(address.sun_path, path.data(), path.size());
+    return true;
+}
+
+// Сокет TCP, подключённый к узлу host или слушающий на нём (listening = true)
+// Возвращает дескриптор или -1 с описанием ошибки в error
+int tcpSocket(const std::string& host, uint16_t port, bool listening, std::string& error) {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+
+    addrinfo* addresses = nullptr;
+    std::string service = std::to_string(port);
+    int status = ::getaddrinfo(host.empty() ? nullptr : host.c_str(), service.c_str(), &hints, &addresses);
+
+    if (status != 0) {
+        error = std::string("не удалось разрешить адрес: ") + gai_strerror(status);
+        return -1;
+    }
+
+    int fd = -1;
+
+    for (addrinfo* address = addresses; address; address = address->ai_next) {
+        fd = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+
+        if (fd < 0) {
+            continue;
+        }
+
+        int one = 1;
+        bool ok;
+
+        if (listening) {
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            ok = ::bind(fd, address->ai_addr, address->ai_addrlen) == 0 && ::listen(fd, SERVER_BACKLOG) == 0;
+        } else {
+            ok = ::connect(fd, address->ai_addr, address->ai_addrlen) == 0;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        if (ok) {
+            break;
+        }
+
+        error = std::strerror(errno);
+        ::close(fd);
+        fd = -1;
+    }
+
+    ::freeaddrinfo(addresses);
+    return fd;
+}
+
+// Сервер приёма заявок по Unix-сокету и TCP
+// Несколько потоков, у каждого свой цикл epoll; слушающие сокеты добавлены во все циклы с EPOLLEXCLUSIVE,
+// поэтому новое соединение будит один поток и дальше обслуживается только им. Сокеты неблокирующие,
+// заявки разбираются и планируются прямо в потоке цикла. Если клиент не забирает ответы, соединение
+// перестаёт читаться, пока неотправленные ответы не уменьшатся до SERVER_MAX_OUTPUT
+class IntakeServer {
+private:
+    // Соединение с клиентом
+    struct Connection {
+        int fd = -1;
+        std::string input;
+        std::string output;
+        size_t outputOffset = 0;
+        // Подписка epoll на чтение и запись
+        uint32_t events = 0;
+        // Клиент закончил отправку или нарушил протокол: соединение закрывается после отправки ответов
+        bool draining = false;
+        // Подписка на события завершения (кадр S)
+        std::shared_ptr<CompletionSubscriber> subscriber;
+        // Подписка epoll на eventfd подписчика: снимается, пока ответы не умещаются в SERVER_MAX_OUTPUT
+        uint32_t subscriberEvents = 0;
+        // Соединение принято через Unix-сокет: клиент работает на той же машине
+        bool local = false;
+        // Номера заявок, поданных этим соединением: отменить (кадр C) можно только их
+        // Номера завершившихся заданий удаляются, когда номеров становится ticketsLimit
+        std::unordered_set<uint64_t> tickets;
+        size_t ticketsLimit = SERVER_TICKETS_PRUNE;
+    };
+
+    // Цикл событий одного потока
+    struct Loop {
+        int epoll = -1;
+        int wake = -1;
+        std::thread thread;
+        std::unordered_map<int, std::unique_ptr<Connection>> connections;
+        // Соединения подписчиков по дескрипторам eventfd их подписок
+        std::unordered_map<int, int> subscriptions;
+    };
+
+    RequestProcessor& processor;
+    size_t threadsCount;
+    std::vector<int> listeners;
+    // Слушающие Unix-сокеты (подмножество listeners)
+    std::vector<int> localListeners;
+    std::vector<std::unique_ptr<Loop>> loops;
+    std::string unixPath;
+    uint16_t port = 0;
+    bool started = false;
+    std::atomic<size_t> accepted{0};
+    std::atomic<uint64_t> frames{0};
+    // Номера заявок, которые хранят все соединения
+    std::atomic<size_t> tickets{0};
+    // Снятия сигнала подписчика с epoll при полном буфере ответов и пробуждения по сигналу при полном буфере
+    std::atomic<uint64_t> pausedSubscriptions{0};
+    std::atomic<uint64_t> idleWakeups{0};
+
+    // Запоминание номера заявки соединения; номера завершившихся заданий удаляются, когда их накопилось
+    // ticketsLimit, и порог удваивается по оставшимся - память соединения ограничена числом его незавершённых заданий
+    void trackTicket(Connection& connection, uint64_t ticket) {
+        size_t before = connection.tickets.size();
+
+        if (connection.tickets.insert(ticket).second && before + 1 >= connection.ticketsLimit) {
+            processor.forgetFinished(connection.tickets);
+            connection.ticketsLimit = std::max<size_t>(SERVER_TICKETS_PRUNE, 2 * connection.tickets.size());
+        }
+
+        if (connection.tickets.size() >= before) {
+            tickets.fetch_add(connection.tickets.size() - before, std::memory_order_relaxed);
+        } else {
+            tickets.fetch_sub(before - connection.tickets.size(), std::memory_order_relaxed);
+        }
+    }
+
+    // Обработка одного запроса соединения, ответ дописывается в его ответы
+    // Путь к файлу-заявке (кадр P) открывается на сервере, поэтому принимается только от локальных клиентов;
+    // исполняемый файл из заявки TCP-клиента сервер тоже не читает
+    // Отменить можно только задание, поданное тем же соединением; чужое задание для клиента не существует
+    void handleFrame(char type, std::string_view payload, Connection& connection) {
+        std::string& out = connection.output;
+        ParseResult result;
+        frames.fetch_add(1, std::memory_order_relaxed);
+
+        if (type == 'C') {
+            std::string ticket(payload);
+            char* end = nullptr;
+            uint64_t number = std::strtoull(ticket.c_str(), &end, 10);
+
+            if (ticket.empty() || *end != '\0' || !connection.tickets.count(number) || !processor.cancelJob(number)) {
+                appendFrame(out, 'E', "Задание не найдено: " + ticket);
+            } else {
+                connection.tickets.erase(number);
+                tickets.fetch_sub(1, std::memory_order_relaxed);
+                appendFrame(out, 'C', ticket);
+            }
+
+            return;
+        }
+
+        if (type == 'R') {
+            MetricsTimer timer(metrics().parseTime);
+            result = parseRequestText(payload);
+
+            if (!result.ok()) {
+                metrics().reject(rejectReason(result.error));
+            }
+        } else if (type == 'P') {
+            if (!connection.local) {
+                appendFrame(out, 'E', "Путь к файлу-заявке принимается только через Unix-сокет");
+                return;
+            }
+
+            // Файл читается в цикле соединений: открываются без ожидания только обычные файлы,
+            // и читается не больше REQUEST_FILE_MAX байт, поэтому канал или огромный файл не задерживают цикл
+            result = parseRequestFile(std::string(payload));
+        } else {
+            appendFrame(out, 'E', "Неизвестный тип запроса");
+            return;
+        }
+
+        if (!result.ok()) {
+            appendFrame(out, 'E', describeError(result));
+            return;
+        }
+
+        uint64_t ticket;
+        Reservation reservation;
+        bool reserved;
+
+        if (!processor.processRequest(result.request, ticket, reservation, reserved, connection.local)) {
+            appendFrame(out, 'E', "Нет доступных стендов для платы: " + result.request.boardName);
+            return;
+        }
+
+        trackTicket(connection, ticket);
+
+        if (reserved) {
+            auto end = std::chrono::duration_cast<std::chrono::milliseconds>(reservation.freeTime.time_since_epoch());
+            appendFrame(out, 'A', std::to_string(ticket) + " " + std::to_string(end.count()));
+        } else {
+            appendFrame(out, 'Q', std::to_string(ticket));
+        }
+    }
+
+    // Подписка соединения на события завершения, прежняя подписка соединения заменяется
+    // Очередь подписчика регистрируется в epoll цикла: события отправляются потоком соединения
+    void subscribe(Loop& loop, Connection& connection, std::string_view payload) {
+        CompletionFilter filter;
+        frames.fetch_add(1, std::memory_order_relaxed);
+
+        if (!filter.parse(payload)) {
+            appendFrame(connection.output, 'E', "Неверная подписка: " + std::string(payload));
+            return;
+        }
+
+        unsubscribe(loop, connection);
+        connection.subscriber = completionHub().subscribe(filter);
+
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = connection.subscriber->eventFd();
+        ::epoll_ctl(loop.epoll, EPOLL_CTL_ADD, event.data.fd, &event);
+        connection.subscriberEvents = EPOLLIN;
+        loop.subscriptions[event.data.fd] = connection.fd;
+        appendFrame(connection.output, 'S', trimmed(payload));
+    }
+
+    // Отмена подписки соединения
+    static void unsubscribe(Loop& loop, Connection& connection) {
+        if (!connection.subscriber) {
+            return;
+        }
+
+        int fd = connection.subscriber->eventFd();
+        ::epoll_ctl(loop.epoll, EPOLL_CTL_DEL, fd, nullptr);
+        loop.subscriptions.erase(fd);
+        completionHub().unsubscribe(connection.subscriber);
+        connection.subscriber.reset();
+    }
+
+    // Перенос событий подписки в ответы соединения, пока ответов меньше SERVER_MAX_OUTPUT
+    // Остальные события ждут в очереди подписчика (где при переполнении вытесняются старые) до следующей отправки
+    static void deliverEvents(Connection& connection) {
+        std::vector<std::shared_ptr<const CompletionEvent>> events;
+        uint64_t dropped = 0;
+
+        while (connection.subscriber && !connection.draining && connection.output.size() - connection.outputOffset < SERVER_MAX_OUTPUT) {
+            events.clear();
+
+            if (connection.subscriber->take(events, SUBSCRIBER_BATCH, dropped) == 0 && dropped == 0) {
+                break;
+            }
+
+            if (dropped > 0) {
+                appendFrame(connection.output, 'D', std::to_string(dropped));
+            }
+
+            for (const auto& event : events) {
+                appendFrame(connection.output, 'N', completionEventText(*event));
+            }
+        }
+    }
+
+    // Обработка всех полностью принятых запросов соединения
+    void processInput(Loop& loop, Connection& connection) {
+        size_t offset = 0;
+        char type;
+        std::string_view payload;
+
+        while (!connection.draining) {
+            FrameStatus status = takeFrame(connection.input, offset, type, payload);
+
+            if (status == FrameStatus::Incomplete) {
+                break;
+            }
+
+            if (status == FrameStatus::TooLarge) {
+                appendFrame(connection.output, 'E', "Слишком большой запрос");
+                connection.draining = true;
+                break;
+            }
+
+            if (type == 'S') {
+                subscribe(loop, connection, payload);
+            } else {
+                handleFrame(type, payload, connection);
+            }
+        }
+
+        connection.input.erase(0, offset);
+    }
+
+    // Чтение доступных данных; false при ошибке соединения
+    bool readInput(Loop& loop, Connection& connection) {
+        char buffer[SERVER_READ_CHUNK];
+
+        while (!connection.draining && connection.output.size() - connection.outputOffset < SERVER_MAX_OUTPUT) {
+            ssize_t count = ::read(connection.fd, buffer, sizeof(buffer));
+
+            if (count > 0) {
+                connection.input.append(buffer, static_cast<size_t>(count));
+                processInput(loop, connection);
+                continue;
+            }
+
+            if (count == 0) {
+                connection.draining = true;
+                break;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        return true;
+    }
+
+    // Отправка накопленных ответов; false при ошибке соединения
+    static bool writeOutput(Connection& connection) {
+        while (connection.outputOffset < connection.output.size()) {
+            ssize_t count = ::send(connection.fd, connection.output.data() + connection.outputOffset,
+                                   connection.output.size() - connection.outputOffset, MSG_NOSIGNAL);
+
+            if (count > 0) {
+                connection.outputOffset += static_cast<size_t>(count);
+                continue;
+            }
+
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+
+            return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+
+        connection.output.clear();
+        connection.outputOffset = 0;
+        return true;
+    }
+
+    // Обновление подписки epoll по состоянию соединения; false, если соединение пора закрыть
+    // Сигнал подписчика срабатывает по уровню и не сбрасывается, пока события не забраны, поэтому при полном
+    // буфере ответов он снимается с epoll и возвращается, когда отправка освободит место
+    bool updateEvents(Loop& loop, Connection& connection) {
+        bool pending = connection.outputOffset < connection.output.size();
+        bool accepting = !connection.draining && connection.output.size() - connection.outputOffset < SERVER_MAX_OUTPUT;
+        uint32_t events = 0;
+
+        if (accepting) {
+            events |= EPOLLIN;
+        }
+
+        if (connection.subscriber && (accepting ? EPOLLIN : 0u) != connection.subscriberEvents) {
+            epoll_event event;
+            event.events = accepting ? EPOLLIN : 0u;
+            event.data.fd = connection.subscriber->eventFd();
+            ::epoll_ctl(loop.epoll, EPOLL_CTL_MOD, event.data.fd, &event);
+            connection.subscriberEvents = event.events;
+            pausedSubscriptions.fetch_add(accepting ? 0 : 1, std::memory_order_relaxed);
+        }
+
+        if (pending) {
+            events |= EPOLLOUT;
+        }
+
+        if (events == 0) {
+            return false;
+        }
+
+        if (events != connection.events) {
+            epoll_event event;
+            event.events = events;
+            event.data.fd = connection.fd;
+            ::epoll_ctl(loop.epoll, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.events = events;
+        }
+
+        return true;
+    }
+
+    // Приём всех ожидающих соединений слушающего сокета
+    void acceptConnections(Loop& loop, int listener) {
+        while (true) {
+            int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+
+                // EAGAIN - соединений больше нет, другие ошибки (например, EMFILE) - повторим на следующем событии
+                return;
+            }
+
+            // Для Unix-сокета параметр не поддерживается, ошибка не важна
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            auto connection = std::make_unique<Connection>();
+            connection->fd = fd;
+            connection->events = EPOLLIN;
+            connection->local = std::find(localListeners.begin(), localListeners.end(), listener) != localListeners.end();
+
+            epoll_event event;
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+
+            if (::epoll_ctl(loop.epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+                ::close(fd);
+                continue;
+            }
+
+            loop.connections.emplace(fd, std::move(connection));
+            accepted.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Закрытие соединения вместе с его подпиской
+    void closeConnection(Loop& loop, int fd) {
+        Connection& connection = *loop.connections.at(fd);
+        unsubscribe(loop, connection);
+        tickets.fetch_sub(connection.tickets.size(), std::memory_order_relaxed);
+        ::epoll_ctl(loop.epoll, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        loop.connections.erase(fd);
+    }
+
+    // Цикл событий потока
+    void run(Loop& loop) {
+        epoll_event events[SERVER_MAX_EVENTS];
+
+        while (true) {
+            int count = ::epoll_wait(loop.epoll, events, SERVER_MAX_EVENTS, -1);
+
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                break;
+            }
+
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+
+                if (fd == loop.wake) {
+                    for (auto& pair : loop.connections) {
+                        unsubscribe(loop, *pair.second);
+                        ::close(pair.first);
+                    }
+
+                    loop.connections.clear();
+                    return;
+                }
+
+                if (std::find(listeners.begin(), listeners.end(), fd) != listeners.end()) {
+                    acceptConnections(loop, fd);
+                    continue;
+                }
+
+                // Событие очереди подписчика обрабатывается как готовность его соединения к отправке
+                auto subscription = loop.subscriptions.find(fd);
+                bool notified = subscription != loop.subscriptions.end();
+
+                if (notified) {
+                    fd = subscription->second;
+                }
+
+                auto it = loop.connections.find(fd);
+
+                if (it == loop.connections.end()) {
+                    continue;
+                }
+
+                Connection& connection = *it->second;
+                bool alive = true;
+
+                // Сигнал подписчика при полном буфере ответов: события некуда перенести
+                if (notified && connection.output.size() - connection.outputOffset >= SERVER_MAX_OUTPUT) {
+                    idleWakeups.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                if (!notified && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                    alive = readInput(loop, connection);
+                }
+
+                if (alive) {
+                    deliverEvents(connection);
+                }
+
+                alive = alive && writeOutput(connection) && updateEvents(loop, connection);
+
+                if (!alive) {
+                    closeConnection(loop, fd);
+                }
+            }
+        }
+    }
+
+    // Добавление слушающего сокета
+    bool addListener(int fd, std::string& error) {
+        if (fd < 0) {
+            return false;
+        }
+
+        if (::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+            error = std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+
+        listeners.push_back(fd);
+        return true;
+    }
+
+public:
+    // Конструктор; сокеты добавляются до запуска методами listenUnix и listenTcp
+    explicit IntakeServer(RequestProcessor& processor, size_t threadsCount = SERVER_THREADS)
+        : processor(processor), threadsCount(std::max<size_t>(1, threadsCount)) {}
+
+    // Деструктор: останавливает потоки и закрывает сокеты
+    ~IntakeServer() {
+        stop();
+    }
+
+    IntakeServer(const IntakeServer&) = delete;
+    IntakeServer& operator=(const IntakeServer&) = delete;
+
+    // Приём соединений по Unix-сокету path (существующий файл сокета заменяется)
+    bool listenUnix(const std::string& path, std::string& error) {
+        sockaddr_un address;
+
+        if (!unixAddress(path, address)) {
+            error = "слишком длинный путь к сокету";
+            return false;
+        }
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        if (fd < 0) {
+            error = std::strerror(errno);
+            return false;
+        }
+
+        ::unlink(path.c_str());
+
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, SERVER_BACKLOG) != 0) {
+            error = std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+
+        unixPath = path;
+
+        if (!addListener(fd, error)) {
+            return false;
+        }
+
+        localListeners.push_back(fd);
+        return true;
+    }
+
+    // Приём соединений по TCP; порт 0 - любой свободный порт (см. tcpPort)
+    bool listenTcp(const std::string& host, uint16_t requestedPort, std::string& error) {
+        int fd = tcpSocket(host, requestedPort, true, error);
+
+        if (!addListener(fd, error)) {
+            return false;
+        }
+
+        sockaddr_storage address;
+        socklen_t length = sizeof(address);
+
+        if (::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) == 0) {
+            port = ntohs(address.ss_family == AF_INET6 ? reinterpret_cast<sockaddr_in6*>(&address)->sin6_port
+                                                        : reinterpret_cast<sockaddr_in*>(&address)->sin_port);
+        }
+
+        return true;
+    }
+
+    // Порт TCP, на котором принимаются соединения
+    uint16_t tcpPort() const {
+        return port;
+    }
+
+    // Запуск потоков обработки
+    bool start(std::string& error) {
+        if (started || listeners.empty()) {
+            error = "не задан адрес сервера";
+            return false;
+        }
+
+        for (size_t i = 0; i < threadsCount; ++i) {
+            auto loop = std::make_unique<Loop>();
+            loop->epoll = ::epoll_create1(EPOLL_CLOEXEC);
+            loop->wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+            if (loop->epoll < 0 || loop->wake < 0) {
+                error = std::strerror(errno);
+                return false;
+            }
+
+            epoll_event event;
+            event.events = EPOLLIN;
+            event.data.fd = loop->wake;
+            ::epoll_ctl(loop->epoll, EPOLL_CTL_ADD, loop->wake, &event);
+
+            for (int listener : listeners) {
+                event.events = EPOLLIN | EPOLLEXCLUSIVE;
+                event.data.fd = listener;
+                ::epoll_ctl(loop->epoll, EPOLL_CTL_ADD, listener, &event);
+            }
+
+            loops.push_back(std::move(loop));
+        }
+
+        for (auto& loop : loops) {
+            Loop* current = loop.get();
+            loop->thread = std::thread([this, current]() { run(*current); });
+        }
+
+        started = true;
+        return true;
+    }
+
+    // Остановка: открытые соединения закрываются, неотправленные ответы теряются
+    void stop() {
+        for (auto& loop : loops) {
+            uint64_t one = 1;
+
+            if (loop->thread.joinable()) {
+                ssize_t written = ::write(loop->wake, &one, sizeof(one));
+                (void)written;
+                loop->thread.join();
+            }
+
+            if (loop->epoll >= 0) {
+                ::close(loop->epoll);
+            }
+
+            if (loop->wake >= 0) {
+                ::close(loop->wake);
+            }
+        }
+
+        loops.clear();
+
+        for (int fd : listeners) {
+            ::close(fd);
+        }
+
+        listeners.clear();
+
+        if (!unixPath.empty()) {
+            ::unlink(unixPath.c_str());
+            unixPath.clear();
+        }
+
+        started = false;
+    }
+
+    // Количество принятых соединений и обработанных запросов
+    size_t acceptedConnections() const {
+        return accepted.load();
+    }
+
+    uint64_t processedFrames() const {
+        return frames.load();
+    }
+
+    // Количество номеров заявок, которые хранят открытые соединения для отмены
+    size_t trackedTickets() const {
+        return tickets.load();
+    }
+
+    // Сколько раз сигнал подписчика снимался из-за полного буфера ответов и сколько раз цикл
+    // просыпался по сигналу подписчика, когда события некуда перенести
+    uint64_t pausedSubscriptionCount() const {
+        return pausedSubscriptions.load();
+    }
+
+    uint64_t idleWakeupCount() const {
+        return idleWakeups.load();
+    }
+};
+
+// Клиент протокола приёма заявок с блокирующим сокетом
+class IntakeClient {
+private:
+    int fd = -1;
+    std::string input;
+    size_t inputOffset = 0;
+
+public:
+    IntakeClient() = default;
+
+    ~IntakeClient() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    IntakeClient(const IntakeClient&) = delete;
+    IntakeClient& operator=(const IntakeClient&) = delete;
+
+    // Подключение по Unix-сокету
+    bool connectUnix(const std::string& path, std::string& error) {
+        sockaddr_un address;
+
+        if (!unixAddress(path, address)) {
+            error = "слишком длинный путь к сокету";
+            return false;
+        }
+
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            error = std::strerror(errno);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Подключение по TCP
+    bool connectTcp(const std::string& host, uint16_t port, std::string& error) {
+        fd = tcpSocket(host, port, false, error);
+        return fd >= 0;
+    }
+
+    // Разрыв соединения: ожидающий ответа поток получает конец данных
+    void disconnect() {
+        if (fd >= 0) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+    }
+
+    // Отправка заранее собранных кадров
+    bool sendRaw(std::string_view data) {
+        while (!data.empty()) {
+            ssize_t count = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (count <= 0) {
+                return false;
+            }
+
+            data.remove_prefix(static_cast<size_t>(count));
+        }
+
+        return true;
+    }
+
+    // Отправка запроса
+    bool send(char type, std::string_view payload) {
+        std::string frame;
+        appendFrame(frame, type, payload);
+        return sendRaw(frame);
+    }
+
+    // Получение следующего ответа; false, если сервер закрыл соединение
+    bool receive(char& type, std::string& payload) {
+        char buffer[SERVER_READ_CHUNK];
+
+        while (true) {
+            std::string_view frame;
+            size_t offset = inputOffset;
+            FrameStatus status = takeFrame(input, offset, type, frame);
+
+            if (status == FrameStatus::TooLarge) {
+                return false;
+            }
+
+            if (status == FrameStatus::Ready) {
+                payload.assign(frame.data(), frame.size());
+                inputOffset = offset;
+
+                if (inputOffset == input.size()) {
+                    input.clear();
+                    inputOffset = 0;
+                }
+
+                return true;
+            }
+
+            ssize_t count = ::read(fd, buffer, sizeof(buffer));
+
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (count <= 0) {
+                return false;
+            }
+
+            input.append(buffer, static_cast<size_t>(count));
+        }
+    }
+
+    // Есть ли уже принятый, но не полученный ответ (receive вернёт его без ожидания)
+    bool pending() const {
+        size_t offset = inputOffset;
+        char type;
+        std::string_view frame;
+        return takeFrame(input, offset, type, frame) == FrameStatus::Ready;
+    }
+};
+
+// Тесты сервера приёма заявок
+void testIntakeServer() {
+    using namespace std::chrono;
+
+    // Кадры разбираются частями и целиком, слишком большой кадр обнаруживается по заголовку
+    std::string stream;
+    appendFrame(stream, 'R', "abc");
+    appendFrame(stream, 'P', "");
+    size_t offset = 0;
+    char type;
+    std::string_view payload;
+    assert(takeFrame(std::string_view(stream).substr(0, 6), offset, type, payload) == FrameStatus::Incomplete);
+    assert(takeFrame(stream, offset, type, payload) == FrameStatus::Ready && type == 'R' && payload == "abc");
+    assert(takeFrame(stream, offset, type, payload) == FrameStatus::Ready && type == 'P' && payload.empty());
+    assert(offset == stream.size());
+
+    std::string host;
+    uint16_t port = 0;
+    assert(splitHostPort("127.0.0.1:8080", host, port) && host == "127.0.0.1" && port == 8080);
+    assert(!splitHostPort("localhost", host, port) && !splitHostPort("localhost:99999", host, port));
+    assert(!splitHostPort("localhost:99999999999999999999999", host, port) && !splitHostPort("localhost:+80", host, port));
+
+    // Числа параметров командной строки разбираются целиком и без исключений
+    size_t count = 0;
+    double number = 0;
+    assert(parseCount("16", count) && count == 16);
+    assert(!parseCount("", count) && !parseCount("-1", count) && !parseCount(" 1", count) && !parseCount("4x", count));
+    assert(!parseCount("99999999999999999999999", count) && count == 16);
+    assert(parseNumber("0.25", number) && number == 0.25 && parseNumber("-3", number) && number == -3);
+    assert(!parseNumber("", number) && !parseNumber("abc", number) && !parseNumber("1.5s", number));
+    assert(!parseNumber("1e999", number) && !parseNumber("nan", number) && number == -3);
+
+    ManualClock clock;
+    StandCluster cluster;
+    cluster.addStand(RemoteStand("Arduino Uno", clock));
+    RequestProcessor processor(cluster, clock);
+    processor.setVerbose(false);
+    processor.setNotifications(false);
+
+    IntakeServer server(processor, 3);
+    std::string socketPath = (std::filesystem::temp_directory_path() / "remote_stand_test.sock").string();
+    std::string error;
+    assert(server.listenUnix(socketPath, error));
+    assert(server.listenTcp("127.0.0.1", 0, error) && server.tcpPort() != 0);
+    assert(server.start(error));
+
+    // Запросы отправляются пачкой, ответы приходят в том же порядке
+    const std::string valid = "Ivanov\nIvan\nIvanovich\nBIV1\nArduino Uno\nmain.exe\nC:\n";
+    IntakeClient client;
+    assert(client.connectUnix(socketPath, error));
+    assert(client.send('R', valid));
+    assert(client.send('R', "Ivanov\nIvan\nIvanovich\nBIV 1\nArduino Uno\nmain.exe\nC:\n"));
+    assert(client.send('R', "Ivanov\nIvan\nIvanovich\nBIV1\nSTM-32\nmain.exe\nC:\n"));
+    assert(client.send('P', "/nonexistent/request.txt"));
+    assert(client.send('X', ""));
+    assert(client.send('C', "1"));
+    assert(client.send('C', "1"));
+
+    std::string reply;
+    auto end = duration_cast<milliseconds>((clock.now() + DELAY).time_since_epoch()).count();
+    assert(client.receive(type, reply) && type == 'A' && reply == "1 " + std::to_string(end));
+    assert(client.receive(type, reply) && type == 'E' && reply == "Ошибка в группе: BIV 1");
+    assert(client.receive(type, reply) && type == 'E' && reply == "Нет доступных стендов для платы: STM-32");
+    assert(client.receive(type, reply) && type == 'E' && reply == "Не удалось открыть файл: /nonexistent/request.txt");
+    assert(client.receive(type, reply) && type == 'E' && reply == "Неизвестный тип запроса");
+    assert(client.receive(type, reply) && type == 'C' && reply == "1");
+    assert(client.receive(type, reply) && type == 'E' && reply == "Задание не найдено: 1");
+
+    // Канал без писателя и огромный файл по пути отклоняются сразу, цикл продолжает обслуживать соединение
+    auto fifoPath = std::filesystem::temp_directory_path() / "remote_stand_test_request.fifo";
+    auto hugePath = std::filesystem::temp_directory_path() / "remote_stand_test_huge.txt";
+    std::filesystem::remove(fifoPath);
+    assert(::mkfifo(fifoPath.c_str(), 0600) == 0);
+    std::ofstream(hugePath.string()) << valid << std::string(4 * REQUEST_FILE_MAX, '#');
+    assert(client.send('P', fifoPath.string()) && client.send('P', hugePath.string()) && client.send('C', "1"));
+    assert(client.receive(type, reply) && type == 'E' && reply == "Не удалось открыть файл: " + fifoPath.string());
+    assert(client.receive(type, reply) && type == 'E' && reply.find("Файл заявки больше") == 0);
+    assert(client.receive(type, reply) && type == 'E' && reply == "Задание не найдено: 1");
+    std::filesystem::remove(fifoPath);
+    std::filesystem::remove(hugePath);
+
+    // Отменить можно только задание, поданное тем же соединением
+    IntakeClient other;
+    assert(other.connectUnix(socketPath, error));
+    assert(client.send('R', valid) && client.receive(type, reply) && (type == 'A' || type == 'Q'));
+    std::string owned = reply.substr(0, reply.find(' '));
+    assert(other.send('C', owned) && other.receive(type, reply) && type == 'E' && reply == "Задание не найдено: " + owned);
+    assert(client.send('C', owned) && client.receive(type, reply) && type == 'C' && reply == owned);
+
+    // Много клиентов TCP одновременно, у каждого по несколько пачек запросов
+    std::atomic<size_t> acknowledged{0};
+    std::vector<std::thread> clients;
+
+    for (int c = 0; c < 32; ++c) {
+        clients.emplace_back([&]() {
+            IntakeClient tcp;
+            std::string clientError;
+            char replyType;
+            std::string clientReply;
+
+            if (!tcp.connectTcp("127.0.0.1", server.tcpPort(), clientError)) {
+                return;
+            }
+
+            for (int batch = 0; batch < 5; ++batch) {
+                std::string frames;
+
+                for (int i = 0; i < 10; ++i) {
+                    appendFrame(frames, 'R', valid);
+                }
+
+                tcp.sendRaw(frames);
+
+                for (int i = 0; i < 10; ++i) {
+                    if (tcp.receive(replyType, clientReply) && replyType == 'A') {
+                        ++acknowledged;
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& thread : clients) {
+        thread.join();
+    }
+
+    assert(acknowledged == 32 * 50);
+    assert(server.acceptedConnections() == 34);
+
+    // Номера завершившихся заданий не накапливаются в долгоживущем соединении
+    IntakeClient longLived;
+    assert(longLived.connectUnix(socketPath, error));
+    size_t trackedBefore = server.trackedTickets();
+
+    for (int i = 0; i < SERVER_TICKETS_PRUNE + 44; ++i) {
+        if (i == 200) {
+            clock.advance(hours(24 * 365));
+        }
+
+        assert(longLived.send('R', valid) && longLived.receive(type, reply) && type == 'A');
+    }
+
+    assert(server.trackedTickets() <= trackedBefore + 100);
+    longLived.disconnect();
+
+    // Путь к файлу на сервере по TCP не принимается
+    IntakeClient remote;
+    assert(remote.connectTcp("127.0.0.1", server.tcpPort(), error));
+    assert(remote.send('P', "/nonexistent/request.txt"));
+    assert(remote.receive(type, reply) && type == 'E' && reply == "Путь к файлу-заявке принимается только через Unix-сокет");
+    remote.disconnect();
+
+    // Подписка на события завершения: события платы приходят кадрами N, неверный фильтр отклоняется
+    IntakeClient subscriber;
+    assert(subscriber.connectUnix(socketPath, error));
+    assert(subscriber.send('S', "group") && subscriber.send('S', "board Arduino Uno"));
+    assert(subscriber.receive(type, reply) && type == 'E');
+    assert(subscriber.receive(type, reply) && type == 'S' && reply == "board Arduino Uno");
+    processor.completionMessage("STM-32", "Petrov", "BIV2", 7);
+    processor.completionMessage("Arduino Uno", "Ivanov", "BIV1", 8);
+    auto completed = duration_cast<milliseconds>(clock.now().time_since_epoch()).count();
+    assert(subscriber.receive(type, reply) && type == 'N' && reply == "8\tIvanov\tBIV1\tArduino Uno\t" + std::to_string(completed));
+    assert(completionHub().subscribers() == 1);
+    subscriber.disconnect();
+
+    while (completionHub().subscribers() != 0) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+
+    // Подписчик, который не читает ответы: после заполнения буфера ответов очередь подписчика
+    // остаётся непустой, но цикл событий не крутится вхолостую
+    IntakeClient stalled;
+    assert(stalled.connectUnix(socketPath, error));
+    assert(stalled.send('S', "all"));
+
+    while (completionHub().subscribers() != 1) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+
+    // События публикуются по одному: каждое забирается из очереди сразу, поэтому буфер ответов
+    // заполняется при пустой очереди, и следующее событие снова выставляет сигнал подписчика.
+    // После заполнения сигнал снимается с epoll, и новые события не будят цикл
+    std::string longName(16 * 1024, 'x');
+    uint64_t published = 0;
+    uint64_t pausedBefore = server.pausedSubscriptionCount();
+    uint64_t idleBefore = server.idleWakeupCount();
+
+    while (server.pausedSubscriptionCount() == pausedBefore) {
+        completionHub().publish(published++, longName, "BIV1", "Arduino Uno", clock.now());
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+
+    for (int i = 0; i < 16; ++i) {
+        completionHub().publish(published++, longName, "BIV1", "Arduino Uno", clock.now());
+    }
+
+    stalled.disconnect();
+
+    while (completionHub().subscribers() != 0) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+
+    assert(server.idleWakeupCount() == idleBefore);
+
+    // Слишком большой запрос отклоняется, соединение закрывается
+    IntakeClient oversized;
+    assert(oversized.connectUnix(socketPath, error));
+    std::string header = {static_cast<char>(0x7f), 0, 0, 0};
+    assert(oversized.sendRaw(header));
+    assert(oversized.receive(type, reply) && type == 'E');
+    assert(!oversized.receive(type, reply));
+
+    server.stop();
+    assert(!std::filesystem::exists(socketPath));
+}
+
+// Пакетное чтение файлов через io_uring без liburing: кольца отображаются в память,
+// чтения всей пачки отправляются и собираются одним вызовом io_uring_enter
+// Если ядро не поддерживает io_uring или он запрещён, available() возвращает false
+class UringReader {
+private:
+    int ring = -1;
+    unsigned entries = 0;
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    void* sqesMemory = MAP_FAILED;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    size_t sqesSize = 0;
+    // Поля очереди отправки и очереди завершений в общей с ядром памяти
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    // Освобождение кольца (после ошибки чтение идёт без io_uring)
+    void release() {
+        if (sqesMemory != MAP_FAILED) {
+            ::munmap(sqesMemory, sqesSize);
+        }
+
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            ::munmap(cqRing, cqRingSize);
+        }
+
+        if (sqRing != MAP_FAILED) {
+            ::munmap(sqRing, sqRingSize);
+        }
+
+        if (ring >= 0) {
+            ::close(ring);
+        }
+
+        ring = -1;
+        sqRing = cqRing = sqesMemory = MAP_FAILED;
+    }
+
+public:
+    // Кольцо на depth одновременных чтений
+    explicit UringReader(unsigned depth = SPOOL_BATCH) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+
+        if (ring < 0) {
+            return;
+        }
+
+        entries = params.sq_entries;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+        if (single) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+        cqRing = single ? sqRing : ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+        sqesMemory = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+
+        if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqesMemory == MAP_FAILED) {
+            release();
+            return;
+        }
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqes = static_cast<io_uring_sqe*>(sqesMemory);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    ~UringReader() {
+        release();
+    }
+
+    UringReader(const UringReader&) = delete;
+    UringReader& operator=(const UringReader&) = delete;
+
+    // Доступен ли io_uring
+    bool available() const {
+        return ring >= 0;
+    }
+
+    // Чтение с начала каждого файла fds[i] до buffers[i].size() байт; results[i] - прочитано байт или -errno
+    // false, если кольцо перестало работать (тогда оно закрывается)
+    bool read(const std::vector<int>& fds, std::vector<std::string>& buffers, std::vector<int>& results) {
+        results.assign(fds.size(), -EIO);
+
+        for (size_t begin = 0; begin < fds.size() && available(); begin += entries) {
+            unsigned count = static_cast<unsigned>(std::min<size_t>(entries, fds.size() - begin));
+            unsigned tail = *sqTail;
+
+            for (unsigned i = 0; i < count; ++i) {
+                unsigned index = (tail + i) & *sqMask;
+                io_uring_sqe& sqe = sqes[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = IORING_OP_READ;
+                sqe.fd = fds[begin + i];
+                sqe.addr = reinterpret_cast<uint64_t>(&buffers[begin + i][0]);
+                sqe.len = static_cast<uint32_t>(buffers[begin + i].size());
+                sqe.off = 0;
+                sqe.user_data = begin + i;
+                sqArray[index] = index;
+            }
+
+            // Ядро видит новые запросы после публикации хвоста очереди отправки
+            __atomic_store_n(sqTail, tail + count, __ATOMIC_RELEASE);
+
+            unsigned unsubmitted = count;
+            unsigned completed = 0;
+
+            while (completed < count) {
+                int submitted = static_cast<int>(::syscall(__NR_io_uring_enter, ring, unsubmitted, count - completed,
+                                                           IORING_ENTER_GETEVENTS, nullptr, 0));
+
+                if (submitted < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+
+                    release();
+                    return false;
+                }
+
+                unsubmitted -= std::min<unsigned>(unsubmitted, static_cast<unsigned>(submitted));
+                unsigned head = *cqHead;
+                unsigned available = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+                for (; head != available; ++head) {
+                    const io_uring_cqe& cqe = cqes[head & *cqMask];
+                    results[cqe.user_data] = cqe.res;
+                    ++completed;
+                }
+
+                __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+            }
+        }
+
+        return available();
+    }
+};
+
+// Приём заявок из каталога-спула: новые файлы отслеживаются через inotify, собираются в пачки
+// и читаются одним обращением к io_uring (без него - потоками на время пачки). Заявки проверяются
+// и планируются в порядке появления файлов, затем файл переименовывается в done/ или rejected/
+// (переименование в пределах файловой системы атомарно). Для отклонённой заявки рядом пишется
+// файл <имя>.error с причиной. Скрытые файлы (начинаются с точки) не обрабатываются, поэтому
+// заявку удобно записать во временный скрытый файл и переименовать
+class SpoolWatcher {
+private:
+    RequestProcessor& processor;
+    std::filesystem::path directory;
+    bool useUring;
+    std::unique_ptr<UringReader> uring;
+    int inotify = -1;
+    int wake = -1;
+    std::thread thread;
+    std::atomic<size_t> accepted{0};
+    std::atomic<size_t> rejected{0};
+    std::atomic<size_t> unmoved{0};
+    std::atomic<size_t> batches{0};
+
+    // Файл подходит для обработки
+    static bool isRequestName(const std::string& name) {
+        return !name.empty() && name[0] != '.';
+    }
+
+    // Перенос файла в каталог target; при совпадении имени к нему добавляется номер
+    // false, если файл не перенесён: он остаётся в спуле, причина записывается в журнал
+    bool moveTo(const std::string& name, const std::string& target, std::filesystem::path& destination) {
+        std::error_code error;
+        destination = directory / target / name;
+
+        for (size_t i = 1; std::filesystem::exists(destination, error); ++i) {
+            destination = directory / target / (name + "." + std::to_string(i));
+        }
+
+        if (!error) {
+            std::filesystem::rename(directory / name, destination, error);
+        }
+
+        if (error) {
+            writeToLog(name + ": не удалось перенести в " + target + ": " + error.message() + "\n");
+            unmoved.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Чтение содержимого файлов пачки; ok[i] = false, если файл прочитать не удалось
+    // Читается не больше REQUEST_FILE_MAX + 1 байт: текст длиннее REQUEST_FILE_MAX означает слишком большой файл
+    // Файлы открываются без ожидания, поэтому канал, оставленный в спуле, не останавливает обработку
+    void readBatch(const std::vector<std::string>& names, std::vector<std::string>& texts, std::vector<bool>& ok) {
+        texts.assign(names.size(), std::string());
+        ok.assign(names.size(), false);
+
+        if (uring && uring->available()) {
+            std::vector<int> fds(names.size(), -1);
+            std::vector<int> results;
+
+            for (size_t i = 0; i < names.size(); ++i) {
+                fds[i] = ::open((directory / names[i]).c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+                texts[i].resize(SPOOL_READ_SIZE);
+                static_assert(SPOOL_READ_SIZE > REQUEST_FILE_MAX, "полный буфер кольца должен означать слишком большой файл");
+            }
+
+            // Неоткрытые файлы в кольцо не отправляются
+            std::vector<int> openFds;
+            std::vector<std::string> buffers;
+            std::vector<size_t> indexes;
+
+            for (size_t i = 0; i < names.size(); ++i) {
+                if (fds[i] >= 0) {
+                    openFds.push_back(fds[i]);
+                    buffers.push_back(std::move(texts[i]));
+                    indexes.push_back(i);
+                }
+            }
+
+            bool ringOk = uring->read(openFds, buffers, results);
+
+            for (size_t j = 0; j < indexes.size(); ++j) {
+                size_t i = indexes[j];
+                texts[i] = std::move(buffers[j]);
+
+                // Ошибка чтения или отказ кольца - файл читается обычным способом; заполненный буфер
+                // уже длиннее REQUEST_FILE_MAX, и файл дальше не читается
+                if (!ringOk || results[j] < 0) {
+                    size_t length = 0;
+                    ok[i] = readFileContents(fds[i], texts[i], length, REQUEST_FILE_MAX);
+                    texts[i].resize(length);
+                } else {
+                    texts[i].resize(static_cast<size_t>(results[j]));
+                    ok[i] = true;
+                }
+
+                ::close(fds[i]);
+            }
+
+            return;
+        }
+
+        // Без io_uring файлы читают несколько потоков, каждый свою часть пачки
+        size_t threadsCount = std::min<size_t>(SPOOL_READ_THREADS, (names.size() + 15) / 16);
+        auto readRange = [&](size_t first, size_t step) {
+            for (size_t i = first; i < names.size(); i += step) {
+                int fd = ::open((directory / names[i]).c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+                if (fd >= 0) {
+                    size_t length = 0;
+                    ok[i] = readFileContents(fd, texts[i], length, REQUEST_FILE_MAX);
+                    texts[i].resize(length);
+                    ::close(fd);
+                }
+            }
+        };
+        std::vector<std::thread> readers;
+
+        for (size_t t = 1; t < threadsCount; ++t) {
+            readers.emplace_back(readRange, t, threadsCount);
+        }
+
+        readRange(0, std::max<size_t>(1, threadsCount));
+
+        for (auto& reader : readers) {
+            reader.join();
+        }
+    }
+
+    // Проверка и планирование пачки в порядке появления файлов
+    void processBatch(std::vector<std::string>& names) {
+        std::vector<std::string> texts;
+        std::vector<bool> ok;
+        readBatch(names, texts, ok);
+        batches.fetch_add(1, std::memory_order_relaxed);
+
+        for (size_t i = 0; i < names.size(); ++i) {
+            // Файл удалён или переименован до чтения
+            if (!ok[i]) {
+                continue;
+            }
+
+            // Повторно поданный текст (новый файл с тем же содержимым) берётся из кэша без проверки
+            // Слишком большой файл не проверяется и не кэшируется
+            ParseResult result;
+
+            if (texts[i].size() > REQUEST_FILE_MAX) {
+                result.error = RequestError::TooLarge;
+                result.detail = names[i];
+            } else {
+                MetricsTimer timer(metrics().parseTime);
+                uint64_t hash;
+                result = parseRequestContents(texts[i], requestFiles(), hash);
+            }
+
+            std::string reason;
+            std::filesystem::path destination;
+
+            if (!result.ok()) {
+                metrics().reject(rejectReason(result.error));
+                reason = describeError(result);
+            } else if (!processor.processRequest(result.request)) {
+                reason = "Нет доступных стендов для платы: " + result.request.boardName;
+            }
+
+            if (reason.empty()) {
+                if (moveTo(names[i], "done", destination)) {
+                    accepted.fetch_add(1, std::memory_order_relaxed);
+                }
+            } else {
+                writeToLog(names[i] + ": " + reason + "\n");
+
+                if (moveTo(names[i], "rejected", destination)) {
+                    std::ofstream(destination.string() + ".error") << reason << "\n";
+                    rejected.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        names.clear();
+    }
+
+    // Файлы, уже лежащие в спуле (появились до запуска или при переполнении очереди inotify)
+    void scan(std::vector<std::string>& names) {
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            std::string name = entry.path().filename().string();
+
+            if (entry.is_regular_file(error) && isRequestName(name) &&
+                std::find(names.begin(), names.end(), name) == names.end()) {
+                names.push_back(name);
+            }
+        }
+
+        std::sort(names.begin(), names.end());
+    }
+
+    // Цикл наблюдения: пачка обрабатывается, когда набралось SPOOL_BATCH файлов
+    // или новые файлы перестали появляться на SPOOL_BATCH_DELAY
+    void run() {
+        std::vector<std::string> names;
+        alignas(inotify_event) char buffer[64 * 1024];
+        scan(names);
+
+        while (true) {
+            pollfd fds[2] = {{inotify, POLLIN, 0}, {wake, POLLIN, 0}};
+            int timeout = names.empty() ? -1 : static_cast<int>(std::chrono::milliseconds(SPOOL_BATCH_DELAY).count());
+            int ready = ::poll(fds, 2, timeout);
+
+            if (ready < 0 && errno != EINTR) {
+                break;
+            }
+
+            if (fds[1].revents & POLLIN) {
+                break;
+            }
+
+            if (ready == 0) {
+                processBatch(names);
+                continue;
+            }
+
+            if (!(fds[0].revents & POLLIN)) {
+                continue;
+            }
+
+            ssize_t length = ::read(inotify, buffer, sizeof(buffer));
+
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    scan(names);
+                } else if (!(event->mask & IN_ISDIR) && event->len > 0 && isRequestName(event->name) &&
+                           std::find(names.begin(), names.end(), event->name) == names.end()) {
+                    // Файл, найденный при просмотре каталога, может прийти и событием
+                    names.emplace_back(event->name);
+                }
+
+                if (names.size() >= SPOOL_BATCH) {
+                    processBatch(names);
+                }
+            }
+        }
+
+        // Файлы, замеченные до остановки, обрабатываются
+        if (!names.empty()) {
+            processBatch(names);
+        }
+    }
+
+public:
+    // Конструктор; useUring = false - чтение потоками даже при доступном io_uring
+    SpoolWatcher(RequestProcessor& processor, const std::string& directory, bool useUring = true)
+        : processor(processor), directory(directory), useUring(useUring) {}
+
+    // Деструктор: останавливает наблюдение
+    ~SpoolWatcher() {
+        stop();
+    }
+
+    SpoolWatcher(const SpoolWatcher&) = delete;
+    SpoolWatcher& operator=(const SpoolWatcher&) = delete;
+
+    // Запуск наблюдения; каталоги done и rejected создаются при необходимости
+    bool start(std::string& error) {
+        std::error_code code;
+        std::filesystem::create_directories(directory / "done", code);
+        std::filesystem::create_directories(directory / "rejected", code);
+
+        if (code) {
+            error = code.message();
+            return false;
+        }
+
+        inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        // Файл готов, когда его закрыли после записи или переместили в спул
+        if (inotify < 0 || wake < 0 || ::inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            error = std::strerror(errno);
+            return false;
+        }
+
+        if (useUring) {
+            uring = std::make_unique<UringReader>();
+        }
+
+        thread = std::thread(&SpoolWatcher::run, this);
+        return true;
+    }
+
+    // Остановка наблюдения
+    void stop() {
+        if (thread.joinable()) {
+            uint64_t one = 1;
+            ssize_t written = ::write(wake, &one, sizeof(one));
+            (void)written;
+            thread.join();
+        }
+
+        if (inotify >= 0) {
+            ::close(inotify);
+            inotify = -1;
+        }
+
+        if (wake >= 0) {
+            ::close(wake);
+            wake = -1;
+        }
+    }
+
+    // Используется ли io_uring
+    bool usesUring() const {
+        return uring && uring->available();
+    }
+
+    // Количество принятых и отклонённых заявок и обработанных пачек
+    size_t acceptedRequests() const {
+        return accepted.load();
+    }
+
+    size_t rejectedRequests() const {
+        return rejected.load();
+    }
+
+    size_t processedBatches() const {
+        return batches.load();
+    }
+
+    // Количество файлов, которые не удалось перенести в done/ или rejected/ (они остались в спуле)
+    size_t unmovedFiles() const {
+        return unmoved.load();
+    }
+};
+
+// Тесты приёма заявок из каталога-спула
+void testSpoolWatcher() {
+    using namespace std::chrono;
+
+    // Чтение пачки через io_uring, если он доступен
+    auto directory = std::filesystem::temp_directory_path() / "remote_stand_test_spool";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    UringReader reader(4);
+
+    if (reader.available()) {
+        std::vector<int> fds;
+        std::vector<std::string> buffers;
+        std::vector<int> results;
+
+        for (int i = 0; i < 6; ++i) {
+            std::string path = (directory / ("read" + std::to_string(i))).string();
+            std::ofstream(path) << std::string(i, 'x');
+            fds.push_back(::open(path.c_str(), O_RDONLY));
+            buffers.emplace_back(16, '\0');
+        }
+
+        assert(reader.read(fds, buffers, results));
+
+        for (int i = 0; i < 6; ++i) {
+            assert(results[i] == i && buffers[i].compare(0, i, std::string(i, 'x')) == 0);
+            ::close(fds[i]);
+            std::filesystem::remove(directory / ("read" + std::to_string(i)));
+        }
+    }
+
+    const std::string valid = "Ivanov\nIvan\nIvanovich\nBIV1\nArduino Uno\nmain.exe\nC:\n";
+
+    // С io_uring и без него: файл, лежавший до запуска, новые файлы, ошибочная заявка и скрытый файл
+    for (bool useUring : {true, false}) {
+        ManualClock clock;
+        StandCluster cluster;
+        cluster.addStand(RemoteStand("Arduino Uno", clock));
+        RequestProcessor processor(cluster, clock);
+        processor.setVerbose(false);
+        processor.setNotifications(false);
+
+        std::ofstream(directory / "early.txt") << valid;
+        SpoolWatcher watcher(processor, directory.string(), useUring);
+        std::string error;
+        assert(watcher.start(error));
+
+        for (int i = 0; i < 40; ++i) {
+            std::ofstream(directory / ("request " + std::to_string(i) + ".txt")) << valid;
+        }
+
+        std::ofstream(directory / "bad.txt") << "Ivanov\nIvan\nIvanovich\nBIV 1\nArduino Uno\nmain.exe\nC:\n";
+        std::ofstream(directory / "huge.txt") << valid << std::string(64 * REQUEST_FILE_MAX, '#');
+        std::ofstream(directory / ".partial") << valid;
+
+        // Перемещение готового файла в спул
+        std::ofstream(directory / ".moved") << valid;
+        std::filesystem::rename(directory / ".moved", directory / "moved.txt");
+
+        auto deadline = steady_clock::now() + seconds(10);
+
+        while (watcher.acceptedRequests() + watcher.rejectedRequests() < 44 && steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(milliseconds(5));
+        }
+
+        watcher.stop();
+        assert(watcher.acceptedRequests() == 42 && watcher.rejectedRequests() == 2 && watcher.unmovedFiles() == 0);
+        assert(watcher.processedBatches() >= 1);
+        assert(std::filesystem::exists(directory / "done" / "early.txt"));
+        assert(std::filesystem::exists(directory / "done" / "request 39.txt"));
+        assert(std::filesystem::exists(directory / "done" / "moved.txt"));
+        assert(std::filesystem::exists(directory / "rejected" / "bad.txt"));
+        assert(std::filesystem::exists(directory / ".partial") && !std::filesystem::exists(directory / "request 0.txt"));
+
+        std::ifstream reasonFile(directory / "rejected" / "bad.txt.error");
+        std::string reason;
+        std::getline(reasonFile, reason);
+        assert(reason == "Ошибка в группе: BIV 1");
+        std::ifstream hugeReason(directory / "rejected" / "huge.txt.error");
+        std::getline(hugeReason, reason);
+        assert(reason == "Файл заявки больше " + std::to_string(REQUEST_FILE_MAX) + " байт: huge.txt");
+        assert(cluster.getStandsByBoard("Arduino Uno")[0].getFreeTime() == clock.now() + 42 * DELAY);
+
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+    }
+
+    // Файл, который не удалось перенести (done/ подменён обычным файлом), не считается принятым
+    {
+        ManualClock clock;
+        StandCluster cluster;
+        cluster.addStand(RemoteStand("Arduino Uno", clock));
+        RequestProcessor processor(cluster, clock);
+        processor.setVerbose(false);
+        processor.setNotifications(false);
+
+        SpoolWatcher watcher(processor, directory.string(), false);
+        std::string error;
+        assert(watcher.start(error));
+        std::filesystem::remove(directory / "done");
+        std::ofstream(directory / "done") << "";
+        std::ofstream(directory / "stuck.txt") << valid;
+
+        auto deadline = steady_clock::now() + seconds(10);
+
+        while (watcher.unmovedFiles() == 0 && steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(milliseconds(5));
+        }
+
+        watcher.stop();
+        assert(watcher.unmovedFiles() == 1 && watcher.acceptedRequests() == 0);
+        assert(std::filesystem::exists(directory / "stuck.txt"));
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+// Способ запуска задания на стенде: по заявке и брони формируются аргументы и окружение процесса
+// Для оборудования это обёртка программы прошивки платы, для проверки на обычной машине - локальный эмулятор
+class BoardBackend {
+public:
+    virtual ~BoardBackend() = default;
+
+    // Аргументы процесса (первый - исполняемый файл) и дополнительные переменные окружения вида "имя=значение"
+    virtual void command(const Request& request, const Reservation& reservation, std::vector<std::string>& arguments,
+                         std::vector<std::string>& environment) const = 0;
+};
+
+// Локальный эмулятор платы: исполняемый файл задания запускается на этой машине,
+// плата, стенд и студент передаются в переменных окружения REMOTE_STAND_*
+class LocalBoardEmulator final : public BoardBackend {
+public:
+    void command(const Request& request, const Reservation& reservation, std::vector<std::string>& arguments,
+                 std::vector<std::string>& environment) const override {
+        arguments = {request.executablePath};
+        environment = {
+            "REMOTE_STAND_BOARD=" + request.boardName,
+            "REMOTE_STAND_INDEX=" + std::to_string(reservation.standIndex),
+            "REMOTE_STAND_STUDENT=" + request.lastName
+        };
+    }
+};
+
+// Исполнитель по названию (пока только local); для неизвестного названия возвращается nullptr
+std::unique_ptr<BoardBackend> makeBoardBackend(const std::string& name) {
+    if (name == "local") {
+        return std::make_unique<LocalBoardEmulator>();
+    }
+
+    return nullptr;
+}
+
+// Выполнение заданий: процесс задания запускается через posix_spawn, когда наступает начало его брони,
+// вывод (stdout и stderr) переносится из канала в файл результата splice без копирования в память программы,
+// по окончании процесса фактическое время завершения сообщается обработчику заявок (reportCompletion),
+// и только тогда рассылается уведомление о завершении. Процесс, работающий дольше брони, продлевает её
+// шагами не короче EXEC_OVERRUN_STEP (RequestProcessor::extendJob), следующие брони стенда переносятся
+// Все процессы обслуживает один поток с epoll: окончание процесса приходит через pidfd, поэтому сотни
+// заданий выполняются без потока на задание. Одновременно выполняется не больше maxJobs заданий
+// и не больше одного задания на стенд: задание, бронь которого началась раньше окончания предыдущего
+// задания стенда, ждёт его. Задание дольше timeout завершается вместе со всей группой процессов,
+// отменённое задание (RequestProcessor::cancelJob) - тоже
+class ExecutionEngine {
+private:
+    // Задание из брони обработчика
+    struct Job {
+        Request request;
+        uint64_t ticket = 0;
+        Reservation reservation;
+    };
+
+    // Выполняющийся процесс задания
+    struct Process {
+        Job job;
+        pid_t pid = -1;
+        int pidfd = -1;
+        int pipe = -1;
+        int output = -1;
+        size_t written = 0;
+        std::chrono::steady_clock::time_point deadline;
+        bool exited = false;
+        // Причина принудительного завершения (таймаут, объём вывода)
+        std::string killed;
+    };
+
+    RequestProcessor& processor;
+    std::unique_ptr<BoardBackend> backend;
+    // Хранилище копий исполняемых файлов (nullptr - файл задания запускается по своему пути)
+    std::atomic<ExecutableCache*> executableCache{nullptr};
+    size_t maxJobs;
+    std::chrono::steady_clock::duration timeout;
+    int epoll = -1;
+    int wake = -1;
+    std::thread thread;
+
+    // Переданные из обработчика задания и признак остановки
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::vector<Job> submitted;
+    std::vector<uint64_t> cancelled;
+    size_t inFlight = 0;
+    bool stopping = false;
+
+    // Состояние потока исполнителя: задания по началу брони, ждущие места в пуле и ждущие своего стенда
+    std::multimap<std::chrono::system_clock::time_point, Job> scheduled;
+    std::deque<Job> ready;
+    std::unordered_map<uint64_t, std::deque<Job>> standQueues;
+    std::unordered_set<uint64_t> busyStands;
+    std::vector<std::unique_ptr<Process>> processes;
+    std::vector<uint32_t> freeProcesses;
+    size_t running = 0;
+
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> failed{0};
+    std::atomic<size_t> timedOut{0};
+    std::atomic<size_t> skipped{0};
+    std::atomic<size_t> aborted{0};
+
+    // Ключ занятости стенда (поколение не нужно: слот занят, пока не завершится его задание)
+    static uint64_t standKey(const Reservation& reservation) {
+        return (static_cast<uint64_t>(reservation.stand.board) << 32) | reservation.stand.slot;
+    }
+
+    // Перенос вывода из канала в файл результата; false, когда канал закрыт писателем
+    bool drain(Process& process) {
+        while (process.pipe >= 0) {
+            ssize_t moved = ::splice(process.pipe, nullptr, process.output, nullptr, EXEC_SPLICE_CHUNK,
+                                     SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+            // Файловая система без splice: обычное чтение и запись через буфер
+            if (moved < 0 && errno == EINVAL) {
+                char buffer[EXEC_SPLICE_CHUNK];
+                moved = ::read(process.pipe, buffer, sizeof(buffer));
+
+                if (moved > 0 && ::write(process.output, buffer, static_cast<size_t>(moved)) != moved) {
+                    moved = -1;
+                }
+            }
+
+            if (moved == 0) {
+                return false;
+            }
+
+            if (moved < 0) {
+                return errno == EAGAIN || errno == EINTR;
+            }
+
+            process.written += static_cast<size_t>(moved);
+
+            if (process.written > EXEC_MAX_OUTPUT && process.killed.empty()) {
+                process.killed = "превышен объём вывода";
+                ::kill(-process.pid, SIGKILL);
+                ::epoll_ctl(epoll, EPOLL_CTL_DEL, process.pipe, nullptr);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Сообщение об итоге задания в журнал
+    void jobMessage(uint64_t ticket, const std::string& text) {
+        writeToLog("Задание " + std::to_string(ticket) + ": " + text + "\n");
+    }
+
+    // Учёт задания, которое больше не выполняется
+    void done() {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (inFlight > 0 && --inFlight == 0) {
+            idle.notify_all();
+        }
+    }
+
+    // Окончание задания: обработчик узнаёт фактическое время завершения, освободившееся время брони доступно другим
+    void finish(Job& job) {
+        processor.reportCompletion(job.request, job.reservation, job.ticket);
+        done();
+    }
+
+    // Освобождение стенда после окончания его процесса: следующее задание стенда ждёт только места в пуле
+    void releaseStand(const Reservation& reservation) {
+        uint64_t key = standKey(reservation);
+        auto waiting = standQueues.find(key);
+        busyStands.erase(key);
+
+        if (waiting != standQueues.end()) {
+            ready.push_front(std::move(waiting->second.front()));
+            waiting->second.pop_front();
+
+            if (waiting->second.empty()) {
+                standQueues.erase(waiting);
+            }
+        }
+    }
+
+    // Запуск процесса задания; при ошибке задание сразу завершается
+    void launch(Job job) {
+        // Номера заявок начинаются заново при перезапуске, поэтому существующий файл результата не перезаписывается
+        std::filesystem::path directory(job.request.resultPath);
+        std::string name = "job-" + std::to_string(job.ticket);
+        std::filesystem::path resultPath = directory / (name + ".log");
+        std::error_code code;
+        std::filesystem::create_directories(directory, code);
+        int output = ::open(resultPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+
+        for (size_t i = 1; output < 0 && errno == EEXIST; ++i) {
+            resultPath = directory / (name + "." + std::to_string(i) + ".log");
+            output = ::open(resultPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        }
+
+        if (output < 0) {
+            jobMessage(job.ticket, "не удалось создать файл результата " + resultPath.string() + ": " + std::strerror(errno));
+            failed.fetch_add(1, std::memory_order_relaxed);
+            finish(job);
+            return;
+        }
+
+        std::vector<std::string> arguments;
+        std::vector<std::string> environment;
+        backend->command(job.request, job.reservation, arguments, environment);
+
+        // Дополнительные переменные идут первыми: getenv находит первое совпадение
+        std::vector<char*> argv;
+        std::vector<char*> envp;
+
+        for (auto& argument : arguments) {
+            argv.push_back(argument.data());
+        }
+
+        for (auto& variable : environment) {
+            envp.push_back(variable.data());
+        }
+
+        for (char** variable = environ; *variable; ++variable) {
+            envp.push_back(*variable);
+        }
+
+        argv.push_back(nullptr);
+        envp.push_back(nullptr);
+
+        int fds[2];
+
+        if (::pipe2(fds, O_CLOEXEC) < 0) {
+            ::close(output);
+            jobMessage(job.ticket, std::string("не удалось создать канал: ") + std::strerror(errno));
+            failed.fetch_add(1, std::memory_order_relaxed);
+            finish(job);
+            return;
+        }
+
+        // Процесс получает стандартный ввод из /dev/null, вывод в канал, свою группу и сигналы по умолчанию
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], 1);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], 2);
+
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        sigset_t signals;
+        sigemptyset(&signals);
+        posix_spawnattr_setsigmask(&attributes, &signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        sigaddset(&signals, SIGPIPE);
+        posix_spawnattr_setsigdefault(&attributes, &signals);
+        posix_spawnattr_setpgroup(&attributes, 0);
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+        // Неизменённый исполняемый файл запускается из хранилища без повторного копирования;
+        // копия могла быть вытеснена между выдачей и запуском - тогда запускается исходный файл
+        std::string staged;
+        ExecutableCache* cache = executableCache.load();
+        pid_t pid;
+        int result = ENOENT;
+
+        if (cache && cache->stage(arguments[0], staged)) {
+            result = posix_spawn(&pid, staged.c_str(), &actions, &attributes, argv.data(), envp.data());
+        }
+
+        if (result == ENOENT) {
+            result = posix_spawn(&pid, argv[0], &actions, &attributes, argv.data(), envp.data());
+        }
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attributes);
+        ::close(fds[1]);
+
+        if (result != 0) {
+            std::string message = "Не удалось запустить " + arguments[0] + ": " + std::strerror(result) + "\n";
+            ssize_t written = ::write(output, message.data(), message.size());
+            (void)written;
+            ::close(output);
+            ::close(fds[0]);
+            jobMessage(job.ticket, message.substr(0, message.size() - 1));
+            failed.fetch_add(1, std::memory_order_relaxed);
+            finish(job);
+            return;
+        }
+
+        uint32_t index;
+
+        if (!freeProcesses.empty()) {
+            index = freeProcesses.back();
+            freeProcesses.pop_back();
+        } else {
+            index = static_cast<uint32_t>(processes.size());
+            processes.emplace_back();
+        }
+
+        processes[index] = std::make_unique<Process>();
+        Process& process = *processes[index];
+        process.job = std::move(job);
+        process.pid = pid;
+        process.pipe = fds[0];
+        process.output = output;
+        process.deadline = std::chrono::steady_clock::now() + timeout;
+        ::fcntl(process.pipe, F_SETFL, O_NONBLOCK);
+#ifdef SYS_pidfd_open
+        process.pidfd = static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#endif
+
+        // В событии epoll: номер процесса и признак pidfd в младшем бите
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = static_cast<uint64_t>(index) << 1;
+        ::epoll_ctl(epoll, EPOLL_CTL_ADD, process.pipe, &event);
+
+        if (process.pidfd >= 0) {
+            event.data.u64 |= 1;
+            ::epoll_ctl(epoll, EPOLL_CTL_ADD, process.pidfd, &event);
+        }
+
+        busyStands.insert(standKey(process.job.reservation));
+        ++running;
+    }
+
+    // Завершение учёта процесса после его окончания
+    void reap(uint32_t index, int status) {
+        Process& process = *processes[index];
+        drain(process);
+        ::close(process.pipe);
+        ::close(process.output);
+
+        if (process.pidfd >= 0) {
+            ::close(process.pidfd);
+        }
+
+        if (!process.killed.empty()) {
+            jobMessage(process.job.ticket, "прервано (" + process.killed + ")");
+            (process.killed == "таймаут" ? timedOut : process.killed == "отменено" ? aborted : failed)
+                .fetch_add(1, std::memory_order_relaxed);
+        } else if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            jobMessage(process.job.ticket, "выполнено");
+            completed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            jobMessage(process.job.ticket, WIFEXITED(status) ? "код завершения " + std::to_string(WEXITSTATUS(status))
+                                                             : "завершено сигналом " + std::to_string(WTERMSIG(status)));
+            failed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Job job = std::move(process.job);
+        processes[index].reset();
+        freeProcesses.push_back(index);
+        --running;
+        releaseStand(job.reservation);
+        finish(job);
+    }
+
+    // Проверка окончания процесса (с ожиданием, если block); true, если процесс завершился и учтён
+    // Процессы, оставшиеся в группе задания, завершаются до того, как процесс пожат: пока он не пожат,
+    // номер группы занят им, а после waitpid мог бы достаться чужой группе
+    bool tryReap(uint32_t index, bool block = false) {
+        pid_t pid = processes[index]->pid;
+        siginfo_t info{};
+        int result;
+
+        do {
+            result = ::waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOWAIT | (block ? 0 : WNOHANG));
+        } while (result != 0 && errno == EINTR);
+
+        if (result != 0 || info.si_pid != pid) {
+            return false;
+        }
+
+        ::kill(-pid, SIGKILL);
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        reap(index, status);
+        return true;
+    }
+
+    // Задание, бронь которого началась: отменённое пропускается, перенесённое ждёт нового начала
+    void admit(Job job, std::chrono::system_clock::time_point now) {
+        Reservation current;
+
+        if (processor.jobReservation(job.ticket, current)) {
+            if (current.startTime > now && current.startTime != job.reservation.startTime) {
+                job.reservation = current;
+                scheduled.emplace(current.startTime, std::move(job));
+                return;
+            }
+
+            job.reservation = current;
+        } else if (job.reservation.freeTime > now) {
+            jobMessage(job.ticket, "отменено до запуска");
+            skipped.fetch_add(1, std::memory_order_relaxed);
+            done();
+            return;
+        }
+
+        uint64_t key = standKey(job.reservation);
+
+        if (busyStands.count(key)) {
+            standQueues[key].push_back(std::move(job));
+        } else {
+            ready.push_back(std::move(job));
+        }
+    }
+
+    // Продление броней процессов, работающих дольше брони; продление выполняется раньше выдачи заданий,
+    // чьи брони начинаются в окончание продлеваемой: они переносятся, а не ждут стенда
+    void extendOverruns(std::chrono::system_clock::time_point now) {
+        for (const auto& process : processes) {
+            if (!process || !process->killed.empty() || process->job.reservation.freeTime > now) {
+                continue;
+            }
+
+            Reservation& reservation = process->job.reservation;
+            auto step = std::max<std::chrono::system_clock::duration>(reservation.freeTime - reservation.startTime, EXEC_OVERRUN_STEP);
+
+            // Задания уже нет (отменено): процесс прерывается обработчиком отмены, продлевать нечего
+            if (!processor.extendJob(process->job.ticket, now + step, reservation)) {
+                reservation.freeTime = std::chrono::system_clock::time_point::max();
+            }
+        }
+    }
+
+    // Прерывание процессов отменённых заданий; ещё не запущенные задания пропускаются при запуске
+    void abort(const std::vector<uint64_t>& tickets) {
+        for (uint64_t ticket : tickets) {
+            for (const auto& process : processes) {
+                if (process && process->job.ticket == ticket && process->killed.empty()) {
+                    process->killed = "отменено";
+                    ::kill(-process->pid, SIGKILL);
+                }
+            }
+        }
+    }
+
+    // Цикл потока исполнителя
+    void run() {
+        std::vector<epoll_event> events(EXEC_MAX_EVENTS);
+
+        while (true) {
+            std::vector<Job> incoming;
+            std::vector<uint64_t> cancels;
+            bool stop;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                incoming.swap(submitted);
+                cancels.swap(cancelled);
+                stop = stopping;
+            }
+
+            if (stop) {
+                break;
+            }
+
+            for (auto& job : incoming) {
+                scheduled.emplace(job.reservation.startTime, std::move(job));
+            }
+
+            abort(cancels);
+            auto now = std::chrono::system_clock::now();
+            extendOverruns(now);
+
+            while (!scheduled.empty() && scheduled.begin()->first <= now) {
+                Job job = std::move(scheduled.begin()->second);
+                scheduled.erase(scheduled.begin());
+                admit(std::move(job), now);
+            }
+
+            // Задание, чей стенд занят (например, вернулся в ready после переноса), ждёт этот стенд;
+            // задание, отменённое, пока оно ждало стенда или места в пуле, не запускается
+            while (running < maxJobs && !ready.empty()) {
+                Job job = std::move(ready.front());
+                ready.pop_front();
+                uint64_t key = standKey(job.reservation);
+                Reservation current;
+
+                if (!processor.jobReservation(job.ticket, current)) {
+                    jobMessage(job.ticket, "отменено до запуска");
+                    skipped.fetch_add(1, std::memory_order_relaxed);
+                    done();
+                } else if (busyStands.count(key)) {
+                    standQueues[key].push_back(std::move(job));
+                } else {
+                    launch(std::move(job));
+                }
+            }
+
+            // Ожидание до ближайшего начала брони, окончания брони выполняющегося задания или таймаута;
+            // без pidfd процессы проверяются периодически
+            auto steadyNow = std::chrono::steady_clock::now();
+            auto wait = std::chrono::milliseconds(EXEC_MAX_WAIT);
+            bool polling = false;
+
+            if (!scheduled.empty()) {
+                wait = std::min(wait, std::chrono::ceil<std::chrono::milliseconds>(scheduled.begin()->first - now));
+            }
+
+            for (const auto& process : processes) {
+                if (process) {
+                    polling = polling || process->pidfd < 0;
+
+                    if (process->killed.empty()) {
+                        wait = std::min(wait, std::chrono::ceil<std::chrono::milliseconds>(process->deadline - steadyNow));
+
+                        if (process->job.reservation.freeTime != std::chrono::system_clock::time_point::max()) {
+                            wait = std::min(wait, std::chrono::ceil<std::chrono::milliseconds>(process->job.reservation.freeTime - now));
+                        }
+                    }
+                }
+            }
+
+            if (polling) {
+                wait = std::min(wait, std::chrono::milliseconds(EXEC_POLL_INTERVAL));
+            }
+
+            int count = ::epoll_wait(epoll, events.data(), static_cast<int>(events.size()),
+                                     static_cast<int>(std::max<int64_t>(0, wait.count())));
+
+            for (int i = 0; i < count; ++i) {
+                if (events[i].data.u64 == UINT64_MAX) {
+                    uint64_t value;
+                    ssize_t received = ::read(wake, &value, sizeof(value));
+                    (void)received;
+                    continue;
+                }
+
+                uint32_t index = static_cast<uint32_t>(events[i].data.u64 >> 1);
+
+                // Процесс мог быть учтён раньше в этой же пачке событий
+                if (index >= processes.size() || !processes[index]) {
+                    continue;
+                }
+
+                if (events[i].data.u64 & 1) {
+                    tryReap(index);
+                } else if (!drain(*processes[index])) {
+                    ::epoll_ctl(epoll, EPOLL_CTL_DEL, processes[index]->pipe, nullptr);
+                }
+            }
+
+            // Таймауты и процессы без pidfd
+            steadyNow = std::chrono::steady_clock::now();
+
+            for (uint32_t i = 0; i < processes.size(); ++i) {
+                if (!processes[i]) {
+                    continue;
+                }
+
+                Process& process = *processes[i];
+
+                if (process.killed.empty() && process.deadline <= steadyNow) {
+                    process.killed = "таймаут";
+                    ::kill(-process.pid, SIGKILL);
+                }
+
+                if (process.pidfd < 0) {
+                    tryReap(i);
+                }
+            }
+        }
+
+        // Остановка: выполняющиеся задания прерываются, ещё не начавшиеся не запускаются
+        for (uint32_t i = 0; i < processes.size(); ++i) {
+            if (processes[i]) {
+                processes[i]->killed = "остановка";
+                ::kill(-processes[i]->pid, SIGKILL);
+                tryReap(i, true);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight = 0;
+        idle.notify_all();
+    }
+
+public:
+    // Исполнитель заданий обработчика: бронирования обработчика становятся заданиями исполнителя
+    ExecutionEngine(RequestProcessor& processor, std::unique_ptr<BoardBackend> backend, size_t maxJobs = EXEC_MAX_JOBS,
+                    std::chrono::steady_clock::duration timeout = EXEC_TIMEOUT)
+        : processor(processor), backend(std::move(backend)), maxJobs(std::max<size_t>(1, maxJobs)), timeout(timeout) {
+        epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = UINT64_MAX;
+        ::epoll_ctl(epoll, EPOLL_CTL_ADD, wake, &event);
+        thread = std::thread(&ExecutionEngine::run, this);
+
+        // Обработчики вызываются под блокировкой очередей обработчика заявок и только передают задание или отмену потоку
+        processor.setCompletionByExit(true);
+        processor.setDispatchHandler([this](const RequestView& request, uint64_t ticket, std::chrono::system_clock::time_point,
+                                            const Reservation& reservation) {
+            submit(Job{request.toRequest(), ticket, reservation});
+        });
+        processor.setCancelHandler([this](uint64_t ticket) { cancel(ticket); });
+    }
+
+    // Деструктор: останавливает исполнитель
+    ~ExecutionEngine() {
+        stop();
+        ::close(epoll);
+        ::close(wake);
+    }
+
+    ExecutionEngine(const ExecutionEngine&) = delete;
+    ExecutionEngine& operator=(const ExecutionEngine&) = delete;
+
+    // Запуск исполняемых файлов заданий через кэш cache (nullptr - без кэша)
+    void setExecutableCache(ExecutableCache* cache) {
+        executableCache.store(cache);
+    }
+
+    // Передача задания потоку исполнителя
+    void submit(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (stopping) {
+                return;
+            }
+
+            submitted.push_back(std::move(job));
+            ++inFlight;
+        }
+
+        uint64_t one = 1;
+        ssize_t written = ::write(wake, &one, sizeof(one));
+        (void)written;
+    }
+
+    // Прерывание процесса отменённого задания ticket (вместе с группой процессов)
+    void cancel(uint64_t ticket) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (stopping) {
+                return;
+            }
+
+            cancelled.push_back(ticket);
+        }
+
+        uint64_t one = 1;
+        ssize_t written = ::write(wake, &one, sizeof(one));
+        (void)written;
+    }
+
+    // Ожидание окончания всех переданных заданий; false, если время ожидания истекло
+    bool waitIdle(std::chrono::steady_clock::duration limit) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return idle.wait_for(lock, limit, [this]() { return inFlight == 0; });
+    }
+
+    // Остановка: выполняющиеся задания прерываются, ожидающие не запускаются
+    // Возвращает количество заданий, не выполненных до конца
+    size_t stop() {
+        size_t unfinished;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (stopping) {
+                return 0;
+            }
+
+            stopping = true;
+            unfinished = inFlight;
+        }
+
+        processor.setDispatchHandler(nullptr);
+        processor.setCancelHandler(nullptr);
+        uint64_t one = 1;
+        ssize_t written = ::write(wake, &one, sizeof(one));
+        (void)written;
+
+        if (thread.joinable()) {
+            thread.join();
+        }
+
+        processor.setCompletionByExit(false);
+        return unfinished;
+    }
+
+    // Итоги: выполнено успешно, с ошибкой, прервано по таймауту, отменено до запуска, прервано отменой
+    size_t completedJobs() const {
+        return completed.load();
+    }
+
+    size_t failedJobs() const {
+        return failed.load();
+    }
+
+    size_t timedOutJobs() const {
+        return timedOut.load();
+    }
+
+    size_t skippedJobs() const {
+        return skipped.load();
+    }
+
+    size_t cancelledJobs() const {
+        return aborted.load();
+    }
+};
+
+// Тесты исполнителя заданий
+void testExecutionEngine() {
+    using namespace std::chrono;
+
+    auto directory = std::filesystem::temp_directory_path() / "remote_stand_test_exec";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    // Скрипт задания с окружением эмулятора
+    auto script = [&directory](const std::string& name, const std::string& body) {
+        std::string path = (directory / name).string();
+        std::ofstream(path) << "#!/bin/sh\n" << body << "\n";
+        std::filesystem::permissions(path, std::filesystem::perms::owner_all);
+        return path;
+    };
+
+    auto result = [&directory](uint64_t ticket) {
+        std::ifstream file(directory / "out" / ("job-" + std::to_string(ticket) + ".log"));
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+
+    std::string resultPath = (directory / "out").string();
+    StandCluster cluster;
+    cluster.addStand(RemoteStand("Arduino Uno", systemClock()));
+    cluster.addStand(RemoteStand("Arduino Uno", systemClock()));
+    RequestProcessor processor(cluster);
+    processor.setVerbose(false);
+    processor.setNotifications(false);
+    uint64_t ticket;
+    uint64_t missing;
+    Reservation reservation;
+
+    // Вывод задания попадает в файл результата, стенд освобождается по фактическому завершению
+    {
+        ExecutionEngine engine(processor, makeBoardBackend("local"));
+        Request request{"Ivanov", "Ivan", "Ivanovich", "BIV1", "Arduino Uno",
+                        script("ok.sh", "echo \"out $REMOTE_STAND_BOARD $REMOTE_STAND_STUDENT\"\necho err >&2"), resultPath};
+
+        assert(processor.processRequest(request, ticket));
+        assert(processor.jobReservation(ticket, reservation));
+        request.executablePath = (directory / "missing").string();
+        assert(processor.processRequest(request, missing));
+        assert(engine.waitIdle(seconds(10)));
+
+        assert(engine.completedJobs() == 1 && engine.failedJobs() == 1);
+        assert(result(ticket) == "out Arduino Uno Ivanov\nerr\n");
+        assert(result(missing).find("Не удалось запустить") == 0);
+        assert(cluster.getStandsByBoard("Arduino Uno")[reservation.standIndex].getFreeTime() < reservation.freeTime);
+    }
+
+    // Исполняемый файл запускается из хранилища копий, повторная подача того же файла не копирует его заново
+    {
+        ExecutableCache cache;
+        std::string error;
+        std::string store = (directory / "store").string();
+        assert(cache.setStore(store, error));
+        ExecutionEngine engine(processor, makeBoardBackend("local"));
+        engine.setExecutableCache(&cache);
+        Request request{"Ivanov", "Ivan", "Ivanovich", "BIV1", "Arduino Uno", script("staged.sh", "echo \"$0\""), resultPath};
+        uint64_t again;
+        std::this_thread::sleep_for(CACHE_SETTLE_TIME);
+
+        assert(processor.processRequest(request, ticket) && processor.processRequest(request, again));
+        assert(engine.waitIdle(seconds(10)));
+        assert(engine.completedJobs() == 2 && result(ticket) == result(again) && result(ticket).find(store) == 0);
+        assert(cache.storeCache().size() == 1 && cache.storeCache().hits() == 1);
+    }
+
+    // Задание дольше таймаута прерывается вместе с дочерними процессами
+    {
+        ExecutionEngine engine(processor, makeBoardBackend("local"), 4, milliseconds(200));
+        Request request{"Ivanov", "Ivan", "Ivanovich", "BIV1", "Arduino Uno", script("sleep.sh", "echo start\nsleep 30"), resultPath};
+        auto start = steady_clock::now();
+
+        assert(processor.processRequest(request, ticket));
+        assert(engine.waitIdle(seconds(10)));
+        assert(engine.timedOutJobs() == 1 && steady_clock::now() - start < seconds(5));
+        assert(result(ticket) == "start\n");
+    }
+
+    // Задание, отменённое до начала брони, не запускается
+    {
+        StandCluster busy;
+        busy.addStand(RemoteStand("Arduino Uno", system_clock::now() + milliseconds(300)));
+        RequestProcessor busyProcessor(busy);
+        busyProcessor.setVerbose(false);
+        busyProcessor.setNotifications(false);
+        ExecutionEngine engine(busyProcessor, makeBoardBackend("local"));
+        Request request{"Ivanov", "Ivan", "Ivanovich", "BIV1", "Arduino Uno", script("never.sh", "echo ran"),
+                        (directory / "never").string()};
+
+        assert(busyProcessor.processRequest(request, ticket) && busyProcessor.cancelJob(ticket));
+        assert(engine.waitIdle(seconds(10)));
+        assert(engine.skippedJobs() == 1 && engine.completedJobs() == 0);
+        assert(!std::filesystem::exists(directory / "never"));
+    }
+
+    // Задание дольше брони: стенд остаётся занят до окончания процесса, следующая бронь стенда переносится,
+    // событие завершения приходит по окончании процесса. Отмена выполняющегося задания прерывает его процесс
+    {
+        StandCluster single;
+        single.addStand(RemoteStand("Board O", systemClock()));
+        RequestProcessor overrunProcessor(single);
+        overrunProcessor.setVerbose(false);
+        Request request{"Ivanov", "Ivan", "Ivanovich", "BIV1", "Board O", script("overrun.sh", "sleep 0.6\necho late"),
+                        (directory / "overrun").string()};
+        Reservation past;
+        past.startTime = system_clock::now() - milliseconds(100);
+
+        // Модель предсказывает 0.1 с, процесс работает 0.6 с
+        for (int i = 0; i < ESTIMATOR_MIN_SAMPLES; ++i) {
+            overrunProcessor.reportCompletion(request, past);
+        }
+
+        CompletionFilter filter;
+        assert(filter.parse("board Board O"));
+        auto events = completionHub().subscribe(filter);
+        ExecutionEngine engine(overrunProcessor, makeBoardBackend("local"));
+        uint64_t first;
+        uint64_t second;
+        Reservation booked;
+
+        assert(overrunProcessor.processRequest(request, first) && overrunProcessor.processRequest(request, second));
+        assert(overrunProcessor.jobReservation(second, booked) && booked.startTime < system_clock::now() + milliseconds(200));
+        std::this_thread::sleep_for(milliseconds(300));
+
+        Reservation extended;
+        Reservation moved;
+        Reservation third;
+        assert(events->pending() == 0);
+        assert(overrunProcessor.jobReservation(first, extended) && extended.freeTime > system_clock::now());
+        assert(overrunProcessor.jobReservation(second, moved) && moved.startTime >= extended.freeTime);
+        assert(overrunProcessor.processRequest(request, third) && third.startTime >= extended.freeTime);
+        assert(overrunProcessor.cancelJob(first));
+        assert(engine.waitIdle(seconds(10)));
+        assert(engine.cancelledJobs() == 1 && engine.completedJobs() == 2);
+        assert(std::filesystem::file_size(directory / "overrun" / ("job-" + std::to_string(first) + ".log")) == 0);
+
+        std::vector<std::shared_ptr<const CompletionEvent>> completions;
+        uint64_t dropped = 0;
+        assert(events->take(completions, 16, dropped) == 2 && completions[0]->ticket == second);
+        completionHub().unsubscribe(events);
+    }
+
+    // Сотни одновременных заданий обслуживает один поток исполнителя
+    {
+        StandCluster many;
+
+        for (int i = 0; i < 200; ++i) {
+            many.addStand(RemoteStand("STM-32", systemClock()));
+        }
+
+        RequestProcessor manyProcessor(many);
+        manyProcessor.setVerbose(false);
+        manyProcessor.setNotifications(false);
+        ExecutionEngine engine(manyProcessor, makeBoardBackend("local"));
+        Request request{"Ivanov", "Ivan", "Ivanovich", "BIV1", "STM-32", script("short.sh", "sleep 0.3\necho done"), resultPath};
+        auto start = steady_clock::now();
+
+        for (int i = 0; i < 200; ++i) {
+            assert(manyProcessor.processRequest(request));
+        }
+
+        assert(engine.waitIdle(seconds(20)));
+        assert(engine.completedJobs() == 200 && steady_clock::now() - start < seconds(5));
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+// Построчное чтение из файлового дескриптора крупными блоками
+// Строки возвращаются как std::string_view внутри буфера и действительны до следующего вызова next
+// Строка длиннее LINE_READER_MAX_LINE байт не накапливается: next возвращает её пустой с отметкой tooLong,
+// а остаток строки до перевода строки пропускается
+class LineReader {
+private:
+    int fd;
+    std::string buffer;
+    // Начало непрочитанных данных и конец заполненной части буфера
+    size_t begin = 0;
+    size_t end = 0;
+    bool eof = false;
+    // Последняя строка оказалась слишком длинной, её остаток ещё не пропущен
+    bool overflow = false;
+    bool skipping = false;
+
+    // Отрезание перевода строки Windows
+    static std::string_view trimCarriageReturn(std::string_view line) {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        return line;
+    }
+
+    // Дочитывание данных после end; при ошибке или конце файла выставляется eof
+    void fill() {
+        while (true) {
+            ssize_t count = ::read(fd, &buffer[end], buffer.size() - end);
+
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (count <= 0) {
+                eof = true;
+            } else {
+                end += static_cast<size_t>(count);
+            }
+
+            return;
+        }
+    }
+
+public:
+    // Конструктор
+    explicit LineReader(int fd) : fd(fd), buffer(LINE_READER_CHUNK, '\0') {}
+
+    // Следующая строка без перевода строки, false при окончании данных
+    bool next(std::string_view& line) {
+        overflow = false;
+
+        while (true) {
+            const char* start = buffer.data() + begin;
+            const char* newline = static_cast<const char*>(std::memchr(start, '\n', end - begin));
+
+            // Остаток слишком длинной строки отбрасывается, не занимая буфер
+            if (skipping) {
+                if (newline) {
+                    begin += newline - start + 1;
+                    skipping = false;
+                    continue;
+                }
+
+                begin = end = 0;
+
+                if (eof) {
+                    return false;
+                }
+
+                fill();
+                continue;
+            }
+
+            if (newline) {
+                line = trimCarriageReturn(std::string_view(start, newline - start));
+                begin += newline - start + 1;
+                return true;
+            }
+
+            if (eof) {
+                if (begin == end) {
+                    return false;
+                }
+
+                // Последняя строка без перевода строки
+                line = trimCarriageReturn(std::string_view(start, end - begin));
+                begin = end;
+                return true;
+            }
+
+            // Незаконченная строка переносится в начало буфера, буфер растёт только под очень длинные строки
+            if (begin > 0) {
+                std::memmove(&buffer[0], start, end - begin);
+                end -= begin;
+                begin = 0;
+            }
+
+            if (end > LINE_READER_MAX_LINE) {
+                line = std::string_view();
+                begin = end = 0;
+                overflow = true;
+                skipping = true;
+                return true;
+            }
+
+            if (end == buffer.size()) {
+                buffer.resize(std::min<size_t>(buffer.size() * 2, LINE_READER_MAX_LINE + 1));
+            }
+
+            fill();
+        }
+    }
+
+    // Была ли последняя строка длиннее LINE_READER_MAX_LINE байт
+    bool tooLong() const {
+        return overflow;
+    }
+};
+
+// Пропуск пробельных символов JSON
+inline void skipJsonSpaces(std::string_view text, size_t& pos) {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n')) {
+        ++pos;
+    }
+}
+
+// Запись символа Unicode в UTF-8
+void appendUtf8(std::string& out, uint32_t symbol) {
+    if (symbol < 0x80) {
+        out += static_cast<char>(symbol);
+    } else if (symbol < 0x800) {
+        out += static_cast<char>(0xC0 | (symbol >> 6));
+        out += static_cast<char>(0x80 | (symbol & 0x3F));
+    } else if (symbol < 0x10000) {
+        out += static_cast<char>(0xE0 | (symbol >> 12));
+        out += static_cast<char>(0x80 | ((symbol >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (symbol & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (symbol >> 18));
+        out += static_cast<char>(0x80 | ((symbol >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((symbol >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (symbol & 0x3F));
+    }
+}
+
+// Чтение четырёх шестнадцатеричных цифр escape-последовательности \uXXXX
+bool parseJsonHex(std::string_view text, size_t pos, uint32_t& value) {
+    if (pos + 4 > text.size()) {
+        return false;
+    }
+
+    value = 0;
+
+    for (size_t i = pos; i < pos + 4; ++i) {
+        char c = text[i];
+        value <<= 4;
+
+        if (c >= '0' && c <= '9') {
+            value |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            value |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            value |= c - 'A' + 10;
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Разбор строки JSON начиная с открывающей кавычки, результат дописывается в out
+bool parseJsonString(std::string_view text, size_t& pos, std::string& out) {
+    if (pos >= text.size() || text[pos] != '"') {
+        return false;
+    }
+
+    ++pos;
+
+    while (pos < text.size()) {
+        // Участок без escape-последовательностей копируется целиком
+        size_t stop = text.find_first_of("\"\\", pos);
+
+        if (stop == std::string_view::npos) {
+            return false;
+        }
+
+        out.append(text.data() + pos, stop - pos);
+        pos = stop;
+
+        if (text[pos] == '"') {
+            ++pos;
+            return true;
+        }
+
+        if (pos + 1 >= text.size()) {
+            return false;
+        }
+
+        char escape = text[pos + 1];
+        pos += 2;
+
+        switch (escape) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+            uint32_t symbol;
+
+            if (!parseJsonHex(text, pos, symbol)) {
+                return false;
+            }
+
+            pos += 4;
+
+            // Суррогатная пара UTF-16
+            if (symbol >= 0xD800 && symbol <= 0xDBFF) {
+                uint32_t low;
+
+                if (pos + 6 > text.size() || text[pos] != '\\' || text[pos + 1] != 'u' ||
+                    !parseJsonHex(text, pos + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                    return false;
+                }
+
+                symbol = 0x10000 + ((symbol - 0xD800) << 10) + (low - 0xDC00);
+                pos += 6;
+            }
+
+            appendUtf8(out, symbol);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    return false;
+}
+
+// Разбор строки JSON Lines с заявкой: плоский объект, поля заявки - строки, прочие поля пропускаются
+// Поля записываются в переиспользуемую заявку, поэтому после первых записей память почти не выделяется
+bool parseJsonRequest(std::string_view line, Request& request, std::string& error) {
+    std::string* fields[7] = {
+        &request.lastName, &request.firstName, &request.patronymic, &request.group,
+        &request.boardName, &request.executablePath, &request.resultPath
+    };
+    static const std::string_view names[7] = {
+        "lastName", "firstName", "patronymic", "group", "boardName", "executablePath", "resultPath"
+    };
+
+    for (auto* field : fields) {
+        field->clear();
+    }
+
+    thread_local std::string key;
+    size_t pos = 0;
+    skipJsonSpaces(line, pos);
+
+    if (pos >= line.size() || line[pos] != '{') {
+        error = "ожидался объект JSON";
+        return false;
+    }
+
+    ++pos;
+    skipJsonSpaces(line, pos);
+
+    if (pos < line.size() && line[pos] == '}') {
+        ++pos;
+    } else {
+        while (true) {
+            key.clear();
+            skipJsonSpaces(line, pos);
+
+            if (!parseJsonString(line, pos, key)) {
+                error = "ошибка в имени поля";
+                return false;
+            }
+
+            skipJsonSpaces(line, pos);
+
+            if (pos >= line.size() || line[pos] != ':') {
+                error = "ожидалось двоеточие после поля " + key;
+                return false;
+            }
+
+            ++pos;
+            skipJsonSpaces(line, pos);
+
+            size_t index = std::find(std::begin(names), std::end(names), key) - std::begin(names);
+
+            if (pos < line.size() && line[pos] == '"') {
+                std::string ignored;
+
+                // Повторное поле заменяет прежнее значение
+                if (index < 7) {
+                    fields[index]->clear();
+                }
+
+                if (!parseJsonString(line, pos, index < 7 ? *fields[index] : ignored)) {
+                    error = "ошибка в значении поля " + key;
+                    return false;
+                }
+            } else if (index < 7) {
+                error = "поле " + key + " должно быть строкой";
+                return false;
+            } else {
+                // Числа, true, false и null у посторонних полей пропускаются, вложенные значения не поддерживаются
+                size_t stop = line.find_first_of(",}", pos);
+
+                if (stop == std::string_view::npos || line.substr(pos, stop - pos).find_first_of("{[\"") != std::string_view::npos) {
+                    error = "неподдерживаемое значение поля " + key;
+                    return false;
+                }
+
+                pos = stop;
+            }
+
+            skipJsonSpaces(line, pos);
+
+            if (pos < line.size() && line[pos] == ',') {
+                ++pos;
+                continue;
+            }
+
+            if (pos < line.size() && line[pos] == '}') {
+                ++pos;
+                break;
+            }
+
+            error = "ожидалась запятая или конец объекта";
+            return false;
+        }
+    }
+
+    skipJsonSpaces(line, pos);
+
+    if (pos != line.size()) {
+        error = "лишние символы после объекта";
+        return false;
+    }
+
+    return true;
+}
+
+// Итоги пакетного импорта
+struct BulkReport {
+    size_t lines = 0;
+    size_t scheduled = 0;
+    size_t rejected = 0;
+    double elapsed = 0;
+};
+
+// Пакетный импорт заявок в формате JSON Lines из файлового дескриптора
+// Файл читается потоково, заявки проверяются сразу, а планируются пачками по BULK_BATCH_SIZE
+// Ошибочные строки записываются в rejects с номером строки
+// Строка разбирается в переиспользуемую заявку, проверенная заявка копируется в арену пачки
+// (плата и группа интернируются), арена освобождается после планирования пачки. Обработчик
+// копирует заявку, только если она остаётся в очереди, поэтому память на заявку почти не выделяется
+BulkReport importJsonLines(int fd, RequestProcessor& processor, std::ostream& rejects) {
+    BulkReport report;
+    LineReader reader(fd);
+    Request request;
+    RequestArena arena;
+    std::vector<RequestView> batch(BULK_BATCH_SIZE);
+    std::vector<size_t> batchLines(BULK_BATCH_SIZE);
+    size_t batchSize = 0;
+    std::string error;
+    std::string_view line;
+    auto begin = std::chrono::steady_clock::now();
+
+    // Планирование накопленной пачки
+    auto flush = [&]() {
+        for (size_t i = 0; i < batchSize; ++i) {
+            if (processor.processRequest(batch[i])) {
+                ++report.scheduled;
+            } else {
+                ++report.rejected;
+                rejects << batchLines[i] << "\tНет доступных стендов для платы: " << batch[i].boardName << "\n";
+            }
+        }
+
+        batchSize = 0;
+        arena.reset();
+    };
+
+    while (reader.next(line)) {
+        ++report.lines;
+
+        if (reader.tooLong()) {
+            ++report.rejected;
+            metrics().reject(RejectReason::Json);
+            rejects << report.lines << "\tстрока длиннее " << LINE_READER_MAX_LINE << " байт\n";
+            continue;
+        }
+
+        if (line.find_first_not_of(" \t") == std::string_view::npos) {
+            continue;
+        }
+
+        if (!parseJsonRequest(line, request, error)) {
+            ++report.rejected;
+            metrics().reject(RejectReason::Json);
+            rejects << report.lines << "\t" << error << "\t" << line << "\n";
+            continue;
+        }
+
+        const std::string_view fields[7] = {
+            request.lastName, request.firstName, request.patronymic, request.group,
+            request.boardName, request.executablePath, request.resultPath
+        };
+        size_t failed;
+        RequestError validation = validateRequestFields(fields, failed);
+
+        if (validation != RequestError::None) {
+            ++report.rejected;
+            metrics().reject(rejectReason(validation));
+            rejects << report.lines << "\t" << describeError(validation, std::string(fields[failed])) << "\t" << line << "\n";
+            continue;
+        }
+
+        batch[batchSize] = arena.store(RequestView(request));
+        batchLines[batchSize] = report.lines;
+
+        if (++batchSize == BULK_BATCH_SIZE) {
+            flush();
+        }
+    }
+
+    flush();
+    report.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return report;
+}
+
+// Тесты пакетного импорта
+void testJsonLines() {
+    // Разбор escape-последовательностей, в том числе \u и суррогатных пар
+    Request request;
+    std::string error;
+
+    assert(parseJsonRequest(R"({"lastName":"\u0418\u0432\u0430\u043d\u043e\u0432","firstName":"Иван","patronymic":"Ivanovich",)"
+                            R"( "group":"BIV211", "boardName":"Arduino Uno", "executablePath":"C:\\bin\/main.exe",)"
+                            R"( "resultPath":"C:", "priority": 5, "note": "\ud83d\ude00"})", request, error));
+    assert(request.lastName == "Иванов");
+    assert(request.executablePath == "C:\\bin/main.exe");
+    assert(request.boardName == "Arduino Uno");
+
+    assert(!parseJsonRequest(R"({"lastName": 5})", request, error));
+    assert(!parseJsonRequest(R"({"lastName": "Ivanov")", request, error));
+    assert(!parseJsonRequest(R"([1, 2])", request, error));
+    assert(!parseJsonRequest(R"({"nested": {"a": 1}})", request, error));
+
+    // Импорт из файла: корректные заявки планируются, ошибочные строки уходят в отказы с номерами
+    std::string path = (std::filesystem::temp_directory_path() / "remote_stand_test_bulk.jsonl").string();
+    {
+        std::ofstream file(path);
+        file << R"({"lastName":"Ivanov","firstName":"Ivan","patronymic":"Ivanovich","group":"BIV1","boardName":"STM-32","executablePath":"a.exe","resultPath":"C:"})" << "\n";
+        file << "не json\n";
+        file << "\n";
+        file << R"({"lastName":"Ivanov1","firstName":"Ivan","patronymic":"Ivanovich","group":"BIV1","boardName":"STM-32","executablePath":"a.exe","resultPath":"C:"})" << "\r\n";
+        file << R"({"lastName":"Petrov","firstName":"Petr","patronymic":"Petrovich","group":"BIV1","boardName":"Unknown Bulk","executablePath":"a.exe","resultPath":"C:"})" << "\n";
+        file << R"({"lastName":"Sidorov","firstName":"Sidor","patronymic":"Sidorovich","group":"BIV1","boardName":"STM-32","executablePath":"a.exe","resultPath":"C:"})";
+    }
+
+    ManualClock clock;
+    StandCluster cluster;
+    cluster.addStand(RemoteStand("STM-32", clock));
+    RequestProcessor processor(cluster, clock);
+    processor.setVerbose(false);
+
+    // Заявка на несуществующую плату не оставляет плату и группу в таблице интернирования
+    internedStrings().intern("STM-32");
+    internedStrings().intern("BIV1");
+    size_t interned = internedStrings().size();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    assert(fd >= 0);
+    std::ostringstream rejects;
+    BulkReport report = importJsonLines(fd, processor, rejects);
+    ::close(fd);
+    std::filesystem::remove(path);
+    assert(internedStrings().size() == interned);
+
+    assert(report.lines == 6);
+    assert(report.scheduled == 2);
+    assert(report.rejected == 3);
+    assert(rejects.str().find("2\tожидался объект JSON") == 0);
+    assert(rejects.str().find("4\tОшибка в фамилии: Ivanov1") != std::string::npos);
+    assert(rejects.str().find("5\tНет доступных стендов для платы: Unknown") != std::string::npos);
+    assert(cluster.getStandsByBoard("STM-32")[0].getFreeTime() == clock.now() + 2 * DELAY);
+
+    // Строка длиннее LINE_READER_MAX_LINE отклоняется без накопления, следующая строка читается как обычно
+    {
+        std::ofstream file(path);
+        file << std::string(LINE_READER_MAX_LINE, 'x') << "\n";
+        file << std::string(3 * LINE_READER_MAX_LINE, 'y') << "\r\n";
+        file << R"({"lastName":"Sidorov","firstName":"Sidor","patronymic":"Sidorovich","group":"BIV1","boardName":"STM-32","executablePath":"a.exe","resultPath":"C:"})" << "\n";
+        file << std::string(LINE_READER_MAX_LINE + 1, 'z');
+    }
+
+    fd = ::open(path.c_str(), O_RDONLY);
+    assert(fd >= 0);
+    LineReader reader(fd);
+    std::string_view line;
+    assert(reader.next(line) && !reader.tooLong() && line.size() == LINE_READER_MAX_LINE);
+    assert(reader.next(line) && reader.tooLong() && line.empty());
+    assert(reader.next(line) && !reader.tooLong() && line.find("Sidorov") != std::string_view::npos);
+    assert(reader.next(line) && reader.tooLong());
+    assert(!reader.next(line));
+    ::lseek(fd, 0, SEEK_SET);
+    std::ostringstream oversized;
+    report = importJsonLines(fd, processor, oversized);
+    ::close(fd);
+    std::filesystem::remove(path);
+
+    assert(report.lines == 4 && report.scheduled == 1 && report.rejected == 3);
+    assert(oversized.str().find("2\tстрока длиннее " + std::to_string(LINE_READER_MAX_LINE) + " байт\n") != std::string::npos);
+}
+
+// Стандартный набор стендов: по standsPerBoard стендов каждой платы
+void addDefaultStands(StandCluster& cluster, const Clock& clock, size_t standsPerBoard = 2) {
+    for (const char* boardName : {"Arduino Uno", "STM-32", "DE10-Lite"}) {
+        for (size_t i = 0; i < standsPerBoard; ++i) {
+            cluster.addStand(RemoteStand(boardName, clock));
+        }
+    }
+}
+
+// Запись трассы заявок: время поступления от начала трассы, плата, группа,
+// фактическая длительность задания (0 - задание занимает ровно забронированное время) и исполняемый файл
+struct TraceRecord {
+    std::chrono::milliseconds arrival{0};
+    std::string boardName;
+    std::string group;
+    std::chrono::milliseconds duration{0};
+    std::string executable;
+};
+
+// Источник записей трассы, возвращает false, когда записи закончились
+using TraceSource = std::function<bool(TraceRecord&)>;
+
+// Трасса из потока, по строке на заявку: время_мс;плата;группа[;длительность_мс[;исполняемый_файл]]
+// Строки читаются по одной, трасса не загружается в память целиком
+TraceSource traceFromStream(std::shared_ptr<std::istream> input) {
+    return [input](TraceRecord& record) {
+        std::string line;
+
+        while (std::getline(*input, line)) {
+            size_t first = line.find(';');
+            size_t second = first == std::string::npos ? std::string::npos : line.find(';', first + 1);
+
+            // Пустые строки, комментарии и строки без разделителей пропускаются
+            if (line.empty() || line[0] == '#' || second == std::string::npos) {
+                continue;
+            }
+
+            size_t third = line.find(';', second + 1);
+            size_t fourth = third == std::string::npos ? std::string::npos : line.find(';', third + 1);
+
+            record.arrival = std::chrono::milliseconds(std::strtoll(line.c_str(), nullptr, 10));
+            record.boardName = line.substr(first + 1, second - first - 1);
+            record.group = line.substr(second + 1, third == std::string::npos ? std::string::npos : third - second - 1);
+            record.duration = std::chrono::milliseconds(third == std::string::npos ? 0 : std::strtoll(line.c_str() + third + 1, nullptr, 10));
+            record.executable = fourth == std::string::npos ? "" : line.substr(fourth + 1);
+            return true;
+        }
+
+        return false;
+    };
+}
+
+// Синтетическая трасса: пуассоновский поток заявок, платы выбираются равновероятно
+// Длительность заданий логнормальная, у каждой платы свой масштаб и у каждой из 8 программ свой множитель
+TraceSource syntheticTrace(size_t count, double ratePerSecond, uint32_t seed) {
+    auto rng = std::make_shared<std::mt19937_64>(seed);
+    auto produced = std::make_shared<size_t>(0);
+    auto time = std::make_shared<double>(0);
+
+    return [=](TraceRecord& record) {
+        static const char* boards[] = {"Arduino Uno", "STM-32", "DE10-Lite"};
+        static const double medianSeconds[] = {0.5, 1.5, 4.0};
+
+        if (*produced == count) {
+            return false;
+        }
+
+        std::exponential_distribution<double> gap(ratePerSecond);
+        *time += gap(*rng);
+
+        record.arrival = std::chrono::milliseconds(static_cast<int64_t>(*time * 1000));
+        size_t board = (*rng)() % 3;
+        size_t program = (*rng)() % 8;
+        std::lognormal_distribution<double> spread(0, 0.25);
+        double seconds = medianSeconds[board] * (0.5 + 0.25 * program) * spread(*rng);
+
+        record.boardName = boards[board];
+        record.group = "БИВ" + std::to_string(200 + (*rng)() % 20);
+        record.duration = std::chrono::milliseconds(std::max<int64_t>(1, static_cast<int64_t>(seconds * 1000)));
+        record.executable = "program" + std::to_string(program) + ".bin";
+        ++*produced;
+        return true;
+    };
+}
+
+// Итоги моделирования
+struct SimulationReport {
+    size_t requests = 0;
+    size_t rejected = 0;
+    // Время от первой заявки до окончания последнего задания
+    std::chrono::system_clock::duration makespan{0};
+    // Время ожидания в очереди каждой принятой заявки, с (всего и по группам)
+    std::vector<double> waits;
+    std::map<std::string, std::vector<double>> groupWaits;
+    // Занятое время каждого стенда по платам
+    std::map<std::string, std::vector<std::chrono::system_clock::duration>> busy;
+    // Суммарное забронированное и фактически занятое время заданий с известной длительностью
+    std::chrono::system_clock::duration reserved{0};
+    std::chrono::system_clock::duration used{0};
+    // Реальное время расчёта, с
+    double elapsed = 0;
+};
+
+// Моделирование обработки трассы в виртуальном времени
+// Заявки обрабатываются тем же RequestProcessor, что и в обычном режиме, но без ожидания реального времени
+// События (поступление заявок, завершение заданий, освобождение стенда для удерживаемых заявок) обрабатываются
+// в порядке времени. Задания с известной длительностью завершаются по ней: задание начинается не раньше брони,
+// в первом промежутке, где стенд действительно свободен, а о завершении сообщается обработчику заявок
+SimulationReport simulate(StandCluster& cluster, ManualClock& clock, const TraceSource& next, const PolicyFactory& policy = PolicyFactory()) {
+    using Time = std::chrono::system_clock::time_point;
+
+    // Завершение задания: время, порядковый номер для детерминированного порядка, заявка и бронь
+    struct Completion {
+        Time time;
+        size_t order;
+        Request request;
+        Reservation reservation;
+
+        bool operator>(const Completion& other) const {
+            return time != other.time ? time > other.time : order > other.order;
+        }
+    };
+
+    SimulationReport report;
+    RequestProcessor processor(cluster, clock);
+    processor.setVerbose(false);
+
+    if (policy) {
+        processor.setPolicy(policy);
+    }
+
+    std::priority_queue<Completion, std::vector<Completion>, std::greater<Completion>> completions;
+    // Фактическая занятость стендов по платам и длительности заданий, ожидающих стенда, по номерам заявок
+    std::map<std::string, std::vector<StandCalendar>> actualBusy;
+    std::map<uint64_t, std::chrono::milliseconds> durations;
+
+    auto begin = std::chrono::steady_clock::now();
+    auto start = clock.now();
+    auto finish = start;
+    TraceRecord record;
+    Request request{"Студент", "Иван", "Иванович", "", "", "main.exe", "C:"};
+    size_t dispatched = 0;
+
+    // Учёт выданного стенда
+    processor.setDispatchHandler([&](const RequestView& booked, uint64_t ticket, Time arrival, const Reservation& reservation) {
+        Time jobStart = reservation.startTime;
+        Time jobEnd = reservation.freeTime;
+        auto duration = durations.find(ticket);
+
+        if (duration != durations.end()) {
+            auto& standsBusy = actualBusy[std::string(booked.boardName)];
+
+            if (standsBusy.size() <= reservation.standIndex) {
+                standsBusy.resize(reservation.standIndex + 1, StandCalendar(start));
+            }
+
+            StandCalendar& calendar = standsBusy[reservation.standIndex];
+            calendar.trim(clock.now());
+            jobStart = calendar.earliestFit(jobStart, duration->second);
+            jobEnd = jobStart + duration->second;
+            calendar.book(jobStart, jobEnd);
+            report.reserved += reservation.freeTime - reservation.startTime;
+            report.used += duration->second;
+            completions.push({jobEnd, ++dispatched, booked.toRequest(), reservation});
+            durations.erase(duration);
+        }
+
+        auto& standsBusy = report.busy[std::string(booked.boardName)];
+
+        if (standsBusy.size() <= reservation.standIndex) {
+            standsBusy.resize(reservation.standIndex + 1, std::chrono::system_clock::duration(0));
+        }
+
+        double wait = std::chrono::duration<double>(jobStart - arrival).count();
+        standsBusy[reservation.standIndex] += jobEnd - jobStart;
+        report.waits.push_back(wait);
+        report.groupWaits[std::string(booked.group)].push_back(wait);
+        finish = std::max(finish, jobEnd);
+    });
+
+    // Обработка завершений и освобождений стендов, наступивших не позже until (при равном времени - сначала завершения)
+    auto advance = [&](Time until) {
+        while (true) {
+            Time dispatchAt;
+            bool dispatchPending = processor.nextDispatchTime(dispatchAt);
+            bool dispatchFirst = dispatchPending && (completions.empty() || dispatchAt < completions.top().time);
+
+            if (!dispatchFirst && completions.empty()) {
+                break;
+            }
+
+            Time event = dispatchFirst ? dispatchAt : completions.top().time;
+
+            if (event > until) {
+                break;
+            }
+
+            clock.set(std::max(clock.now(), event));
+
+            if (dispatchFirst) {
+                processor.dispatchDue();
+            } else {
+                Completion completion = completions.top();
+                completions.pop();
+                processor.reportCompletion(completion.request, completion.reservation);
+            }
+        }
+    };
+
+    while (next(record)) {
+        // Время не идёт назад, даже если трасса не отсортирована
+        Time arrival = std::max(clock.now(), start + record.arrival);
+        advance(arrival);
+        clock.set(arrival);
+        processor.pollNotifications();
+
+        request.boardName = record.boardName;
+        request.group = record.group;
+        request.executablePath = record.executable.empty() ? "main.exe" : record.executable;
+        ++report.requests;
+
+        // Длительность запоминается до постановки в очередь: стенд может быть выдан сразу
+        uint64_t ticket = processor.upcomingTicket();
+
+        if (record.duration.count() > 0) {
+            durations[ticket] = record.duration;
+        }
+
+        if (!processor.processRequest(request, ticket)) {
+            durations.erase(ticket);
+            ++report.rejected;
+        }
+    }
+
+    // Доводим моделирование до окончания последнего задания
+    advance(Time::max());
+    clock.set(std::max(clock.now(), finish));
+    processor.pollNotifications();
+
+    report.makespan = finish - start;
+    report.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    return report;
+}
+
+// Вывод итогов моделирования
+void printSimulationReport(const SimulationReport& report, const StandCluster& cluster) {
+    using namespace std::chrono;
+
+    std::vector<double> waits = report.waits;
+    std::sort(waits.begin(), waits.end());
+
+    // Перцентиль отсортированной выборки
+    auto percentile = [](const std::vector<double>& sorted, double p) {
+        return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+    };
+
+    double makespan = duration<double>(report.makespan).count();
+    double total = 0;
+
+    for (double wait : waits) {
+        total += wait;
+    }
+
+    std::cout << "Заявок: " << report.requests << ", отклонено: " << report.rejected << "\n";
+    std::cout << "Общее время выполнения (makespan): " << makespan << " с\n";
+    std::cout << "Ожидание в очереди, с: среднее " << (waits.empty() ? 0.0 : total / waits.size())
+              << ", p50 " << percentile(waits, 0.5) << ", p99 " << percentile(waits, 0.99)
+              << ", максимум " << (waits.empty() ? 0.0 : waits.back()) << "\n";
+
+    if (report.used.count() > 0) {
+        std::cout << "Забронировано сверх фактической длительности: "
+                  << 100 * (duration<double>(report.reserved).count() / duration<double>(report.used).count() - 1) << "%\n";
+    }
+
+    std::cout << "Ожидание по группам, с:\n";
+
+    for (const auto& pair : report.groupWaits) {
+        std::vector<double> groupWaits = pair.second;
+        std::sort(groupWaits.begin(), groupWaits.end());
+        std::cout << "  " << pair.first << ": заявок " << groupWaits.size() << ", p50 " << percentile(groupWaits, 0.5)
+                  << ", p99 " << percentile(groupWaits, 0.99) << "\n";
+    }
+
+    std::cout << "Загрузка стендов:\n";
+
+    for (const auto& pair : report.busy) {
+        size_t standsCount = std::max(pair.second.size(), cluster.getStandsByBoard(pair.first).size());
+        double sum = 0;
+        double minimum = 1;
+        double maximum = 0;
+
+        for (size_t i = 0; i < standsCount; ++i) {
+            double busy = i < pair.second.size() ? duration<double>(pair.second[i]).count() : 0.0;
+            double utilization = makespan > 0 ? busy / makespan : 0.0;
+
+            sum += utilization;
+            minimum = std::min(minimum, utilization);
+            maximum = std::max(maximum, utilization);
+        }
+
+        std::cout << "  " << pair.first << " (стендов: " << standsCount << "): средняя " << 100 * sum / standsCount
+                  << "%, минимальная " << 100 * minimum << "%, максимальная " << 100 * maximum << "%\n";
+    }
+
+    std::cout << "Время расчёта: " << report.elapsed << " с ("
+              << static_cast<size_t>(report.elapsed > 0 ? report.requests / report.elapsed : 0) << " заявок/с)" << std::endl;
+}
+
+// Тесты моделирования
+void testSimulation() {
+    using namespace std::chrono;
+
+    // Три заявки на одну плату с одним стендом приходят одновременно: ожидание 0, DELAY и 2 * DELAY
+    std::vector<TraceRecord> trace = {
+        {milliseconds(0), "Arduino Uno", "A", milliseconds(0), ""},
+        {milliseconds(0), "Arduino Uno", "B", milliseconds(0), ""},
+        {milliseconds(0), "Arduino Uno", "C", milliseconds(0), ""},
+        {milliseconds(0), "Unknown", "A", milliseconds(0), ""},
+    };
+    size_t position = 0;
+
+    ManualClock clock;
+    StandCluster cluster;
+    addDefaultStands(cluster, clock, 1);
+
+    SimulationReport report = simulate(cluster, clock, [&](TraceRecord& record) {
+        if (position == trace.size()) {
+            return false;
+        }
+
+        record = trace[position++];
+        return true;
+    });
+
+    assert(report.requests == 4);
+    assert(report.rejected == 1);
+    assert(report.makespan == 3 * DELAY);
+    assert((report.waits == std::vector<double>{0.0, 5.0, 10.0}));
+    assert(report.busy["Arduino Uno"][0] == 3 * DELAY);
+
+    // Задания по 1 с каждые 2 с: первые ESTIMATOR_MIN_SAMPLES бронируют DELAY, затем - выученную длительность
+    ManualClock learnClock;
+    StandCluster learnCluster;
+    addDefaultStands(learnCluster, learnClock, 1);
+    position = 0;
+
+    SimulationReport learned = simulate(learnCluster, learnClock, [&](TraceRecord& record) {
+        if (position == 30) {
+            return false;
+        }
+
+        record = {milliseconds(2000 * position++), "Arduino Uno", "A", milliseconds(1000), "blink.hex"};
+        return true;
+    });
+
+    assert(learned.makespan == seconds(59));
+    assert(learned.used == seconds(30));
+    assert(learned.reserved == ESTIMATOR_MIN_SAMPLES * DELAY + (30 - ESTIMATOR_MIN_SAMPLES) * seconds(1));
+    assert(*std::max_element(learned.waits.begin(), learned.waits.end()) == 0.0);
+
+    // Группа A отправляет 20 заявок сразу, группа B - одну через секунду; все задания по 1 с на одном стенде
+    auto burst = [](const PolicyFactory& policy) {
+        ManualClock burstClock;
+        StandCluster burstCluster;
+        addDefaultStands(burstCluster, burstClock, 1);
+        size_t produced = 0;
+
+        return simulate(burstCluster, burstClock, [&](TraceRecord& record) {
+            if (produced == 21) {
+                return false;
+            }
+
+            record = produced < 20 ? TraceRecord{milliseconds(0), "Arduino Uno", "A", milliseconds(1000), ""}
+                                   : TraceRecord{milliseconds(1000), "Arduino Uno", "B", milliseconds(1000), ""};
+            ++produced;
+            return true;
+        }, policy);
+    };
+
+    // В порядке поступления B ждёт всю пачку A, при справедливом разделении - не больше одного задания
+    SimulationReport fcfs = burst(PolicyFactory());
+    SimulationReport fair = burst(makePolicyFactory("fair"));
+    assert(fcfs.groupWaits["B"].size() == 1 && fcfs.groupWaits["B"][0] >= 10.0);
+    assert(fair.groupWaits["B"].size() == 1 && fair.groupWaits["B"][0] <= 1.0);
+    assert(fair.groupWaits["A"].size() == 20);
+    assert(fair.makespan == seconds(21));
+
+    // Трасса из текстового потока
+    auto input = std::make_shared<std::istringstream>("# время;плата;группа\n0;STM-32;БИВ1\n\n2500;DE10-Lite;БИВ2;1500;top.sof\n");
+    TraceSource source = traceFromStream(input);
+    TraceRecord record;
+
+    assert(source(record) && record.boardName == "STM-32" && record.group == "БИВ1");
+    assert(record.duration == milliseconds(0) && record.executable.empty());
+    assert(source(record) && record.arrival == milliseconds(2500) && record.boardName == "DE10-Lite");
+    assert(record.group == "БИВ2" && record.duration == milliseconds(1500) && record.executable == "top.sof");
+    assert(!source(record));
+}
+
+// Профиль нагрузки генератора заявок
+struct LoadProfile {
+    // Средний поток заявок в секунду
+    double rate = 200;
+    // Доли заявок с ошибкой, студентов с кириллическими ФИО и повторных подач уже поданной заявки
+    double invalidShare = 0.05;
+    double cyrillicShare = 0.5;
+    double repeatShare = 0.1;
+    // Количество групп и показатель распределения Ципфа по группам (0 - группы равновероятны)
+    size_t groups = 20;
+    double groupSkew = 1.1;
+    // Платы и их веса
+    std::vector<std::pair<std::string, double>> boards = {{"Arduino Uno", 3}, {"STM-32", 2}, {"DE10-Lite", 1}};
+    // Всплески перед сроками сдачи: каждые burstEvery поток на burstLength вырастает в burstFactor раз (0 - без всплесков)
+    std::chrono::milliseconds burstEvery{0};
+    std::chrono::milliseconds burstLength{5000};
+    double burstFactor = 10;
+    uint32_t seed = 42;
+};
+
+// Синтетическая заявка генератора: заявка, ожидаемый исход и время отправки от начала нагрузки
+struct LoadItem {
+    Request request;
+    // Заявка должна быть принята (без ошибок в полях и для существующей платы)
+    bool valid = true;
+    bool repeat = false;
+    std::chrono::nanoseconds arrival{0};
+};
+
+// Генератор заявок по профилю: пуассоновский поток со всплесками, платы по весам, группы по Ципфу,
+// ФИО кириллицей, латиницей и вперемешку. Ошибочная заявка портит ровно одно поле так, как ошибаются люди:
+// цифра или пробел в имени, буква другого кириллического алфавита, пробел в группе, пустая или несуществующая плата
+class LoadGenerator {
+private:
+    LoadProfile profile;
+    std::mt19937_64 rng;
+    std::discrete_distribution<size_t> boardChoice;
+    std::discrete_distribution<size_t> groupChoice;
+    std::uniform_real_distribution<double> unit{0.0, 1.0};
+    // Недавние правильные заявки для повторных подач
+    std::vector<Request> recent;
+    size_t recentNext = 0;
+    double time = 0;
+
+    // Слово из набора
+    template <size_t N>
+    const char* pick(const char* const (&words)[N]) {
+        return words[rng() % N];
+    }
+
+    // Правильная заявка случайного студента
+    Request student() {
+        static const char* const cyrillicLast[] = {"Иванов", "Смирнов", "Кузнецов", "Попов", "Соколов", "Лебедев",
+                                                   "Козлов", "Новиков", "Морозов", "Ёлкин", "Волков", "Жуков"};
+        static const char* const cyrillicFirst[] = {"Иван", "Пётр", "Алексей", "Мария", "Анна", "Дмитрий", "Ольга", "Юрий"};
+        static const char* const cyrillicMiddle[] = {"Иванович", "Петрович", "Сергеевич", "Андреевна", "Юрьевна"};
+        static const char* const latinLast[] = {"Ivanov", "Smirnov", "Kuznetsov", "Popov", "Sokolov", "Lebedev",
+                                                "Kozlov", "Novikov", "Morozov", "Volkov", "Zhukov", "OBrien"};
+        static const char* const latinFirst[] = {"Ivan", "Petr", "Aleksei", "Maria", "Anna", "Dmitry", "Olga", "Yuri"};
+        static const char* const latinMiddle[] = {"Ivanovich", "Petrovich", "Sergeevich", "Andreevna", "Yurievna"};
+
+        Request request;
+        double script = unit(rng);
+
+        if (script < profile.cyrillicShare) {
+            request.lastName = pick(cyrillicLast);
+            request.firstName = pick(cyrillicFirst);
+            request.patronymic = pick(cyrillicMiddle);
+        } else if (script < profile.cyrillicShare + (1 - profile.cyrillicShare) / 4) {
+            // Смесь алфавитов в одном имени допустима: такие имена проходят обе ветви проверки
+            request.lastName = std::string(pick(latinLast)) + pick(cyrillicLast);
+            request.firstName = pick(latinFirst);
+            request.patronymic = pick(cyrillicMiddle);
+        } else {
+            request.lastName = pick(latinLast);
+            request.firstName = pick(latinFirst);
+            request.patronymic = pick(latinMiddle);
+        }
+
+        size_t group = groupChoice(rng);
+        request.group = (group % 2 == 0 ? "БИВ" : "BIV") + std::to_string(201 + group);
+        request.boardName = profile.boards[boardChoice(rng)].first;
+        request.executablePath = "/labs/lab" + std::to_string(1 + rng() % 8) + "/main.bin";
+        request.resultPath = "/results/" + std::string(pick(latinLast));
+        return request;
+    }
+
+    // Порча одного поля заявки
+    void corrupt(Request& request) {
+        switch (rng() % 8) {
+        case 0:
+            request.lastName += std::to_string(1 + rng() % 9);
+            break;
+        case 1:
+            request.firstName += " " + request.firstName;
+            break;
+        case 2:
+            request.patronymic = "Ђорђевич";
+            break;
+        case 3:
+            request.group.insert(request.group.size() - 3, " ");
+            break;
+        case 4:
+            request.boardName.clear();
+            break;
+        case 5:
+            request.boardName = "Raspberry Pi";
+            break;
+        case 6:
+            request.executablePath = "main|" + std::to_string(rng() % 100) + ".bin";
+            break;
+        default:
+            request.resultPath = "C:\\results <" + request.lastName + ">";
+            break;
+        }
+    }
+
+public:
+    explicit LoadGenerator(const LoadProfile& profile) : profile(profile), rng(profile.seed) {
+        std::vector<double> weights;
+
+        for (const auto& board : profile.boards) {
+            weights.push_back(board.second);
+        }
+
+        boardChoice = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+        weights.clear();
+
+        for (size_t k = 0; k < std::max<size_t>(1, profile.groups); ++k) {
+            weights.push_back(1.0 / std::pow(static_cast<double>(k + 1), profile.groupSkew));
+        }
+
+        groupChoice = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+    }
+
+    // Поток заявок в секунду в момент t от начала нагрузки, с
+    double rateAt(double t) const {
+        double period = std::chrono::duration<double>(profile.burstEvery).count();
+
+        if (period > 0 && std::fmod(t, period) >= period - std::chrono::duration<double>(profile.burstLength).count()) {
+            return profile.rate * profile.burstFactor;
+        }
+
+        return profile.rate;
+    }
+
+    // Следующая заявка потока
+    void next(LoadItem& item) {
+        time += std::exponential_distribution<double>(rateAt(time))(rng);
+        item.arrival = std::chrono::nanoseconds(static_cast<int64_t>(time * 1e9));
+        item.repeat = false;
+        item.valid = true;
+
+        if (!recent.empty() && unit(rng) < profile.repeatShare) {
+            item.request = recent[rng() % recent.size()];
+            item.repeat = true;
+            return;
+        }
+
+        item.request = student();
+
+        if (unit(rng) < profile.invalidShare) {
+            corrupt(item.request);
+            item.valid = false;
+            return;
+        }
+
+        if (recent.size() < 1024) {
+            recent.push_back(item.request);
+        } else {
+            recent[recentNext++ % recent.size()] = item.request;
+        }
+    }
+};
+
+// Текст файла-заявки
+std::string requestText(const Request& request) {
+    return request.lastName + "\n" + request.firstName + "\n" + request.patronymic + "\n" + request.group + "\n" +
+           request.boardName + "\n" + request.executablePath + "\n" + request.resultPath + "\n";
+}
+
+// Строка JSON Lines с заявкой (формат --bulk)
+std::string requestJson(const Request& request) {
+    const std::string* fields[7] = {
+        &request.lastName, &request.firstName, &request.patronymic, &request.group,
+        &request.boardName, &request.executablePath, &request.resultPath
+    };
+    static const char* names[7] = {"lastName", "firstName", "patronymic", "group", "boardName", "executablePath", "resultPath"};
+    std::string line = "{";
+
+    for (size_t i = 0; i < 7; ++i) {
+        line += (i == 0 ? "\"" : ",\"");
+        line += names[i];
+        line += "\":\"";
+
+        for (char c : *fields[i]) {
+            if (c == '"' || c == '\\') {
+                line += '\\';
+            }
+
+            line += c;
+        }
+
+        line += '"';
+    }
+
+    return line + "}";
+}
+
+// Память (VmRSS, КБ), потоки и открытые дескрипторы процесса pid из /proc; false, если процесса нет
+bool processStats(pid_t pid, size_t& rssKb, size_t& threads, size_t& fds) {
+    std::string base = "/proc/" + std::to_string(pid);
+    std::ifstream status(base + "/status");
+    std::string line;
+    rssKb = threads = fds = 0;
+
+    if (!status) {
+        return false;
+    }
+
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            rssKb = std::strtoull(line.c_str() + 6, nullptr, 10);
+        } else if (line.compare(0, 8, "Threads:") == 0) {
+            threads = std::strtoull(line.c_str() + 8, nullptr, 10);
+        }
+    }
+
+    std::error_code code;
+
+    for (auto it = std::filesystem::directory_iterator(base + "/fd", code); !code && it != std::filesystem::directory_iterator();
+         it.increment(code)) {
+        ++fds;
+    }
+
+    return true;
+}
+
+// Срез нагрузки за интервал отчёта
+struct LoadSample {
+    double elapsed = 0;
+    uint64_t sent = 0;
+    uint64_t acked = 0;
+    uint64_t accepted = 0;
+    uint64_t queued = 0;
+    uint64_t rejected = 0;
+    uint64_t coalesced = 0;
+    // Исход, не совпавший с ожидаемым (правильная заявка отклонена или ошибочная принята)
+    uint64_t unexpected = 0;
+    // События завершения, полученные по подписке, и потерянные сервером для неё
+    uint64_t completed = 0;
+    uint64_t completionsLost = 0;
+    double throughput = 0;
+    // Задержка от запланированной отправки до ответа за интервал, мкс
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    // Задержка доставки события завершения от отметки времени сервера до получения за интервал, мс
+    double completionP50 = 0;
+    double completionP99 = 0;
+    size_t rssKb = 0;
+    size_t threads = 0;
+    size_t fds = 0;
+};
+
+// Итоги нагрузки: срезы, задержка за всё время, рост памяти и потоков
+struct LoadReport {
+    std::vector<LoadSample> samples;
+    LoadSample total;
+    // Рост памяти от первого среза до последнего, КБ, и его наклон по методу наименьших квадратов, КБ/мин
+    int64_t rssGrowthKb = 0;
+    double rssSlopeKbPerMinute = 0;
+    size_t maxThreads = 0;
+    int64_t threadGrowth = 0;
+    // Процесс pid пропал во время нагрузки: замеры памяти и потоков недостоверны
+    bool processLost = false;
+};
+
+// Нагрузка на сервер приёма заявок: connections соединений, у каждого свой генератор (поток profile.rate / connections)
+// Отправка идёт по расписанию генератора независимо от ответов (открытая модель), поэтому задержка считается
+// от запланированного времени отправки и включает ожидание самого клиента, если сервер не успевает
+// Раз в interval снимается срез: пропускная способность, квантили задержки, память, потоки и дескрипторы процесса pid
+// Отдельное соединение подписано на все события завершения (кадр "S all"): по ним считаются завершения и задержка их доставки
+class LoadDriver {
+private:
+    struct Connection {
+        IntakeClient client;
+        std::mutex mutex;
+        // Запланированное время отправки и ожидаемый исход запросов без ответа, в порядке отправки
+        std::deque<std::pair<std::chrono::steady_clock::time_point, bool>> pending;
+        bool finished = false;
+        std::thread sender;
+        std::thread receiver;
+    };
+
+    LoadProfile profile;
+    size_t connections;
+    pid_t pid;
+    // Сервер работает в этом же процессе: известны уведомления о завершении и объединённые подачи
+    bool local;
+    std::vector<std::unique_ptr<Connection>> links;
+    // Подписка на события завершения
+    IntakeClient events;
+    std::thread listener;
+    LatencyHistogram latency;
+    LatencyHistogram completionLatency;
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> completionsLost{0};
+    std::atomic<bool> processLost{false};
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> acked{0};
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> queued{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> unexpected{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> sending{0};
+
+    // Отправка заявок соединения по расписанию генератора до deadline
+    void send(Connection& link, uint32_t seed, std::chrono::steady_clock::time_point start,
+              std::chrono::steady_clock::time_point deadline) {
+        LoadProfile own = profile;
+        own.rate = profile.rate / connections;
+        own.seed = seed;
+        LoadGenerator generator(own);
+        LoadItem item;
+        std::string frame;
+
+        while (!stopping.load()) {
+            generator.next(item);
+            auto planned = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(item.arrival);
+
+            if (planned >= deadline) {
+                break;
+            }
+
+            std::this_thread::sleep_until(planned);
+            frame.clear();
+            appendFrame(frame, 'R', requestText(item.request));
+            {
+                std::lock_guard<std::mutex> lock(link.mutex);
+                link.pending.emplace_back(planned, item.valid);
+            }
+
+            if (!link.client.sendRaw(frame)) {
+                break;
+            }
+
+            sent.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::lock_guard<std::mutex> lock(link.mutex);
+        link.finished = true;
+        sending.fetch_sub(1);
+    }
+
+    // Приём ответов соединения до ответа на последний отправленный запрос
+    void receive(Connection& link) {
+        char type;
+        std::string reply;
+
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(link.mutex);
+
+                if (link.finished && link.pending.empty()) {
+                    return;
+                }
+            }
+
+            if (!link.client.receive(type, reply)) {
+                return;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            std::pair<std::chrono::steady_clock::time_point, bool> request;
+            {
+                std::lock_guard<std::mutex> lock(link.mutex);
+
+                if (link.pending.empty()) {
+                    continue;
+                }
+
+                request = link.pending.front();
+                link.pending.pop_front();
+            }
+
+            latency.record(now - request.first);
+            acked.fetch_add(1, std::memory_order_relaxed);
+            bool ok = type == 'A' || type == 'Q';
+            (type == 'A' ? accepted : type == 'Q' ? queued : rejected).fetch_add(1, std::memory_order_relaxed);
+
+            if (ok != request.second) {
+                unexpected.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Приём событий завершения до закрытия подписки
+    // Событие: "номер\tстудент\tгруппа\tплата\tвремя_завершения_мс_от_эпохи" (см. completionEventText)
+    void listen() {
+        char type;
+        std::string reply;
+
+        while (events.receive(type, reply)) {
+            if (type == 'D') {
+                completionsLost.fetch_add(std::strtoull(reply.c_str(), nullptr, 10), std::memory_order_relaxed);
+                continue;
+            }
+
+            if (type != 'N') {
+                continue;
+            }
+
+            auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+            size_t tab = reply.rfind('\t');
+            auto stamped = std::chrono::milliseconds(tab == std::string::npos ? now.count() : std::strtoll(reply.c_str() + tab + 1, nullptr, 10));
+            completionLatency.record(std::max(now - stamped, std::chrono::milliseconds(0)));
+            completed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Срез счётчиков; previous и previousCompletions - гистограммы на начало интервала
+    LoadSample sample(double elapsed, const std::vector<uint64_t>& previous, const std::vector<uint64_t>& current,
+                      const std::vector<uint64_t>& previousCompletions, const std::vector<uint64_t>& currentCompletions) {
+        LoadSample result;
+        std::vector<uint64_t> interval(current.size());
+        std::vector<uint64_t> completions(currentCompletions.size());
+
+        for (size_t i = 0; i < current.size(); ++i) {
+            interval[i] = current[i] - previous[i];
+        }
+
+        for (size_t i = 0; i < currentCompletions.size(); ++i) {
+            completions[i] = currentCompletions[i] - previousCompletions[i];
+        }
+
+        result.elapsed = elapsed;
+        result.sent = sent.load();
+        result.acked = acked.load();
+        result.accepted = accepted.load();
+        result.queued = queued.load();
+        result.rejected = rejected.load();
+        result.unexpected = unexpected.load();
+        result.coalesced = local ? metrics().coalesced.value() : 0;
+        result.completed = completed.load();
+        result.completionsLost = completionsLost.load();
+        result.p50 = LatencyHistogram::quantile(interval, 0.5) / 1000.0;
+        result.p99 = LatencyHistogram::quantile(interval, 0.99) / 1000.0;
+        result.p999 = LatencyHistogram::quantile(interval, 0.999) / 1000.0;
+        result.completionP50 = LatencyHistogram::quantile(completions, 0.5) / 1e6;
+        result.completionP99 = LatencyHistogram::quantile(completions, 0.99) / 1e6;
+
+        if (!processStats(pid, result.rssKb, result.threads, result.fds)) {
+            processLost.store(true);
+        }
+
+        return result;
+    }
+
+public:
+    // Нагрузка по профилю profile; pid - процесс сервера для замеров памяти и потоков,
+    // local - сервер работает в этом же процессе (тогда известны объединённые подачи)
+    LoadDriver(const LoadProfile& profile, size_t connections, pid_t pid, bool local)
+        : profile(profile), connections(std::max<size_t>(1, connections)), pid(pid), local(local) {}
+
+    ~LoadDriver() {
+        stop();
+    }
+
+    LoadDriver(const LoadDriver&) = delete;
+    LoadDriver& operator=(const LoadDriver&) = delete;
+
+    // Подключение всех соединений и подписки на события завершения через connect (по Unix-сокету или TCP)
+    bool connect(const std::function<bool(IntakeClient&, std::string&)>& connect, std::string& error) {
+        for (size_t i = 0; i < connections; ++i) {
+            links.push_back(std::make_unique<Connection>());
+
+            if (!connect(links.back()->client, error)) {
+                return false;
+            }
+        }
+
+        char type;
+        std::string reply;
+
+        if (!connect(events, error)) {
+            return false;
+        }
+
+        if (!events.send('S', "all") || !events.receive(type, reply) || type != 'S') {
+            error = "сервер не принял подписку на события завершения";
+            return false;
+        }
+
+        return true;
+    }
+
+    // Нагрузка в течение length со срезом каждые interval (onSample получает срез сразу после снятия)
+    // После окончания отправки ответы ждутся не дольше drain
+    LoadReport run(std::chrono::steady_clock::duration length, std::chrono::steady_clock::duration interval,
+                   const std::function<void(const LoadSample&)>& onSample,
+                   std::chrono::steady_clock::duration drain = std::chrono::seconds(10)) {
+        using namespace std::chrono;
+        using Seconds = duration<double>;
+
+        LoadReport report;
+        auto start = steady_clock::now() + milliseconds(10);
+        auto deadline = start + length;
+        std::vector<uint64_t> previous = latency.counts();
+        std::vector<uint64_t> previousCompletions = completionLatency.counts();
+        uint64_t previousAcked = 0;
+
+        sending.store(links.size());
+        listener = std::thread(&LoadDriver::listen, this);
+
+        for (size_t i = 0; i < links.size(); ++i) {
+            Connection& link = *links[i];
+            link.sender = std::thread(&LoadDriver::send, this, std::ref(link), profile.seed + static_cast<uint32_t>(i), start,
+                                      deadline);
+            link.receiver = std::thread(&LoadDriver::receive, this, std::ref(link));
+        }
+
+        // Срезы до окончания отправки и ответов на неё
+        auto finish = deadline + drain;
+        auto next = start + interval;
+
+        auto finished = [this]() { return sending.load() == 0 && acked.load() == sent.load(); };
+
+        while (true) {
+            while (steady_clock::now() < std::min(next, finish) && !finished()) {
+                std::this_thread::sleep_for(milliseconds(10));
+            }
+
+            bool done = finished();
+            auto now = steady_clock::now();
+            std::vector<uint64_t> current = latency.counts();
+            std::vector<uint64_t> currentCompletions = completionLatency.counts();
+            LoadSample slice = sample(Seconds(now - start).count(), previous, current, previousCompletions, currentCompletions);
+            double seconds = Seconds(interval).count();
+
+            // Последний срез может быть короче интервала
+            if (now < next) {
+                seconds -= Seconds(next - now).count();
+            }
+
+            slice.throughput = seconds > 0 ? (slice.acked - previousAcked) / seconds : 0;
+            previousAcked = slice.acked;
+            previous = std::move(current);
+            previousCompletions = std::move(currentCompletions);
+            report.samples.push_back(slice);
+
+            if (onSample) {
+                onSample(slice);
+            }
+
+            if (done || now >= finish) {
+                break;
+            }
+
+            next += interval;
+        }
+
+        stop();
+
+        // Итоги за всё время, рост памяти и потоков
+        std::vector<uint64_t> none(LatencyHistogram::BUCKETS, 0);
+        report.total = sample(Seconds(steady_clock::now() - start).count(), none, latency.counts(), none,
+                              completionLatency.counts());
+        report.processLost = processLost.load();
+        report.total.throughput = report.total.acked / std::max(1e-9, Seconds(length).count());
+
+        const LoadSample& first = report.samples.front();
+        const LoadSample& last = report.samples.back();
+        report.rssGrowthKb = static_cast<int64_t>(last.rssKb) - static_cast<int64_t>(first.rssKb);
+        report.threadGrowth = static_cast<int64_t>(last.threads) - static_cast<int64_t>(first.threads);
+
+        double meanTime = 0;
+        double meanRss = 0;
+
+        for (const auto& slice : report.samples) {
+            meanTime += slice.elapsed / report.samples.size();
+            meanRss += static_cast<double>(slice.rssKb) / report.samples.size();
+            report.maxThreads = std::max(report.maxThreads, slice.threads);
+        }
+
+        double covariance = 0;
+        double variance = 0;
+
+        for (const auto& slice : report.samples) {
+            covariance += (slice.elapsed - meanTime) * (slice.rssKb - meanRss);
+            variance += (slice.elapsed - meanTime) * (slice.elapsed - meanTime);
+        }
+
+        report.rssSlopeKbPerMinute = variance > 0 ? covariance / variance * 60 : 0;
+        return report;
+    }
+
+    // Остановка отправки и приёма; соединения закрываются, если ответы так и не пришли
+    void stop() {
+        stopping.store(true);
+
+        for (auto& link : links) {
+            if (link->sender.joinable()) {
+                link->sender.join();
+            }
+
+            link->client.disconnect();
+
+            if (link->receiver.joinable()) {
+                link->receiver.join();
+            }
+        }
+
+        events.disconnect();
+
+        if (listener.joinable()) {
+            listener.join();
+        }
+    }
+};
+
+// Вывод среза нагрузки строкой JSON
+void printLoadSample(std::ostream& out, const LoadSample& sample, bool local) {
+    out << "{\"t_s\":" << sample.elapsed << ",\"sent\":" << sample.sent << ",\"acked\":" << sample.acked
+        << ",\"accepted\":" << sample.accepted << ",\"queued\":" << sample.queued << ",\"rejected\":" << sample.rejected
+        << ",\"unexpected\":" << sample.unexpected << ",\"completed\":" << sample.completed
+        << ",\"completions_lost\":" << sample.completionsLost;
+
+    if (local) {
+        out << ",\"coalesced\":" << sample.coalesced;
+    }
+
+    out << ",\"ops_per_sec\":" << static_cast<uint64_t>(sample.throughput) << ",\"p50_us\":" << sample.p50
+        << ",\"p99_us\":" << sample.p99 << ",\"p999_us\":" << sample.p999 << ",\"completion_p50_ms\":" << sample.completionP50
+        << ",\"completion_p99_ms\":" << sample.completionP99 << ",\"rss_kb\":" << sample.rssKb
+        << ",\"threads\":" << sample.threads << ",\"fds\":" << sample.fds << "}" << std::endl;
+}
+
+// Вывод итогов нагрузки строкой JSON
+void printLoadReport(std::ostream& out, const LoadReport& report, bool local) {
+    std::ostringstream total;
+    printLoadSample(total, report.total, local);
+    std::string line = total.str();
+    line.erase(line.size() - 2);
+
+    out << "{\"summary\":true," << line.substr(1) << ",\"rss_growth_kb\":" << report.rssGrowthKb
+        << ",\"rss_slope_kb_per_min\":" << report.rssSlopeKbPerMinute << ",\"max_threads\":" << report.maxThreads
+        << ",\"thread_growth\":" << report.threadGrowth << "}" << std::endl;
+}
+
+// Тесты генератора нагрузки и прогона через сервер приёма заявок
+void testLoadGenerator() {
+    using namespace std::chrono;
+
+    // Поток воспроизводим по seed, ожидаемый исход совпадает с проверкой заявки
+    LoadProfile profile;
+    profile.invalidShare = 0.3;
+    profile.repeatShare = 0.2;
+    LoadGenerator first(profile);
+    LoadGenerator second(profile);
+    LoadItem item;
+    LoadItem other;
+    std::map<std::string, size_t> boards;
+    std::map<std::string, size_t> groups;
+    size_t invalid = 0;
+    size_t repeats = 0;
+    size_t cyrillic = 0;
+    nanoseconds previous{0};
+
+    for (size_t i = 0; i < 5000; ++i) {
+        first.next(item);
+        second.next(other);
+        assert(item.arrival == other.arrival && item.request.lastName == other.request.lastName);
+        assert(item.arrival > previous);
+        previous = item.arrival;
+
+        ParseResult parsed = parseRequestText(requestText(item.request));
+        bool known = item.request.boardName == "Arduino Uno" || item.request.boardName == "STM-32" ||
+                     item.request.boardName == "DE10-Lite";
+        assert(item.valid == (parsed.ok() && known));
+
+        Request fromJson;
+        std::string error;
+        assert(parseJsonRequest(requestJson(item.request), fromJson, error) && fromJson.lastName == item.request.lastName);
+
+        invalid += !item.valid;
+        repeats += item.repeat;
+        cyrillic += static_cast<unsigned char>(item.request.firstName[0]) >= 0x80;
+
+        if (item.valid) {
+            ++boards[item.request.boardName];
+            ++groups[item.request.group];
+        }
+    }
+
+    // Доли близки к профилю: платы 3:2:1, группы по убыванию частоты, средний поток 200 в секунду
+    assert(invalid > 1000 && invalid < 1400 && repeats > 800 && repeats < 1200 && cyrillic > 1800 && cyrillic < 3200);
+    assert(boards["Arduino Uno"] > boards["STM-32"] && boards["STM-32"] > boards["DE10-Lite"]);
+    assert(groups["БИВ201"] > 2 * groups["BIV210"]);
+    assert(previous > seconds(20) && previous < seconds(30));
+
+    // Всплеск: последние 2 с каждых 10 с поток в 10 раз больше
+    profile.burstEvery = seconds(10);
+    profile.burstLength = seconds(2);
+    LoadGenerator bursty(profile);
+    assert(bursty.rateAt(1) == 200 && bursty.rateAt(9) == 2000 && bursty.rateAt(11) == 200);
+
+    // Прогон через сервер в этом же процессе: на каждую заявку пришёл ответ с ожидаемым исходом
+    auto socket = (std::filesystem::temp_directory_path() / "remote_stand_test_load.sock").string();
+    StandCluster cluster;
+    addDefaultStands(cluster, systemClock(), 4);
+    RequestProcessor processor(cluster);
+    processor.setVerbose(false);
+    processor.setNotifications(false);
+    processor.setCoalescing(true);
+    IntakeServer server(processor, 2);
+    std::string error;
+    assert(server.listenUnix(socket, error) && server.start(error));
+
+    profile.burstEvery = milliseconds(0);
+    profile.rate = 1000;
+    LoadDriver driver(profile, 2, ::getpid(), true);
+    size_t slices = 0;
+    assert(driver.connect([&socket](IntakeClient& client, std::string& message) { return client.connectUnix(socket, message); },
+                          error));
+    assert(completionHub().subscribers() == 1);
+
+    // Уведомления выключены, поэтому единственное событие завершения - отправленное здесь; оно приходит по подписке
+    LoadReport report = driver.run(milliseconds(300), milliseconds(100), [&slices, &processor](const LoadSample&) {
+        if (++slices == 1) {
+            processor.completionMessage("Arduino Uno", "Load", "BIV1", 1);
+        }
+    });
+
+    assert(report.total.sent > 150 && report.total.acked == report.total.sent && report.total.unexpected == 0);
+    assert(report.total.completed == 1 && report.total.completionsLost == 0 && !report.processLost);
+    assert(report.total.rejected > 0 && report.total.accepted + report.total.queued > 0);
+    assert(slices == report.samples.size() && slices >= 3 && report.maxThreads > 0 && report.total.rssKb > 0);
+    assert(report.total.p50 > 0 && report.total.p50 <= report.total.p99 && report.total.p99 <= report.total.p999);
+    server.stop();
+}
+
+// Результат замера производительности
+struct BenchResult {
+    std::string name;
+    // Размер задачи (например, количество стендов платы) и число потоков
+    size_t size = 0;
+    size_t threads = 1;
+    size_t operations = 0;
+    double opsPerSecond = 0;
+    // Перцентили задержки одной операции, нс
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double max = 0;
+};
+
+// Вывод результата замера одной строкой JSON
+void printBenchResult(std::ostream& out, const BenchResult& result) {
+    out << "{\"bench\":\"" << result.name << "\",\"size\":" << result.size << ",\"threads\":" << result.threads
+        << ",\"ops\":" << result.operations << ",\"ops_per_sec\":" << static_cast<uint64_t>(result.opsPerSecond)
+        << ",\"p50_ns\":" << result.p50 << ",\"p90_ns\":" << result.p90 << ",\"p99_ns\":" << result.p99
+        << ",\"p999_ns\":" << result.p999 << ",\"max_ns\":" << result.max << "}" << std::endl;
+}
+
+// Замер операции: операции выполняются пачками по batch штук, время пачки делится на её размер
+// Пачки нужны для очень быстрых операций, время которых меньше цены вызова часов
+template <typename Operation>
+BenchResult measure(const std::string& name, size_t size, size_t operations, size_t batch, Operation operation) {
+    using namespace std::chrono;
+
+    std::vector<double> samples;
+    samples.reserve(operations / batch + 1);
+    size_t done = 0;
+    auto begin = steady_clock::now();
+
+    while (done < operations) {
+        size_t count = std::min(batch, operations - done);
+        auto batchBegin = steady_clock::now();
+
+        for (size_t i = 0; i < count; ++i) {
+            operation(done + i);
+        }
+
+        samples.push_back(double(duration_cast<nanoseconds>(steady_clock::now() - batchBegin).count()) / count);
+        done += count;
+    }
+
+    double total = duration<double>(steady_clock::now() - begin).count();
+    std::sort(samples.begin(), samples.end());
+
+    auto percentile = [&samples](double p) {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+    };
+
+    BenchResult result;
+    result.name = name;
+    result.size = size;
+    result.operations = operations;
+    result.opsPerSecond = operations / total;
+    result.p50 = percentile(0.5);
+    result.p90 = percentile(0.9);
+    result.p99 = percentile(0.99);
+    result.p999 = percentile(0.999);
+    result.max = samples.back();
+    return result;
+}
+
+// Количество операций для размера задачи: больше задача - меньше операций
+size_t benchOperations(size_t budget, size_t size, size_t minimum, size_t maximum) {
+    return std::max(minimum, std::min(maximum, budget / std::max<size_t>(1, size)));
+}
+
+// Замеры операций удалённого стенда
+void benchRemoteStand(std::ostream& out) {
+    using namespace std::chrono;
+
+    RemoteStand stand("Board", system_clock::now());
+    RemoteStand other("Board", system_clock::now() + hours(1));
+    volatile bool sink = false;
+    volatile int64_t ticks = 0;
+
+    // Результат каждой операции читается через volatile, чтобы компилятор не выбросил цикл
+    printBenchResult(out, measure("stand_increase_delay", 1, 10000000, 1000, [&](size_t) {
+        stand.increaseDelay(seconds(1));
+        ticks = stand.getFreeTime().time_since_epoch().count();
+    }));
+    printBenchResult(out, measure("stand_update_free_time", 1, 10000000, 1000, [&](size_t i) {
+        stand.updateFreeTime(system_clock::time_point(seconds(i)));
+        ticks = stand.getFreeTime().time_since_epoch().count();
+    }));
+    printBenchResult(out, measure("stand_compare", 1, 10000000, 1000, [&](size_t) {
+        sink = sink ^ (stand < other) ^ (stand == other);
+    }));
+    printBenchResult(out, measure("stand_copy", 1, 1000000, 100, [&](size_t) {
+        RemoteStand copy(stand);
+        sink = sink ^ (copy == stand);
+    }));
+}
+
+// Замеры операций кластера и выбора стенда при разных размерах платы
+void benchStandCluster(std::ostream& out) {
+    using namespace std::chrono;
+
+    std::mt19937 rng(42);
+    auto start = system_clock::now();
+
+    for (size_t count : {size_t(10), size_t(1000), size_t(100000)}) {
+        std::vector<RemoteStand> scanStands;
+        StandCluster cluster;
+
+        for (size_t i = 0; i < count; ++i) {
+            RemoteStand stand("Board", start + seconds(rng() % 3600) + microseconds(i));
+            scanStands.push_back(stand);
+            cluster.addStand(stand);
+        }
+
+        // Прежний способ выбора: поиск минимума по всему вектору
+        size_t operations = benchOperations(20000000, count, 200, 1000000);
+        printBenchResult(out, measure("stand_select_scan", count, operations, 1, [&](size_t) {
+            auto optimalStand = std::min_element(scanStands.begin(), scanStands.end());
+            optimalStand->increaseDelay(DELAY);
+        }));
+
+        // Новый способ: бронирование по вершине кучи
+        Reservation reservation;
+        printBenchResult(out, measure("stand_select_heap", count, 1000000, 1, [&](size_t) {
+            cluster.reserveEarliestStand("Board", start, DELAY, reservation);
+        }));
+
+        // То же по номеру платы, без поиска по названию
+        BoardId board = 0;
+        cluster.boardId("Board", board);
+        printBenchResult(out, measure("stand_select_heap_by_id", count, 1000000, 1, [&](size_t) {
+            cluster.reserveEarliestStand(board, start, DELAY, reservation);
+        }));
+
+        printBenchResult(out, measure("cluster_get_stands_by_board", count, benchOperations(10000000, count, 50, 100000), 1, [&](size_t) {
+            cluster.getStandsByBoard("Board");
+        }));
+
+        // Каждый стенд удаляется не более одного раза, затем все удалённые стенды добавляются обратно
+        size_t removals = std::min(count, benchOperations(20000000, count, 100, 10000));
+        std::vector<RemoteStand> current = cluster.getStandsByBoard("Board");
+        printBenchResult(out, measure("cluster_remove_stand", count, removals, 1, [&](size_t i) {
+            cluster.removeStand("Board", current[i % current.size()]);
+        }));
+        printBenchResult(out, measure("cluster_add_stand", count, removals, 1, [&](size_t i) {
+            cluster.addStand(current[i % current.size()]);
+        }));
+    }
+}
+
+// Масштабирование бронирования при росте числа потоков, каждый поток работает со своей платой
+void benchClusterScaling(std::ostream& out) {
+    using namespace std::chrono;
+
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t operations = 200000;
+
+    for (unsigned threadsCount = 1; threadsCount <= maxThreads; threadsCount *= 2) {
+        StandCluster cluster;
+
+        for (unsigned t = 0; t < threadsCount; ++t) {
+            for (int i = 0; i < 1000; ++i) {
+                cluster.addStand(RemoteStand("Board " + std::to_string(t), system_clock::now()));
+            }
+        }
+
+        std::vector<BenchResult> results(threadsCount);
+        std::vector<std::thread> threads;
+        auto begin = steady_clock::now();
+
+        for (unsigned t = 0; t < threadsCount; ++t) {
+            threads.emplace_back([&cluster, &results, t]() {
+                std::string boardName = "Board " + std::to_string(t);
+                Reservation reservation;
+
+                results[t] = measure("cluster_reserve_parallel", 1000, operations, 16, [&](size_t) {
+                    cluster.reserveEarliestStand(boardName, system_clock::now(), DELAY, reservation);
+                });
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        // Общая пропускная способность и худшие перцентили среди потоков
+        BenchResult total = results[0];
+        total.threads = threadsCount;
+        total.operations = operations * threadsCount;
+        total.opsPerSecond = total.operations / duration<double>(steady_clock::now() - begin).count();
+
+        for (const auto& result : results) {
+            total.p50 = std::max(total.p50, result.p50);
+            total.p90 = std::max(total.p90, result.p90);
+            total.p99 = std::max(total.p99, result.p99);
+            total.p999 = std::max(total.p999, result.p999);
+            total.max = std::max(total.max, result.max);
+        }
+
+        printBenchResult(out, total);
+    }
+}
+
+// Замер бронирования на большой плате во время непрерывных перезагрузок топологии (плата растёт и сжимается на 10%)
+// Задержка бронирования показывает паузы, которые перезагрузка вносит в планирование
+void benchTopologyReload(std::ostream& out) {
+    using namespace std::chrono;
+
+    const size_t stands = 100000;
+    StandCluster cluster;
+    ClusterTopology topology(cluster);
+    Topology config{{TopologyBoard{"Board", stands, {}}}};
+    topology.apply(config, system_clock::now());
+
+    std::atomic<bool> reloading{true};
+    std::atomic<size_t> reloads{0};
+    std::thread reloader([&]() {
+        Topology changed = config;
+
+        while (reloading.load()) {
+            changed.boards[0].numbered = reloads.load() % 2 == 0 ? stands + stands / 10 : stands;
+            topology.apply(changed, system_clock::now());
+            ++reloads;
+        }
+    });
+
+    Reservation reservation;
+    BenchResult result = measure("cluster_reserve_during_reload", stands, 200000, 1, [&](size_t) {
+        cluster.reserveEarliestStand("Board", system_clock::now(), DELAY, reservation);
+    });
+
+    reloading = false;
+    reloader.join();
+    result.threads = 2;
+    printBenchResult(out, result);
+
+    // Наибольшее удержание блокировки шарда за перезагрузку: рост в пределах запаса, удвоение сверх запаса,
+    // сжатие и возврат к исходному размеру
+    const size_t cycles = 10;
+    const size_t sizes[] = {stands + stands / 10, 2 * stands, stands - stands / 10, stands};
+    std::vector<double> holds;
+
+    for (size_t i = 0; i < cycles * std::size(sizes); ++i) {
+        Topology changed = config;
+        changed.boards[0].numbered = sizes[i % std::size(sizes)];
+        holds.push_back(double(duration_cast<nanoseconds>(topology.apply(changed, system_clock::now()).longestHold).count()));
+    }
+
+    std::sort(holds.begin(), holds.end());
+    BenchResult hold;
+    hold.name = "cluster_reload_hold";
+    hold.size = stands;
+    hold.operations = holds.size();
+    hold.p50 = holds[holds.size() / 2];
+    hold.p90 = holds[holds.size() * 9 / 10];
+    hold.p99 = hold.p999 = hold.max = holds.back();
+    printBenchResult(out, hold);
+}
+
+// Замеры обработки заявки при разных размерах кластера
+void benchProcessRequest(std::ostream& out) {
+    using namespace std::chrono;
+
+    for (size_t count : {size_t(10), size_t(1000), size_t(100000)}) {
+        StandCluster cluster;
+
+        for (size_t i = 0; i < count; ++i) {
+            cluster.addStand(RemoteStand("Arduino Uno", system_clock::now()));
+        }
+
+        RequestProcessor processor(cluster);
+        processor.setVerbose(false);
+        Request request{"Иванов", "Иван", "Иванович", "БИВ222", "Arduino Uno", "main.exe", "C:"};
+
+        printBenchResult(out, measure("process_request", count, 100000, 1, [&](size_t) {
+            processor.processRequest(request);
+        }));
+
+        processor.shutdown();
+    }
+}
+
+// Замеры валидаторов, в том числе прежней реализации на регулярных выражениях
+void benchValidators(std::ostream& out) {
+    const std::vector<std::string> names = {"Иванов", "JaneDoe", "Смирнова", "Константинопольский", "Invalid Name@"};
+    const std::string path = "/home/students/BIV211/Ivanov/projects/lab_07/build/release/firmware.hex";
+    volatile bool sink = false;
+
+    // Прежний способ: регулярное выражение создаётся на каждый вызов
+    printBenchResult(out, measure("validate_name_regex", names.size(), 20000, 1, [&](size_t i) {
+        std::regex namePattern("^[a-zA-Zа-яА-ЯёЁрРчЧьЬъЪ]+$");
+        sink = sink ^ std::regex_match(names[i % names.size()], namePattern);
+    }));
+    printBenchResult(out, measure("validate_name", names.size(), 10000000, 1000, [&](size_t i) {
+        sink = sink ^ isValidName(names[i % names.size()]);
+    }));
+    printBenchResult(out, measure("validate_group", 1, 10000000, 1000, [&](size_t) {
+        sink = sink ^ isValidGroup("БИВ211");
+    }));
+    printBenchResult(out, measure("validate_file_path", path.size(), 10000000, 1000, [&](size_t) {
+        sink = sink ^ isValidFilePath(path);
+    }));
+}
+
+// Замеры записи метрик: счётчик, гистограмма и замер длительности по монотонным часам
+void benchMetrics(std::ostream& out) {
+    Metrics local;
+
+    printBenchResult(out, measure("metrics_counter_add", 1, 10000000, 1000, [&](size_t) {
+        local.reject(RejectReason::Group);
+    }));
+    printBenchResult(out, measure("metrics_histogram_record", 1, 10000000, 1000, [&](size_t i) {
+        local.parseTime.record(static_cast<uint64_t>(i * 7919));
+    }));
+    printBenchResult(out, measure("metrics_timer", 1, 10000000, 1000, [&](size_t) {
+        MetricsTimer timer(local.decisionTime);
+    }));
+}
+
+// Замеры чтения заявки из файла и записи в журнал
+void benchFileIo(std::ostream& out) {
+    std::string path = (std::filesystem::temp_directory_path() / "remote_stand_bench_request.txt").string();
+    {
+        std::ofstream file(path);
+        file << "Иванов\nИван\nИванович\nБИВ211\nArduino Uno\n/users/Ivan/main.cpp\nC:\\Results\n";
+    }
+
+    // Без кэша (нулевая ёмкость) и с кэшем по подписи файла; файл должен устояться, чтобы его подпись запомнилась
+    RequestFileCache uncached(0, 0);
+    RequestFileCache cache;
+    std::this_thread::sleep_for(CACHE_SETTLE_TIME);
+
+    printBenchResult(out, measure("read_request_from_file", 1, 100000, 1, [&](size_t) {
+        parseRequestFile(path, uncached);
+    }));
+    printBenchResult(out, measure("read_request_from_file_cached", 1, 100000, 1, [&](size_t) {
+        parseRequestFile(path, cache);
+    }));
+    std::filesystem::remove(path);
+
+    const std::string message = "Задание будет выполнено на стенде с платой Arduino Uno в Fri Oct 16 15:00:00 2026\n";
+    printBenchResult(out, measure("write_to_log", 1, 1000000, 1, [&](size_t) {
+        writeToLog(message);
+    }));
+}
+
+// Набор замеров производительности горячих путей
+void runBenchmarks(std::ostream& out) {
+    // Журнал на время замеров пишется во временный файл, чтобы не засорять logs.txt
+    std::string benchLog = (std::filesystem::temp_directory_path() / "remote_stand_bench_log.txt").string();
+    logPath() = benchLog;
+
+    benchRemoteStand(out);
+    benchStandCluster(out);
+    benchClusterScaling(out);
+    benchTopologyReload(out);
+    benchProcessRequest(out);
+    benchValidators(out);
+    benchMetrics(out);
+    benchFileIo(out);
+
+    logger().shutdown();
+
+    for (size_t i = 0; i <= LOG_MAX_FILES; ++i) {
+        std::filesystem::remove(i == 0 ? benchLog : benchLog + "." + std::to_string(i));
+    }
+}
+
+// Быстрые проверки в памяти: выполняются и перед интерактивной работой
+void runUnitTests() {
+    testRemoteStand();
+    testStandCluster();
+    testStandClusterConcurrency();
+    testStandCalendar();
+    testIsValidFilePath();
+    testIsValidGroup();
+    testIsValidName();
+    testValidatorsEquivalence();
+    testParseRequest();
+    testRequestArena();
+    testRuntimeEstimator();
+    testSchedulingPolicy();
+    testCompletionHub();
+    testRequestProcessor();
+    testSimulation();
+}
+
+// Проверки с файлами, сокетами, дочерними процессами и реальным временем: только в режиме --self-test
+void runIntegrationTests() {
+    testClusterJournal();
+    testTopology();
+    testContentCache();
+    testMetrics();
+    testAsyncLogger();
+    testTimerWheel();
+    testIntakePipeline();
+    testIntakeServer();
+    testSpoolWatcher();
+    testExecutionEngine();
+    testJsonLines();
+    testLoadGenerator();
+}
+
+// Полная самопроверка (--self-test, ctest)
+void runSelfTests() {
+    runUnitTests();
+    runIntegrationTests();
+}
+
+// Значение необязательного параметра командной строки (пустая строка, если параметр не задан)
+std::string optionValue(const std::vector<std::string>& args, const std::string& name) {
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        if (args[i] == name) {
+            return args[i + 1];
+        }
+    }
+
+    return "";
+}
+
+// Числовое значение необязательного параметра; value не меняется, если параметр не задан
+// false с сообщением об ошибке, если значение не число
+bool numberOption(const std::vector<std::string>& args, const std::string& name, double& value) {
+    std::string text = optionValue(args, name);
+
+    if (!text.empty() && !parseNumber(text, value)) {
+        std::cerr << "Неверное значение параметра " << name << ": " << text << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Неотрицательное целое значение необязательного параметра; value не меняется, если параметр не задан
+// false с сообщением об ошибке, если значение не целое число
+bool countOption(const std::vector<std::string>& args, const std::string& name, size_t& value) {
+    std::string text = optionValue(args, name);
+
+    if (!text.empty() && !parseCount(text, value)) {
+        std::cerr << "Неверное значение параметра " << name << ": " << text << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Вывод итогов восстановления состояния кластера из каталога --state
+void printRecoveryReport(const RecoveryReport& report, const std::string& directory) {
+    std::cout << "Состояние восстановлено из " << directory << ": ";
+
+    if (report.snapshotLoaded) {
+        std::cout << "снимок до записи " << report.snapshotSequence << ", ";
+    } else {
+        std::cout << "снимка нет, ";
+    }
+
+    std::cout << "повторено записей журнала: " << report.replayed << ", стендов: " << report.standsRestored;
+
+    if (report.tornTail) {
+        std::cout << " (оборванный хвост журнала отброшен)";
+    }
+
+    std::cout << std::endl;
+}
+
+// Стенды кластера из файла топологии (--topology файл) или стандартный набор по standsPerBoard стендов платы
+// Загруженная топология остаётся в topology для перезагрузок; false, если файл не удалось разобрать
+bool setupStands(StandCluster& cluster, const std::vector<std::string>& args, std::unique_ptr<ClusterTopology>& topology,
+                 size_t standsPerBoard = 2) {
+    std::string path = optionValue(args, "--topology");
+
+    if (path.empty()) {
+        addDefaultStands(cluster, systemClock(), standsPerBoard);
+        return true;
+    }
+
+    topology = std::make_unique<ClusterTopology>(cluster, path);
+    TopologyReport report;
+    std::string error;
+
+    if (!topology->reload(report, error)) {
+        std::cerr << "Не удалось загрузить топологию " << path << ": " << error << std::endl;
+        return false;
+    }
+
+    printTopologyReport(std::cout, report);
+    return true;
+}
+
+// Перезагрузка топологии по сигналу или команде; при ошибке кластер остаётся прежним
+// Если стенды удалены, журнал состояния (если есть) сразу делает снимок, чтобы записи удалённых стендов не повторялись
+// при восстановлении, даже если их метки появятся в топологии снова
+void reloadTopology(ClusterTopology* topology, ClusterJournal* journal) {
+    if (!topology) {
+        std::cerr << "Топология не задана: перезагружать нечего (см. --topology)" << std::endl;
+        return;
+    }
+
+    TopologyReport report;
+    std::string error;
+
+    if (topology->reload(report, error)) {
+        printTopologyReport(std::cout, report);
+
+        if (journal && report.removed > 0) {
+            journal->requestSnapshot();
+        }
+    } else {
+        std::cerr << "Топология " << topology->source() << " не применена: " << error << std::endl;
+    }
+}
+
+// Установка политики планирования из параметров --policy и --weights; false для неизвестной политики или неверного веса
+bool applyPolicyOption(RequestProcessor& processor, const std::vector<std::string>& args) {
+    std::string policyName = optionValue(args, "--policy");
+
+    if (policyName.empty()) {
+        return true;
+    }
+
+    std::string error;
+    PolicyFactory policy = makePolicyFactory(policyName, optionValue(args, "--weights"), error);
+
+    if (!policy) {
+        std::cerr << error << std::endl;
+        return false;
+    }
+
+    processor.setPolicy(policy);
+    return true;
+}
+
+// Исполнитель заданий из параметров --execute исполнитель (local), --exec-jobs n, --exec-timeout секунды
+// и --exec-cache каталог (хранилище копий исполняемых файлов по содержимому)
+// Без --execute задания только планируются; false для неизвестного исполнителя, неверного числа
+// или недоступного каталога кэша
+bool applyExecuteOption(RequestProcessor& processor, const std::vector<std::string>& args, std::unique_ptr<ExecutionEngine>& engine) {
+    std::string backendName = optionValue(args, "--execute");
+
+    if (backendName.empty()) {
+        return true;
+    }
+
+    std::unique_ptr<BoardBackend> backend = makeBoardBackend(backendName);
+
+    if (!backend) {
+        std::cerr << "Неизвестный исполнитель заданий: " << backendName << std::endl;
+        return false;
+    }
+
+    size_t jobs = EXEC_MAX_JOBS;
+    size_t timeoutSeconds = 0;
+    std::string timeout = optionValue(args, "--exec-timeout");
+    std::string cacheDirectory = optionValue(args, "--exec-cache");
+    std::string error;
+
+    if (!countOption(args, "--exec-jobs", jobs) || !countOption(args, "--exec-timeout", timeoutSeconds)) {
+        return false;
+    }
+
+    if (!cacheDirectory.empty() && !executables().setStore(cacheDirectory, error)) {
+        std::cerr << error << std::endl;
+        return false;
+    }
+
+    engine = std::make_unique<ExecutionEngine>(processor, std::move(backend), jobs,
+                                               timeout.empty() ? std::chrono::steady_clock::duration(EXEC_TIMEOUT)
+                                                               : std::chrono::seconds(timeoutSeconds));
+
+    if (!cacheDirectory.empty()) {
+        engine->setExecutableCache(&executables());
+    }
+
+    return true;
+}
+
+// Остановка исполнителя заданий с выводом количества прерванных заданий
+void stopExecution(std::unique_ptr<ExecutionEngine>& engine) {
+    if (!engine) {
+        return;
+    }
+
+    size_t unfinished = engine->stop();
+
+    if (unfinished > 0) {
+        std::cout << "Прервано или не запущено заданий: " << unfinished << std::endl;
+    }
+
+    engine.reset();
+}
+
+// Режим сервера: заявки принимаются по Unix-сокету (--unix путь) и TCP (--tcp узел:порт) до SIGINT или SIGTERM
+int runServer(const std::vector<std::string>& args) {
+    std::string unixSocket = optionValue(args, "--unix");
+    std::string tcpAddress = optionValue(args, "--tcp");
+    size_t threads = SERVER_THREADS;
+    std::string stateDirectory = optionValue(args, "--state");
+    std::string metricsPath = optionValue(args, "--metrics");
+    std::string host;
+    uint16_t port = 0;
+
+    if (unixSocket.empty() && tcpAddress.empty()) {
+        std::cerr << "Укажите адрес сервера: --unix путь и/или --tcp узел:порт" << std::endl;
+        return 1;
+    }
+
+    if (!tcpAddress.empty() && !splitHostPort(tcpAddress, host, port)) {
+        std::cerr << "Неверный адрес TCP: " << tcpAddress << std::endl;
+        return 1;
+    }
+
+    if (!countOption(args, "--threads", threads)) {
+        return 1;
+    }
+
+    // Без узла (--tcp :порт) сервер доступен только с этой машины; все интерфейсы - явно через 0.0.0.0
+    if (host.empty()) {
+        host = "127.0.0.1";
+    }
+
+    // Заявка называет исполняемый файл и каталог результата на сервере: по TCP любой клиент запускал бы
+    // произвольные программы и создавал файлы где угодно, поэтому задания исполняются только с Unix-сокетом
+    if (!tcpAddress.empty() && !optionValue(args, "--execute").empty()) {
+        std::cerr << "Параметр --execute нельзя использовать с --tcp: задания исполняются только для заявок через Unix-сокет"
+                  << std::endl;
+        return 1;
+    }
+
+    // Сигналы завершения блокируются до запуска потоков и принимаются основным потоком через sigwait
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    StandCluster cluster;
+    std::unique_ptr<ClusterTopology> topology;
+
+    if (!setupStands(cluster, args, topology)) {
+        return 1;
+    }
+
+    std::unique_ptr<ClusterJournal> journal;
+
+    if (!stateDirectory.empty()) {
+        journal = std::make_unique<ClusterJournal>(cluster, stateDirectory);
+        printRecoveryReport(journal->recover(), stateDirectory);
+        journal->start();
+    }
+
+    // Сообщения о заявках пишутся только в журнал, повторные подачи объединяются с незавершённым заданием
+    RequestProcessor processor(cluster);
+    processor.setVerbose(false);
+    processor.setCoalescing(true);
+
+    std::unique_ptr<ExecutionEngine> engine;
+
+    if (!applyPolicyOption(processor, args) || !applyExecuteOption(processor, args, engine)) {
+        return 1;
+    }
+
+    std::unique_ptr<MetricsWriter> metricsWriter;
+
+    if (!metricsPath.empty()) {
+        metricsWriter = std::make_unique<MetricsWriter>(metrics(), metricsPath);
+    }
+
+    IntakeServer server(processor, threads);
+    std::string error;
+
+    if ((!unixSocket.empty() && !server.listenUnix(unixSocket, error)) ||
+        (!tcpAddress.empty() && !server.listenTcp(host, port, error)) || !server.start(error)) {
+        std::cerr << "Не удалось запустить сервер: " << error << std::endl;
+        return 1;
+    }
+
+    std::cout << "Сервер принимает заявки";
+
+    if (!unixSocket.empty()) {
+        std::cout << ", сокет " << unixSocket;
+    }
+
+    if (!tcpAddress.empty()) {
+        std::cout << ", TCP " << host << ":" << server.tcpPort();
+    }
+
+    std::cout << std::endl;
+
+    // SIGHUP перечитывает топологию, не прерывая приём заявок
+    int received = 0;
+
+    while (sigwait(&signals, &received) == 0 && received == SIGHUP) {
+        reloadTopology(topology.get(), journal.get());
+    }
+
+    server.stop();
+    std::cout << "Сервер остановлен, соединений: " << server.acceptedConnections()
+              << ", запросов: " << server.processedFrames() << std::endl;
+
+    stopExecution(engine);
+    processor.shutdown();
+    size_t queued = processor.queuedRequests();
+
+    if (queued > 0) {
+        std::cout << "Не получили стенд заявок из очереди: " << queued << std::endl;
+    }
+
+    processor.printGroupWaits(std::cout);
+    metricsWriter.reset();
+
+    if (journal) {
+        journal->stop();
+    }
+
+    logger().shutdown();
+    return 0;
+}
+
+// Режим клиента: файлы-заявки из аргументов (или пути построчно со стандартного ввода) читаются локально
+// и отправляются серверу пачками по CLIENT_WINDOW запросов
+int runClient(const std::vector<std::string>& args) {
+    std::string unixSocket = optionValue(args, "--unix");
+    std::string tcpAddress = optionValue(args, "--tcp");
+    std::vector<std::string> paths;
+
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "--unix" || args[i] == "--tcp") {
+            ++i;
+        } else {
+            paths.push_back(args[i]);
+        }
+    }
+
+    // Пути со стандартного ввода могут содержать пробелы
+    if (paths.empty()) {
+        std::string line;
+
+        while (std::getline(std::cin, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+
+            if (!line.empty()) {
+                paths.push_back(line);
+            }
+        }
+    }
+
+    IntakeClient client;
+    std::string error;
+    std::string host;
+    uint16_t port = 0;
+    bool connected;
+
+    if (!unixSocket.empty()) {
+        connected = client.connectUnix(unixSocket, error);
+    } else if (splitHostPort(tcpAddress, host, port)) {
+        connected = client.connectTcp(host, port, error);
+    } else {
+        std::cerr << "Укажите адрес сервера: --unix путь или --tcp узел:порт" << std::endl;
+        return 1;
+    }
+
+    if (!connected) {
+        std::cerr << "Не удалось подключиться к серверу: " << error << std::endl;
+        return 1;
+    }
+
+    size_t failed = 0;
+
+    for (size_t begin = 0; begin < paths.size(); begin += CLIENT_WINDOW) {
+        size_t end = std::min(paths.size(), begin + CLIENT_WINDOW);
+        std::string frames;
+        std::vector<bool> sent(end - begin, false);
+
+        for (size_t i = begin; i < end; ++i) {
+            std::ifstream file(paths[i], std::ios::binary);
+
+            if (!file) {
+                std::cerr << paths[i] << ": не удалось открыть файл" << std::endl;
+                ++failed;
+                continue;
+            }
+
+            std::ostringstream text;
+            text << file.rdbuf();
+            appendFrame(frames, 'R', text.str());
+            sent[i - begin] = true;
+        }
+
+        if (!client.sendRaw(frames)) {
+            std::cerr << "Соединение с сервером потеряно" << std::endl;
+            return 1;
+        }
+
+        for (size_t i = begin; i < end; ++i) {
+            char type;
+            std::string reply;
+
+            if (!sent[i - begin]) {
+                continue;
+            }
+
+            if (!client.receive(type, reply)) {
+                std::cerr << "Соединение с сервером потеряно" << std::endl;
+                return 1;
+            }
+
+            if (type == 'A') {
+                size_t space = reply.find(' ');
+                std::chrono::system_clock::time_point finish(std::chrono::milliseconds(std::stoll(reply.substr(space + 1))));
+                std::cout << paths[i] << ": заявка " << reply.substr(0, space) << ", задание будет выполнено в " << formatTime(finish);
+            } else if (type == 'Q') {
+                std::cout << paths[i] << ": заявка " << reply << " поставлена в очередь" << std::endl;
+            } else {
+                std::cout << paths[i] << ": " << reply << std::endl;
+                ++failed;
+            }
+        }
+    }
+
+    return failed == 0 ? 0 : 2;
 }
 
-// Функция для проверки файла
-bool checkFile(const std::string& filename) {
-    std::ifstream file(filename);
+// Режим подписчика: события завершения заданий с сервера выводятся по строке на событие до закрытия соединения
+// Фильтр: all (по умолчанию), student фамилия, group группа или board плата
+int runSubscribe(const std::vector<std::string>& args) {
+    std::string unixSocket = optionValue(args, "--unix");
+    std::string tcpAddress = optionValue(args, "--tcp");
+    std::string filter;
 
-    if (!file.is_open()) {
-        std::cerr << "Не удалось открыть файл: " << filename << std::endl;
-        return false;
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "--unix" || args[i] == "--tcp") {
+            ++i;
+        } else {
+            filter += (filter.empty() ? "" : " ") + args[i];
+        }
     }
 
-    std::string line;
+    if (filter.empty()) {
+        filter = "all";
+    }
 
-    // Фамилия
-    std::getline(file, line);
+    IntakeClient client;
+    std::string error;
+    std::string host;
+    uint16_t port = 0;
+    bool connected;
 
-    if (!isValidName(line)) {
-        std::cerr << "Ошибка в фамилии: " << line << std::endl;
-        return false;
+    if (!unixSocket.empty()) {
+        connected = client.connectUnix(unixSocket, error);
+    } else if (splitHostPort(tcpAddress, host, port)) {
+        connected = client.connectTcp(host, port, error);
+    } else {
+        std::cerr << "Укажите адрес сервера: --unix путь или --tcp узел:порт" << std::endl;
+        return 1;
     }
 
-    // Имя
-    std::getline(file, line);
+    if (!connected || !client.send('S', filter)) {
+        std::cerr << "Не удалось подключиться к серверу: " << error << std::endl;
+        return 1;
+    }
 
-    if (!isValidName(line)) {
-        std::cerr << "Ошибка в имени: " << line << std::endl;
-        return false;
+    char type;
+    std::string payload;
+
+    while (client.receive(type, payload)) {
+        if (type == 'E') {
+            std::cerr << payload << std::endl;
+            return 1;
+        }
+
+        if (type == 'D') {
+            std::cerr << "Пропущено событий: " << payload << std::endl;
+        } else if (type == 'N') {
+            std::cout << payload << "\n";
+        }
+
+        // Вывод сбрасывается, когда события кончились, а не на каждой строке
+        if (!client.pending()) {
+            std::cout.flush();
+        }
     }
 
-    // Отчество
-    std::getline(file, line);
+    return 0;
+}
 
-    if (!isValidName(line)) {
-        std::cerr << "Ошибка в отчество: " << line << std::endl;
-        return false;
+// Режим спула: заявки принимаются из файлов, появляющихся в каталоге, до SIGINT или SIGTERM
+int runSpool(const std::vector<std::string>& args) {
+    if (args.size() < 2 || args[1].empty() || args[1][0] == '-') {
+        std::cerr << "Укажите каталог спула: --spool каталог" << std::endl;
+        return 1;
     }
 
-    // Группа
-    std::getline(file, line);
+    std::string directory = args[1];
+    std::string stateDirectory = optionValue(args, "--state");
+    std::string metricsPath = optionValue(args, "--metrics");
 
-    if (!isValidGroup(line)) {
-        std::cerr << "Ошибка в группе: " << line << std::endl;
-        return false;
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    StandCluster cluster;
+    std::unique_ptr<ClusterTopology> topology;
+
+    if (!setupStands(cluster, args, topology)) {
+        return 1;
     }
 
-    // Название платы
-    std::getline(file, line);
+    std::unique_ptr<ClusterJournal> journal;
 
-    if (line.empty()) {
-        std::cerr << "Название платы не может быть пустым." << std::endl;
-        return false;
+    if (!stateDirectory.empty()) {
+        journal = std::make_unique<ClusterJournal>(cluster, stateDirectory);
+        printRecoveryReport(journal->recover(), stateDirectory);
+        journal->start();
     }
 
-    // Путь к исполняемому файлу
-    std::getline(file, line);
+    RequestProcessor processor(cluster);
+    processor.setVerbose(false);
+    processor.setCoalescing(true);
+    std::unique_ptr<ExecutionEngine> engine;
 
-    if (!isValidFilePath(line)) {
-        std::cerr << "Неверный путь к исполняемому файлу: " << line << std::endl;
-        return false;
+    if (!applyPolicyOption(processor, args) || !applyExecuteOption(processor, args, engine)) {
+        return 1;
+    }
+
+    std::unique_ptr<MetricsWriter> metricsWriter;
+
+    if (!metricsPath.empty()) {
+        metricsWriter = std::make_unique<MetricsWriter>(metrics(), metricsPath);
+    }
+
+    SpoolWatcher watcher(processor, directory, optionValue(args, "--reader") != "threads");
+    std::string error;
+
+    if (!watcher.start(error)) {
+        std::cerr << "Не удалось наблюдать за каталогом " << directory << ": " << error << std::endl;
+        return 1;
+    }
+
+    std::cout << "Заявки принимаются из каталога " << directory
+              << (watcher.usesUring() ? " (чтение через io_uring)" : "") << std::endl;
+
+    // SIGHUP перечитывает топологию, не прерывая приём заявок
+    int received = 0;
+
+    while (sigwait(&signals, &received) == 0 && received == SIGHUP) {
+        reloadTopology(topology.get(), journal.get());
     }
 
-    // Путь для сохранения результата
-    std::getline(file, line);
+    watcher.stop();
+    std::cout << "Спул остановлен, принято заявок: " << watcher.acceptedRequests()
+              << ", отклонено: " << watcher.rejectedRequests() << std::endl;
+
+    stopExecution(engine);
+    processor.shutdown();
+    size_t queued = processor.queuedRequests();
+
+    if (queued > 0) {
+        std::cout << "Не получили стенд заявок из очереди: " << queued << std::endl;
+    }
+
+    processor.printGroupWaits(std::cout);
+    metricsWriter.reset();
+
+    if (journal) {
+        journal->stop();
+    }
+
+    logger().shutdown();
+    return 0;
+}
 
-    if (!isValidFilePath(line)) {
-        std::cerr << "Неверный путь для сохранения результата: " << line << std::endl;
+// Параметры профиля нагрузки из командной строки: --rate, --invalid, --cyrillic, --repeat, --groups, --group-skew,
+// --boards плата=вес,..., --burst-every с, --burst-length с, --burst-factor, --seed
+// false с сообщением об ошибке, если какое-то значение не число
+bool applyLoadOptions(const std::vector<std::string>& args, LoadProfile& profile) {
+    double burstEvery = 0;
+    double burstLength = 5;
+    size_t seed = profile.seed;
+
+    if (!numberOption(args, "--rate", profile.rate) || !numberOption(args, "--invalid", profile.invalidShare) ||
+        !numberOption(args, "--cyrillic", profile.cyrillicShare) || !numberOption(args, "--repeat", profile.repeatShare) ||
+        !countOption(args, "--groups", profile.groups) || !numberOption(args, "--group-skew", profile.groupSkew) ||
+        !numberOption(args, "--burst-every", burstEvery) || !numberOption(args, "--burst-length", burstLength) ||
+        !numberOption(args, "--burst-factor", profile.burstFactor) || !countOption(args, "--seed", seed)) {
         return false;
     }
 
+    profile.burstEvery = std::chrono::milliseconds(static_cast<int64_t>(burstEvery * 1000));
+    profile.burstLength = std::chrono::milliseconds(static_cast<int64_t>(burstLength * 1000));
+    profile.seed = static_cast<uint32_t>(seed);
+
+    std::string boards = optionValue(args, "--boards");
+
+    if (!boards.empty()) {
+        std::istringstream input(boards);
+        std::string item;
+        profile.boards.clear();
+
+        while (std::getline(input, item, ',')) {
+            size_t separator = item.find('=');
+            double weight = 1.0;
+
+            if (separator != std::string::npos && !parseNumber(item.substr(separator + 1), weight)) {
+                std::cerr << "Неверное значение параметра --boards: " << item << std::endl;
+                return false;
+            }
+
+            profile.boards.emplace_back(item.substr(0, separator), weight);
+        }
+    }
+
     return true;
 }
 
-// Функция для записи в логи
-void writeToLog(const std::string& message) {
-    std::mutex logMutex;
+// Режим нагрузки: поток синтетических заявок по профилю идёт через сервер приёма заявок до уведомлений о завершении,
+// срезы пропускной способности, задержки, памяти и потоков выводятся строками JSON (в --report файл или на экран)
+// Без --unix и --tcp сервер запускается в этом же процессе; иначе нагружается внешний сервер, процесс которого
+// задаётся --pid. Код возврата 3 - превышен --max-rss-growth (МБ) или --max-threads, 2 - исход заявки не совпал с ожидаемым
+int runLoad(const std::vector<std::string>& args) {
+    using namespace std::chrono;
 
-    // Блокируем мьютекс на время записи
-    std::lock_guard<std::mutex> lock(logMutex);
+    if (args.size() < 2 || args[1].empty() || args[1][0] == '-') {
+        std::cerr << "Укажите длительность нагрузки: --load секунды" << std::endl;
+        return 1;
+    }
 
-    // Открываем файл для добавления данных
-    std::ofstream logFile(LOG_PATH, std::ios::app);
+    double seconds = 0;
+    double interval = 10;
+    double maxGrowth = 0;
+    size_t standsPerBoard = 2;
+    size_t serverThreads = SERVER_THREADS;
+    size_t connections = 4;
+    size_t maxThreads = 0;
+    size_t pidNumber = 0;
+
+    if (!parseNumber(args[1], seconds) || seconds <= 0) {
+        std::cerr << "Неверная длительность нагрузки: " << args[1] << std::endl;
+        return 1;
+    }
 
-    if (logFile.is_open()) {
-        logFile << message;
-    } else {
-        std::cerr << "Не удалось открыть лог-файл!" << std::endl;
+    LoadProfile profile;
+
+    if (!applyLoadOptions(args, profile) || !numberOption(args, "--interval", interval) ||
+        !numberOption(args, "--max-rss-growth", maxGrowth) || !countOption(args, "--stands-per-board", standsPerBoard) ||
+        !countOption(args, "--threads", serverThreads) || !countOption(args, "--connections", connections) ||
+        !countOption(args, "--max-threads", maxThreads) || !countOption(args, "--pid", pidNumber)) {
+        return 1;
+    }
+
+    if (interval <= 0) {
+        std::cerr << "Неверное значение параметра --interval: " << interval << std::endl;
+        return 1;
+    }
+
+    std::string unixSocket = optionValue(args, "--unix");
+    std::string tcpAddress = optionValue(args, "--tcp");
+    std::string reportPath = optionValue(args, "--report");
+    std::string metricsPath = optionValue(args, "--metrics");
+    bool local = unixSocket.empty() && tcpAddress.empty();
+    pid_t pid = local ? ::getpid() : pidNumber > static_cast<size_t>(INT32_MAX) ? 0 : static_cast<pid_t>(pidNumber);
+    std::string host;
+    uint16_t port = 0;
+    size_t rssKb;
+    size_t threads;
+    size_t fds;
+
+    // Без процесса сервера пороги памяти и потоков проверялись бы по пустым замерам
+    if (!local && pid <= 0) {
+        std::cerr << "Укажите процесс нагружаемого сервера: --pid номер" << std::endl;
+        return 1;
+    }
+
+    if (!processStats(pid, rssKb, threads, fds)) {
+        std::cerr << "Процесс сервера не найден: /proc/" << pid << std::endl;
+        return 1;
+    }
+
+    if (!tcpAddress.empty() && !splitHostPort(tcpAddress, host, port)) {
+        std::cerr << "Неверный адрес TCP: " << tcpAddress << std::endl;
+        return 1;
+    }
+
+    // Сервер в этом же процессе: обычный набор стендов или топология, уведомления о завершении включены
+    StandCluster cluster;
+    std::unique_ptr<ClusterTopology> topology;
+
+    if (!setupStands(cluster, args, topology, standsPerBoard)) {
+        return 1;
+    }
+
+    RequestProcessor processor(cluster);
+    processor.setVerbose(false);
+    processor.setCoalescing(true);
+    std::unique_ptr<IntakeServer> server;
+    std::unique_ptr<MetricsWriter> metricsWriter;
+    std::string error;
+
+    if (local) {
+        unixSocket = (std::filesystem::temp_directory_path() / ("remote_stand_load_" + std::to_string(pid) + ".sock")).string();
+        server = std::make_unique<IntakeServer>(processor, serverThreads);
+
+        if (!applyPolicyOption(processor, args)) {
+            return 1;
+        }
+
+        if (!server->listenUnix(unixSocket, error) || !server->start(error)) {
+            std::cerr << "Не удалось запустить сервер: " << error << std::endl;
+            return 1;
+        }
+
+        if (!metricsPath.empty()) {
+            metricsWriter = std::make_unique<MetricsWriter>(metrics(), metricsPath);
+        }
+    }
+
+    LoadDriver driver(profile, connections, pid, local);
+    bool connected = driver.connect([&](IntakeClient& client, std::string& message) {
+        return unixSocket.empty() ? client.connectTcp(host, port, message) : client.connectUnix(unixSocket, message);
+    }, error);
+
+    if (!connected) {
+        std::cerr << "Не удалось подключиться к серверу: " << error << std::endl;
+        return 1;
+    }
+
+    std::ofstream reportFile;
+
+    if (!reportPath.empty()) {
+        reportFile.open(reportPath);
+    }
+
+    std::ostream& out = reportPath.empty() ? std::cout : reportFile;
+    LoadReport report = driver.run(duration_cast<steady_clock::duration>(duration<double>(seconds)),
+                                   duration_cast<steady_clock::duration>(duration<double>(interval)),
+                                   [&out, local](const LoadSample& sample) { printLoadSample(out, sample, local); });
+    printLoadReport(out, report, local);
+
+    if (server) {
+        server->stop();
+        ::unlink(unixSocket.c_str());
+    }
+
+    processor.shutdown();
+    metricsWriter.reset();
+    logger().shutdown();
+
+
+    if (report.processLost) {
+        std::cerr << "Процесс сервера " << pid << " завершился во время нагрузки" << std::endl;
+        return 3;
+    }
+
+    if (maxGrowth > 0 && report.rssGrowthKb > maxGrowth * 1024) {
+        std::cerr << "Память выросла на " << report.rssGrowthKb / 1024 << " МБ (допустимо " << maxGrowth << " МБ)" << std::endl;
+        return 3;
+    }
+
+    if (maxThreads > 0 && report.maxThreads > maxThreads) {
+        std::cerr << "Потоков было до " << report.maxThreads << " (допустимо " << maxThreads << ")" << std::endl;
+        return 3;
+    }
+
+    if (report.total.unexpected > 0) {
+        std::cerr << "Исход не совпал с ожидаемым у заявок: " << report.total.unexpected << std::endl;
+        return 2;
     }
+
+    return 0;
 }
 
-// Класс для обработки заявки
-class RequestProcessor {
-private:
-    // Кластер стендов для выбора оптимального стенда
-    StandCluster& cluster;
+// Режим генератора: count синтетических заявок по профилю в файл JSON Lines (--jsonl, для --bulk)
+// или файлами-заявками в каталог (--dir, например каталог спула: файл появляется в каталоге готовым)
+int runLoadGenerate(const std::vector<std::string>& args) {
+    std::string jsonPath = optionValue(args, "--jsonl");
+    std::string directory = optionValue(args, "--dir");
 
-public:
-    // Конструктор
-    RequestProcessor(StandCluster& cluster) : cluster(cluster) {}
+    if (args.size() < 2 || args[1].empty() || args[1][0] == '-' || (jsonPath.empty() == directory.empty())) {
+        std::cerr << "Укажите количество заявок и один вывод: --load-gen количество (--jsonl файл | --dir каталог)" << std::endl;
+        return 1;
+    }
+
+    LoadProfile profile;
+    size_t count = 0;
+
+    if (!parseCount(args[1], count)) {
+        std::cerr << "Неверное количество заявок: " << args[1] << std::endl;
+        return 1;
+    }
+
+    if (!applyLoadOptions(args, profile)) {
+        return 1;
+    }
+
+    LoadGenerator generator(profile);
+    LoadItem item;
+    size_t invalid = 0;
+    std::ofstream json;
+    std::error_code code;
 
-    // Асинхронная функция для вывода сообщения по завершении работы
-    void asyncMessage(std::chrono::system_clock::time_point freeTime, const std::string& boardName, const std::string& studentName) {
-        // Рассчитываем, сколько времени осталось до времени освобождения
-        auto now = std::chrono::system_clock::now();
-        auto delay = freeTime - now;
+    if (!jsonPath.empty()) {
+        json.open(jsonPath == "-" ? "/dev/stdout" : jsonPath);
+    } else {
+        std::filesystem::create_directories(directory, code);
+    }
 
-        // Если стенд освободится в будущем, ждем
-        if (delay > std::chrono::seconds(0)) {
-            // Задержка до наступления времени
-            std::this_thread::sleep_for(delay);
+    for (size_t i = 0; i < count; ++i) {
+        generator.next(item);
+        invalid += !item.valid;
+
+        if (json.is_open()) {
+            json << requestJson(item.request) << "\n";
+            continue;
         }
 
-        // Выводим сообщение, когда стенд освободится
-        auto freeTime_t = std::chrono::system_clock::to_time_t(freeTime);
+        char name[32];
+        std::snprintf(name, sizeof(name), "load-%08zu.txt", i + 1);
+        std::filesystem::path target = std::filesystem::path(directory) / name;
+        std::filesystem::path temporary = std::filesystem::path(directory) / ("." + std::string(name));
+        std::ofstream(temporary, std::ios::binary) << requestText(item.request);
+        std::filesystem::rename(temporary, target, code);
 
-        std::string message = "Запрос студента " + studentName + " на стенде с платой " + boardName + " выполнено.";
-        
-        // Используем std::mutex для синхронизации вывода в терминал
-        static std::mutex coutMutex;
-        {
-            // Блокируем вывод в консоль
-            std::lock_guard<std::mutex> lock(coutMutex);
-            std::cout << message << std::endl;
+        if (code) {
+            std::cerr << "Не удалось записать " << target.string() << ": " << code.message() << std::endl;
+            return 1;
         }
+    }
 
-        // Записываем в лог
-        writeToLog(message+"\n");
+    std::cerr << "Заявок: " << count << ", из них с ошибкой: " << invalid << std::endl;
+    return 0;
+}
+
+// Перевод топологии (текстовой или двоичной) в компактную двоичную форму: --topology-compile файл результат
+int runTopologyCompile(const std::vector<std::string>& args) {
+    if (args.size() < 3) {
+        std::cerr << "Укажите файлы: --topology-compile топология результат" << std::endl;
+        return 1;
     }
 
-    // Обработка заявки
-    void processRequest(const Request& request) {
-        // Ищем стенд с самым ранним временем освобождения для заданной платы
-        auto& stands = cluster.getStandsByBoard(request.boardName);  // Получаем ссылку на вектор стендов
-
-        // Если стенды для этой платы есть
-        if (!stands.empty()) {
-            // Находим стенд с минимальным временем освобождения
-            auto optimalStand = std::min_element(stands.begin(), stands.end(), [](RemoteStand& a, RemoteStand& b) {
-                return a.getFreeTime() < b.getFreeTime();
-            });
+    Topology topology;
+    std::string error;
 
-            // Если стенд свободен, устанавливаем время освобождения на текущий момент + задержка
-            auto now = std::chrono::system_clock::now();
+    if (!loadTopology(args[1], topology, error)) {
+        std::cerr << "Не удалось разобрать топологию " << args[1] << ": " << error << std::endl;
+        return 1;
+    }
 
-            if (optimalStand->getFreeTime() <= now) {
-                // Если стенд свободен, меняем его время освобождения
-                optimalStand->updateFreeTime(now + DELAY);
-            } else {
-                // Если стенд занят, увеличиваем его время освобождения
-                optimalStand->increaseDelay(DELAY);
+    std::string data = topologyBinary(topology);
+    std::ofstream out(args[2], std::ios::binary);
+
+    if (!out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+        std::cerr << "Не удалось записать файл " << args[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Плат: " << topology.boards.size() << ", стендов: " << topology.standsCount()
+              << ", размер: " << data.size() << " байт" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    // Режим замеров производительности: результаты в формате JSON Lines
+    if (!args.empty() && args[0] == "--bench") {
+        if (args.size() > 2 && args[1] == "--bench-out") {
+            std::ofstream out(args[2]);
+            runBenchmarks(out);
+        } else {
+            runBenchmarks(std::cout);
+        }
+
+        return 0;
+    }
+
+    // Режим моделирования в виртуальном времени
+    if (!args.empty() && (args[0] == "--simulate" || args[0] == "--simulate-synthetic") && args.size() > 1) {
+        size_t standsPerBoard = 2;
+        double rate = 1.0;
+        std::string policyName = "fcfs";
+        std::string weights;
+
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            if ((args[i] == "--stands-per-board" && !parseCount(args[i + 1], standsPerBoard)) ||
+                (args[i] == "--rate" && !parseNumber(args[i + 1], rate))) {
+                std::cerr << "Неверное значение параметра " << args[i] << ": " << args[i + 1] << std::endl;
+                return 1;
+            } else if (args[i] == "--policy") {
+                policyName = args[i + 1];
+            } else if (args[i] == "--weights") {
+                weights = args[i + 1];
             }
+        }
 
-            // Выводим время, когда задание будет выполнено
-            auto freeTime = optimalStand->getFreeTime();
+        std::string error;
+        PolicyFactory policy = makePolicyFactory(policyName, weights, error);
 
-            std::time_t freeTime_t = std::chrono::system_clock::to_time_t(freeTime);
-            std::string message = "Задание будет выполнено на стенде с платой " + request.boardName +
-                                " в " + std::ctime(&freeTime_t);
-            std::cout << message;
+        if (!policy) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
 
-            // Записываем в лог
-            writeToLog(message);
+        TraceSource source;
 
-            // Асинхронное сообщение
-            std::thread(&RequestProcessor::asyncMessage, this, optimalStand->getFreeTime(), request.boardName, request.lastName).detach();
+        if (args[0] == "--simulate") {
+            auto file = std::make_shared<std::ifstream>(args[1]);
+
+            if (!file->is_open()) {
+                std::cerr << "Не удалось открыть трассу: " << args[1] << std::endl;
+                return 1;
+            }
+
+            source = traceFromStream(file);
         } else {
-            std::string message = "Нет доступных стендов для платы: " + request.boardName;
-            std::cout << message << std::endl;
+            size_t count = 0;
 
-            // Записываем в лог
-            writeToLog(message);
+            if (!parseCount(args[1], count)) {
+                std::cerr << "Неверное количество заявок: " << args[1] << std::endl;
+                return 1;
+            }
+
+            source = syntheticTrace(count, rate, 42);
         }
+
+        // Журнал моделирования не сохраняется
+        logPath() = "/dev/null";
+
+        ManualClock clock;
+        StandCluster cluster;
+        addDefaultStands(cluster, clock, standsPerBoard);
+
+        SimulationReport report = simulate(cluster, clock, source, policy);
+        printSimulationReport(report, cluster);
+        logger().shutdown();
+        return 0;
     }
-};
 
-void testRequestProcessor() {
-    using namespace std::chrono;
+    // Сервер приёма заявок и его клиент
+    if (!args.empty() && args[0] == "--serve") {
+        return runServer(args);
+    }
 
-    std::cout << "Запуск тестов для RequestProcessor..." << std::endl;
+    if (!args.empty() && args[0] == "--client") {
+        return runClient(args);
+    }
 
-    // Создание тестового кластера и стендов
-    StandCluster testCluster;
-    RemoteStand stand1("Arduino Uno", system_clock::now());
-    RemoteStand stand2("Arduino Uno", system_clock::now() + seconds(10)); // Стенд занят
-    testCluster.addStand(stand1);
-    testCluster.addStand(stand2);
+    if (!args.empty() && args[0] == "--subscribe") {
+        return runSubscribe(args);
+    }
 
-    // Проверка асинхронного вывода сообщения
-    RequestProcessor processor(testCluster);
+    // Приём заявок из каталога-спула
+    if (!args.empty() && args[0] == "--spool") {
+        return runSpool(args);
+    }
 
-    // Создаем время освобождения через 1 секунду
-    auto freeTime = system_clock::now() + seconds(1);
-    std::string boardName = "Arduino Uno";
-    std::string studentName = "Иванов";
+    // Нагрузка и генерация синтетических заявок
+    if (!args.empty() && args[0] == "--load") {
+        return runLoad(args);
+    }
 
-    // Поток для асинхронного вызова
-    std::thread asyncTestThread([&]() {
-        processor.asyncMessage(freeTime, boardName, studentName);
-    });
+    if (!args.empty() && args[0] == "--load-gen") {
+        return runLoadGenerate(args);
+    }
 
-    // Подождем, чтобы асинхронный вызов успел отработать
-    asyncTestThread.join();
+    // Компиляция топологии кластера в двоичную форму
+    if (!args.empty() && args[0] == "--topology-compile") {
+        return runTopologyCompile(args);
+    }
 
-    // Тест 2: Проверка обработки заявки на стенде
-    Request request1{"Иванов", "Иван", "Иванович", "БИВ222", "Arduino Uno", "otpt.txt", "C:"};
-    processor.processRequest(request1);
+    // Пакетный импорт заявок в формате JSON Lines из файла или стандартного ввода ("-")
+    if (!args.empty() && args[0] == "--bulk" && args.size() > 1) {
+        std::string rejectsPath = optionValue(args, "--rejects");
+        std::string stateDirectory = optionValue(args, "--state");
+        std::string metricsPath = optionValue(args, "--metrics");
 
-    std::this_thread::sleep_for(DELAY);
+        if (rejectsPath.empty()) {
+            rejectsPath = "rejects.txt";
+        }
 
-    // Время, когда запрос должен быть выполнен
-    auto freeTimeAfterRequest = stand1.getFreeTime();
+        int fd = args[1] == "-" ? 0 : ::open(args[1].c_str(), O_RDONLY);
 
-    // Проверим, что время свободного стенда обновилось
-    assert(freeTimeAfterRequest <= system_clock::now() + seconds(10));
+        if (fd < 0) {
+            std::cerr << "Не удалось открыть файл: " << args[1] << std::endl;
+            return 1;
+        }
 
-    // Проверка на отсутствие доступных стендов для платы
-    StandCluster emptyCluster;  // Пустой кластер
-    RequestProcessor emptyProcessor(emptyCluster);
+        std::ofstream rejects(rejectsPath);
+        StandCluster cluster;
+        std::unique_ptr<ClusterTopology> topology;
 
-    Request request2{"Иванов", "Иван", "Иванович", "БИВ222", "STM-32", "otpt.txt", "C:"};
-    emptyProcessor.processRequest(request2);
+        if (!setupStands(cluster, args, topology)) {
+            return 1;
+        }
 
-    // Проверка на некорректный путь файла
-    std::string invalidPath = "invalid_path.txt";
-    bool isValid = checkFile(invalidPath);
+        // Журнал состояния продолжает расписание предыдущих запусков
+        std::unique_ptr<ClusterJournal> journal;
 
-    // Ожидаем, что путь будет неверным
-    assert(!isValid);
-}
+        if (!stateDirectory.empty()) {
+            journal = std::make_unique<ClusterJournal>(cluster, stateDirectory);
+            printRecoveryReport(journal->recover(), stateDirectory);
+            journal->start();
+        }
+
+        // Программа завершается сразу после импорта, поэтому уведомления о завершении не планируются
+        RequestProcessor processor(cluster);
+        processor.setVerbose(false);
+        processor.setNotifications(false);
+
+        // Метрики пишутся в файл во время импорта и после его окончания
+        std::unique_ptr<MetricsWriter> metricsWriter;
+
+        if (!metricsPath.empty()) {
+            metricsWriter = std::make_unique<MetricsWriter>(metrics(), metricsPath);
+        }
+
+        BulkReport report = importJsonLines(fd, processor, rejects);
+
+        if (fd != 0) {
+            ::close(fd);
+        }
+
+        std::cout << "Строк: " << report.lines << ", запланировано: " << report.scheduled
+                  << ", отклонено: " << report.rejected << " (см. " << rejectsPath << ")" << std::endl;
+        std::cout << "Время импорта: " << report.elapsed << " с" << std::endl;
+        processor.printGroupWaits(std::cout);
+        metricsWriter.reset();
+
+        if (journal) {
+            journal->stop();
+        }
+
+        logger().shutdown();
+        return 0;
+    }
+
+    // Режим только самопроверки
+    if (!args.empty() && args[0] == "--self-test") {
+        runSelfTests();
+        logger().shutdown();
+        std::cout << "Тесты прошли успешно." << std::endl;
+        return 0;
+    }
 
-int main() {
     std::cout << "Проверка тестов перед работой..." << std::endl;
     
-    // Проверка тестов перед работой
-    testRemoteStand();
-    testStandCluster();
-    testIsValidFilePath();
-    testIsValidGroup();
-    testIsValidName();
-    testRequestProcessor();
+    // Проверка тестов перед работой: только быстрые проверки в памяти, полная самопроверка - --self-test
+    // Тесты пишут в общие метрики, поэтому перед работой метрики сбрасываются
+    runUnitTests();
+    metrics().reset();
 
     std::cout << "Тесты прошли успешно. Программа готова к использованию." << std::endl;
     
     using namespace std::chrono;
 
-    // Создание стендов
-    RemoteStand stand1("Arduino Uno", system_clock::now());
-    RemoteStand stand2("Arduino Uno", system_clock::now());
-    RemoteStand stand3("STM-32", system_clock::now());
-    RemoteStand stand4("STM-32", system_clock::now());
-    RemoteStand stand5("DE10-Lite", system_clock::now());
-    RemoteStand stand6("DE10-Lite", system_clock::now());
-    
+    // Создание кластера стендов: стандартный набор или топология из файла (--topology <файл>)
     StandCluster cluster;
+    std::unique_ptr<ClusterTopology> topology;
 
-    // Добавление стендов в кластер
-    cluster.addStand(stand1);
-    cluster.addStand(stand2);
-    cluster.addStand(stand3);
-    cluster.addStand(stand4);
-    cluster.addStand(stand5);
-    cluster.addStand(stand6);
+    if (!setupStands(cluster, args, topology)) {
+        return 1;
+    }
+
+    // Восстановление и журналирование состояния кластера между запусками (--state <каталог>)
+    std::string stateDirectory = optionValue(args, "--state");
+    std::unique_ptr<ClusterJournal> journal;
+
+    if (!stateDirectory.empty()) {
+        journal = std::make_unique<ClusterJournal>(cluster, stateDirectory);
+        printRecoveryReport(journal->recover(), stateDirectory);
+        journal->start();
+    }
 
     // Вывод информации об имеющихся стендах
     std::cout << std::endl << "Стенды в кластере:" << std::endl;
@@ -769,25 +15178,92 @@ int main() {
     std::cout << std::endl;
     std::cout << std::endl;
 
-    // Создание процессор заявок
+    // Создание процессор заявок; повторная подача той же заявки до завершения задания не создаёт нового задания
     RequestProcessor processor(cluster);
+    processor.setCoalescing(true);
+
+    // Политика планирования (--policy fcfs|fair, веса групп --weights группа=вес,...)
+    // и запуск заданий (--execute local)
+    std::unique_ptr<ExecutionEngine> engine;
+
+    if (!applyPolicyOption(processor, args) || !applyExecuteOption(processor, args, engine)) {
+        return 1;
+    }
+
+    // Периодическая запись метрик в формате Prometheus (--metrics <файл>)
+    std::string metricsPath = optionValue(args, "--metrics");
+    std::unique_ptr<MetricsWriter> metricsWriter;
+
+    if (!metricsPath.empty()) {
+        metricsWriter = std::make_unique<MetricsWriter>(metrics(), metricsPath);
+    }
     
+    // Конвейер приёма: файлы читаются и проверяются параллельно, планирование идёт в порядке ввода
+    IntakePipeline pipeline([&processor](const ParseResult& result) {
+        if (result.ok()) {
+            processor.processRequest(result.request);
+        } else {
+            std::cerr << describeError(result) << std::endl;
+        }
+    });
+
     // Обработка заявок
     std::cout << "Введите путь к файлу с заявкой: " << std::endl;
     while (true) {
         std::string filepath;
-        std::cin >> filepath;
 
-        if (filepath == "exit") {
+        // Путь читается строкой целиком, поэтому может содержать пробелы
+        bool ended = !std::getline(std::cin, filepath);
+
+        if (!filepath.empty() && filepath.back() == '\r') {
+            filepath.pop_back();
+        }
+
+        // Конец ввода завершает программу так же, как команда exit
+        if (ended || filepath == "exit") {
+            // Дожидаемся планирования всех принятых заявок
+            pipeline.finish();
+
             std::cout << "Выход из программы." << std::endl;
+            stopExecution(engine);
+
+            // Останавливаем поток уведомлений до выхода из main
+            size_t cancelled = processor.shutdown();
+            size_t queued = processor.queuedRequests();
+
+            if (cancelled > 0) {
+                std::cout << "Отменено ожидающих уведомлений: " << cancelled << std::endl;
+            }
+
+            if (queued > 0) {
+                std::cout << "Не получили стенд заявок из очереди: " << queued << std::endl;
+            }
+
+            processor.printGroupWaits(std::cout);
+
+            // Итоговый снимок состояния после планирования всех заявок
+            if (journal) {
+                journal->stop();
+            }
+
             break;
         }
-        
-        if (checkFile(filepath)){
-            Request request = readRequestFromFile(filepath);
-            processor.processRequest(request);
+
+        if (filepath.empty()) {
+            continue;
         }
+
+        // Команда reload перечитывает топологию кластера, заявки конвейера планируются параллельно
+        if (filepath == "reload") {
+            reloadTopology(topology.get(), journal.get());
+            continue;
+        }
+
+        pipeline.submit(filepath);
     }
 
+    // Дописываем журнал до конца перед выходом
+    logger().shutdown();
+
     return 0;
 }